@@ -46,6 +46,7 @@
 #include "vm/vm.hpp"
 
 #include "vm/jit/builtin.hpp"
+#include "vm/jit/invoker.hpp"
 
 
 /**
@@ -107,6 +108,13 @@ java_handle_t* Reflection::invoke(methodinfo *m, java_handle_t *o, java_handle_o
 	if (m->flags & ACC_STATIC)
 		o = NULL;
 
+	/* frequently invoked methods get a specialized invoker */
+
+	invokerinfo *inv = invoker_get(m);
+
+	if (inv != NULL)
+		return invoker_invoke(inv, o, params);
+
 	if (o != NULL) {
 		/* for instance methods we must do a vftbl lookup */
 		resm = method_vftbl_lookup(LLNI_vftbl_direct(o), m);
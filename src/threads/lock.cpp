@@ -73,6 +73,12 @@ STAT_DECLARE_VAR(int,size_lock_record,0)
 STAT_DECLARE_VAR(int,size_lock_hashtable,0)
 STAT_DECLARE_VAR(int,size_lock_waiter,0)
 
+STAT_REGISTER_GROUP(lock_reservation_stat,"lock reservation","lock reservation")
+STAT_REGISTER_GROUP_VAR(int,count_lock_reserved,0,"reserved","objects reserved for a thread",lock_reservation_stat)
+STAT_REGISTER_GROUP_VAR_EXTERN(int,count_lock_reserved_enter,0,"reserved enters","monitors entered without atomic operations",lock_reservation_stat)
+STAT_REGISTER_GROUP_VAR(int,count_lock_reservation_revoked,0,"revoked","reservations revoked",lock_reservation_stat)
+STAT_REGISTER_GROUP_VAR(int,count_lock_reservation_suspended,0,"revoke suspensions","reserving threads suspended to revoke",lock_reservation_stat)
+
 /******************************************************************************/
 /* MACROS                                                                     */
 /******************************************************************************/
@@ -104,14 +110,36 @@ STAT_DECLARE_VAR(int,size_lock_waiter,0)
  *
  * In thin lock mode the lockword looks like this:
  *
- *     ,----------------------,-----------,---,
- *     |      thread ID       |   count   | 0 |
- *     `----------------------'-----------'---'
+ *     ,----------------------,---,-----------,---,
+ *     |      thread ID       | 0 |   count   | 0 |
+ *     `----------------------'---'-----------'---'
  *
  *     thread ID......the 'index' of the owning thread, or 0
  *     count..........number of times the lock has been entered	minus 1
  *     0..............the shape bit is 0 in thin lock mode
  *
+ * With -XX:+LockReservation new objects start out reservable, and the
+ * first thread locking one reserves it, as described in
+ *
+ *     Kiyokuni Kawachiya, Akira Koseki, Tamiya Onodera
+ *     Lock Reservation: Java Locks Can Mostly Do Without Atomic Operations
+ *     Proceedings of the ACM OOPSLA '02, pp. 130-141
+ *     2002
+ *
+ * In reserved mode the lockword looks like this:
+ *
+ *     ,----------------------,---,-----------,---,
+ *     |      thread ID       | 1 |   count   | 0 |
+ *     `----------------------'---'-----------'---'
+ *
+ *     thread ID......the 'index' of the reserving thread, 0 if reservable
+ *     count..........number of times the lock has been entered
+ *
+ * The reserving thread enters and exits with plain loads and stores.
+ * Any other thread locking the object first revokes the reservation,
+ * turning the lockword into the equivalent thin lock; see
+ * lock_reservation_revoke.
+ *
  * In fat lock mode it is basically a lock_record_t *:
  *
  *     ,----------------------------------,---,
@@ -126,6 +154,9 @@ STAT_DECLARE_VAR(int,size_lock_waiter,0)
 /* hashtable mapping objects to lock records */
 static lock_hashtable_t lock_hashtable;
 
+/* serializes revoking lock reservations */
+static Mutex* lock_reservation_mutex;
+
 
 /******************************************************************************/
 /* PROTOTYPES                                                                 */
@@ -156,6 +187,22 @@ void lock_init(void)
 	/* initialize lock hashtable */
 
 	lock_hashtable_init();
+
+	lock_reservation_mutex = new Mutex();
+}
+
+
+/* lock_reservation_get_mutex **************************************************
+
+   Returns the mutex serializing revocations of lock reservations.  A
+   terminating thread holds it while clearing its thread ID, so it
+   cannot disappear while lock_reservation_revoke suspends it.
+
+*******************************************************************************/
+
+Mutex& lock_reservation_get_mutex(void)
+{
+	return *lock_reservation_mutex;
 }
 
 
@@ -766,6 +813,200 @@ static void notify_flc_waiters(threadobject *t, java_handle_t *o)
 	t->flc_lock->unlock();
 }
 
+/* lock_reservation_enter ******************************************************
+
+   Enter the monitor of an object reserved for the current thread, or
+   reserve an object nobody has locked yet.
+
+   While reservation_critical is set, a thread revoking the
+   reservation waits, so the lockword cannot change between the load
+   and the store.
+
+   IN:
+      t............the current thread
+	  lw_ptr.......the object's lockword
+
+   RETURN VALUE:
+      true.........the lock has been acquired
+	  false........the lockword is not reserved for the current thread,
+	               or the count is at its maximum
+
+*******************************************************************************/
+
+static bool lock_reservation_enter(threadobject *t, uintptr_t *lw_ptr)
+{
+	bool result = false;
+
+	t->reservation_critical = 1;
+	Atomic::instruction_barrier();
+
+	uintptr_t lw_cache = *lw_ptr;
+	Lockword lockword(lw_cache);
+
+	if (lockword.is_reserved_by(t->thinlock) && !lockword.is_max_thin_lock_count()) {
+		Lockword(*lw_ptr).increase_thin_lock_count();
+		result = true;
+	}
+
+	Atomic::instruction_barrier();
+	t->reservation_critical = 0;
+
+	if (result) {
+		STATISTICS(count_lock_reserved_enter++);
+		return true;
+	}
+
+	if (lockword.is_reservable() && Lockword(*lw_ptr).reserve(t->thinlock)) {
+		STATISTICS(count_lock_reserved++);
+		return true;
+	}
+
+	return false;
+}
+
+
+/* lock_reservation_exit *******************************************************
+
+   Exit the monitor of an object reserved for the current thread.
+
+   RETURN VALUE:
+      true.........the lock has been released
+	  false........the current thread does not hold a reserved lock
+
+*******************************************************************************/
+
+static bool lock_reservation_exit(threadobject *t, uintptr_t *lw_ptr)
+{
+	bool result = false;
+
+	t->reservation_critical = 1;
+	Atomic::instruction_barrier();
+
+	uintptr_t lw_cache = *lw_ptr;
+	Lockword lockword(lw_cache);
+
+	if (lockword.is_reserved_by(t->thinlock) && (lockword.get_thin_lock_count() > 0)) {
+		Lockword(*lw_ptr).decrease_thin_lock_count();
+		result = true;
+	}
+
+	Atomic::instruction_barrier();
+	t->reservation_critical = 0;
+
+	return result;
+}
+
+
+/* lock_reservation_cancel *****************************************************
+
+   Turn a reservation of the current thread into the equivalent thin
+   lock, so it can be inflated or waited on.
+
+*******************************************************************************/
+
+static void lock_reservation_cancel(threadobject *t, uintptr_t *lw_ptr)
+{
+	t->reservation_critical = 1;
+	Atomic::instruction_barrier();
+
+	uintptr_t lw_cache = *lw_ptr;
+	Lockword lockword(lw_cache);
+
+	if (lockword.is_reserved_by(t->thinlock)) {
+		Lockword(*lw_ptr).revoke();
+		STATISTICS(count_lock_reservation_revoked++);
+	}
+
+	Atomic::instruction_barrier();
+	t->reservation_critical = 0;
+}
+
+
+/* lock_reservation_revoke *****************************************************
+
+   Revoke the reservation of another thread on the given object.
+
+   There are no safepoints, so the reserving thread is suspended with
+   threads_suspend_thread instead.  If it was stopped in the middle of
+   entering or exiting a reserved lock, it is resumed and we try
+   again.  The thread list is only locked to look up the reserving
+   thread, never while suspending it.  A terminating thread clears its
+   thread ID under lock_reservation_mutex (see
+   lock_reservation_get_mutex), so it cannot go away meanwhile.
+
+   IN:
+      t............the current thread
+	  o............the object
+
+*******************************************************************************/
+
+static void lock_reservation_revoke(threadobject *t, java_handle_t *o)
+{
+	MutexLocker lock(*lock_reservation_mutex);
+
+	uintptr_t *lw_ptr = lock_lockword_get(o);
+
+	for (;;) {
+		uintptr_t lw_cache = *lw_ptr;
+		Lockword lockword(lw_cache);
+
+		// Somebody else revoked it in the meantime.
+		if (!lockword.is_reserved())
+			return;
+
+		int32_t       index = lockword.get_thin_lock_thread_index();
+		threadobject *owner;
+
+		{
+			// No other thread can take over the index while the list
+			// is locked.
+			MutexLocker threadlist_lock(ThreadList::get()->mutex());
+
+			owner = ThreadList::get()->get_thread_by_index(index);
+
+			// The reserving thread is gone.
+			if (owner == NULL) {
+				Lockword(*lw_ptr).revoke();
+				break;
+			}
+		}
+
+		assert(owner != t);
+
+		bool suspended = threads_suspend_thread(owner, SUSPEND_REASON_REVOKE);
+		bool revoked   = false;
+
+		STATISTICS(count_lock_reservation_suspended++);
+
+		{
+			MutexLocker ml(*owner->suspendmutex);
+
+			if (owner->suspended && !owner->reservation_critical && (owner->index == index)) {
+				// The owner may have canceled the reservation itself.
+				lw_cache = *lw_ptr;
+
+				if (lockword.is_reserved())
+					Lockword(*lw_ptr).revoke();
+
+				revoked = true;
+			}
+		}
+
+		if (suspended)
+			threads_resume_thread(owner, SUSPEND_REASON_REVOKE);
+
+		if (revoked)
+			break;
+
+		threads_yield();
+	}
+
+	DEBUGLOCKS(("thread %d revoked reservation of %p", t->index, (void*) o));
+
+	STATISTICS(count_lock_reservation_revoked++);
+}
+
+
 /* lock_monitor_enter **********************************************************
 
    Acquire the monitor of the given object. If the current thread already
@@ -798,8 +1039,14 @@ bool lock_monitor_enter(java_handle_t *o)
 	uintptr_t thinlock = t->thinlock;
 
 retry:
-	// Most common case: try to thin-lock an unlocked object.
 	uintptr_t *lw_ptr = lock_lockword_get(o);
+
+	// With lock reservation, the most common case is an object
+	// reserved for the current thread.
+	if (opt_LockReservation && lock_reservation_enter(t, lw_ptr))
+		return true;
+
+	// Most common case: try to thin-lock an unlocked object.
 	uintptr_t lw_cache = *lw_ptr;
 	Lockword lockword(lw_cache);
 	bool result = Lockword(*lw_ptr).lock(thinlock);
@@ -862,6 +1109,17 @@ retry:
 		return true;
 	}
 
+	// The object is reserved, for another thread or for us with the
+	// count at its maximum.  Make it a thin lock and start over.
+	if (lockword.is_reserved()) {
+		if (lockword.is_reserved_by(thinlock))
+			lock_reservation_cancel(t, lw_ptr);
+		else
+			lock_reservation_revoke(t, o);
+
+		goto retry;
+	}
+
 	/****** inflation path ******/
 
 #if defined(ENABLE_JVMTI)
@@ -914,6 +1172,9 @@ bool lock_monitor_exit(java_handle_t* o)
 	// We don't have to worry about stale values here, as any stale
 	// value will indicate that we don't own the lock.
 	uintptr_t *lw_ptr = lock_lockword_get(o);
+
+	if (opt_LockReservation && lock_reservation_exit(t, lw_ptr))
+		return true;
 	uintptr_t lw_cache = *lw_ptr;
 	Lockword lockword(lw_cache);
 
@@ -977,6 +1238,29 @@ bool lock_monitor_exit(java_handle_t* o)
 }
 
 
+/* lock_monitor_exit_contended *************************************************
+
+   Called by the inline fast-path of monitorexit after it released a
+   thin lock and saw the FLC bit of the current thread set.
+
+   IN:
+	  o............the object just unlocked
+
+*******************************************************************************/
+
+void lock_monitor_exit_contended(java_handle_t *o)
+{
+	// This function is inside a critical section.
+	GCCriticalSection cs;
+
+	threadobject *t = thread_get_current();
+
+	DEBUGLOCKS(("thread %d saw flc bit", t->index));
+
+	notify_flc_waiters(t, o);
+}
+
+
 /* lock_record_add_waiter ******************************************************
 
    Add a thread to the list of waiting threads of a lock record.
@@ -1114,6 +1398,11 @@ static void lock_monitor_wait(threadobject *t, java_handle_t *o, s8 millis, s4 n
 	lock_record_t *lr;
 
 	uintptr_t *lw_ptr = lock_lockword_get(o);
+
+	// Waiting needs a fat lock.
+	if (opt_LockReservation)
+		lock_reservation_cancel(t, lw_ptr);
+
 	uintptr_t lw_cache = *lw_ptr;
 	Lockword lockword(lw_cache);
 
@@ -1242,6 +1531,15 @@ static void lock_monitor_notify(threadobject *t, java_handle_t *o, bool one)
 				return;
 			}
 		}
+		else if (lockword.is_reserved()) {
+			if (!lockword.is_reserved_by(t->thinlock) || (lockword.get_thin_lock_count() == 0)) {
+				exceptions_throw_illegalmonitorstateexception();
+				return;
+			}
+
+			// Nor on a reserved lock.
+			return;
+		}
 		else {
 			// It's a thin lock.
 			if (lockword.get_thin_lock_without_count() != t->thinlock) {
@@ -1294,6 +1592,10 @@ bool lock_is_held_by_current_thread(java_handle_t *o)
 		lock_record_t* lr = lockword.get_fat_lock();
 		return (lr->owner == t);
 	}
+	else if (lockword.is_reserved()) {
+		// A reserved lock is held if the count is not zero.
+		return lockword.is_reserved_by(t->thinlock) && (lockword.get_thin_lock_count() > 0);
+	}
 	else {
 		// It's a thin lock.
 		return (lockword.get_thin_lock_without_count() == t->thinlock);
@@ -74,8 +74,11 @@ struct lock_hashtable_t {
 
 void lock_init(void);
 
+Mutex& lock_reservation_get_mutex(void);
+
 bool lock_monitor_enter(java_handle_t *);
 bool lock_monitor_exit(java_handle_t *);
+void lock_monitor_exit_contended(java_handle_t *o);
 
 bool lock_is_held_by_current_thread(java_handle_t *o);
 
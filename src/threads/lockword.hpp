@@ -30,12 +30,15 @@
 #include <stdint.h>
 #include <assert.h>
 #include "threads/atomic.hpp"
+#include "vm/options.hpp"
 
 /**
  * Lockword.
  */
 class Lockword {
-private:
+public:
+	// The layout is public as the code generators emit inline fast
+	// paths for the thin lock cases.
 	static const int       THIN_LOCK_WORD_SIZE   = SIZEOF_VOID_P * 8; // Pointer size multiplied by 8-bit.
 	static const int       THIN_LOCK_SHAPE_BIT   = 0x01;
 
@@ -48,7 +51,12 @@ private:
 
 	static const int       THIN_LOCK_COUNT_MASK  = (THIN_LOCK_COUNT_MAX << THIN_LOCK_COUNT_SHIFT);
 
-	static const int       THIN_LOCK_TID_SHIFT   = (THIN_LOCK_COUNT_SIZE + THIN_LOCK_COUNT_SHIFT);
+	static const int       THIN_LOCK_RESERVED_BIT = (1 << (THIN_LOCK_COUNT_SIZE + THIN_LOCK_COUNT_SHIFT));
+
+	// An object nobody has locked yet when lock reservation is enabled.
+	static const uintptr_t THIN_RESERVABLE       = THIN_LOCK_RESERVED_BIT;
+
+	static const int       THIN_LOCK_TID_SHIFT   = (THIN_LOCK_COUNT_SIZE + THIN_LOCK_COUNT_SHIFT + 1);
 	static const int       THIN_LOCK_TID_SIZE    = (THIN_LOCK_WORD_SIZE - THIN_LOCK_TID_SHIFT);
 
 private:
@@ -58,7 +66,7 @@ private:
 public:
 	Lockword(uintptr_t& lockword) : _lockword(lockword) {}
 
-	void init() { _lockword = THIN_UNLOCKED; } // REMOVEME
+	void init() { _lockword = opt_LockReservation ? THIN_RESERVABLE : THIN_UNLOCKED; } // REMOVEME
 
 	static inline uintptr_t pre_compute_thinlock(int32_t index);
 
@@ -82,6 +90,12 @@ public:
 	inline void increase_thin_lock_count();
 	inline void decrease_thin_lock_count();
 
+	inline bool is_reservable () const;
+	inline bool is_reserved   () const;
+	inline bool is_reserved_by(uintptr_t thinlock) const;
+	inline bool reserve       (uintptr_t thinlock);
+	inline void revoke        ();
+
 	void inflate(struct lock_record_t* lr);
 };
 
@@ -212,6 +226,70 @@ void Lockword::decrease_thin_lock_count()
 	_lockword -= (1 << THIN_LOCK_COUNT_SHIFT);
 }
 
+
+/**
+ * Check if the lockword can be reserved for the next thread locking it.
+ */
+bool Lockword::is_reservable() const
+{
+	return (_lockword == THIN_RESERVABLE);
+}
+
+
+/**
+ * Check if the lockword is reserved for a thread.  The thread ID and
+ * the count have the thin lock layout, but the count is the number
+ * of times the lock has been entered, so a reserved lock may be free.
+ *
+ * @return true if reserved, false otherwise.
+ */
+bool Lockword::is_reserved() const
+{
+	return is_thin_lock() && ((_lockword & THIN_LOCK_RESERVED_BIT) != 0) && (_lockword != THIN_RESERVABLE);
+}
+
+
+/**
+ * Check if the lockword is reserved for the thread with the given
+ * thin-lock value.
+ */
+bool Lockword::is_reserved_by(uintptr_t thinlock) const
+{
+	return ((_lockword & ~THIN_LOCK_COUNT_MASK) == (thinlock | THIN_LOCK_RESERVED_BIT));
+}
+
+
+/**
+ * Try to reserve a reservable lockword for the thread with the given
+ * thin-lock value and enter it once.
+ *
+ * @return true if successful, false otherwise.
+ */
+bool Lockword::reserve(uintptr_t thinlock)
+{
+	uintptr_t reserved    = thinlock | THIN_LOCK_RESERVED_BIT | THIN_LOCK_COUNT_INCR;
+	uintptr_t oldlockword = Atomic::compare_and_swap(&_lockword, THIN_RESERVABLE, reserved);
+
+	return (oldlockword == THIN_RESERVABLE);
+}
+
+
+/**
+ * Turn a reserved lockword into the equivalent thin lock.  The
+ * reserving thread must not be in the middle of entering or exiting
+ * the lock.  Released thin locks are never reserved again.
+ */
+void Lockword::revoke()
+{
+	// Sanity check.
+	assert(is_reserved());
+
+	if (get_thin_lock_count() == 0)
+		_lockword = THIN_UNLOCKED;
+	else
+		_lockword = (_lockword & ~THIN_LOCK_RESERVED_BIT) - THIN_LOCK_COUNT_INCR;
+}
+
 #endif // _LOCKWORD_HPP
 
 
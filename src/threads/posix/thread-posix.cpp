@@ -168,7 +168,11 @@ static void threads_set_thread_priority(pthread_t tid, int priority);
 /* This is either a thread-local variable defined with __thread, or           */
 /* a thread-specific value stored with key threads_current_threadobject_key.  */
 #if defined(HAVE___THREAD)
+# if defined(THREAD_CURRENT_STATIC_TLS)
+__thread threadobject *thread_current __attribute__((tls_model("initial-exec")));
+# else
 __thread threadobject *thread_current;
+# endif
 #else
 pthread_key_t thread_current_key;
 #endif
@@ -445,6 +449,8 @@ void threads_impl_thread_clear(threadobject *t)
 	t->suspended      = false;
 	t->suspend_reason = SUSPEND_REASON_NONE;
 
+	t->reservation_critical = 0;
+
 	t->pc = NULL;
 
 	t->_exceptionptr   = NULL;
@@ -937,9 +943,16 @@ bool thread_detach_current_thread(void)
 	/* XXX Care about exceptions? */
 	(void) lock_monitor_exit(jlt.get_handle());
 
-	t->waitmutex->lock();
-	t->impl.tid = 0;
-	t->waitmutex->unlock();
+	/* A thread revoking one of our lock reservations may be about to
+	   suspend us, see lock_reservation_revoke. */
+
+	{
+		MutexLocker lock(lock_reservation_get_mutex());
+
+		t->waitmutex->lock();
+		t->impl.tid = 0;
+		t->waitmutex->unlock();
+	}
 
 	{
 		MutexLocker lock(ThreadList::get()->mutex());
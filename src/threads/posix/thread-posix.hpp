@@ -50,7 +50,15 @@
 
 #define THREADOBJECT      thread_current
 
+// The x86_64 code generator reads thread_current at a fixed offset
+// from the thread pointer, which needs static TLS even though libjvm
+// is loaded with dlopen.
+#if defined(__X86_64__) && defined(__LINUX__)
+# define THREAD_CURRENT_STATIC_TLS 1
+extern __thread threadobject *thread_current __attribute__((tls_model("initial-exec")));
+#else
 extern __thread threadobject *thread_current;
+#endif
 
 #else /* defined(HAVE___THREAD) */
 
@@ -67,7 +67,8 @@ enum SuspendReason {
   SUSPEND_REASON_JAVA      = 1,   // suspended from java.lang.Thread
   SUSPEND_REASON_STOPWORLD = 2,   // suspended from stop-the-world
   SUSPEND_REASON_DUMP      = 3,   // suspended from threadlist dumping
-  SUSPEND_REASON_JVMTI     = 4    // suspended from JVMTI agent
+  SUSPEND_REASON_JVMTI     = 4,   // suspended from JVMTI agent
+  SUSPEND_REASON_REVOKE    = 5    // suspended to revoke a lock reservation
 };
 
 /* thread priorities **********************************************************/
@@ -109,6 +110,9 @@ struct threadobject {
 	Mutex*                flc_lock;     /* controlling access to these fields */
 	Condition*            flc_cond;
 
+	//***** for lock reservation
+	s4                    reservation_critical; /* in enter/exit of a reserved lock */
+
 	//***** these are used for the wait/notify implementation
 	Mutex*                waitmutex;
 	Condition*            waitcond;
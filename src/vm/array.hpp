@@ -39,9 +39,14 @@
 #include "vm/jit/builtin.hpp"           // for builtin_canstore
 #include "vm/os.hpp"                    // for os
 #include "vm/primitive.hpp"             // for primitivetypeinfo, etc
+#include "vm/statistics.hpp"            // for STATISTICS
 #include "vm/types.hpp"                 // for s4, s2
 #include "vm/vftbl.hpp"                 // for vftbl_t
 
+STAT_DECLARE_VAR(u8,count_heap_arrays,0)
+STAT_DECLARE_VAR(u8,size_heap_arrays,0)
+STAT_DECLARE_VAR(u8,size_heap_array_refs,0)
+
 /* array types ****************************************************************/
 
 /* CAUTION: Don't change the numerical values! These constants (with
@@ -183,6 +188,11 @@ inline Array::Array(int32_t size, classinfo* arrayclass)
 
 	a->size = size;
 
+	STATISTICS(count_heap_arrays++);
+	STATISTICS(size_heap_arrays += actualsize);
+	STATISTICS(size_heap_array_refs += SIZEOF_VOID_P +
+			   ((desc->arraytype == ARRAYTYPE_OBJECT) ? (u8) size * componentsize : 0));
+
 	_handle = (java_handle_array_t*) a;
 }
 
@@ -116,6 +116,9 @@ struct classinfo {                /* class structure                          */
 	s4          index;            /* hierarchy depth (classes) or index       */
 	                              /* (interfaces)                             */
 	s4          instancesize;     /* size of an instance of this class        */
+#if defined(ENABLE_STATISTICS)
+	s4          instancereferences; /* reference fields of an instance        */
+#endif
 
 	threadobject *initializing_thread;
 	vftbl_t      *vftbl;          /* pointer to virtual function table        */
@@ -0,0 +1,389 @@
+/* src/vm/classindex.cpp - index of the class files on the classpath
+
+   Copyright (C) 1996-2013
+   CACAOVM - Verein zur Foerderung der freien virtuellen Maschine CACAO
+
+   This file is part of CACAO.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation; either version 2, or (at
+   your option) any later version.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA.
+
+*/
+
+
+#include "config.h"
+
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <vector>
+
+#include "mm/memory.hpp"
+
+#include "threads/mutex.hpp"
+
+#include "toolbox/buffer.hpp"
+#include "toolbox/hashtable.hpp"
+
+#include "vm/classindex.hpp"
+#include "vm/options.hpp"
+#include "vm/os.hpp"
+#include "vm/statistics.hpp"
+#include "vm/suck.hpp"
+#include "vm/utf8.hpp"
+#include "vm/zip.hpp"
+
+using namespace cacao;
+
+
+STAT_DECLARE_GROUP(classpath_stat)
+STAT_REGISTER_GROUP_VAR(int,count_classindex_archived,0,"archived","class files indexed in zip/jar archives",classpath_stat)
+STAT_REGISTER_GROUP_VAR(int,count_classindex_packages,0,"packages","package directories listed",classpath_stat)
+STAT_REGISTER_GROUP_VAR(int,count_classindex_rescans,0,"rescans","package directories listed again after a change",classpath_stat)
+
+
+/* hashtable entries **********************************************************/
+
+struct ClassIndexEntry {
+	Utf8String            name;
+	int32_t               position;     // position of lce in the classpath
+	list_classpath_entry *lce;
+
+	/// interface to HashTable
+	size_t hash() const { return name.hash(); }
+
+	Utf8String key() const { return name; }
+	void set_key(Utf8String u) { name = u; }
+};
+
+struct DirectoryState {
+	time_t mtime;                       // of the package directory, 0 if missing
+	time_t scanned;                     // when the directory was listed
+};
+
+struct PackageIndexEntry {
+	Utf8String      name;
+	DirectoryState *dirs;               // one per directory on the classpath
+
+	/// interface to HashTable
+	size_t hash() const { return name.hash(); }
+
+	Utf8String key() const { return name; }
+	void set_key(Utf8String u) { name = u; }
+};
+
+struct IndexedDirectory {
+	list_classpath_entry *lce;
+	int32_t               position;
+};
+
+typedef HashTable<InsertOnlyNamedEntry<ClassIndexEntry> >   ClassIndexTable;
+typedef HashTable<InsertOnlyNamedEntry<PackageIndexEntry> > PackageIndexTable;
+
+
+/* global variables ***********************************************************/
+
+static ClassIndexTable               *class_table   = NULL;
+static PackageIndexTable             *package_table = NULL;
+static std::vector<IndexedDirectory> *directories   = NULL;
+static Mutex                         *index_mutex   = NULL;
+
+
+/**
+ * Records that <name> can be loaded from <lce>, unless an entry earlier
+ * in the classpath provides it as well.
+ */
+static void index_add(Utf8String name, int32_t position, list_classpath_entry *lce)
+{
+	ClassIndexTable::EntryRef ref = class_table->find(name);
+
+	if (ref) {
+		if (position < ref->position) {
+			ref->position = position;
+			ref->lce      = lce;
+		}
+		return;
+	}
+
+	ClassIndexEntry e;
+
+	e.name     = name;
+	e.position = position;
+	e.lce      = lce;
+
+	class_table->insert(ref, e);
+}
+
+
+/**
+ * Filter for class files.
+ */
+static int class_filter(const struct dirent *a)
+{
+	size_t namlen = strlen(a->d_name);
+
+	return (namlen > strlen(".class")) &&
+		(strcmp(a->d_name + namlen - strlen(".class"), ".class") == 0);
+}
+
+
+/**
+ * Builds the path of a package directory below a directory entry of
+ * the classpath.  Classpath directories always end with a '/'.
+ */
+static void package_path(Buffer<>& path, list_classpath_entry *lce, Utf8String package)
+{
+	path.reset();
+	path.write(lce->path);
+
+	if (package.size() > 0)
+		path.write(package).write('/');
+}
+
+
+/**
+ * Lists the class files of <package> in the directory <dir> and adds
+ * them to the index.  A missing package directory lists nothing.
+ */
+static void package_scan(PackageIndexEntry *pkg, size_t dir, ClassLookupCost *cost)
+{
+	IndexedDirectory& d     = (*directories)[dir];
+	DirectoryState&   state = pkg->dirs[dir];
+	Buffer<>          path;
+	struct stat       st;
+
+	package_path(path, d.lce, pkg->name);
+
+	state.scanned = time(NULL);
+
+	cost->syscalls++;
+
+	if (os::stat(path.c_str(), &st) == -1 || !S_ISDIR(st.st_mode)) {
+		state.mtime = 0;
+		return;
+	}
+
+	state.mtime = st.st_mtime;
+
+	struct dirent **namelist = NULL;
+
+	cost->syscalls++;
+
+	int n = os::scandir(path.c_str(), &namelist, &class_filter, NULL);
+
+	Buffer<> classname;
+
+	for (int i = 0; i < n; i++) {
+		size_t namlen = strlen(namelist[i]->d_name) - strlen(".class");
+
+		classname.reset();
+
+		if (pkg->name.size() > 0)
+			classname.write(pkg->name).write('/');
+
+		classname.write(namelist[i]->d_name, namlen);
+
+		index_add(classname.utf8_str(), d.position, d.lce);
+
+		// (We use `free` as the memory came from the C library.)
+		free(namelist[i]);
+	}
+
+	if (namelist != NULL)
+		free(namelist);
+
+	STATISTICS(count_classindex_packages++);
+}
+
+
+/**
+ * Lists <package> again in all directories whose listing is out of
+ * date.  Returns true if anything was listed.
+ *
+ * Modification times have a resolution of one second, so a listing
+ * taken in the same second the directory was changed is not trusted.
+ */
+static bool package_revalidate(PackageIndexEntry *pkg, ClassLookupCost *cost)
+{
+	bool changed = false;
+
+	for (size_t i = 0; i < directories->size(); i++) {
+		IndexedDirectory& d     = (*directories)[i];
+		DirectoryState&   state = pkg->dirs[i];
+		Buffer<>          path;
+		struct stat       st;
+
+		package_path(path, d.lce, pkg->name);
+
+		cost->syscalls++;
+
+		time_t mtime = (os::stat(path.c_str(), &st) == -1) ? 0 : st.st_mtime;
+
+		if (mtime == state.mtime && mtime < state.scanned)
+			continue;
+
+		package_scan(pkg, i, cost);
+
+		STATISTICS(count_classindex_rescans++);
+
+		changed = true;
+	}
+
+	return changed;
+}
+
+
+/**
+ * Returns the package entry of the class <name>, listing the package
+ * in all directories if it is seen for the first time.
+ */
+static PackageIndexEntry *package_find(Utf8String name, bool *fresh, ClassLookupCost *cost)
+{
+	const char *start = name.begin();
+	const char *slash = start + name.size();
+
+	while (slash > start && slash[-1] != '/')
+		slash--;
+
+	size_t     len     = (slash > start) ? slash - start - 1 : 0;
+	Utf8String package = Utf8String::from_utf8(start, len);
+
+	cost->probes++;
+
+	PackageIndexTable::EntryRef ref = package_table->find(package);
+
+	if (ref) {
+		*fresh = false;
+		return &*ref;
+	}
+
+	PackageIndexEntry e;
+
+	e.name = package;
+	e.dirs = MNEW(DirectoryState, directories->size());
+
+	PackageIndexEntry& pkg = package_table->insert(ref, e);
+
+	for (size_t i = 0; i < directories->size(); i++)
+		package_scan(&pkg, i, cost);
+
+	*fresh = true;
+	return &pkg;
+}
+
+
+/**
+ * Builds the index over all entries of the classpath.  Must be called
+ * after the classpath is complete and before any class is loaded.
+ */
+void ClassIndex::initialize(SuckClasspath& classpath)
+{
+	if (!opt_ClassPathIndex)
+		return;
+
+	class_table   = new ClassIndexTable(4096);
+	package_table = new PackageIndexTable();
+	directories   = new std::vector<IndexedDirectory>();
+	index_mutex   = new Mutex();
+
+	int32_t position = 0;
+
+	for (SuckClasspath::iterator it = classpath.begin(); it != classpath.end(); it++, position++) {
+		list_classpath_entry *lce = *it;
+
+#if defined(ENABLE_ZLIB)
+		if (lce->type == CLASSPATH_ARCHIVE) {
+			ZipFile *zip = lce->zip;
+
+			// resources keep their extension and would collide with
+			// class names
+
+			for (ZipFile::Iterator it = zip->begin(), end = zip->end(); it != end; ++it) {
+				if (!it->classfile)
+					continue;
+
+				index_add(it->filename, position, lce);
+
+				STATISTICS(count_classindex_archived++);
+			}
+
+			continue;
+		}
+#endif
+
+		IndexedDirectory d;
+
+		d.lce      = lce;
+		d.position = position;
+
+		directories->push_back(d);
+	}
+}
+
+
+bool ClassIndex::is_enabled()
+{
+	return class_table != NULL;
+}
+
+
+/**
+ * Looks up the classpath entry holding the class file for <name>.  The
+ * index may be out of date if class files were removed from a
+ * directory, so callers must be prepared for the file to be missing.
+ * On a miss the package directories are checked for changes, so class
+ * files added after the package was listed are found.
+ */
+list_classpath_entry *ClassIndex::find(Utf8String name, ClassLookupCost *cost)
+{
+	assert(is_enabled());
+
+	MutexLocker lock(*index_mutex);
+
+	PackageIndexEntry *pkg   = NULL;
+	bool               fresh = true;
+
+	if (!directories->empty())
+		pkg = package_find(name, &fresh, cost);
+
+	cost->probes++;
+
+	ClassIndexTable::EntryRef ref = class_table->find(name);
+
+	if (!ref && !fresh && package_revalidate(pkg, cost)) {
+		cost->probes++;
+		ref = class_table->find(name);
+	}
+
+	return ref ? ref->lce : NULL;
+}
+
+
+/*
+ * These are local overrides for various environment variables in Emacs.
+ * Please do not remove this and leave it at the end of the file, where
+ * Emacs will automagically detect them.
+ * ---------------------------------------------------------------------
+ * Local variables:
+ * mode: c++
+ * indent-tabs-mode: t
+ * c-basic-offset: 4
+ * tab-width: 4
+ * End:
+ * vim:noexpandtab:sw=4:ts=4:
+ */
@@ -0,0 +1,88 @@
+/* src/vm/classindex.hpp - index of the class files on the classpath
+
+   Copyright (C) 1996-2013
+   CACAOVM - Verein zur Foerderung der freien virtuellen Maschine CACAO
+
+   This file is part of CACAO.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation; either version 2, or (at
+   your option) any later version.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA.
+
+*/
+
+
+#ifndef CLASSINDEX_HPP_
+#define CLASSINDEX_HPP_ 1
+
+#include "config.h"
+
+#include <stdint.h>                     // for int32_t
+
+#include "vm/utf8.hpp"                  // for Utf8String
+
+class SuckClasspath;
+struct list_classpath_entry;
+
+
+/**
+ * Cost of locating one class file, for the statistics.
+ */
+struct ClassLookupCost {
+	int32_t probes;                     // hashtable lookups
+	int32_t syscalls;                   // fopen, stat and scandir calls
+};
+
+
+/**
+ * Maps class names to the first classpath entry providing them, so a
+ * class file is located with a single hash lookup instead of a probe
+ * per classpath entry.
+ *
+ * The class files of zip/jar archives are indexed once at startup.
+ * Directories are listed lazily, each package directory when a class
+ * of the package is looked up for the first time.  Hits make no system
+ * calls after that.  A miss checks the modification times of the
+ * package directories and lists the changed ones again, so class files
+ * added later are found; a class file added in front of the one that
+ * was found is not.
+ *
+ * Disabled with -XX:-ClassPathIndex.
+ */
+class ClassIndex {
+public:
+	static void initialize(SuckClasspath& classpath);
+
+	static bool is_enabled();
+
+	/// Returns the classpath entry to load <name> from, NULL if there is none
+	static list_classpath_entry *find(Utf8String name, ClassLookupCost *cost);
+};
+
+#endif // CLASSINDEX_HPP_
+
+
+/*
+ * These are local overrides for various environment variables in Emacs.
+ * Please do not remove this and leave it at the end of the file, where
+ * Emacs will automagically detect them.
+ * ---------------------------------------------------------------------
+ * Local variables:
+ * mode: c++
+ * indent-tabs-mode: t
+ * c-basic-offset: 4
+ * tab-width: 4
+ * End:
+ * vim:noexpandtab:sw=4:ts=4:
+ */
@@ -44,6 +44,7 @@
 #include "vm/jit/asmpart.hpp"
 #include "vm/jit/builtin.hpp"           // for builtin_new, etc
 #include "vm/jit/exceptiontable.hpp"    // for exceptiontable_entry_t, etc
+#include "vm/jit/linenumbertable.hpp"   // for LinenumberTable
 #include "vm/jit/methodheader.hpp"
 #include "vm/jit/patcher-common.hpp"
 #include "vm/jit/show.hpp"
@@ -1416,9 +1417,12 @@ extern "C" void *exceptions_handle_exception(java_object_t *xptro, void *xpc, vo
 	codeinfo               *code;
 	exceptiontable_t       *et;
 	exceptiontable_entry_t *ete;
+	exceptiontable_range_t *range;
 	s4                      i;
 	classref_or_classinfo   cr;
 	classinfo              *c;
+	classinfo              *xclass;
+	uint32_t                generation;
 	void                   *result;
 
 #ifdef __S390__
@@ -1453,10 +1457,17 @@ extern "C" void *exceptions_handle_exception(java_object_t *xptro, void *xpc, vo
 	m = code->m;
 
 #if !defined(NDEBUG)
-	/* print exception trace */
+	/* print exception trace, the exception may come from an inlined
+	   method */
 
-	if (opt_TraceExceptions)
-		trace_exception(LLNI_DIRECT(xptr), m, xpc);
+	if (opt_TraceExceptions) {
+		methodinfo *xm = m;
+
+		if (code->linenumbertable != NULL)
+			(void) code->linenumbertable->find(&xm, xpc);
+
+		trace_exception(LLNI_DIRECT(xptr), xm, xpc);
+	}
 #endif
 
 	/* Get the exception table. */
@@ -1464,94 +1475,101 @@ extern "C" void *exceptions_handle_exception(java_object_t *xptro, void *xpc, vo
 	et = code->exceptiontable;
 
 	if (et != NULL) {
-	/* Iterate over all exception table entries. */
+		/* Ask the cache first, it knows the answer for the same PC and
+		   exception class. */
 
-	ete = et->entries;
+		LLNI_class_get(xptr, xclass);
 
-	for (i = 0; i < et->length; i++, ete++) {
-		/* is the xpc is the current catch range */
+		generation = exceptiontable_cache_generation();
 
-		if ((ADDR_MASK(ete->startpc) <= xpc) && (xpc < ADDR_MASK(ete->endpc))) {
-			cr = ete->catchtype;
+		if (exceptiontable_cache_find(xpc, xclass, &result)) {
+			if (result != NULL)
+				goto exceptions_handle_exception_found;
+		}
+		else {
+			/* Iterate over the exception table entries covering the xpc. */
 
-			/* NULL catches everything */
+			range = exceptiontable_find_range(et, xpc);
 
-			if (cr.any == NULL) {
-#if !defined(NDEBUG)
-				/* Print stacktrace of exception when caught. */
+			for (i = 0; (range != NULL) && (i < range->count); i++) {
+				ete = &et->entries[et->indices[range->first + i]];
 
-				if (opt_TraceExceptions) {
-					exceptions_print_exception(xptr);
-					stacktrace_print_exception(xptr);
-				}
-#endif
+				cr = ete->catchtype;
 
-				result = ete->handlerpc;
-				goto exceptions_handle_exception_return;
-			}
-
-			/* resolve or load/link the exception class */
+				/* NULL catches everything */
 
-			if (cr.is_classref()) {
-				/* The exception class reference is unresolved. */
-				/* We have to do _eager_ resolving here. While the
-				   class of the exception object is guaranteed to be
-				   loaded, it may well have been loaded by a different
-				   loader than the defining loader of m's class, which
-				   is the one we must use to resolve the catch
-				   class. Thus lazy resolving might fail, even if the
-				   result of the resolution would be an already loaded
-				   class. */
+				if (cr.any == NULL) {
+					result = ete->handlerpc;
+					exceptiontable_cache_add(xpc, xclass, result, generation);
+					goto exceptions_handle_exception_found;
+				}
 
-				c = resolve_classref_eager(cr.ref);
+				/* resolve or load/link the exception class */
 
-				if (c == NULL) {
-					/* Exception resolving the exception class, argh! */
-					goto exceptions_handle_exception_return;
-				}
+				if (cr.is_classref()) {
+					/* The exception class reference is unresolved. */
+					/* We have to do _eager_ resolving here. While the
+					   class of the exception object is guaranteed to be
+					   loaded, it may well have been loaded by a different
+					   loader than the defining loader of m's class, which
+					   is the one we must use to resolve the catch
+					   class. Thus lazy resolving might fail, even if the
+					   result of the resolution would be an already loaded
+					   class. */
 
-				/* Ok, we resolved it. Enter it in the table, so we
-				   don't have to do this again. */
-				/* XXX this write should be atomic. Is it? */
+					c = resolve_classref_eager(cr.ref);
 
-				ete->catchtype.cls = c;
-			}
-			else {
-				c = cr.cls;
-
-				/* XXX I don't think this case can ever happen. -Edwin */
-				if (!(c->state & CLASS_LOADED))
-					/* use the methods' classloader */
-					if (!load_class_from_classloader(c->name,
-													 m->clazz->classloader))
+					if (c == NULL) {
+						/* Exception resolving the exception class, argh! */
 						goto exceptions_handle_exception_return;
+					}
 
-				/* XXX I think, if it is not linked, we can be sure
-				   that the exception object is no (indirect) instance
-				   of it, no?  -Edwin  */
-				if (!(c->state & CLASS_LINKED))
-					if (!link_class(c))
-						goto exceptions_handle_exception_return;
-			}
+					/* Ok, we resolved it. Enter it in the table, so we
+					   don't have to do this again. */
+					/* XXX this write should be atomic. Is it? */
 
-			/* is the thrown exception an instance of the catch class? */
+					ete->catchtype.cls = c;
+				}
+				else {
+					c = cr.cls;
+
+					/* XXX I don't think this case can ever happen. -Edwin */
+					if (!(c->state & CLASS_LOADED)) {
+						/* use the classloader of the method the handler
+						   belongs to, which may be an inlined one */
+
+						methodinfo *hm = code->m;
+
+						if (code->linenumbertable != NULL)
+							(void) code->linenumbertable->find(&hm, ete->handlerpc);
+
+						if (!load_class_from_classloader(c->name,
+														 hm->clazz->classloader))
+							goto exceptions_handle_exception_return;
+					}
+
+					/* XXX I think, if it is not linked, we can be sure
+					   that the exception object is no (indirect) instance
+					   of it, no?  -Edwin  */
+					if (!(c->state & CLASS_LINKED))
+						if (!link_class(c))
+							goto exceptions_handle_exception_return;
+				}
 
-			if (builtin_instanceof(xptr, c)) {
-#if !defined(NDEBUG)
-				/* Print stacktrace of exception when caught. */
+				/* is the thrown exception an instance of the catch class? */
 
-				if (opt_TraceExceptions) {
-					exceptions_print_exception(xptr);
-					stacktrace_print_exception(xptr);
+				if (builtin_instanceof(xptr, c)) {
+					result = ete->handlerpc;
+					exceptiontable_cache_add(xpc, xclass, result, generation);
+					goto exceptions_handle_exception_found;
 				}
-#endif
-
-				result = ete->handlerpc;
-				goto exceptions_handle_exception_return;
 			}
+
+			/* Remember that this frame does not catch the exception. */
+
+			exceptiontable_cache_add(xpc, xclass, NULL, generation);
 		}
 	}
-	}
 
 	/* Is this method realization synchronized? */
 
@@ -1588,6 +1606,18 @@ extern "C" void *exceptions_handle_exception(java_object_t *xptro, void *xpc, vo
 #endif /* !defined(NDEBUG) */
 
 	result = NULL;
+	goto exceptions_handle_exception_return;
+
+exceptions_handle_exception_found:
+
+#if !defined(NDEBUG)
+	/* Print stacktrace of exception when caught. */
+
+	if (opt_TraceExceptions) {
+		exceptions_print_exception(xptr);
+		stacktrace_print_exception(xptr);
+	}
+#endif
 
 exceptions_handle_exception_return:
 
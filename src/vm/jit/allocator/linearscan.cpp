@@ -0,0 +1,1149 @@
+/* src/vm/jit/allocator/linearscan.cpp - linear scan allocation of locals
+
+   Copyright (C) 1996-2014
+   CACAOVM - Verein zur Foerderung der freien virtuellen Maschine CACAO
+
+   This file is part of CACAO.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation; either version 2, or (at
+   your option) any later version.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA.
+
+*/
+
+/* The simple register allocator gives every java local slot a register
+   or a stack slot for the whole method.  In methods which are not leaf
+   methods only callee saved registers can be used that way, which on
+   x86_64 means that all float locals live in memory.
+
+   The allocator in this file computes the live interval of every local
+   variable instead, i.e. the range of instructions between its first
+   definition and its last use in the linear code order, and runs the
+   linear scan algorithm of Poletto and Sarkar over them:
+
+   - Locals whose intervals do not overlap share a register or a stack
+     slot.
+   - A local whose interval contains no call is given a caller saved
+     register, also in methods which are not leaf methods.
+   - A local copied from another local whose interval ends at the copy
+     gets the register of the other one, which makes the copy a no-op.
+     Parameters preferably stay in the register they are passed in.
+
+   Intervals are not split, since the code generator expects every
+   variable at one location for the whole method.  Only the registers
+   the temporaries and interface variables have left in the register
+   pools are used, so the allocation of those is not affected. */
+
+
+#include "config.h"
+
+#include <algorithm>
+#include <cassert>
+
+#include "vm/types.hpp"
+
+#include "arch.hpp"
+#include "md-abi.hpp"
+
+#include "mm/dumpmemory.hpp"
+#include "mm/memory.hpp"
+
+#include "toolbox/bitvector.hpp"
+
+#include "vm/descriptor.hpp"
+#include "vm/method.hpp"
+#include "vm/options.hpp"
+#include "vm/statistics.hpp"
+
+#include "vm/jit/abi.hpp"
+#include "vm/jit/code.hpp"
+#include "vm/jit/jit.hpp"
+#include "vm/jit/reg.hpp"
+
+#include "vm/jit/allocator/linearscan.hpp"
+
+#include "vm/jit/ir/icmd.hpp"
+#include "vm/jit/ir/instruction.hpp"
+
+
+#if SUPPORT_LINEARSCAN
+
+STAT_REGISTER_VAR(int,count_linearscan_methods,0,"linear scan methods","methods whose locals were allocated by linear scan")
+STAT_REGISTER_VAR(int,count_linearscan_shared,0,"shared locations","locals sharing a register or stack slot with another local")
+STAT_REGISTER_VAR(int,count_linearscan_callersaved,0,"caller saved locals","locals of non-leaf methods in caller saved registers")
+STAT_REGISTER_VAR(int,count_linearscan_coalesced,0,"coalesced copies","copies between locals removed by coalescing")
+
+
+/* size of a stackslot used by the internal ABI */
+
+#define SIZE_OF_STACKSLOT 8
+
+
+/* register kinds, in the order they are preferred ****************************/
+
+enum {
+	LINEARSCAN_TMP,
+	LINEARSCAN_ARG,
+	LINEARSCAN_SAV
+};
+
+
+struct lsregister {
+	s4    regoff;
+	s4    kind;                     // LINEARSCAN_TMP, _ARG or _SAV
+	s4    index;                    // index into the register pool of its kind
+	s4    param;                    // parameter passed in it, or -1
+	s4    owner;                    // interval holding it, or -1
+	bool  used;                     // held by some interval before
+};
+
+struct lsinterval {
+	s4    varindex;
+	s4    start;                    // -1 if the variable is never used
+	s4    end;
+	s4    param;                    // parameter index, or -1
+	s4    hint;                     // interval copied from at hintpos, or -1
+	s4    hintpos;
+	bool  flt;                      // float register class
+	bool  crosses;                  // a call lies within the interval
+	bool  own;                      // stays in its parameter register
+	s4    reg;                      // index into the registers, or -1
+};
+
+struct linearscan_t {
+	jitdata     *jd;
+	s4           count;             // intervals
+	lsinterval  *intervals;
+	s4          *intervalof;        // interval of every variable, or -1
+	s4           positions;
+	s4          *calls;             // number of calls up to a position
+	lsregister  *regs[2];           // integer and float registers
+	s4           regcount[2];
+	s4          *active;            // intervals holding a register
+	s4           activecount;
+	s4           coalesced;         // statistics
+	s4           shared;
+	s4           callersaved;
+};
+
+
+/* linearscan_is_call **********************************************************
+
+   Returns true if the code generated for the instruction calls a
+   function, which destroys the caller saved registers.
+
+*******************************************************************************/
+
+static bool linearscan_is_call(const instruction *iptr)
+{
+	switch (icmd_table[iptr->opc].dataflow) {
+	case DF_INVOKE:
+	case DF_BUILTIN:
+		return true;
+	}
+
+	switch (iptr->opc) {
+	case ICMD_MULTIANEWARRAY:
+	case ICMD_AASTORE:
+	case ICMD_F2I:
+	case ICMD_F2L:
+	case ICMD_D2I:
+	case ICMD_D2L:
+		return true;
+
+	case ICMD_CHECKCAST:
+		return (iptr->flags.bits & INS_FLAG_ARRAY) != 0;
+
+	default:
+		return false;
+	}
+}
+
+
+/* linearscan_operands *********************************************************
+
+   Returns the number of variables the instruction reads and points
+   operands at them.
+
+*******************************************************************************/
+
+static s4 linearscan_operands(const instruction *iptr, s4 *buffer, const s4 **operands)
+{
+	*operands = buffer;
+
+	switch (icmd_table[iptr->opc].dataflow) {
+	case DF_3_TO_0:
+	case DF_3_TO_1:
+		buffer[0] = iptr->s1.varindex;
+		buffer[1] = iptr->sx.s23.s2.varindex;
+		buffer[2] = iptr->sx.s23.s3.varindex;
+		return 3;
+
+	case DF_2_TO_0:
+	case DF_2_TO_1:
+		buffer[0] = iptr->s1.varindex;
+		buffer[1] = iptr->sx.s23.s2.varindex;
+		return 2;
+
+	case DF_1_TO_0:
+	case DF_1_TO_1:
+	case DF_COPY:
+	case DF_MOVE:
+		buffer[0] = iptr->s1.varindex;
+		return 1;
+
+	case DF_INVOKE:
+	case DF_BUILTIN:
+	case DF_N_TO_1:
+		*operands = iptr->sx.s23.s2.args;
+		return iptr->s1.argcount;
+
+	default:
+		/* the stack of the caller is kept alive for replacement */
+
+		if (iptr->opc == ICMD_INLINE_START) {
+			*operands = iptr->sx.s23.s3.inlineinfo->stackvars;
+			return iptr->sx.s23.s3.inlineinfo->stackvarscount;
+		}
+		return 0;
+	}
+}
+
+
+/* linearscan_result ***********************************************************
+
+   Returns the variable the instruction writes, or UNUSED.
+
+*******************************************************************************/
+
+static s4 linearscan_result(const instruction *iptr)
+{
+	methoddesc *md;
+
+	switch (icmd_table[iptr->opc].dataflow) {
+	case DF_INVOKE:
+		INSTRUCTION_GET_METHODDESC(iptr, md);
+		break;
+
+	case DF_BUILTIN:
+		md = iptr->sx.s23.s3.bte->md;
+		break;
+
+	default:
+		if (icmd_table[iptr->opc].dataflow >= DF_DST_BASE)
+			return iptr->dst.varindex;
+		return jitdata::UNUSED;
+	}
+
+	return (md->returntype.type == TYPE_VOID) ? jitdata::UNUSED : iptr->dst.varindex;
+}
+
+
+/* linearscan_local ************************************************************
+
+   Returns the interval of the variable, or -1 if it is no local.
+
+*******************************************************************************/
+
+static inline s4 linearscan_local(linearscan_t *ls, s4 varindex)
+{
+	if ((varindex < 0) || (varindex >= ls->jd->localcount))
+		return -1;
+
+	return ls->intervalof[varindex];
+}
+
+
+/* linearscan_successors *******************************************************
+
+   Stores the successors of the block by normal control flow in succ
+   and returns their number.
+
+*******************************************************************************/
+
+static s4 linearscan_successors(basicblock *bptr, basicblock **succ)
+{
+	s4 n = 0;
+
+	if (bptr->icount > 0) {
+		instruction *iptr = bptr->iinstr + bptr->icount - 1;
+
+		switch (icmd_table[iptr->opc].controlflow) {
+		case CF_IF:
+			succ[n++] = iptr->dst.block;
+			break;
+
+		case CF_GOTO:
+			succ[n++] = iptr->dst.block;
+			return n;
+
+		case CF_TABLE:
+		{
+			branch_target_t *table = iptr->dst.table;
+			s4 i = iptr->sx.s23.s3.tablehigh - iptr->sx.s23.s2.tablelow + 1;
+
+			succ[n++] = (table++)->block;     // default target
+			while (--i >= 0)
+				succ[n++] = (table++)->block;
+			return n;
+		}
+
+		case CF_LOOKUP:
+		{
+			lookup_target_t *lookup = iptr->dst.lookup;
+			s4 i = iptr->sx.s23.s2.lookupcount;
+
+			succ[n++] = iptr->sx.s23.s3.lookupdefault.block;
+			while (--i >= 0)
+				succ[n++] = (lookup++)->target.block;
+			return n;
+		}
+
+		case CF_END:
+			return n;
+		}
+	}
+
+	if (bptr->next != NULL)
+		succ[n++] = bptr->next;
+
+	return n;
+}
+
+
+/* linearscan_intervals ********************************************************
+
+   Creates an interval for every local variable and numbers the
+   instructions of the reachable blocks in code order.  Returns false
+   if the method contains subroutines.
+
+*******************************************************************************/
+
+static bool linearscan_intervals(linearscan_t *ls)
+{
+	jitdata     *jd = ls->jd;
+	methoddesc  *md = jd->m->parseddesc;
+	basicblock  *bptr;
+	lsinterval  *iv;
+	s4           s, t, p, l, varindex;
+
+	ls->intervalof = DMNEW(s4, jd->localcount);
+	ls->intervals  = DMNEW(lsinterval, jd->localcount);
+	ls->count      = 0;
+
+	for (s = 0; s < jd->localcount; s++)
+		ls->intervalof[s] = -1;
+
+	for (s = 0; s < jd->maxlocals; s++) {
+		for (t = 0; t < 5; t++) {
+			varindex = jd->local_map[s * 5 + t];
+
+			if (varindex == jitdata::UNUSED)
+				continue;
+
+			assert(varindex < jd->localcount);
+
+			if (ls->intervalof[varindex] >= 0)
+				continue;
+
+			iv = &ls->intervals[ls->count];
+
+			iv->varindex = varindex;
+			iv->start    = -1;
+			iv->end      = -1;
+			iv->param    = -1;
+			iv->hint     = -1;
+			iv->hintpos  = -1;
+			iv->flt      = IS_FLT_DBL_TYPE(VAR(varindex)->type);
+			iv->crosses  = false;
+			iv->own      = false;
+			iv->reg      = -1;
+
+			ls->intervalof[varindex] = ls->count++;
+		}
+	}
+
+	/* the parameters are defined by the method prolog at position 0 */
+
+	for (p = 0, l = 0; p < md->paramcount; p++) {
+		t = md->paramtypes[p].type;
+
+		varindex = jd->local_map[l * 5 + t];
+
+		l++;
+		if (IS_2_WORD_TYPE(t))
+			l++;
+
+		if (varindex == jitdata::UNUSED)
+			continue;
+
+		iv = &ls->intervals[ls->intervalof[varindex]];
+
+		iv->param = p;
+		iv->start = 0;
+		iv->end   = 0;
+	}
+
+	/* count the positions: the prolog, a label for every block and
+	   the instructions */
+
+	ls->positions = 1;
+
+	for (bptr = jd->basicblocks; bptr != NULL; bptr = bptr->next) {
+		if (bptr->state < basicblock::REACHED)
+			continue;
+
+		for (s = 0; s < bptr->icount; s++) {
+			s4 cf = icmd_table[bptr->iinstr[s].opc].controlflow;
+
+			if ((cf == CF_JSR) || (cf == CF_RET))
+				return false;
+		}
+
+		ls->positions += 1 + bptr->icount;
+	}
+
+	return true;
+}
+
+
+/* linearscan_liveness *********************************************************
+
+   Computes which locals are live at the boundaries of the blocks and
+   extends the intervals over them.  A local live at the start of an
+   exception handler is live in all blocks the handler covers.
+
+*******************************************************************************/
+
+static void linearscan_liveness(linearscan_t *ls)
+{
+	jitdata         *jd = ls->jd;
+	codeinfo        *code = jd->code;
+	basicblock      *bptr;
+	basicblock     **blocks;
+	basicblock     **succ;
+	exception_entry *ex;
+	instruction     *iptr;
+	bitvector       *use, *def, *in, *out;
+	bitvector        tmp;
+	s4              *index;
+	s4              *first, *last;
+	s4               buffer[3];
+	const s4        *operands;
+	s4               count, maxnr, maxsucc;
+	s4               b, i, j, n, pos, v;
+	bool             changed;
+	bool             sync;
+
+	/* number the reachable blocks */
+
+	count   = 0;
+	maxnr   = 0;
+	maxsucc = 1;
+
+	for (bptr = jd->basicblocks; bptr != NULL; bptr = bptr->next) {
+		if (bptr->nr > maxnr)
+			maxnr = bptr->nr;
+
+		if (bptr->state < basicblock::REACHED)
+			continue;
+
+		count++;
+
+		if (bptr->icount > 0) {
+			iptr = bptr->iinstr + bptr->icount - 1;
+
+			if (icmd_table[iptr->opc].controlflow == CF_TABLE)
+				n = iptr->sx.s23.s3.tablehigh - iptr->sx.s23.s2.tablelow + 2;
+			else if (icmd_table[iptr->opc].controlflow == CF_LOOKUP)
+				n = iptr->sx.s23.s2.lookupcount + 1;
+			else
+				n = 2;
+
+			if (n > maxsucc)
+				maxsucc = n;
+		}
+	}
+
+	blocks = DMNEW(basicblock*, count);
+	succ   = DMNEW(basicblock*, maxsucc);
+	index  = DMNEW(s4, maxnr + 1);
+	first  = DMNEW(s4, count);
+	last   = DMNEW(s4, count);
+	use    = DMNEW(bitvector, count);
+	def    = DMNEW(bitvector, count);
+	in     = DMNEW(bitvector, count);
+	out    = DMNEW(bitvector, count);
+	tmp    = bv_new(ls->count);
+
+	ls->calls = DMNEW(s4, ls->positions);
+	MZERO(ls->calls, s4, ls->positions);
+
+	for (i = 0; i <= maxnr; i++)
+		index[i] = -1;
+
+	sync = checksync && code_is_synchronized(code);
+
+	/* the monitor is entered after the prolog has moved the parameters */
+
+	if (sync)
+		ls->calls[0] = 1;
+
+	/* walk the code, record the uses and definitions of the locals */
+
+	pos = 0;
+	b   = 0;
+
+	for (bptr = jd->basicblocks; bptr != NULL; bptr = bptr->next) {
+		if (bptr->state < basicblock::REACHED)
+			continue;
+
+		blocks[b]       = bptr;
+		index[bptr->nr] = b;
+		use[b]          = bv_new(ls->count);
+		def[b]          = bv_new(ls->count);
+		in[b]           = bv_new(ls->count);
+		out[b]          = bv_new(ls->count);
+		first[b]        = ++pos;
+
+		for (iptr = bptr->iinstr, i = bptr->icount; --i >= 0; iptr++) {
+			lsinterval *iv;
+
+			pos++;
+
+			n = linearscan_operands(iptr, buffer, &operands);
+
+			for (j = 0; j < n; j++) {
+				if ((v = linearscan_local(ls, operands[j])) < 0)
+					continue;
+
+				iv = &ls->intervals[v];
+
+				if (iv->start < 0)
+					iv->start = pos;
+				iv->end = pos;
+
+				if (!bv_get_bit(def[b], v))
+					bv_set_bit(use[b], v);
+			}
+
+			if ((v = linearscan_local(ls, linearscan_result(iptr))) >= 0) {
+				iv = &ls->intervals[v];
+
+				if (iv->start < 0)
+					iv->start = pos;
+				iv->end = pos;
+
+				bv_set_bit(def[b], v);
+
+				/* remember copies from other locals for coalescing */
+
+				if ((iv->hint < 0) && ((icmd_table[iptr->opc].dataflow == DF_COPY) ||
+									   (icmd_table[iptr->opc].dataflow == DF_MOVE)))
+				{
+					s4 h = linearscan_local(ls, iptr->s1.varindex);
+
+					if ((h >= 0) && (h != v)) {
+						iv->hint    = h;
+						iv->hintpos = pos;
+					}
+				}
+			}
+
+			if (linearscan_is_call(iptr))
+				ls->calls[pos] = 1;
+
+			/* the monitor is exited before returning */
+
+			if (sync && (icmd_table[iptr->opc].controlflow == CF_END) &&
+				(iptr->opc != ICMD_ATHROW))
+				ls->calls[pos] = 1;
+		}
+
+		last[b] = pos;
+		b++;
+	}
+
+	assert(pos + 1 == ls->positions);
+
+	/* solve the dataflow equations backwards */
+
+	do {
+		changed = false;
+
+		for (b = count - 1; b >= 0; b--) {
+			bptr = blocks[b];
+
+			n = linearscan_successors(bptr, succ);
+
+			bv_reset(tmp, ls->count);
+
+			for (i = 0; i < n; i++) {
+				j = (succ[i]->nr <= maxnr) ? index[succ[i]->nr] : -1;
+
+				if (j >= 0)
+					bv_union(tmp, tmp, in[j], ls->count);
+			}
+
+			bv_union(out[b], out[b], tmp, ls->count);
+
+			bv_minus(tmp, out[b], def[b], ls->count);
+			bv_union(tmp, tmp, use[b], ls->count);
+			bv_union(tmp, tmp, in[b], ls->count);
+
+			if (!bv_equal(tmp, in[b], ls->count)) {
+				bv_copy(in[b], tmp, ls->count);
+				changed = true;
+			}
+		}
+
+		for (ex = jd->exceptiontable; ex != NULL; ex = ex->down) {
+			j = index[ex->handler->nr];
+
+			if (j < 0)
+				continue;
+
+			for (bptr = ex->start; (bptr != NULL) && (bptr != ex->end); bptr = bptr->next) {
+				b = index[bptr->nr];
+
+				if (b < 0)
+					continue;
+
+				bv_union(tmp, in[b], in[j], ls->count);
+
+				if (!bv_equal(tmp, in[b], ls->count)) {
+					bv_copy(in[b], tmp, ls->count);
+					changed = true;
+				}
+
+				bv_union(out[b], out[b], in[j], ls->count);
+			}
+		}
+	} while (changed);
+
+	/* extend the intervals over the blocks they are live in */
+
+	for (b = 0; b < count; b++) {
+		for (v = 0; v < ls->count; v++) {
+			lsinterval *iv = &ls->intervals[v];
+
+			if (bv_get_bit(in[b], v)) {
+				if ((iv->start < 0) || (first[b] < iv->start))
+					iv->start = first[b];
+				if (first[b] > iv->end)
+					iv->end = first[b];
+			}
+
+			if (bv_get_bit(out[b], v)) {
+				if ((iv->start < 0) || (last[b] < iv->start))
+					iv->start = last[b];
+				if (last[b] > iv->end)
+					iv->end = last[b];
+			}
+		}
+	}
+
+	/* count the calls up to every position */
+
+	for (pos = 1; pos < ls->positions; pos++)
+		ls->calls[pos] += ls->calls[pos - 1];
+
+	for (v = 0; v < ls->count; v++) {
+		lsinterval *iv = &ls->intervals[v];
+
+		if (iv->start < 0)
+			continue;
+
+		n = ls->calls[iv->end];
+		if (iv->start > 0)
+			n -= ls->calls[iv->start - 1];
+
+		iv->crosses = (n > 0);
+	}
+}
+
+
+/* linearscan_registers ********************************************************
+
+   Collects the registers the temporaries and interface variables have
+   left, in the order they are preferred: caller saved registers first,
+   then callee saved registers, which have to be saved by the prolog.
+
+*******************************************************************************/
+
+static void linearscan_add_register(linearscan_t *ls, s4 c, s4 regoff, s4 kind, s4 index)
+{
+	lsregister *r = &ls->regs[c][ls->regcount[c]++];
+
+	r->regoff = regoff;
+	r->kind   = kind;
+	r->index  = index;
+	r->param  = -1;
+	r->owner  = -1;
+	r->used   = false;
+}
+
+static void linearscan_registers(linearscan_t *ls)
+{
+	jitdata      *jd = ls->jd;
+	registerdata *rd = jd->rd;
+	methoddesc   *md = jd->m->parseddesc;
+	s4            i, p, c;
+
+	ls->regs[0]     = DMNEW(lsregister, INT_REG_CNT);
+	ls->regs[1]     = DMNEW(lsregister, FLT_REG_CNT);
+	ls->regcount[0] = 0;
+	ls->regcount[1] = 0;
+
+	for (i = rd->tmpintreguse - 1; i >= 0; i--)
+		linearscan_add_register(ls, 0, rd->tmpintregs[i], LINEARSCAN_TMP, i);
+	for (i = rd->argintreguse; i < INT_ARG_CNT; i++)
+		linearscan_add_register(ls, 0, abi_registers_integer_argument[i], LINEARSCAN_ARG, i);
+	for (i = rd->savintreguse - 1; i >= 0; i--)
+		linearscan_add_register(ls, 0, rd->savintregs[i], LINEARSCAN_SAV, i);
+
+	for (i = rd->tmpfltreguse - 1; i >= 0; i--)
+		linearscan_add_register(ls, 1, rd->tmpfltregs[i], LINEARSCAN_TMP, i);
+	for (i = rd->argfltreguse; i < FLT_ARG_CNT; i++)
+		linearscan_add_register(ls, 1, abi_registers_float_argument[i], LINEARSCAN_ARG, i);
+	for (i = rd->savfltreguse - 1; i >= 0; i--)
+		linearscan_add_register(ls, 1, rd->savfltregs[i], LINEARSCAN_SAV, i);
+
+	/* mark the registers the parameters are passed in */
+
+	for (p = 0; p < md->paramcount; p++) {
+		if (md->params[p].inmemory)
+			continue;
+
+		c = IS_FLT_DBL_TYPE(md->paramtypes[p].type) ? 1 : 0;
+
+		for (i = 0; i < ls->regcount[c]; i++)
+			if (ls->regs[c][i].regoff == (s4) md->params[p].regoff)
+				ls->regs[c][i].param = p;
+	}
+}
+
+
+/* linearscan_allowed **********************************************************
+
+   Returns true if the interval may be held in the register.  Intervals
+   containing a call need a callee saved register, and a parameter must
+   not be moved into the register of another parameter, which the prolog
+   may not have read yet.
+
+*******************************************************************************/
+
+static bool linearscan_allowed(lsinterval *iv, lsregister *r)
+{
+	if (iv->crosses && (r->kind != LINEARSCAN_SAV))
+		return false;
+
+	if ((iv->param >= 0) && (r->param >= 0) && (r->param != iv->param))
+		return false;
+
+	return true;
+}
+
+
+/* linearscan_expire ***********************************************************
+
+   Frees the register of an active interval.
+
+*******************************************************************************/
+
+static void linearscan_expire(linearscan_t *ls, s4 a)
+{
+	lsinterval *iv = &ls->intervals[ls->active[a]];
+
+	ls->regs[iv->flt ? 1 : 0][iv->reg].owner = -1;
+	ls->active[a] = ls->active[--ls->activecount];
+}
+
+
+/* linearscan_choose ***********************************************************
+
+   Returns a free register for the interval, or -1.
+
+*******************************************************************************/
+
+static s4 linearscan_choose(linearscan_t *ls, lsinterval *iv)
+{
+	lsregister *regs = ls->regs[iv->flt ? 1 : 0];
+	s4          n    = ls->regcount[iv->flt ? 1 : 0];
+	s4          i, a;
+
+	/* take the register of the local this one is copied from, if the
+	   copy is its last use */
+
+	if (iv->hint >= 0) {
+		lsinterval *h = &ls->intervals[iv->hint];
+
+		if ((h->reg >= 0) && linearscan_allowed(iv, &regs[h->reg])) {
+			if ((regs[h->reg].owner == iv->hint) &&
+				(h->end == iv->hintpos) && (iv->start == iv->hintpos))
+			{
+				for (a = 0; a < ls->activecount; a++)
+					if (ls->active[a] == iv->hint)
+						break;
+
+				assert(a < ls->activecount);
+
+				linearscan_expire(ls, a);
+				ls->coalesced++;
+
+				return h->reg;
+			}
+
+			if (regs[h->reg].owner < 0)
+				return h->reg;
+		}
+	}
+
+	/* parameters stay in their registers if possible */
+
+	if (iv->param >= 0) {
+		for (i = 0; i < n; i++)
+			if ((regs[i].param == iv->param) && (regs[i].owner < 0) &&
+				linearscan_allowed(iv, &regs[i]))
+				return i;
+	}
+
+	for (i = 0; i < n; i++)
+		if ((regs[i].owner < 0) && linearscan_allowed(iv, &regs[i]))
+			return i;
+
+	return -1;
+}
+
+
+/* linearscan_spill ************************************************************
+
+   Takes the register of the active interval ending last, if it ends
+   after the given interval, and spills that one.  Returns the register
+   or -1 if the given interval is to be spilled.
+
+*******************************************************************************/
+
+static s4 linearscan_spill(linearscan_t *ls, lsinterval *iv)
+{
+	lsregister *regs = ls->regs[iv->flt ? 1 : 0];
+	lsinterval *victim;
+	s4          a, best, reg;
+
+	best = -1;
+
+	for (a = 0; a < ls->activecount; a++) {
+		lsinterval *other = &ls->intervals[ls->active[a]];
+
+		if ((other->flt != iv->flt) || !linearscan_allowed(iv, &regs[other->reg]))
+			continue;
+
+		if ((best < 0) || (other->end > ls->intervals[ls->active[best]].end))
+			best = a;
+	}
+
+	if (best < 0)
+		return -1;
+
+	victim = &ls->intervals[ls->active[best]];
+
+	if (victim->end <= iv->end)
+		return -1;
+
+	reg = victim->reg;
+
+	linearscan_expire(ls, best);
+	victim->reg = -1;
+
+	return reg;
+}
+
+
+/* linearscan_compare **********************************************************
+
+   Orders intervals by their start, and by their end for equal starts.
+
+*******************************************************************************/
+
+struct linearscan_compare {
+	lsinterval *intervals;
+
+	linearscan_compare(lsinterval *intervals) : intervals(intervals) {}
+
+	bool operator()(s4 a, s4 b) const
+	{
+		if (intervals[a].start != intervals[b].start)
+			return intervals[a].start < intervals[b].start;
+
+		return intervals[a].end < intervals[b].end;
+	}
+};
+
+
+/* linearscan_scan *************************************************************
+
+   Assigns registers to the intervals in the order of their starts.
+
+*******************************************************************************/
+
+static void linearscan_scan(linearscan_t *ls)
+{
+	jitdata    *jd = ls->jd;
+	methoddesc *md = jd->m->parseddesc;
+	s4         *order;
+	s4          count, i, a, reg;
+
+	order = DMNEW(s4, ls->count);
+	count = 0;
+
+	for (i = 0; i < ls->count; i++) {
+		lsinterval *iv = &ls->intervals[i];
+
+		if (iv->start < 0)
+			continue;
+
+		/* leaf methods reserve the parameter registers, see
+		   simplereg_allocate_interfaces */
+
+		if (code_is_leafmethod(jd->code) && (iv->param >= 0) &&
+			!md->params[iv->param].inmemory && !iv->crosses)
+		{
+			iv->own = true;
+			continue;
+		}
+
+		order[count++] = i;
+	}
+
+	std::sort(order, order + count, linearscan_compare(ls->intervals));
+
+	ls->active      = DMNEW(s4, ls->count);
+	ls->activecount = 0;
+
+	for (i = 0; i < count; i++) {
+		lsinterval *iv = &ls->intervals[order[i]];
+
+		for (a = 0; a < ls->activecount; a++) {
+			if (ls->intervals[ls->active[a]].end < iv->start)
+				linearscan_expire(ls, a--);
+		}
+
+		reg = linearscan_choose(ls, iv);
+
+		if (reg < 0)
+			reg = linearscan_spill(ls, iv);
+
+		if (reg < 0)
+			continue;
+
+		lsregister *r = &ls->regs[iv->flt ? 1 : 0][reg];
+
+		if (r->used)
+			ls->shared++;
+
+		r->owner = order[i];
+		r->used  = true;
+		iv->reg  = reg;
+
+		ls->active[ls->activecount++] = order[i];
+	}
+}
+
+
+/* linearscan_assign ***********************************************************
+
+   Stores the registers in the variables and gives the spilled ones
+   stack slots, shared by intervals which do not overlap.
+
+*******************************************************************************/
+
+static void linearscan_assign(linearscan_t *ls)
+{
+	jitdata      *jd = ls->jd;
+	registerdata *rd = jd->rd;
+	methoddesc   *md = jd->m->parseddesc;
+	s4           *spilled;
+	s4           *slotoff;
+	s4           *slotend;
+	s4            spillcount, slotcount, deadslot;
+	s4            i, j;
+
+	spilled    = DMNEW(s4, ls->count);
+	spillcount = 0;
+	deadslot   = -1;
+
+	for (i = 0; i < ls->count; i++) {
+		lsinterval *iv = &ls->intervals[i];
+		varinfo    *v  = VAR(iv->varindex);
+
+		if (iv->own) {
+			v->flags     = 0;
+			v->vv.regoff = md->params[iv->param].regoff;
+		}
+		else if (iv->reg >= 0) {
+			lsregister *r = &ls->regs[iv->flt ? 1 : 0][iv->reg];
+
+			v->flags     = 0;
+			v->vv.regoff = r->regoff;
+
+			switch (r->kind) {
+			case LINEARSCAN_TMP:
+				if (iv->flt)
+					rd->tmpfltreguse = MIN(rd->tmpfltreguse, r->index);
+				else
+					rd->tmpintreguse = MIN(rd->tmpintreguse, r->index);
+				break;
+
+			case LINEARSCAN_ARG:
+				if (iv->flt)
+					rd->argfltreguse = MAX(rd->argfltreguse, r->index + 1);
+				else
+					rd->argintreguse = MAX(rd->argintreguse, r->index + 1);
+				break;
+
+			case LINEARSCAN_SAV:
+				if (iv->flt)
+					rd->savfltreguse = MIN(rd->savfltreguse, r->index);
+				else
+					rd->savintreguse = MIN(rd->savintreguse, r->index);
+				break;
+			}
+
+			if (!code_is_leafmethod(jd->code) && (r->kind != LINEARSCAN_SAV))
+				ls->callersaved++;
+		}
+		else if (iv->start < 0) {
+			/* only used in unreachable code */
+
+			if (deadslot < 0) {
+				deadslot = rd->memuse * SIZE_OF_STACKSLOT;
+				rd->memuse++;
+			}
+
+			v->flags     = INMEMORY;
+			v->vv.regoff = deadslot;
+		}
+		else if ((iv->param >= 0) && md->params[iv->param].inmemory) {
+			/* the prolog uses the stack slot of the caller */
+
+			v->flags     = INMEMORY;
+			v->vv.regoff = 0;
+		}
+		else
+			spilled[spillcount++] = i;
+	}
+
+	/* the spilled intervals are sorted by their starts, so the first
+	   slot free at the start of one is free for all of it */
+
+	std::sort(spilled, spilled + spillcount, linearscan_compare(ls->intervals));
+
+	slotoff   = DMNEW(s4, spillcount);
+	slotend   = DMNEW(s4, spillcount);
+	slotcount = 0;
+
+	for (i = 0; i < spillcount; i++) {
+		lsinterval *iv = &ls->intervals[spilled[i]];
+		varinfo    *v  = VAR(iv->varindex);
+
+		for (j = 0; j < slotcount; j++)
+			if (slotend[j] < iv->start)
+				break;
+
+		if (j < slotcount)
+			ls->shared++;
+		else {
+			slotoff[slotcount++] = rd->memuse * SIZE_OF_STACKSLOT;
+			rd->memuse++;
+		}
+
+		slotend[j] = iv->end;
+
+		v->flags     = INMEMORY;
+		v->vv.regoff = slotoff[j];
+	}
+}
+
+
+/* linearscan_allocate_locals **************************************************
+
+   Allocates registers and stack slots for the local variables, after
+   the temporaries and interface variables have been allocated.
+   Returns false if the method is left to the simple allocator.
+
+*******************************************************************************/
+
+bool linearscan_allocate_locals(jitdata *jd)
+{
+	linearscan_t ls;
+
+#if !defined(NDEBUG)
+	if (opt_RegallocSpillAll || JITDATA_HAS_FLAG_VERBOSECALL(jd))
+		return false;
+#endif
+
+	/* the profiling code is emitted around calls and returns */
+
+	if (JITDATA_HAS_FLAG_INSTRUMENT(jd))
+		return false;
+
+#if defined(ENABLE_GC_CACAO)
+	/* the exact collector reads dead references from shared slots */
+
+	return false;
+#endif
+
+	ls.jd          = jd;
+	ls.coalesced   = 0;
+	ls.shared      = 0;
+	ls.callersaved = 0;
+
+	if (!linearscan_intervals(&ls))
+		return false;
+
+	linearscan_liveness(&ls);
+	linearscan_registers(&ls);
+	linearscan_scan(&ls);
+	linearscan_assign(&ls);
+
+	STATISTICS(count_linearscan_methods++);
+	STATISTICS(count_linearscan_coalesced += ls.coalesced);
+	STATISTICS(count_linearscan_shared += ls.shared);
+	STATISTICS(count_linearscan_callersaved += ls.callersaved);
+
+	return true;
+}
+
+#else /* SUPPORT_LINEARSCAN */
+
+bool linearscan_allocate_locals(jitdata *)
+{
+	return false;
+}
+
+#endif /* SUPPORT_LINEARSCAN */
+
+
+/*
+ * These are local overrides for various environment variables in Emacs.
+ * Please do not remove this and leave it at the end of the file, where
+ * Emacs will automagically detect them.
+ * ---------------------------------------------------------------------
+ * Local variables:
+ * mode: c++
+ * indent-tabs-mode: t
+ * c-basic-offset: 4
+ * tab-width: 4
+ * End:
+ */
@@ -27,6 +27,7 @@
 #include "config.h"
 
 #include <cassert>
+#include <ctime>
 #include <stdint.h>
 
 #include "vm/types.hpp"
@@ -43,6 +44,7 @@
 #include "vm/options.hpp"
 #include "vm/resolve.hpp"
 
+#include "vm/jit/allocator/linearscan.hpp"
 #include "vm/jit/allocator/simplereg.hpp"
 #include "vm/jit/abi.hpp"
 #include "vm/jit/builtin.hpp"
@@ -67,12 +69,20 @@ STAT_DECLARE_VAR(int,count_argument_reg_ss,0)
 // currently not used!
 STAT_DECLARE_VAR(int,count_argument_mem_ss,0)
 STAT_REGISTER_VAR(int,count_method_in_register,0,"methods in register","Number of Methods kept in registers")
+STAT_REGISTER_VAR(int,count_compared_locals,0,"compared locals","locals allocated by both simplereg and linear scan")
+STAT_REGISTER_VAR(int,count_compared_simplereg_spilled,0,"simplereg spilled locals","compared locals simplereg puts in memory")
+STAT_REGISTER_VAR(int,count_compared_linearscan_spilled,0,"linear scan spilled locals","compared locals linear scan puts in memory")
+STAT_REGISTER_VAR(u8,count_compared_simplereg_nanos,0,"simplereg nanos","nanoseconds simplereg spends on the compared locals")
+STAT_REGISTER_VAR(u8,count_compared_linearscan_nanos,0,"linear scan nanos","nanoseconds linear scan spends on the compared locals")
 
 /* function prototypes for this file ******************************************/
 
 static void simplereg_allocate_interfaces(jitdata *jd);
 static void simplereg_allocate_locals(jitdata *jd);
 static void simplereg_allocate_temporaries(jitdata *jd);
+#if SUPPORT_LINEARSCAN
+static bool simplereg_linearscan_locals(jitdata *jd);
+#endif
 
 
 /* size of a stackslot used by the internal ABI */
@@ -271,7 +281,14 @@ bool regalloc(jitdata *jd)
 
 	simplereg_allocate_interfaces(jd);
 	simplereg_allocate_temporaries(jd);
-	simplereg_allocate_locals(jd);
+
+#if SUPPORT_LINEARSCAN
+	/* locals get the registers left by the temporaries, shared by
+	   locals whose live ranges do not overlap */
+
+	if (!opt_LinearScan || !simplereg_linearscan_locals(jd))
+#endif
+		simplereg_allocate_locals(jd);
 
 	/* everthing's ok */
 
@@ -733,6 +750,85 @@ static void simplereg_allocate_locals(jitdata *jd)
 }
 
 
+#if SUPPORT_LINEARSCAN
+
+#if defined(ENABLE_STATISTICS)
+static int64_t simplereg_nanotime(void)
+{
+	struct timespec ts;
+
+	if (clock_gettime(CLOCK_MONOTONIC, &ts) != 0)
+		return 0;
+
+	return (int64_t) ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+
+static int simplereg_count_spilled_locals(jitdata *jd)
+{
+	int count = 0;
+
+	for (int i = 0; i < jd->localcount; i++)
+		if (jd->var[i].flags & INMEMORY)
+			count++;
+
+	return count;
+}
+#endif
+
+
+/* simplereg_linearscan_locals *************************************************
+
+   Allocates the local variables by linear scan, see
+   linearscan_allocate_locals.  With statistics the locals are first
+   allocated by simplereg_allocate_locals, which is undone again, to
+   compare the spilled locals and the time taken by both allocators.
+
+*******************************************************************************/
+
+static bool simplereg_linearscan_locals(jitdata *jd)
+{
+#if defined(ENABLE_STATISTICS)
+	registerdata *rd = jd->rd;
+
+	/* the simple allocation only changes the locals and the register
+	   counts of rd */
+
+	registerdata  saverd    = *rd;
+	varinfo      *savelocals = DMNEW(varinfo, jd->localcount);
+
+	MCOPY(savelocals, jd->var, varinfo, jd->localcount);
+
+	int64_t start = simplereg_nanotime();
+
+	simplereg_allocate_locals(jd);
+
+	int64_t simplenanos  = simplereg_nanotime() - start;
+	int     simplespills = simplereg_count_spilled_locals(jd);
+
+	MCOPY(jd->var, savelocals, varinfo, jd->localcount);
+	*rd = saverd;
+
+	start = simplereg_nanotime();
+
+	if (!linearscan_allocate_locals(jd))
+		return false;
+
+	count_compared_locals             += jd->localcount;
+	count_compared_simplereg_spilled  += simplespills;
+	count_compared_linearscan_spilled += simplereg_count_spilled_locals(jd);
+	count_compared_simplereg_nanos    += simplenanos;
+	count_compared_linearscan_nanos   += simplereg_nanotime() - start;
+
+	return true;
+#else
+	return linearscan_allocate_locals(jd);
+#endif
+}
+
+#endif /* SUPPORT_LINEARSCAN */
+
+
 static void simplereg_init(jitdata *jd, registerdata *rd)
 {
 	int i;
@@ -1274,6 +1370,7 @@ static void simplereg_allocate_temporaries(jitdata *jd)
 
 				case ICMD_IFNULL:
 				case ICMD_IFNONNULL:
+				case ICMD_IF_CLASSNE:
 
 				case ICMD_IFEQ:
 				case ICMD_IFNE:
@@ -1597,7 +1694,7 @@ void simplereg_make_statistics(jitdata *jd)
 			if (bptr->state >= basicblock::REACHED) {
 
 #if defined(ENABLE_LSRA) || defined(ENABLE_SSA)
-			if (!opt_lsra) {
+			if (jd->ls == NULL) {
 #endif
 				/* check for memory moves from interface to BB instack */
 				len = bptr->indepth;
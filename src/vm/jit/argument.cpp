@@ -212,7 +212,7 @@ void argument_jitreturn_store(methoddesc *md, uint64_t *return_regs, imm_union r
 
 *******************************************************************************/
 
-static void argument_vmarray_store_int(uint64_t *array, paramdesc *pd, int32_t value)
+void argument_vmarray_store_int(uint64_t *array, paramdesc *pd, int32_t value)
 {
 	int32_t index;
 
@@ -242,7 +242,7 @@ static void argument_vmarray_store_int(uint64_t *array, paramdesc *pd, int32_t v
 
 *******************************************************************************/
 
-static void argument_vmarray_store_lng(uint64_t *array, paramdesc *pd, int64_t value)
+void argument_vmarray_store_lng(uint64_t *array, paramdesc *pd, int64_t value)
 {
 	int32_t index;
 
@@ -278,7 +278,7 @@ static void argument_vmarray_store_lng(uint64_t *array, paramdesc *pd, int64_t v
 
 *******************************************************************************/
 
-static void argument_vmarray_store_flt(uint64_t *array, paramdesc *pd, uint64_t value)
+void argument_vmarray_store_flt(uint64_t *array, paramdesc *pd, uint64_t value)
 {
 	int32_t index;
 
@@ -312,7 +312,7 @@ static void argument_vmarray_store_flt(uint64_t *array, paramdesc *pd, uint64_t
 
 *******************************************************************************/
 
-static void argument_vmarray_store_dbl(uint64_t *array, paramdesc *pd, uint64_t value)
+void argument_vmarray_store_dbl(uint64_t *array, paramdesc *pd, uint64_t value)
 {
 	int32_t index;
 
@@ -344,7 +344,7 @@ static void argument_vmarray_store_dbl(uint64_t *array, paramdesc *pd, uint64_t
 
 *******************************************************************************/
 
-static void argument_vmarray_store_adr(uint64_t *array, paramdesc *pd, java_handle_t *h)
+void argument_vmarray_store_adr(uint64_t *array, paramdesc *pd, java_handle_t *h)
 {
 	void    *value;
 	int32_t  index;
@@ -599,144 +599,39 @@ uint64_t *argument_vmarray_from_objectarray(methodinfo *m, java_handle_t *o,
 
 		switch (td->type) {
 		case TYPE_INT:
+		case TYPE_LNG:
+		case TYPE_FLT:
+		case TYPE_DBL:
 			if (param == NULL)
 				return NULL;
 
 			/* convert the value according to its declared type */
 
-			LLNI_class_get(param, c);
-			type = Primitive::get_type_by_wrapperclass(c);
-
-			switch (td->primitivetype) {
-			case PRIMITIVETYPE_BOOLEAN:
-				switch (type) {
-				case PRIMITIVETYPE_BOOLEAN:
-					/* This type is OK. */
-					break;
-				default:
-					return NULL;
-				}
-				break;
-
-			case PRIMITIVETYPE_BYTE:
-				switch (type) {
-				case PRIMITIVETYPE_BYTE:
-					/* This type is OK. */
-					break;
-				default:
-					return NULL;
-				}
-				break;
-
-			case PRIMITIVETYPE_CHAR:
-				switch (type) {
-				case PRIMITIVETYPE_CHAR:
-					/* This type is OK. */
-					break;
-				default:
-					return NULL;
-				}
-				break;
-
-			case PRIMITIVETYPE_SHORT:
-				switch (type) {
-				case PRIMITIVETYPE_BYTE:
-				case PRIMITIVETYPE_SHORT:
-					/* These types are OK. */
-					break;
-				default:
-					return NULL;
-				}
-				break;
-
-			case PRIMITIVETYPE_INT:
-				switch (type) {
-				case PRIMITIVETYPE_BYTE:
-				case PRIMITIVETYPE_SHORT:
-				case PRIMITIVETYPE_INT:
-					/* These types are OK. */
-					break;
-				default:
-					return NULL;
-				}
-				break;
-
-			default:
-				os::abort("argument_vmarray_from_objectarray: invalid type %d",
-						 td->primitivetype);
-			}
+			type = Primitive::get_type_by_wrapper(param);
 
 			value = Primitive::unbox(param);
-			argument_vmarray_store_int(array, pd, value.i);
-			break;
 
-		case TYPE_LNG:
-			if (param == NULL)
+			if (!Primitive::widen(type, td->primitivetype, &value))
 				return NULL;
 
-			LLNI_class_get(param, c);
-			type = Primitive::get_type_by_wrapperclass(c);
-
-			assert(td->primitivetype == PRIMITIVETYPE_LONG);
-
-			switch (type) {
-			case PRIMITIVETYPE_BYTE:
-			case PRIMITIVETYPE_SHORT:
-			case PRIMITIVETYPE_INT:
-			case PRIMITIVETYPE_LONG:
-				/* These types are OK. */
+			switch (td->type) {
+			case TYPE_INT:
+				argument_vmarray_store_int(array, pd, value.i);
 				break;
-			default:
-				return NULL;
-			}
-
-			value = Primitive::unbox(param);
-			argument_vmarray_store_lng(array, pd, value.l);
-			break;
-
-		case TYPE_FLT:
-			if (param == NULL)
-				return NULL;
-
-			LLNI_class_get(param, c);
-			type = Primitive::get_type_by_wrapperclass(c);
-
-			assert(td->primitivetype == PRIMITIVETYPE_FLOAT);
-
-			switch (type) {
-			case PRIMITIVETYPE_FLOAT:
-				/* This type is OK. */
+			case TYPE_LNG:
+				argument_vmarray_store_lng(array, pd, value.l);
 				break;
-			default:
-				return NULL;
-			}
-
-			value = Primitive::unbox(param);
-			argument_vmarray_store_flt(array, pd, value.l);
-			break;
-
-		case TYPE_DBL:
-			if (param == NULL)
-				return NULL;
-
-			LLNI_class_get(param, c);
-			type = Primitive::get_type_by_wrapperclass(c);
-
-			assert(td->primitivetype == PRIMITIVETYPE_DOUBLE);
-
-			switch (type) {
-			case PRIMITIVETYPE_FLOAT:
-			case PRIMITIVETYPE_DOUBLE:
-				/* These types are OK. */
+			case TYPE_FLT:
+				argument_vmarray_store_flt(array, pd, value.l);
+				break;
+			case TYPE_DBL:
+				argument_vmarray_store_dbl(array, pd, value.l);
 				break;
 			default:
-				return NULL;
+				break;
 			}
-
-			value = Primitive::unbox(param);
-			argument_vmarray_store_dbl(array, pd, value.l);
 			break;
-		
+
 		case TYPE_ADR:
 			if (!resolve_class_from_typedesc(td, true, true, &c))
 				return NULL;
@@ -33,6 +33,8 @@
 #include "vm/global.hpp"
 #include "vm/method.hpp"
 
+struct paramdesc;
+
 
 /* function prototypes ********************************************************/
 
@@ -46,6 +48,17 @@ imm_union argument_jitreturn_load(methoddesc *md, uint64_t *return_regs);
 void      argument_jitreturn_store(methoddesc *md, uint64_t *return_regs,
 								   imm_union ret);
 
+void      argument_vmarray_store_int(uint64_t *array, paramdesc *pd,
+									 int32_t value);
+void      argument_vmarray_store_lng(uint64_t *array, paramdesc *pd,
+									 int64_t value);
+void      argument_vmarray_store_flt(uint64_t *array, paramdesc *pd,
+									 uint64_t value);
+void      argument_vmarray_store_dbl(uint64_t *array, paramdesc *pd,
+									 uint64_t value);
+void      argument_vmarray_store_adr(uint64_t *array, paramdesc *pd,
+									 java_handle_t *h);
+
 uint64_t *argument_vmarray_from_valist(methodinfo *m, java_handle_t *o,
 									   va_list ap);
 uint64_t *argument_vmarray_from_jvalue(methodinfo *m, java_handle_t *o,
@@ -39,12 +39,13 @@
 #include <stdint.h>                     // for uint32_t
 #include <sys/time.h>                   // for timeval, gettimeofday
 
-//#include "arch.hpp"
+#include "arch.hpp"                     // for CAS_PROVIDES_FULL_BARRIER
 //#include "md-abi.hpp"
 
 #include "mm/dumpmemory.hpp"            // for DumpMemoryArea
 #include "mm/gc.hpp"                    // for heap_alloc
 
+#include "threads/atomic.hpp"           // for compare_and_swap, etc
 #include "threads/lockword.hpp"         // for Lockword
 //#include "threads/lock.hpp"
 //#include "threads/mutex.hpp"
@@ -64,6 +65,7 @@
 #include "vm/options.hpp"               // for initverbose, etc
 #include "vm/references.hpp"            // for constant_FMIref
 #include "vm/rt-timing.hpp"
+#include "vm/statistics.hpp"
 #include "vm/types.hpp"                 // for s4, s8, u1, u4
 #include "vm/vftbl.hpp"                 // for vftbl_t
 #include "vm/vm.hpp"                    // for vm_abort
@@ -98,6 +100,17 @@ using namespace cacao;
 CYCLES_STATS_DECLARE(builtin_new         ,100,5)
 CYCLES_STATS_DECLARE(builtin_overhead    , 80,1)
 
+// The reference bytes include the vftbl pointer of every object and
+// are the bytes 32-bit compressed references would halve.
+
+STAT_REGISTER_GROUP(heap_stat,"heap","heap allocations")
+STAT_REGISTER_GROUP_VAR(u8,count_heap_objects,0,"objects","objects allocated",heap_stat)
+STAT_REGISTER_GROUP_VAR(u8,size_heap_objects,0,"object bytes","bytes allocated for objects",heap_stat)
+STAT_REGISTER_GROUP_VAR(u8,size_heap_object_refs,0,"object reference bytes","bytes of objects holding references",heap_stat)
+STAT_REGISTER_GROUP_VAR_EXTERN(u8,count_heap_arrays,0,"arrays","arrays allocated",heap_stat)
+STAT_REGISTER_GROUP_VAR_EXTERN(u8,size_heap_arrays,0,"array bytes","bytes allocated for arrays",heap_stat)
+STAT_REGISTER_GROUP_VAR_EXTERN(u8,size_heap_array_refs,0,"array reference bytes","bytes of arrays holding references",heap_stat)
+
 
 /*============================================================================*/
 /* BUILTIN TABLE MANAGEMENT FUNCTIONS                                         */
@@ -189,10 +202,19 @@ static bool builtintable_init(void)
 	}
 
 	for (builtintable_entry *bte = builtintable_function; bte->fp != NULL; bte++) {
-		bte->md =
-			descpool.parse_method_descriptor(bte->descriptor,
-											 ACC_STATIC | ACC_METHOD_BUILTIN,
-											 NULL);
+		/* builtins replacing instance methods get the receiver as
+		   first argument */
+
+		if (bte->flags & BUILTINTABLE_FLAG_RECEIVER)
+			bte->md =
+				descpool.parse_method_descriptor(bte->descriptor,
+												 ACC_METHOD_BUILTIN,
+												 descpool.lookup_classref(utf8::java_lang_Object));
+		else
+			bte->md =
+				descpool.parse_method_descriptor(bte->descriptor,
+												 ACC_STATIC | ACC_METHOD_BUILTIN,
+												 NULL);
 
 		/* generate a builtin stub if we need one */
 
@@ -325,7 +347,9 @@ builtintable_entry *builtintable_get_automatic(s4 opcode)
 
 /* builtintable_replace_function ***********************************************
 
-   XXX
+   Replaces a call of a method listed in the function table by a call
+   of the builtin function.  Instance methods are only replaced if the
+   receiver class is final, so the call cannot be overridden.
 
 *******************************************************************************/
 
@@ -352,6 +376,16 @@ bool builtintable_replace_function(void *iptr_)
 		mr = iptr->sx.s23.s3.fmiref;
 		break;	
 
+	case ICMD_INVOKEVIRTUAL:
+		if (INSTRUCTION_IS_UNRESOLVED(iptr))
+			return false;
+
+		mr = iptr->sx.s23.s3.fmiref;
+
+		if (!(mr->p.method->clazz->flags & ACC_FINAL))
+			return false;
+		break;
+
 	default:
 		return false;
 	}
@@ -363,6 +397,16 @@ bool builtintable_replace_function(void *iptr_)
 			(mr->name                == bte->name) &&
 			(mr->descriptor          == bte->descriptor)) {
 
+			/* instance methods need a receiver builtin and vice versa */
+
+			if ((iptr->opc == ICMD_INVOKEVIRTUAL) != ((bte->flags & BUILTINTABLE_FLAG_RECEIVER) != 0))
+				return false;
+
+			/* so far only sun.misc.Unsafe methods are replaced this way */
+
+			if ((bte->flags & BUILTINTABLE_FLAG_RECEIVER) && !opt_UnsafeIntrinsics)
+				return false;
+
 			/* set the values in the instruction */
 
 			iptr->opc           = bte->opcode;
@@ -800,6 +844,22 @@ RT_REGISTER_GROUP(buildin_group,"boot","boot group")
 RT_REGISTER_GROUP_TIMER(bi_new_timer,"buildin","builtin_new time",buildin_group)
 RT_REGISTER_GROUP_TIMER(bi_newa_timer,"buildin","builtin_newarray time",buildin_group)
 
+/* builtin_count_new ***********************************************************
+
+   Counts an instance of class c for the heap statistics.
+
+*******************************************************************************/
+
+#if defined(ENABLE_STATISTICS)
+static void builtin_count_new(classinfo *c)
+{
+	count_heap_objects++;
+	size_heap_objects     += c->instancesize;
+	size_heap_object_refs += (1 + c->instancereferences) * SIZEOF_VOID_P;
+}
+#endif
+
+
 /* builtin_new *****************************************************************
 
    Creates a new instance of class c on the heap.
@@ -864,6 +924,8 @@ java_handle_t *builtin_new(classinfo *c)
 
 	Lockword(LLNI_DIRECT(o)->lockword).init();
 
+	STATISTICS(builtin_count_new(c));
+
 	CYCLES_STATS_GET(cycles_end);
 	RT_TIMER_STOP(bi_new_timer);
 
@@ -939,6 +1001,8 @@ java_handle_t *builtin_tlh_new(classinfo *c)
 
 	Lockword(LLNI_DIRECT(o)->lockword).init();
 
+	STATISTICS(builtin_count_new(c));
+
 	CYCLES_STATS_GET(cycles_end);
 
 /*
@@ -1012,6 +1076,8 @@ java_object_t *builtin_fast_new(classinfo *c)
 
 	Lockword(LLNI_DIRECT(o)->lockword).init();
 
+	STATISTICS(builtin_count_new(c));
+
 	CYCLES_STATS_GET(cycles_end);
 
 	CYCLES_STATS_COUNT(builtin_new,cycles_end - cycles_start);
@@ -2068,6 +2134,119 @@ s8 builtin_currenttimemillis(void)
 }
 
 
+/* builtin_unsafe_* ************************************************************
+
+   Replacements for the atomic and volatile field accessors of
+   sun.misc.Unsafe, called directly from JIT code instead of through
+   the JNI stub of the native method.  The first argument is the
+   Unsafe instance, which is only null-checked by the caller.  As in
+   the native methods, <o> may be NULL if <offset> is an absolute
+   address.
+
+   NOTE: These builtins can be called from JIT code only.
+
+*******************************************************************************/
+
+#define UNSAFE_ADDRESS(type, o, offset) \
+	((type *) (((uint8_t *) (o)) + (offset)))
+
+#if defined(CAS_PROVIDES_FULL_BARRIER) && CAS_PROVIDES_FULL_BARRIER
+# define UNSAFE_CAS_BARRIER Atomic::instruction_barrier()
+#else
+# define UNSAFE_CAS_BARRIER Atomic::memory_barrier()
+#endif
+
+s4 builtin_unsafe_compareAndSwapInt(java_object_t *u, java_object_t *o, s8 offset, s4 expected, s4 x)
+{
+	uint32_t *p = UNSAFE_ADDRESS(uint32_t, o, offset);
+	uint32_t  result;
+
+	result = Atomic::compare_and_swap(p, (uint32_t) expected, (uint32_t) x);
+	UNSAFE_CAS_BARRIER;
+
+	return (result == (uint32_t) expected);
+}
+
+s4 builtin_unsafe_compareAndSwapLong(java_object_t *u, java_object_t *o, s8 offset, s8 expected, s8 x)
+{
+	uint64_t *p = UNSAFE_ADDRESS(uint64_t, o, offset);
+	uint64_t  result;
+
+	result = Atomic::compare_and_swap(p, (uint64_t) expected, (uint64_t) x);
+	UNSAFE_CAS_BARRIER;
+
+	return (result == (uint64_t) expected);
+}
+
+s4 builtin_unsafe_compareAndSwapObject(java_object_t *u, java_object_t *o, s8 offset, java_object_t *expected, java_object_t *x)
+{
+	java_object_t **p = UNSAFE_ADDRESS(java_object_t *, o, offset);
+	java_object_t  *result;
+
+	result = Atomic::compare_and_swap(p, expected, x);
+	UNSAFE_CAS_BARRIER;
+
+	return (result == expected);
+}
+
+s4 builtin_unsafe_getIntVolatile(java_object_t *u, java_object_t *o, s8 offset)
+{
+	return *UNSAFE_ADDRESS(volatile int32_t, o, offset);
+}
+
+s8 builtin_unsafe_getLongVolatile(java_object_t *u, java_object_t *o, s8 offset)
+{
+	return *UNSAFE_ADDRESS(volatile int64_t, o, offset);
+}
+
+java_object_t *builtin_unsafe_getObjectVolatile(java_object_t *u, java_object_t *o, s8 offset)
+{
+	return *UNSAFE_ADDRESS(java_object_t * volatile, o, offset);
+}
+
+void builtin_unsafe_putIntVolatile(java_object_t *u, java_object_t *o, s8 offset, s4 x)
+{
+	*UNSAFE_ADDRESS(volatile int32_t, o, offset) = x;
+	Atomic::memory_barrier();
+}
+
+void builtin_unsafe_putLongVolatile(java_object_t *u, java_object_t *o, s8 offset, s8 x)
+{
+	*UNSAFE_ADDRESS(volatile int64_t, o, offset) = x;
+	Atomic::memory_barrier();
+}
+
+void builtin_unsafe_putObjectVolatile(java_object_t *u, java_object_t *o, s8 offset, java_object_t *x)
+{
+	*UNSAFE_ADDRESS(java_object_t * volatile, o, offset) = x;
+	Atomic::memory_barrier();
+}
+
+/* The ordered stores only must not become visible before earlier
+   stores, a store barrier in front of them is enough. */
+
+void builtin_unsafe_putOrderedInt(java_object_t *u, java_object_t *o, s8 offset, s4 x)
+{
+	Atomic::write_memory_barrier();
+	*UNSAFE_ADDRESS(volatile int32_t, o, offset) = x;
+}
+
+void builtin_unsafe_putOrderedLong(java_object_t *u, java_object_t *o, s8 offset, s8 x)
+{
+	Atomic::write_memory_barrier();
+	*UNSAFE_ADDRESS(volatile int64_t, o, offset) = x;
+}
+
+void builtin_unsafe_putOrderedObject(java_object_t *u, java_object_t *o, s8 offset, java_object_t *x)
+{
+	Atomic::write_memory_barrier();
+	*UNSAFE_ADDRESS(java_object_t * volatile, o, offset) = x;
+}
+
+#undef UNSAFE_ADDRESS
+#undef UNSAFE_CAS_BARRIER
+
+
 /* builtin_clone ***************************************************************
 
    Function for cloning objects or arrays.
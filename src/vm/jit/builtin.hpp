@@ -77,6 +77,8 @@ struct builtintable_entry {
 
 #define BUILTINTABLE_FLAG_STUB         0x0001 /* builtin needs a stub         */
 #define BUILTINTABLE_FLAG_EXCEPTION    0x0002 /* check for excepion on return */
+#define BUILTINTABLE_FLAG_RECEIVER     0x0004 /* replaces an instance method  */
+#define BUILTINTABLE_FLAG_INLINE       0x0008 /* fast-path replaces the call  */
 
 
 /* function prototypes ********************************************************/
@@ -330,6 +332,47 @@ s8 builtin_nanotime(void);
 s8 builtin_currenttimemillis(void);
 #define BUILTIN_currenttimemillis (functionptr) builtin_currenttimemillis
 
+/* The sun.misc.Unsafe builtins take the Unsafe instance as first
+   argument, which is ignored.  On x86_64 they are not called at all,
+   the fast-path emitters generate the complete operation. */
+
+s4 builtin_unsafe_compareAndSwapInt(java_object_t *u, java_object_t *o, s8 offset, s4 expected, s4 x);
+#define BUILTIN_unsafe_compareAndSwapInt (functionptr) builtin_unsafe_compareAndSwapInt
+s4 builtin_unsafe_compareAndSwapLong(java_object_t *u, java_object_t *o, s8 offset, s8 expected, s8 x);
+#define BUILTIN_unsafe_compareAndSwapLong (functionptr) builtin_unsafe_compareAndSwapLong
+s4 builtin_unsafe_compareAndSwapObject(java_object_t *u, java_object_t *o, s8 offset, java_object_t *expected, java_object_t *x);
+#define BUILTIN_unsafe_compareAndSwapObject (functionptr) builtin_unsafe_compareAndSwapObject
+s4 builtin_unsafe_getIntVolatile(java_object_t *u, java_object_t *o, s8 offset);
+#define BUILTIN_unsafe_getIntVolatile (functionptr) builtin_unsafe_getIntVolatile
+s8 builtin_unsafe_getLongVolatile(java_object_t *u, java_object_t *o, s8 offset);
+#define BUILTIN_unsafe_getLongVolatile (functionptr) builtin_unsafe_getLongVolatile
+java_object_t *builtin_unsafe_getObjectVolatile(java_object_t *u, java_object_t *o, s8 offset);
+#define BUILTIN_unsafe_getObjectVolatile (functionptr) builtin_unsafe_getObjectVolatile
+void builtin_unsafe_putIntVolatile(java_object_t *u, java_object_t *o, s8 offset, s4 x);
+#define BUILTIN_unsafe_putIntVolatile (functionptr) builtin_unsafe_putIntVolatile
+void builtin_unsafe_putLongVolatile(java_object_t *u, java_object_t *o, s8 offset, s8 x);
+#define BUILTIN_unsafe_putLongVolatile (functionptr) builtin_unsafe_putLongVolatile
+void builtin_unsafe_putObjectVolatile(java_object_t *u, java_object_t *o, s8 offset, java_object_t *x);
+#define BUILTIN_unsafe_putObjectVolatile (functionptr) builtin_unsafe_putObjectVolatile
+void builtin_unsafe_putOrderedInt(java_object_t *u, java_object_t *o, s8 offset, s4 x);
+#define BUILTIN_unsafe_putOrderedInt (functionptr) builtin_unsafe_putOrderedInt
+void builtin_unsafe_putOrderedLong(java_object_t *u, java_object_t *o, s8 offset, s8 x);
+#define BUILTIN_unsafe_putOrderedLong (functionptr) builtin_unsafe_putOrderedLong
+void builtin_unsafe_putOrderedObject(java_object_t *u, java_object_t *o, s8 offset, java_object_t *x);
+#define BUILTIN_unsafe_putOrderedObject (functionptr) builtin_unsafe_putOrderedObject
+
+#if defined(__X86_64__)
+# define EMIT_FASTPATH_unsafe_cas (functionptr) emit_fastpath_unsafe_cas
+# define EMIT_FASTPATH_unsafe_get_volatile (functionptr) emit_fastpath_unsafe_get_volatile
+# define EMIT_FASTPATH_unsafe_put_volatile (functionptr) emit_fastpath_unsafe_put_volatile
+# define EMIT_FASTPATH_unsafe_put_ordered (functionptr) emit_fastpath_unsafe_put_ordered
+#else
+# define EMIT_FASTPATH_unsafe_cas (functionptr) NULL
+# define EMIT_FASTPATH_unsafe_get_volatile (functionptr) NULL
+# define EMIT_FASTPATH_unsafe_put_volatile (functionptr) NULL
+# define EMIT_FASTPATH_unsafe_put_ordered (functionptr) NULL
+#endif
+
 #if defined(ENABLE_CYCLES_STATS)
 void builtin_print_cycles_stats(FILE *file);
 #endif
@@ -25,10 +25,12 @@
 #include "vm/jit/code.hpp"
 #include "mm/codememory.hpp"            // for CFREE
 #include "mm/memory.hpp"                // for OFFSET, FREE, NEW
+#include "vm/jit/exceptiontable.hpp"    // for exceptiontable_cache_invalidate
 #include "vm/jit/linenumbertable.hpp"   // for LinenumberTable
 #include "vm/jit/methodtree.hpp"        // for methodtree_find, etc
 #include "vm/jit/patcher-common.hpp"    // for patcher_list_create, etc
 #include "vm/jit/replace.hpp"           // for replace_free_replacement_points
+#include "vm/jit/optimizing/typeprofile.hpp" // for typeprofile
 #include "vm/options.hpp"               // for checksync
 #include "vm/vm.hpp"                    // for vm_abort
 
@@ -215,8 +217,14 @@ void code_codeinfo_free(codeinfo *code)
 	if (code == NULL)
 		return;
 
-	if (code->mcode != NULL)
+	/* The code memory may be reused, the exception handler cache must
+	   not find handlers of this code anymore. */
+
+	if (code->mcode != NULL) {
+		exceptiontable_cache_invalidate();
+
 		CFREE((void *) (ptrint) code->mcode, code->mcodelength);
+	}
 
 	patcher_list_free(code);
 
@@ -231,6 +239,13 @@ void code_codeinfo_free(codeinfo *code)
 		MFREE(code->bbfrequency, u4, code->basicblockcount);
 #endif
 
+#if defined(ENABLE_THREADS)
+	/* Release the type profiles of baseline code. */
+
+	if (code->typeprofiles != NULL)
+		MFREE(code->typeprofiles, typeprofile, code->typeprofilecount);
+#endif
+
 	FREE(code, codeinfo);
 
 	STATISTICS(size_codeinfo -= sizeof(codeinfo));
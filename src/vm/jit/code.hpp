@@ -39,6 +39,7 @@ struct methodinfo;
 struct patchref_t;
 struct rplalloc;
 struct rplpoint;
+struct typeprofile;
 template <class T> class LockedList;
 
 
@@ -99,6 +100,16 @@ struct codeinfo {
 	u1           *savedmcode;           /* saved code under patches           */
 #endif
 
+	/* tiered compilation counters */
+#if defined(ENABLE_THREADS)
+	u4            invocations;          /* method invocations (baseline tier) */
+	u4            backedges;            /* loop iterations (baseline tier)    */
+	typeprofile  *typeprofiles;         /* classes seen by the type checks    */
+	s4            typeprofilecount;     /* number of profiled type checks     */
+	u4            guardmisses;          /* failed receiver checks             */
+	s4            guardcount;           /* receiver checks of inlined calls   */
+#endif
+
 	/* profiling information */
 #if defined(ENABLE_PROFILING)
 	u4            frequency;            /* number of method invocations       */
@@ -90,6 +90,10 @@
 
 #include "vm/jit/optimizing/profile.hpp"
 
+#if defined(ENABLE_THREADS)
+# include "vm/jit/optimizing/typeprofile.hpp"
+#endif
+
 #if defined(ENABLE_SSA)
 # include "vm/jit/optimizing/lsra.hpp"
 # include "vm/jit/optimizing/ssa.hpp"
@@ -189,6 +193,8 @@ void codegen_setup(jitdata *jd)
 
 	cd->brancheslabel  = new DumpList<branch_label_ref_t*>();
 	cd->linenumbers    = new DumpList<Linenumber>();
+	cd->inlinescopes   = new DumpList<InlineScope>();
+	cd->inlinescope    = -1;
 }
 
 
@@ -230,6 +236,8 @@ static void codegen_reset(jitdata *jd)
 
 	cd->brancheslabel   = new DumpList<branch_label_ref_t*>();
 	cd->linenumbers     = new DumpList<Linenumber>();
+	cd->inlinescopes    = new DumpList<InlineScope>();
+	cd->inlinescope     = -1;
 	
 	/* We need to clear the mpc and the branch references from all
 	   basic blocks as they will definitely change. */
@@ -1180,6 +1188,12 @@ bool codegen_emit(jitdata *jd)
 	}
 #endif
 
+#if defined(ENABLE_THREADS) && SUPPORT_TIERED_COUNTERS
+	// Count invocations of baseline code.
+	if (JITDATA_HAS_FLAG_TIERCOUNT(jd))
+		emit_tier_counter(cd, &(code->invocations));
+#endif
+
 	// Emit code for the method prolog.
 	codegen_emit_prolog(jd);
 
@@ -1232,6 +1246,16 @@ bool codegen_emit(jitdata *jd)
 		}
 #endif
 
+#if defined(ENABLE_THREADS) && SUPPORT_TIERED_COUNTERS
+		// Count loop iterations of baseline code at the targets of
+		// backward branches.  BBFLAG_REPLACEMENT cannot be used here,
+		// replacement drops it if the block has a point of its own.
+		if (JITDATA_HAS_FLAG_TIERCOUNT(jd) && (bptr->bitflags & BBFLAG_LOOPHEADER)) {
+			MCODECHECK(32);
+			emit_tier_counter(cd, &(code->backedges));
+		}
+#endif
+
 #if defined(ENABLE_PROFILING)
 		// Generate basicblock profiling code.
 		if (JITDATA_HAS_FLAG_INSTRUMENT(jd)) {
@@ -1257,7 +1281,8 @@ bool codegen_emit(jitdata *jd)
 			last_cmd_was_goto = false;
 		} else {
 #elif defined(ENABLE_LSRA)
-		if (opt_lsra) {
+		// Only set if lsra allocated this method, see jit_compile_intern.
+		if (jd->ls != NULL) {
 			while (indepth > 0) {
 				indepth--;
 				var = VAR(bptr->invars[indepth]);
@@ -1309,6 +1334,15 @@ bool codegen_emit(jitdata *jd)
 			MCODECHECK(128);   // PPC64
 			MCODECHECK(1024);  // I386, X86_64, S390      /* 1kB should be enough */
 
+#if defined(ENABLE_THREADS) && SUPPORT_TYPE_PROFILES
+			// Record the classes seen by the type checks of baseline code.
+			if (code->typeprofiles != NULL) {
+				typeprofile* tp = typeprofile_find(code, iptr);
+				if (tp != NULL)
+					emit_typeprofile(jd, iptr, tp);
+			}
+#endif
+
 			// The big switch.
 			switch (iptr->opc) {
 
@@ -2025,11 +2059,30 @@ nowperformreturn:
 
 			case ICMD_BUILTIN:      /* ..., [arg1, [arg2 ...]] ==> ...        */
 
-				REPLACEMENT_POINT_FORGC_BUILTIN(cd, iptr);
-
 				bte = iptr->sx.s23.s3.bte;
 				md  = bte->md;
 
+				REPLACEMENT_POINT_FORGC_BUILTIN(cd, iptr);
+
+				// Builtins replacing instance methods keep the implicit
+				// null-pointer check of the INVOKEVIRTUAL on the receiver.
+				if (bte->flags & BUILTINTABLE_FLAG_RECEIVER) {
+					s1 = emit_load(jd, iptr, VAR(iptr->sx.s23.s2.args[0]), REG_ITMP1);
+					M_ALD(REG_ITMP2, s1, OFFSET(java_object_t, vftbl));
+				}
+
+				// Emit the whole builtin inline if the fast-path does
+				// not need the call as slow-path.
+				if ((bte->flags & BUILTINTABLE_FLAG_INLINE) && (bte->emit_fastpath != NULL)) {
+					void (*emit_inline)(jitdata* jd, instruction* iptr, int d);
+					emit_inline = (void (*)(jitdata* jd, instruction* iptr, int d)) bte->emit_fastpath;
+
+					emit_inline(jd, iptr, REG_ITMP1);
+
+					REPLACEMENT_POINT_FORGC_BUILTIN_RETURN(cd, iptr);
+					break;
+				}
+
 #if defined(ENABLE_ESCAPE_REASON) && defined(__I386__)
 				if (bte->fp == BUILTIN_escape_reason_new) {
 					void set_escape_reasons(void *);
@@ -2322,6 +2375,7 @@ gen_method:
 			case ICMD_CHECKCAST:  /* ..., objectref ==> ..., objectref        */
 			case ICMD_INSTANCEOF: /* ..., objectref ==> ..., intresult        */
 			case ICMD_MULTIANEWARRAY:/* ..., cnt1, [cnt2, ...] ==> ..., arrayref  */
+			case ICMD_IF_CLASSNE: /* ..., objectref ==> ...                   */
 
 				// Generate architecture specific instructions.
 				codegen_emit_instruction(jd, iptr);
@@ -33,6 +33,7 @@
 #include "vm/types.hpp"                 // for s4, u1, u4, u2
 
 class Linenumber;
+class InlineScope;
 struct basicblock;
 struct branch_label_ref_t;
 struct branchref;
@@ -140,6 +141,8 @@ struct codegendata {
 
 	DumpList<branch_label_ref_t*>* brancheslabel;
 	DumpList<Linenumber>* linenumbers; ///< List of line numbers.
+	DumpList<InlineScope>* inlinescopes; ///< List of inlined method bodies.
+	int32_t         inlinescope;    /* current scope, -1 outside inlined code */
 
 	methodinfo     *method;
 
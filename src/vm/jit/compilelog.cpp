@@ -0,0 +1,345 @@
+/* src/vm/jit/compilelog.cpp - per-method compilation log
+
+   Copyright (C) 1996-2013
+   CACAOVM - Verein zur Foerderung der freien virtuellen Maschine CACAO
+
+   This file is part of CACAO.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation; either version 2, or (at
+   your option) any later version.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA.
+
+*/
+
+
+#include "config.h"
+
+#include <cassert>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+
+#include "mm/memory.hpp"
+
+#include "threads/mutex.hpp"
+
+#include "toolbox/logging.hpp"
+
+#include "vm/class.hpp"
+#include "vm/method.hpp"
+#include "vm/options.hpp"
+
+#include "vm/jit/code.hpp"
+#include "vm/jit/compilelog.hpp"
+#include "vm/jit/jit.hpp"
+#include "vm/jit/stack.hpp"
+
+#include "vm/jit/ir/icmd.hpp"
+#include "vm/jit/ir/instruction.hpp"
+
+
+/* global variables ***********************************************************/
+
+static Mutex            *compilelog_mutex = NULL;
+static compilelog_entry *compilelog_ring  = NULL;
+static int32_t           compilelog_size  = 0;
+static int64_t           compilelog_count = 0;  // records ever written
+
+static const char *compilelog_phase_names[COMPILELOG_PHASE_COUNT] = {
+	"parse",
+	"stack",
+	"verify",
+	"optimize",
+	"regalloc",
+	"codegen"
+};
+
+
+/* compilelog_nanotime *********************************************************
+
+   Returns the monotonic clock in nanoseconds.  builtin_nanotime is
+   based on gettimeofday, which is neither fine enough for the short
+   phases nor immune to clock adjustments.
+
+*******************************************************************************/
+
+static int64_t compilelog_nanotime(void)
+{
+	struct timespec ts;
+
+	if (clock_gettime(CLOCK_MONOTONIC, &ts) != 0)
+		return 0;
+
+	return (int64_t) ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+
+/* compilelog_init *************************************************************
+
+   Allocates the ring buffer if -XX:+LogCompilation is given.
+
+*******************************************************************************/
+
+bool compilelog_init(void)
+{
+	TRACESUBSYSTEMINITIALIZATION("compilelog_init");
+
+	if (!opt_LogCompilation)
+		return true;
+
+	if (opt_LogCompilationEntries < 1)
+		opt_LogCompilationEntries = 1;
+
+	compilelog_size  = opt_LogCompilationEntries;
+	compilelog_ring  = MNEW(compilelog_entry, compilelog_size);
+	compilelog_mutex = new Mutex();
+
+	return true;
+}
+
+
+/* compilelog_start ************************************************************
+
+   Starts recording a compilation into the given entry, which must stay
+   alive until compilelog_finish is called.  Does nothing if the log is
+   disabled.
+
+*******************************************************************************/
+
+void compilelog_start(jitdata *jd, compilelog_entry *e)
+{
+	if (compilelog_ring == NULL) {
+		jd->log = NULL;
+		return;
+	}
+
+	memset(e, 0, sizeof(compilelog_entry));
+
+	e->m            = jd->m;
+	e->started      = compilelog_nanotime();
+	e->last         = e->started;
+	e->phase        = COMPILELOG_PHASE_PARSE;
+	e->bytecodesize = jd->m->jcodelength;
+	e->optlevel     = jd->code->optlevel;
+
+	jd->log = e;
+}
+
+
+/* compilelog_phase ************************************************************
+
+   Charges the time since the last phase change to the current phase
+   and switches to the given one.  Use the COMPILELOG_PHASE macro.
+
+*******************************************************************************/
+
+void compilelog_phase(jitdata *jd, int32_t phase)
+{
+	compilelog_entry *e   = jd->log;
+	int64_t           now = compilelog_nanotime();
+
+	assert(phase >= 0 && phase < COMPILELOG_PHASE_COUNT);
+
+	e->phasenanos[e->phase] += now - e->last;
+	e->last  = now;
+	e->phase = phase;
+}
+
+
+/* compilelog_finish ***********************************************************
+
+   Completes the record of the current compilation and copies it into
+   the ring buffer.  Must be called while the dump memory of the
+   compilation is still alive.
+
+*******************************************************************************/
+
+void compilelog_finish(jitdata *jd, bool success)
+{
+	compilelog_entry *e = jd->log;
+
+	if (e == NULL)
+		return;
+
+	int64_t now = compilelog_nanotime();
+
+	e->phasenanos[e->phase] += now - e->last;
+	e->totalnanos = now - e->started;
+	e->success    = success;
+
+	/* During a recompilation jd->m->code still is the old code, only
+	   native stubs get a codeinfo of their own. */
+
+	if (success) {
+		codeinfo *code = (jd->m->flags & ACC_NATIVE) ? jd->m->code : jd->code;
+
+		e->mcodesize = code->mcodelength;
+	}
+
+	/* native stubs and empty methods have no intermediate code */
+
+	if (success && !(jd->m->flags & ACC_NATIVE) && (jd->m->jcode != NULL)) {
+		/* count the inlined call sites and remember the first callees */
+
+		if (JITDATA_HAS_FLAG_INLINE(jd)) {
+			for (basicblock *bptr = jd->basicblocks; bptr != NULL; bptr = bptr->next) {
+				instruction *iptr;
+
+				FOR_EACH_INSTRUCTION(bptr, iptr) {
+					if (iptr->opc == ICMD_INLINE_START) {
+						if (e->inlined < COMPILELOG_INLINED_MAX)
+							e->callees[e->inlined] = iptr->sx.s23.s3.inlineinfo->method;
+
+						e->inlined++;
+					}
+				}
+			}
+		}
+
+		/* count the variables the register allocator put into memory */
+
+		for (int32_t i = 0; i < jd->vartop; i++)
+			if (jd->var[i].flags & INMEMORY)
+				e->spilled++;
+	}
+
+	jd->log = NULL;
+
+	MutexLocker lock(*compilelog_mutex);
+
+	compilelog_ring[compilelog_count % compilelog_size] = *e;
+	compilelog_count++;
+}
+
+
+/* compilelog_print_method *****************************************************
+
+   Writes class, name and descriptor of a method.
+
+*******************************************************************************/
+
+static void compilelog_print_method(FILE *file, methodinfo *m)
+{
+	fprintf(file, "%.*s.%.*s%.*s",
+			(int) m->clazz->name.size(), m->clazz->name.begin(),
+			(int) m->name.size(), m->name.begin(),
+			(int) m->descriptor.size(), m->descriptor.begin());
+}
+
+
+/* compilelog_print_entry ******************************************************
+
+   Writes one record as a tab separated line.  The inlined callees come
+   last, separated by commas, followed by "..." if there were more than
+   COMPILELOG_INLINED_MAX of them.
+
+*******************************************************************************/
+
+static void compilelog_print_entry(FILE *file, int64_t id, compilelog_entry *e)
+{
+	methodinfo *m = e->m;
+
+	fprintf(file, "%lld\t%d\t%s\t%d\t%d\t%d\t%d\t%d\t%d\t%d\t%d\t%d\t%lld",
+			(long long) id, e->optlevel, e->success ? "ok" : "failed",
+			e->bytecodesize, e->mcodesize, e->inlined, e->spilled,
+			e->elided, e->nullchecks, e->typechecks, e->coldblocks,
+			e->typeguards, (long long) e->totalnanos);
+
+	for (int32_t i = 0; i < COMPILELOG_PHASE_COUNT; i++)
+		fprintf(file, "\t%lld", (long long) e->phasenanos[i]);
+
+	fputc('\t', file);
+	compilelog_print_method(file, m);
+	fputc('\t', file);
+
+	if (e->inlined == 0)
+		fputc('-', file);
+
+	for (int32_t i = 0; i < e->inlined && i < COMPILELOG_INLINED_MAX; i++) {
+		if (i > 0)
+			fputc(',', file);
+
+		compilelog_print_method(file, e->callees[i]);
+	}
+
+	if (e->inlined > COMPILELOG_INLINED_MAX)
+		fputs(",...", file);
+
+	fputc('\n', file);
+}
+
+
+/* compilelog_dump *************************************************************
+
+   Writes the records in the ring buffer, oldest first, to
+   -XX:LogCompilationFile or the log file.  The buffer is kept, so it
+   can be dumped again later.
+
+*******************************************************************************/
+
+void compilelog_dump(void)
+{
+	FILE *file;
+
+	if (compilelog_ring == NULL)
+		return;
+
+	if (opt_LogCompilationFile != NULL) {
+		file = fopen(opt_LogCompilationFile, "w");
+
+		if (file == NULL) {
+			log_println("compilelog_dump: cannot open %s: %s", opt_LogCompilationFile, strerror(errno));
+			return;
+		}
+	}
+	else
+		file = log_get_logfile();
+
+	MutexLocker lock(*compilelog_mutex);
+
+	int64_t first = (compilelog_count > compilelog_size) ? compilelog_count - compilelog_size : 0;
+
+	fprintf(file, "# compilation log: %lld compilations, last %lld shown, times in ns\n",
+			(long long) compilelog_count, (long long) (compilelog_count - first));
+	fprintf(file, "# id\topt\tresult\tbytes\tmcode\tinlined\tspilled\telided\tnullchecks\ttypechecks\tcold\tguarded\ttotal");
+
+	for (int32_t i = 0; i < COMPILELOG_PHASE_COUNT; i++)
+		fprintf(file, "\t%s", compilelog_phase_names[i]);
+
+	fprintf(file, "\tmethod\tcallees\n");
+
+	for (int64_t id = first; id < compilelog_count; id++)
+		compilelog_print_entry(file, id, &compilelog_ring[id % compilelog_size]);
+
+	if (opt_LogCompilationFile != NULL)
+		fclose(file);
+	else
+		fflush(file);
+}
+
+
+/*
+ * These are local overrides for various environment variables in Emacs.
+ * Please do not remove this and leave it at the end of the file, where
+ * Emacs will automagically detect them.
+ * ---------------------------------------------------------------------
+ * Local variables:
+ * mode: c++
+ * indent-tabs-mode: t
+ * c-basic-offset: 4
+ * tab-width: 4
+ * End:
+ * vim:noexpandtab:sw=4:ts=4:
+ */
@@ -0,0 +1,119 @@
+/* src/vm/jit/compilelog.hpp - per-method compilation log
+
+   Copyright (C) 1996-2013
+   CACAOVM - Verein zur Foerderung der freien virtuellen Maschine CACAO
+
+   This file is part of CACAO.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation; either version 2, or (at
+   your option) any later version.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA.
+
+*/
+
+
+#ifndef _COMPILELOG_HPP
+#define _COMPILELOG_HPP
+
+#include "config.h"
+
+#include <stdint.h>
+
+struct jitdata;
+struct methodinfo;
+
+
+/* Compilation log *************************************************************
+
+   With -XX:+LogCompilation every run of jit_compile and jit_recompile
+   leaves one record in a ring buffer of -XX:LogCompilationEntries
+   entries.  A record holds the time spent in each compiler phase, the
+   size of the code before and after compilation and the methods that
+   were inlined into it.  The buffer is written to
+   -XX:LogCompilationFile (or the log file) at exit and on SIGQUIT.
+
+   Unlike rt-timing the log is available in every build and costs one
+   flag test per phase when disabled.
+
+*******************************************************************************/
+
+enum CompileLogPhase {
+	COMPILELOG_PHASE_PARSE,             // checks and parse
+	COMPILELOG_PHASE_STACK,             // stack analysis
+	COMPILELOG_PHASE_VERIFY,            // type checker
+	COMPILELOG_PHASE_OPTIMIZE,          // ifconv, inlining, CFG, loops
+	COMPILELOG_PHASE_REGALLOC,          // register allocation
+	COMPILELOG_PHASE_CODEGEN,           // code generation
+	COMPILELOG_PHASE_COUNT
+};
+
+#define COMPILELOG_INLINED_MAX  8       // callees recorded per compilation
+
+struct compilelog_entry {
+	methodinfo *m;                      // compiled method
+	int64_t     started;                // monotonic clock at start
+	int64_t     last;                   // start of the current phase
+	int32_t     phase;                  // current phase
+	int64_t     phasenanos[COMPILELOG_PHASE_COUNT];
+	int64_t     totalnanos;             // wall time of the whole compile
+	int32_t     bytecodesize;           // length of the bytecode
+	int32_t     mcodesize;              // length of code and data segment
+	int32_t     inlined;                // inlined call sites
+	methodinfo *callees[COMPILELOG_INLINED_MAX]; // first inlined methods
+	int32_t     spilled;                // variables allocated in memory
+	int32_t     elided;                 // monitor operations removed
+	int32_t     nullchecks;             // explicit null checks removed
+	int32_t     typechecks;             // checkcasts and instanceofs removed
+	int32_t     coldblocks;             // blocks moved behind the hot code
+	int32_t     typeguards;             // checks testing a profiled class first
+	uint8_t     optlevel;               // optimization level of the code
+	bool        success;                // false if an exception occurred
+};
+
+
+/* macros *********************************************************************/
+
+#define COMPILELOG_PHASE(jd, p) \
+	do { \
+		if ((jd)->log != NULL) \
+			compilelog_phase((jd), (p)); \
+	} while (0)
+
+
+/* function prototypes ********************************************************/
+
+bool compilelog_init(void);
+
+void compilelog_start(jitdata *jd, compilelog_entry *e);
+void compilelog_phase(jitdata *jd, int32_t phase);
+void compilelog_finish(jitdata *jd, bool success);
+
+void compilelog_dump(void);
+
+#endif /* _COMPILELOG_HPP */
+
+
+/*
+ * These are local overrides for various environment variables in Emacs.
+ * Please do not remove this and leave it at the end of the file, where
+ * Emacs will automagically detect them.
+ * ---------------------------------------------------------------------
+ * Local variables:
+ * mode: c++
+ * indent-tabs-mode: t
+ * c-basic-offset: 4
+ * tab-width: 4
+ * End:
+ * vim:noexpandtab:sw=4:ts=4:
+ */
@@ -40,6 +40,7 @@ struct codegendata;
 struct codeinfo;
 struct instruction;
 struct jitdata;
+struct typeprofile;
 struct varinfo;
 
 /* branch labels **************************************************************/
@@ -54,6 +55,9 @@ struct varinfo;
 #define BRANCH_LABEL_8    8
 #define BRANCH_LABEL_9    9
 #define BRANCH_LABEL_10  10
+#define BRANCH_LABEL_11  11
+#define BRANCH_LABEL_12  12
+#define BRANCH_LABEL_13  13
 
 
 /* constant range macros ******************************************************/
@@ -217,6 +221,10 @@ void emit_recompute_pv(codegendata* cd);
 /* machine dependent faspath-emitting functions */
 void emit_fastpath_monitor_enter(jitdata* jd, instruction* iptr, int d);
 void emit_fastpath_monitor_exit(jitdata* jd, instruction* iptr, int d);
+void emit_fastpath_unsafe_cas(jitdata* jd, instruction* iptr, int d);
+void emit_fastpath_unsafe_get_volatile(jitdata* jd, instruction* iptr, int d);
+void emit_fastpath_unsafe_put_volatile(jitdata* jd, instruction* iptr, int d);
+void emit_fastpath_unsafe_put_ordered(jitdata* jd, instruction* iptr, int d);
 
 void emit_monitor_enter(jitdata* jd, int32_t syncslot_offset);
 void emit_monitor_exit(jitdata* jd, int32_t syncslot_offset);
@@ -228,6 +236,11 @@ void emit_profile_cycle_start(codegendata* cd, codeinfo* code);
 void emit_profile_cycle_stop(codegendata* cd, codeinfo* code);
 #endif
 
+#if defined(ENABLE_THREADS)
+void emit_tier_counter(codegendata* cd, u4* counter);
+void emit_typeprofile(jitdata* jd, instruction* iptr, typeprofile* tp);
+#endif
+
 void emit_verbosecall_enter(jitdata *jd);
 void emit_verbosecall_exit(jitdata *jd);
 
@@ -26,12 +26,121 @@
 #include "config.h"
 #include <assert.h>                     // for assert
 #include <stdint.h>                     // for uint8_t
+#include <algorithm>                    // for sort, unique, upper_bound
+#include <vector>                       // for vector
 #include "mm/memory.hpp"                // for NEW
+#include "threads/atomic.hpp"           // for compare_and_swap, etc
 #include "toolbox/logging.hpp"          // for log_print, log_finish, etc
 #include "vm/class.hpp"                 // for class_classref_print, etc
 #include "vm/jit/code.hpp"              // for codeinfo
 #include "vm/jit/jit.hpp"               // for exception_entry, jitdata, etc
 #include "vm/method.hpp"                // for method_print
+#include "vm/options.hpp"               // for opt_ExceptionCache
+#include "vm/statistics.hpp"            // for STATISTICS
+
+STAT_REGISTER_GROUP(exceptiontable_stat,"exceptions","exception dispatch")
+STAT_REGISTER_GROUP_VAR(int,count_exceptioncache_hits,0,"cache hits","exception handler lookups answered by the cache",exceptiontable_stat)
+STAT_REGISTER_GROUP_VAR(int,count_exceptioncache_misses,0,"cache misses","exception handler lookups missing the cache",exceptiontable_stat)
+STAT_REGISTER_GROUP_VAR(int,count_exceptioncache_invalidations,0,"invalidations","exception handler cache invalidations",exceptiontable_stat)
+
+
+/* exception handler cache ****************************************************
+
+   Maps a throwing PC and the class of the exception to the handler
+   found for them in the frame of the PC, or NULL if the frame has
+   none.  The cache is direct mapped and written without a lock: every
+   entry is guarded by a sequence number which is odd while the entry
+   is written.  Freeing code starts a new generation, which makes all
+   older entries miss.
+
+*******************************************************************************/
+
+#ifdef __S390__
+/* Addresses are 31 bit integers */
+#	define ADDR_MASK(x) (void *) ((uintptr_t) (x) & 0x7FFFFFFF)
+#else
+#	define ADDR_MASK(x) (x)
+#endif
+
+#define EXCEPTIONCACHE_SIZE    512      /* must be a power of two             */
+
+struct exceptioncache_entry_t {
+	volatile uint32_t  seq;
+	uint32_t           generation;
+	void              *xpc;
+	classinfo         *c;
+	void              *handler;
+};
+
+static exceptioncache_entry_t exceptioncache[EXCEPTIONCACHE_SIZE];
+static volatile uint32_t      exceptioncache_generation = 0;
+
+static inline exceptioncache_entry_t *exceptioncache_slot(void *xpc, classinfo *c)
+{
+	uintptr_t h = ((uintptr_t) xpc >> 2) ^ ((uintptr_t) c >> 4);
+
+	return &exceptioncache[(h ^ (h >> 9)) & (EXCEPTIONCACHE_SIZE - 1)];
+}
+
+/* exceptiontable_create_ranges ************************************************
+
+   Splits the code covered by the exception table into ranges covered
+   by the same entries, so the entries for a PC are found by binary
+   search.  The bounds are masked like the PCs looked up.
+
+   IN:
+       et ... exception table with all entries filled
+
+*******************************************************************************/
+
+static void exceptiontable_create_ranges(exceptiontable_t *et)
+{
+	std::vector<void*> bounds;
+
+	for (int32_t i = 0; i < et->length; i++) {
+		bounds.push_back(ADDR_MASK(et->entries[i].startpc));
+		bounds.push_back(ADDR_MASK(et->entries[i].endpc));
+	}
+
+	std::sort(bounds.begin(), bounds.end());
+	bounds.erase(std::unique(bounds.begin(), bounds.end()), bounds.end());
+
+	/* The last bound only ends the last range, it starts an empty one. */
+
+	et->rangecount = bounds.size();
+	et->ranges     = MNEW(exceptiontable_range_t, et->rangecount);
+	et->indexcount = 0;
+
+	for (int32_t r = 0; r < et->rangecount; r++) {
+		for (int32_t i = 0; i < et->length; i++) {
+			exceptiontable_entry_t *ete = &et->entries[i];
+
+			if ((ADDR_MASK(ete->startpc) <= bounds[r]) && (bounds[r] < ADDR_MASK(ete->endpc)))
+				et->indexcount++;
+		}
+	}
+
+	et->indices = MNEW(int32_t, et->indexcount);
+
+	int32_t n = 0;
+
+	for (int32_t r = 0; r < et->rangecount; r++) {
+		exceptiontable_range_t *range = &et->ranges[r];
+
+		range->startpc = bounds[r];
+		range->first   = n;
+
+		for (int32_t i = 0; i < et->length; i++) {
+			exceptiontable_entry_t *ete = &et->entries[i];
+
+			if ((ADDR_MASK(ete->startpc) <= bounds[r]) && (bounds[r] < ADDR_MASK(ete->endpc)))
+				et->indices[n++] = i;
+		}
+
+		range->count = n - range->first;
+	}
+}
+
 
 /* exceptiontable_create *******************************************************
 
@@ -86,6 +195,8 @@ void exceptiontable_create(jitdata *jd)
 		ete->catchtype.any = ex->catchtype.any;
 	}
 
+	exceptiontable_create_ranges(et);
+
 	/* Store the exception table in the codeinfo. */
 
 	code->exceptiontable = et;
@@ -120,6 +231,12 @@ void exceptiontable_free(codeinfo *code)
 	et = code->exceptiontable;
 
 	if (et != NULL) {
+		if (et->ranges != NULL)
+			MFREE(et->ranges, exceptiontable_range_t, et->rangecount);
+
+		if (et->indices != NULL)
+			MFREE(et->indices, int32_t, et->indexcount);
+
 		ete = et->entries;
 
 		if (ete != NULL) {
@@ -139,6 +256,145 @@ void exceptiontable_free(codeinfo *code)
 }
 
 
+/* exceptiontable_find_range ***************************************************
+
+   Returns the range of the exception table containing the given PC,
+   NULL if no entry covers it.
+
+*******************************************************************************/
+
+static bool exceptiontable_range_compare(void *pc, const exceptiontable_range_t& range)
+{
+	return pc < range.startpc;
+}
+
+exceptiontable_range_t *exceptiontable_find_range(exceptiontable_t *et, void *pc)
+{
+	exceptiontable_range_t *end = et->ranges + et->rangecount;
+	exceptiontable_range_t *it  = std::upper_bound(et->ranges, end, pc, exceptiontable_range_compare);
+
+	if (it == et->ranges)
+		return NULL;
+
+	--it;
+
+	return (it->count > 0) ? it : NULL;
+}
+
+
+/* exceptiontable_cache_find ***************************************************
+
+   Looks up the handler for an exception of class c thrown at xpc.
+
+   OUT:
+       handler ... the handler, NULL if the frame has none
+
+   RETURN VALUE:
+       true if the cache knows the answer
+
+*******************************************************************************/
+
+bool exceptiontable_cache_find(void *xpc, classinfo *c, void **handler)
+{
+	if (!opt_ExceptionCache)
+		return false;
+
+	exceptioncache_entry_t *e = exceptioncache_slot(xpc, c);
+
+	uint32_t seq = e->seq;
+
+	if (seq & 1) {
+		STATISTICS(count_exceptioncache_misses++);
+		return false;
+	}
+
+	Atomic::memory_barrier();
+
+	bool  hit = (e->xpc == xpc) && (e->c == c) &&
+		(e->generation == exceptioncache_generation);
+	void *h   = e->handler;
+
+	Atomic::memory_barrier();
+
+	if (!hit || (e->seq != seq)) {
+		STATISTICS(count_exceptioncache_misses++);
+		return false;
+	}
+
+	STATISTICS(count_exceptioncache_hits++);
+
+	*handler = h;
+
+	return true;
+}
+
+
+/* exceptiontable_cache_add ****************************************************
+
+   Remembers the handler found for an exception of class c thrown at
+   xpc.  The generation must have been read with
+   exceptiontable_cache_generation before the exception table was
+   searched.  If another thread writes the same entry, nothing is
+   stored.
+
+*******************************************************************************/
+
+void exceptiontable_cache_add(void *xpc, classinfo *c, void *handler, uint32_t generation)
+{
+	if (!opt_ExceptionCache)
+		return;
+
+	exceptioncache_entry_t *e = exceptioncache_slot(xpc, c);
+
+	uint32_t seq = e->seq;
+
+	if ((seq & 1) || (Atomic::compare_and_swap((uint32_t *) &e->seq, seq, seq + 1) != seq))
+		return;
+
+	Atomic::write_memory_barrier();
+
+	e->generation = generation;
+	e->xpc        = xpc;
+	e->c          = c;
+	e->handler    = handler;
+
+	Atomic::write_memory_barrier();
+
+	e->seq = seq + 2;
+}
+
+
+/* exceptiontable_cache_generation *********************************************
+
+   Returns the current generation of the exception handler cache.
+
+*******************************************************************************/
+
+uint32_t exceptiontable_cache_generation(void)
+{
+	return exceptioncache_generation;
+}
+
+
+/* exceptiontable_cache_invalidate *********************************************
+
+   Drops all entries of the exception handler cache.  Has to be called
+   before the memory of compiled code is reused.
+
+*******************************************************************************/
+
+void exceptiontable_cache_invalidate(void)
+{
+	uint32_t generation;
+
+	do {
+		generation = exceptioncache_generation;
+	} while (Atomic::compare_and_swap((uint32_t *) &exceptioncache_generation, generation, generation + 1) != generation);
+
+	STATISTICS(count_exceptioncache_invalidations++);
+}
+
+
 /* exceptiontable_print ********************************************************
 
    Print the exception table.
@@ -32,6 +32,7 @@
 
 #include "vm/references.hpp"
 
+struct classinfo;
 struct jitdata;
 struct codeinfo;
 
@@ -39,6 +40,7 @@ struct codeinfo;
 
 struct exceptiontable_t;
 struct exceptiontable_entry_t;
+struct exceptiontable_range_t;
 
 
 /* exceptiontable_t ***********************************************************/
@@ -46,6 +48,10 @@ struct exceptiontable_entry_t;
 struct exceptiontable_t {
 	int32_t                 length;
 	exceptiontable_entry_t *entries;
+	int32_t                 rangecount;
+	exceptiontable_range_t *ranges;     /* sorted by startpc                  */
+	int32_t                 indexcount;
+	int32_t                *indices;    /* entries covering the ranges        */
 };
 
 
@@ -59,11 +65,33 @@ struct exceptiontable_entry_t {
 };
 
 
+/* exceptiontable_range_t *****************************************************
+
+   The code between startpc and the startpc of the next range is covered
+   by the same entries.  These are listed at indices[first] to
+   indices[first + count - 1], in the order of the exception table.
+
+*******************************************************************************/
+
+struct exceptiontable_range_t {
+	void                  *startpc;
+	int32_t                first;
+	int32_t                count;
+};
+
+
 /* function prototypes ********************************************************/
 
 void exceptiontable_create(jitdata *jd);
 void exceptiontable_free(codeinfo *code);
 
+exceptiontable_range_t *exceptiontable_find_range(exceptiontable_t *et, void *pc);
+
+bool exceptiontable_cache_find(void *xpc, classinfo *c, void **handler);
+void exceptiontable_cache_add(void *xpc, classinfo *c, void *handler, uint32_t generation);
+uint32_t exceptiontable_cache_generation(void);
+void exceptiontable_cache_invalidate(void);
+
 #if !defined(NDEBUG)
 void exceptiontable_print(codeinfo *code);
 #endif
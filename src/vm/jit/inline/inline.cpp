@@ -32,6 +32,8 @@
 
 #include "vm/types.hpp"
 
+#include "arch.hpp"                     // for SUPPORT_GUARDED_INLINING
+
 #include "mm/dumpmemory.hpp"
 
 #include "threads/lock.hpp"
@@ -59,6 +61,10 @@
 #include "vm/jit/inline/inline.hpp"
 #include "vm/jit/loop/loop.hpp"
 
+#if defined(ENABLE_THREADS)
+# include "vm/jit/optimizing/typeprofile.hpp"
+#endif
+
 #include "vm/jit/ir/instruction.hpp"
 
 #include "vm/jit/verify/typecheck.hpp"
@@ -117,6 +123,7 @@
 #define DOLOG_SHORT(code) do{ if (opt_TraceInlining >= 1) { code; } }while(0)
 #else
 #define DOLOG(code)
+#define DOLOG_SHORT(code)
 #endif
 
 #if defined(ENABLE_VERIFIER) && !defined(NDEBUG)
@@ -158,6 +165,8 @@ struct inline_node {
 	int n_resultlocal;
 	int synclocal;                    /* variable used for synchr., or UNUSED */
 	bool isstatic;                                   /* this is a static call */
+	classinfo *guard;          /* receiver class checked before the body, or  */
+	                           /* NULL if the call is statically bound        */
 
 	bool blockbefore;                  /* block boundary before inlined body? */
 	bool blockafter;                   /* block boundary after inlined body?  */
@@ -231,6 +240,8 @@ struct inline_context {
 
 	bool stopped;
 
+	int guardcount;                 /* # of calls inlined behind a check */
+
 	int next_debugnr; /* XXX debug */
 };
 
@@ -243,6 +254,8 @@ struct inline_site {
 	exception_entry **handlers;     /* active handlers at the call site       */
 	s4                nhandlers;    /* number of active handlers              */
 	s4                pc;           /* PC of the invocation instruction       */
+	methodinfo       *target;       /* the method to inline                   */
+	classinfo        *guard;        /* receiver class to check, or NULL       */
 };
 
 struct inline_candidate {
@@ -260,6 +273,8 @@ struct inline_candidate {
 
 static bool inline_analyse_code(inline_node *iln);
 static void inline_post_process(jitdata *jd);
+static void inline_clone_instruction(inline_node *iln, jitdata *jd, jitdata *origjd,
+									 s4 *varmap, instruction *o_iptr, instruction *n_iptr);
 
 
 /* debug helpers **************************************************************/
@@ -967,6 +982,59 @@ static basicblock * create_epilog_block(inline_node *caller, inline_node *callee
 }
 
 
+static s4 guard_block_argcount(inline_node *iln, inline_node *callee, instruction *o_iptr)
+{
+	s4 i;
+	s4 count;
+
+	/* arguments on the stack, locals stay where they are */
+
+	count = 0;
+	for (i=0; i<callee->m->parseddesc->paramcount; ++i) {
+		if (o_iptr->sx.s23.s2.args[i] >= iln->jd->localcount)
+			count++;
+	}
+
+	return count;
+}
+
+
+static basicblock * create_guard_block(inline_node *iln, inline_node *callee, instruction *o_iptr)
+{
+	basicblock *n_bptr;
+	s4 i, j;
+	s4 varidx;
+
+	/* the arguments on the stack enter the block after the */
+	/* pass-through variables                               */
+
+	n_bptr = create_block(iln, iln, callee,
+						  callee->n_passthroughcount + guard_block_argcount(iln, callee, o_iptr));
+
+	j = callee->n_passthroughcount;
+	for (i=0; i<callee->m->parseddesc->paramcount; ++i) {
+		varidx = o_iptr->sx.s23.s2.args[i];
+		if (varidx >= iln->jd->localcount) {
+			n_bptr->invars[j] = inline_new_variable_clone(iln->ctx->resultjd, iln->jd, varidx);
+			iln->varmap[varidx] = n_bptr->invars[j];
+			j++;
+		}
+	}
+
+	/* set javalocals */
+
+	n_bptr->javalocals = (s4*) DumpMemory::allocate(sizeof(s4) * iln->jd->maxlocals);
+	MCOPY(n_bptr->javalocals, iln->javalocals, s4, iln->jd->maxlocals);
+
+	/* set block flags & type */
+
+	n_bptr->state = basicblock::FINISHED;
+	n_bptr->type  = basicblock::TYPE_STD;
+
+	return n_bptr;
+}
+
+
 static void close_block(inline_node *iln, inline_node *inner, basicblock *n_bptr, s4 outdepth)
 {
 	inline_node *outer;
@@ -1127,6 +1195,7 @@ static s4 emit_inlining_prolog(inline_node *iln,
 	insinfo->outer = iln->m;
 	insinfo->synclocal = callee->synclocal;
 	insinfo->synchronize = callee->synchronize;
+	insinfo->line = o_iptr->line;
 	insinfo->javalocals_start = NULL;
 	insinfo->javalocals_end = NULL;
 
@@ -1180,7 +1249,9 @@ static s4 emit_inlining_prolog(inline_node *iln,
 		/* ensures that they are only called for an uninit. object */
 		/* (which may not be NULL).                                */
 
-		if (!callee->isstatic && i == 0 && calleem->name != utf8::init) {
+		if (!callee->isstatic && i == 0 && calleem->name != utf8::init
+				&& !callee->guard)
+		{
 			assert(type == TYPE_ADR);
 			n_ins = inline_instruction(iln, ICMD_CHECKNULL, o_iptr);
 			n_ins->s1.varindex = varindex;
@@ -1250,6 +1321,123 @@ static s4 emit_inlining_prolog(inline_node *iln,
 }
 
 
+/* emit_inlining_guard *********************************************************
+
+   Ends the current block with the check of the receiver class of a
+   guarded callee, and starts the block of the inlined body.  The
+   arguments on the stack are passed to both successors.
+
+   RETURN VALUE:
+       the check, its target is set by emit_inlining_guard_miss
+
+*******************************************************************************/
+
+static instruction * emit_inlining_guard(inline_node *iln,
+										 inline_node *callee,
+										 instruction *o_iptr,
+										 basicblock *n_bptr,
+										 s4 icount)
+{
+	instruction *n_ins;
+	instruction *guard;
+	s4 receiver;
+	s4 i, j;
+
+	receiver = iln->varmap[o_iptr->sx.s23.s2.args[0]];
+
+	/* the check consumes a copy of a receiver on the stack */
+
+	if (o_iptr->sx.s23.s2.args[0] >= iln->jd->localcount) {
+		n_ins = inline_instruction(iln, ICMD_COPY, o_iptr);
+		n_ins->s1.varindex = receiver;
+		n_ins->dst.varindex = inline_new_temp_variable(iln->ctx->resultjd, TYPE_ADR);
+		receiver = n_ins->dst.varindex;
+		icount++;
+	}
+
+	guard = inline_instruction(iln, ICMD_IF_CLASSNE, o_iptr);
+	guard->s1.varindex = receiver;
+	guard->sx.s23.s3.c.cls = callee->guard;
+	guard->dst.block = NULL;
+	icount++;
+
+	DOLOG( printf("%sguard: ", iln->indent);
+		   show_icmd(iln->ctx->resultjd, guard, false, SHOW_STACK); printf("\n"); );
+
+	/* close the block, the arguments leave it after the pass-through variables */
+
+	n_bptr->icount = icount;
+
+	close_block(iln, callee, n_bptr,
+				callee->n_passthroughcount + guard_block_argcount(iln, callee, o_iptr));
+
+	j = callee->n_passthroughcount;
+	for (i=0; i<callee->m->parseddesc->paramcount; ++i) {
+		if (o_iptr->sx.s23.s2.args[i] >= iln->jd->localcount)
+			n_bptr->outvars[j++] = iln->varmap[o_iptr->sx.s23.s2.args[i]];
+	}
+
+	/* start the block of the inlined body */
+
+	(void) create_guard_block(iln, callee, o_iptr);
+
+	iln->ctx->guardcount++;
+
+	return guard;
+}
+
+
+/* emit_inlining_guard_miss ****************************************************
+
+   Emits the block taken if the receiver check of a guarded callee
+   fails.  It performs the original call and jumps to the block after
+   the inlined body.
+
+*******************************************************************************/
+
+static void emit_inlining_guard_miss(inline_node *iln,
+									 inline_node *callee,
+									 instruction *o_iptr,
+									 instruction *guard)
+{
+	basicblock *n_bptr;
+	instruction *n_ins;
+	s4 retcount;
+	s4 retidx;
+
+	n_bptr = create_guard_block(iln, callee, o_iptr);
+	guard->dst.block = n_bptr;
+
+	/* the original call */
+
+	n_ins = (iln->inlined_iinstr_cursor++);
+	assert((n_ins - iln->inlined_iinstr) < iln->cumul_instructioncount);
+	inline_clone_instruction(iln, iln->ctx->resultjd, iln->jd, iln->varmap, o_iptr, n_ins);
+	retidx = n_ins->dst.varindex;
+
+	DOLOG( printf("%sguard miss: ", iln->indent);
+		   show_icmd(iln->ctx->resultjd, n_ins, false, SHOW_STACK); printf("\n"); );
+
+	/* jump to the block after the inlined body */
+
+	n_ins = inline_instruction(iln, ICMD_GOTO, o_iptr);
+	n_ins->dst.block = INLINE_RETURN_REFERENCE(callee);
+	inline_add_block_reference(callee, &(n_ins->dst.block));
+
+	n_bptr->icount = 2;
+
+	/* the result leaves the block like the result of the inlined body */
+
+	retcount = (callee->n_resultlocal == -1
+				&& callee->m->parseddesc->returntype.type != TYPE_VOID) ? 1 : 0;
+
+	close_block(iln, callee, n_bptr, callee->n_passthroughcount + retcount);
+
+	if (retcount)
+		n_bptr->outvars[callee->n_passthroughcount] = retidx;
+}
+
+
 static void emit_inlining_epilog(inline_node *iln, inline_node *callee, instruction *o_iptr)
 {
 	instruction *n_ins;
@@ -1442,6 +1630,7 @@ static void inline_rewrite_method(inline_node *iln)
 	char indent[100]; /* XXX debug */
 	s4 retcount;
 	s4 retidx;
+	instruction *guard;
 
 	assert(iln);
 
@@ -1450,6 +1639,7 @@ static void inline_rewrite_method(inline_node *iln)
 
 	n_bptr = NULL;
 	nextcall = iln->children;
+	guard = NULL;
 
 	/* XXX debug */
 	for (i=0; i<iln->depth; ++i)
@@ -1560,6 +1750,14 @@ static void inline_rewrite_method(inline_node *iln)
 
 			if (nextcall && o_iptr == nextcall->callerins) {
 
+				/* check the receiver class of a guarded callee */
+
+				if (nextcall->guard) {
+					guard = emit_inlining_guard(iln, nextcall, o_iptr, n_bptr, icount);
+					n_bptr = iln->inlined_basicblocks_cursor - 1;
+					icount = 0;
+				}
+
 				/* write the inlining prolog */
 
 				(void) emit_inlining_prolog(iln, nextcall, o_iptr, iln->varmap);
@@ -1610,6 +1808,11 @@ static void inline_rewrite_method(inline_node *iln)
 				iln->inlined_iinstr_cursor = nextcall->inlined_iinstr_cursor;
 				iln->inlined_basicblocks_cursor = nextcall->inlined_basicblocks_cursor;
 
+				/* the original call if the receiver check fails */
+
+				if (nextcall->guard)
+					emit_inlining_guard_miss(iln, nextcall, o_iptr, guard);
+
 				/* start new block, or glue blocks together */
 
 				if (nextcall->blockafter) {
@@ -2175,6 +2378,10 @@ static bool inline_transform(inline_node *iln, jitdata *jd)
 			n_jd->code = jd->code;
 			*jd = *n_jd;
 
+#if defined(ENABLE_THREADS)
+			jd->code->guardcount = iln->ctx->guardcount;
+#endif
+
 			/* statistics and logging */
 
 #if !defined(NDEBUG)
@@ -2353,6 +2560,86 @@ static bool inline_is_monomorphic(const methodinfo *callee,
 }
 
 
+/* inline_is_guardable *********************************************************
+
+   Check if the given virtual or interface call can be inlined behind a
+   check of the receiver class.  The class is taken from the receivers
+   profiled by the baseline code of the caller (see typeprofile.hpp).
+   Only the first optimizing compilation of the root method uses the
+   profiles, the recompilation after too many failed checks does not
+   speculate again.  A private method of the receiver class does not
+   override the callee, so it is never inlined for it.
+
+   IN:
+       caller...........inlining node of the caller
+	   callee...........the called method
+	   call.............the invocation instruction
+
+   OUT:
+       site->guard...........the receiver class to check
+       site->target..........the method of that class to inline
+                             (only defined if return value is true)
+
+   RETURN VALUE:
+       true if the call site can be inlined behind a check,
+	   false if not
+
+*******************************************************************************/
+
+static bool inline_is_guardable(const inline_node *caller,
+								const methodinfo *callee,
+								const instruction *call,
+								inline_site *site)
+{
+#if defined(ENABLE_THREADS) && SUPPORT_GUARDED_INLINING
+	codeinfo   *code;
+	vftbl_t    *vftbl;
+	classinfo  *c;
+	methodinfo *target;
+
+	if (!opt_GuardedInlining)
+		return false;
+
+	if ((call->opc != ICMD_INVOKEVIRTUAL) && (call->opc != ICMD_INVOKEINTERFACE))
+		return false;
+
+	/* the root method must still run its profiled baseline code */
+
+	code = caller->ctx->master->m->code;
+
+	if ((code == NULL) || (code->typeprofiles == NULL))
+		return false;
+
+	vftbl = typeprofile_receiver(caller->m->code, (instruction *) call);
+
+	if (vftbl == NULL)
+		return false;
+
+	c      = vftbl->clazz;
+	target = class_resolvemethod(c, callee->name, callee->descriptor);
+
+	if ((target == NULL) || !class_isanysubclass(c, callee->clazz) ||
+		(target->flags & (ACC_STATIC | ACC_PRIVATE | ACC_ABSTRACT | ACC_NATIVE | ACC_SYNCHRONIZED)) ||
+		((call->opc == ICMD_INVOKEVIRTUAL) && (target->vftblindex != callee->vftblindex)))
+	{
+		DOLOG_SHORT( printf("NOT GUARDED: "); method_print((methodinfo *) callee);
+					 printf(" for receiver "); class_println(c); );
+		return false;
+	}
+
+	DOLOG_SHORT( printf("GUARDED INLINE: "); method_print(target);
+				 printf(" for receiver "); class_println(c); );
+
+	site->guard  = c;
+	site->target = target;
+
+	return true;
+#else
+	return false;
+#endif
+}
+
+
 /* inline_can_inline ***********************************************************
 
    Check if inlining of the given call site is possible.
@@ -2365,6 +2652,8 @@ static bool inline_is_monomorphic(const methodinfo *callee,
    OUT:
        site->speculative.....flags whether the inlining is speculative
 	                         (only defined if return value is true)
+       site->guard...........the receiver class to check, or NULL
+       site->target..........the method to inline
 
    RETURN VALUE:
        true if inlining is possible, false if not
@@ -2383,15 +2672,23 @@ static bool inline_can_inline(const inline_node *caller,
 	if (callee->flags & ACC_NATIVE)
 		return false;
 
-	/* cannot inline possibly polymorphic calls */
+	/* cannot inline possibly polymorphic calls, unless the profiled */
+	/* receivers allow inlining behind a check of their class        */
 
-	if (!inline_is_monomorphic(callee, call, site))
-		return false;
+	site->guard  = NULL;
+	site->target = (methodinfo *) callee;
+
+	if (!inline_is_monomorphic(callee, call, site)) {
+		if (!inline_is_guardable(caller, callee, call, site))
+			return false;
+
+		site->speculative = false;
+	}
 
 	/* cannot inline recursive calls */
 
 	for (active = caller; active; active = active->parent) {
-		if (callee == active->m) {
+		if (site->target == active->m) {
 			DOLOG( printf("RECURSIVE!\n") );
 			return false;
 		}
@@ -2463,6 +2760,7 @@ static void inline_set_callee_properties(const inline_node *caller,
 	cn->callerpc = site->pc;
 	cn->o_handlers = site->handlers;
 	cn->n_handlercount = caller->n_handlercount + site->nhandlers;
+	cn->guard = site->guard;
 
 	/* determine if we need basic block boundaries before/after */
 
@@ -2485,6 +2783,11 @@ static void inline_set_callee_properties(const inline_node *caller,
 	if (cn->jd->returnblock != bptr)
 		cn->blockafter = true;
 
+	/* the normal call of a guarded callee joins the body after it */
+
+	if (cn->guard)
+		cn->blockafter = true;
+
 	/* info about the callee */
 
 	cn->localsoffset = caller->localsoffset + caller->m->maxlocals;
@@ -2493,10 +2796,17 @@ static void inline_set_callee_properties(const inline_node *caller,
 	cn->extra_instructioncount = 0;
 
 	/* we need a CHECKNULL for instance methods, except for <init> */
+	/* and guarded callees, whose receiver check rejects NULL      */
 
-	if (!cn->isstatic && cn->m->name != utf8::init)
+	if (!cn->isstatic && cn->m->name != utf8::init && !cn->guard)
 		cn->prolog_instructioncount += 1;
 
+	/* guarded callees need a COPY of the receiver, the check, and */
+	/* the normal call followed by a GOTO                          */
+
+	if (cn->guard)
+		cn->extra_instructioncount += 4;
+
 	/* deal with synchronized callees */
 
 	if (cn->synchronize) {
@@ -2613,6 +2923,10 @@ static void inline_cumulate_counters(inline_node *caller,
 		caller->cumul_basicblockcount += 1;
 		caller->cumul_blockmapcount += 1;
 	}
+
+	/* blocks of the inlined body and of the normal call after a check */
+	if (cn->guard)
+		caller->cumul_basicblockcount += 2;
 }
 
 
@@ -2838,13 +3152,13 @@ static bool inline_analyse_code(inline_node *iln)
 							site.handlers = handlers;
 							site.nhandlers = nhandlers;
 
-							if (inline_pre_parse_heuristics(iln, callee, &site)) {
+							if (inline_pre_parse_heuristics(iln, site.target, &site)) {
 #if defined(INLINE_KNAPSACK) || defined(INLINE_BREADTH_FIRST)
-								inline_add_candidate(iln->ctx, iln, callee, &site);
+								inline_add_candidate(iln->ctx, iln, site.target, &site);
 #else
 								inline_candidate cand;
 								cand.caller = iln;
-								cand.callee = callee;
+								cand.callee = site.target;
 								cand.site   = site;
 
 								if (!inline_process_candidate(&cand))
@@ -0,0 +1,407 @@
+/* src/vm/jit/invoker.cpp - specialized invokers for reflective calls
+
+   Copyright (C) 1996-2013
+   CACAOVM - Verein zur Foerderung der freien virtuellen Maschine CACAO
+
+   This file is part of CACAO.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation; either version 2, or (at
+   your option) any later version.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA.
+
+*/
+
+
+#include "config.h"
+
+#include <cassert>
+#include <stdint.h>
+
+#include "arch.hpp"
+#include "md-abi.hpp"
+
+#include "mm/memory.hpp"
+
+#include "native/llni.hpp"
+
+#include "threads/atomic.hpp"
+#include "threads/thread.hpp"
+
+#include "vm/array.hpp"
+#include "vm/class.hpp"
+#include "vm/descriptor.hpp"
+#include "vm/exceptions.hpp"
+#include "vm/global.hpp"
+#include "vm/globals.hpp"
+#include "vm/method.hpp"
+#include "vm/options.hpp"
+#include "vm/os.hpp"
+#include "vm/primitive.hpp"
+#include "vm/resolve.hpp"
+#include "vm/statistics.hpp"
+#include "vm/utf8.hpp"
+
+#include "vm/jit/argument.hpp"
+#include "vm/jit/asmpart.hpp"
+#include "vm/jit/builtin.hpp"
+#include "vm/jit/code.hpp"
+#include "vm/jit/invoker.hpp"
+#include "vm/jit/jit.hpp"
+
+
+STAT_REGISTER_GROUP(invoker_stat,"invoker","reflective invokers")
+STAT_REGISTER_GROUP_VAR(int,count_invoker_calls,0,"calls","reflective method calls",invoker_stat)
+STAT_REGISTER_GROUP_VAR(int,count_invoker_fast,0,"invoker calls","reflective method calls through an invoker",invoker_stat)
+STAT_REGISTER_GROUP_VAR(int,count_invoker_created,0,"invokers","invokers created",invoker_stat)
+
+
+/* The argument array lives on the C stack.  Methods needing a larger
+   one keep using vm_call_method_objectarray. */
+
+#define INVOKER_MAX_ARRAY    64
+
+
+/* invokerinfo ****************************************************************/
+
+struct invokerparam {
+	paramdesc *pd;                      // where the argument is passed
+	int32_t    type;                    // TYPE_??? of the parameter
+	int32_t    primitivetype;           // PRIMITIVETYPE_??? of the parameter
+	classinfo *c;                       // required class, NULL for any reference
+	bool       isarray;                 // c is an array class
+};
+
+struct invokerinfo {
+	methodinfo   *m;
+	bool          isvirtual;            // target is looked up in the vftbl
+	int32_t       paramcount;           // without the `this' pointer
+	invokerparam *params;
+};
+
+
+/* invoker_create **************************************************************
+
+   Resolves everything a reflective call of the method needs.  Returns
+   NULL if the method cannot get an invoker (yet).
+
+*******************************************************************************/
+
+static invokerinfo *invoker_create(methodinfo *m)
+{
+	methoddesc *md = m->parseddesc;
+
+	if (INT_ARG_CNT + FLT_ARG_CNT + md->memuse > INVOKER_MAX_ARRAY)
+		return NULL;
+
+	int32_t first = (m->flags & ACC_STATIC) ? 0 : 1;
+
+	invokerinfo *inv = NEW(invokerinfo);
+
+	inv->m          = m;
+	inv->paramcount = md->paramcount - first;
+	inv->params     = MNEW(invokerparam, inv->paramcount);
+
+	/* private, final and static methods and constructors cannot be
+	   overridden */
+
+	inv->isvirtual =
+		!(m->flags & (ACC_STATIC | ACC_PRIVATE | ACC_FINAL)) &&
+		!(m->clazz->flags & ACC_FINAL) &&
+		(m->name != utf8::init);
+
+	for (int32_t i = 0; i < inv->paramcount; i++) {
+		typedesc     *td = &md->paramtypes[first + i];
+		invokerparam *ip = &inv->params[i];
+
+		ip->pd            = &md->params[first + i];
+		ip->type          = td->type;
+		ip->primitivetype = td->primitivetype;
+		ip->c             = NULL;
+		ip->isarray       = false;
+
+		if (td->type == TYPE_ADR) {
+			classinfo *c;
+
+			/* The generic path reports the error on every call, so we
+			   just give up for now. */
+
+			if (!resolve_class_from_typedesc(td, true, true, &c)) {
+				exceptions_clear_exception();
+				invoker_free(inv);
+				return NULL;
+			}
+
+			if (c != class_java_lang_Object) {
+				ip->c       = c;
+				ip->isarray = (td->arraydim > 0);
+			}
+		}
+	}
+
+	return inv;
+}
+
+
+/* invoker_get *****************************************************************
+
+   Returns the invoker of a method which is about to be invoked
+   reflectively, creating it if the method was invoked often enough.
+   Returns NULL if the generic path has to be used.
+
+*******************************************************************************/
+
+invokerinfo *invoker_get(methodinfo *m)
+{
+	STATISTICS(count_invoker_calls++);
+
+	if (opt_ReflectionInvokerThreshold <= 0)
+		return NULL;
+
+	invokerinfo *inv = m->invoker;
+
+	if (inv == NULL) {
+		/* The counter is not exact, a lost update only delays the
+		   invoker. */
+
+		if (++m->invokecount < opt_ReflectionInvokerThreshold)
+			return NULL;
+
+		m->invokecount = 0;
+
+		inv = invoker_create(m);
+
+		if (inv == NULL)
+			return NULL;
+
+		/* another thread might have been faster */
+
+		Atomic::write_memory_barrier();
+
+		invokerinfo *old = Atomic::compare_and_swap(&m->invoker, (invokerinfo *) NULL, inv);
+
+		if (old != NULL) {
+			invoker_free(inv);
+			inv = old;
+		}
+		else
+			STATISTICS(count_invoker_created++);
+	}
+
+	STATISTICS(count_invoker_fast++);
+
+	return inv;
+}
+
+
+/* invoker_fill ****************************************************************
+
+   Fills the argument array from the `this' pointer and the boxed
+   parameters.  Returns false if a parameter has the wrong type.
+
+   ATTENTION: This function has to be used outside the nativeworld.
+
+*******************************************************************************/
+
+static bool invoker_fill(invokerinfo *inv, uint64_t *array, java_handle_t *o,
+						 java_handle_objectarray_t *params)
+{
+	if (o != NULL)
+		argument_vmarray_store_adr(array, &inv->m->parseddesc->params[0], o);
+
+	ObjectArray oa(params);
+
+	for (int32_t i = 0; i < inv->paramcount; i++) {
+		invokerparam  *ip    = &inv->params[i];
+		java_handle_t *param = oa.get_element(i);
+
+		if (ip->type == TYPE_ADR) {
+			if ((param != NULL) && (ip->c != NULL)) {
+				if (ip->isarray ? !builtin_arrayinstanceof(param, ip->c)
+					            : !builtin_instanceof(param, ip->c))
+					return false;
+			}
+
+			argument_vmarray_store_adr(array, ip->pd, param);
+			continue;
+		}
+
+		if (param == NULL)
+			return false;
+
+		int type = Primitive::get_type_by_wrapper(param);
+
+		/* unbox and widen to the parameter type, like
+		   argument_vmarray_from_objectarray does */
+
+		imm_union value = Primitive::unbox(param);
+
+		if (!Primitive::widen(type, ip->primitivetype, &value))
+			return false;
+
+		switch (ip->type) {
+		case TYPE_INT:
+			argument_vmarray_store_int(array, ip->pd, value.i);
+			break;
+		case TYPE_LNG:
+			argument_vmarray_store_lng(array, ip->pd, value.l);
+			break;
+		case TYPE_FLT:
+			argument_vmarray_store_flt(array, ip->pd, value.l);
+			break;
+		case TYPE_DBL:
+			argument_vmarray_store_dbl(array, ip->pd, value.l);
+			break;
+		default:
+			os::abort("invoker_fill: invalid type %d", ip->type);
+		}
+	}
+
+	return true;
+}
+
+
+/* invoker_invoke **************************************************************
+
+   Calls the method of the invoker like vm_call_method_objectarray.
+   The caller has checked the receiver and the number of parameters.
+   Returns the boxed return value.
+
+*******************************************************************************/
+
+java_handle_t *invoker_invoke(invokerinfo *inv, java_handle_t *o,
+							  java_handle_objectarray_t *params)
+{
+	methodinfo    *m  = inv->m;
+	methoddesc    *md = m->parseddesc;
+	methodinfo    *resm;
+	uint64_t       array[INVOKER_MAX_ARRAY];
+	java_handle_t *ro;
+	java_handle_t *xptr;
+	imm_union      value;
+
+	ro = NULL;
+
+	if (inv->isvirtual) {
+		assert(o != NULL);
+		resm = method_vftbl_lookup(LLNI_vftbl_direct(o), m);
+	}
+	else
+		resm = m;
+
+	/* compile methods which are not yet compiled */
+
+	if (resm->code == NULL)
+		if (!jit_compile(resm))
+			return NULL;
+
+	/* leave the nativeworld */
+
+	THREAD_NATIVEWORLD_EXIT;
+
+	if (!invoker_fill(inv, array, o, params)) {
+		/* enter the nativeworld again */
+
+		THREAD_NATIVEWORLD_ENTER;
+
+		exceptions_throw_illegalargumentexception();
+
+		return NULL;
+	}
+
+	void *pv = resm->code->entrypoint;
+
+	switch (md->returntype.primitivetype) {
+	case PRIMITIVETYPE_VOID:
+		(void) asm_vm_call_method(pv, array, md->memuse);
+		break;
+
+	case PRIMITIVETYPE_BOOLEAN:
+	case PRIMITIVETYPE_BYTE:
+	case PRIMITIVETYPE_CHAR:
+	case PRIMITIVETYPE_SHORT:
+	case PRIMITIVETYPE_INT:
+		value.i = asm_vm_call_method_int(pv, array, md->memuse);
+		break;
+
+	case PRIMITIVETYPE_LONG:
+		value.l = asm_vm_call_method_long(pv, array, md->memuse);
+		break;
+
+	case PRIMITIVETYPE_FLOAT:
+		value.f = asm_vm_call_method_float(pv, array, md->memuse);
+		break;
+
+	case PRIMITIVETYPE_DOUBLE:
+		value.d = asm_vm_call_method_double(pv, array, md->memuse);
+		break;
+
+	case TYPE_ADR:
+		ro = LLNI_WRAP(asm_vm_call_method(pv, array, md->memuse));
+		break;
+
+	default:
+		os::abort("invoker_invoke: invalid return type %d", md->returntype.primitivetype);
+	}
+
+	/* enter the nativeworld again */
+
+	THREAD_NATIVEWORLD_ENTER;
+
+	/* box the return value if necesarry */
+
+	if (md->returntype.primitivetype != (PrimitiveType) TYPE_ADR)
+		ro = Primitive::box(md->returntype.primitivetype, value);
+
+	/* check for an exception */
+
+	xptr = exceptions_get_exception();
+
+	if (xptr != NULL) {
+		/* clear exception pointer, we are calling JIT code again */
+
+		exceptions_clear_exception();
+
+		exceptions_throw_invocationtargetexception(xptr);
+	}
+
+	return ro;
+}
+
+
+/* invoker_free ****************************************************************
+
+   Frees an invoker.
+
+*******************************************************************************/
+
+void invoker_free(invokerinfo *inv)
+{
+	MFREE(inv->params, invokerparam, inv->paramcount);
+	FREE(inv, invokerinfo);
+}
+
+
+/*
+ * These are local overrides for various environment variables in Emacs.
+ * Please do not remove this and leave it at the end of the file, where
+ * Emacs will automagically detect them.
+ * ---------------------------------------------------------------------
+ * Local variables:
+ * mode: c++
+ * indent-tabs-mode: t
+ * c-basic-offset: 4
+ * tab-width: 4
+ * End:
+ * vim:noexpandtab:sw=4:ts=4:
+ */
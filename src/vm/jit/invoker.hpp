@@ -0,0 +1,73 @@
+/* src/vm/jit/invoker.hpp - specialized invokers for reflective calls
+
+   Copyright (C) 1996-2013
+   CACAOVM - Verein zur Foerderung der freien virtuellen Maschine CACAO
+
+   This file is part of CACAO.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation; either version 2, or (at
+   your option) any later version.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA.
+
+*/
+
+
+#ifndef _INVOKER_HPP
+#define _INVOKER_HPP
+
+#include "config.h"
+
+#include "vm/global.hpp"                // for java_handle_t, etc
+
+struct invokerinfo;
+struct methodinfo;
+
+
+/* Reflective invokers *********************************************************
+
+   Method.invoke goes through vm_call_method_objectarray, which
+   resolves the class of every reference parameter, looks up the
+   wrapper type of every boxed parameter and builds the argument array
+   in dump memory on every call.
+
+   Once a method was invoked reflectively -XX:ReflectionInvokerThreshold
+   times it gets an invoker, which has all of that worked out in
+   advance.  The invoker is kept in the methodinfo and fills the
+   argument array on the C stack, skips the vftbl lookup for methods
+   which cannot be overridden and calls the compiled code directly.
+
+*******************************************************************************/
+
+/* function prototypes ********************************************************/
+
+invokerinfo   *invoker_get(methodinfo *m);
+java_handle_t *invoker_invoke(invokerinfo *inv, java_handle_t *o, java_handle_objectarray_t *params);
+void           invoker_free(invokerinfo *inv);
+
+#endif /* _INVOKER_HPP */
+
+
+/*
+ * These are local overrides for various environment variables in Emacs.
+ * Please do not remove this and leave it at the end of the file, where
+ * Emacs will automagically detect them.
+ * ---------------------------------------------------------------------
+ * Local variables:
+ * mode: c++
+ * indent-tabs-mode: t
+ * c-basic-offset: 4
+ * tab-width: 4
+ * End:
+ * vim:noexpandtab:sw=4:ts=4:
+ */
@@ -318,6 +318,8 @@ enum ICMD {
 	ICMD_IMULPOW2         = 214,
 	ICMD_LMULPOW2         = 215,
 
+	ICMD_IF_CLASSNE       = 240,        /* receiver guard of inlined method   */
+
 	ICMD_GETEXCEPTION     = 249,
 	ICMD_PHI              = 250,
 
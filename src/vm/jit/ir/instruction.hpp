@@ -129,7 +129,9 @@ enum InstructionFlag {
 	                             // for BUILTIN: check exception
 	INS_FLAG_KILL_PREV  = 0x04,  // for *STORE, invalidate prev local
 	INS_FLAG_KILL_NEXT  = 0x08,  // for *STORE, invalidate next local
-	INS_FLAG_RETADDR    = 0x10   // for ASTORE: op is a returnAddress
+	INS_FLAG_RETADDR    = 0x10,  // for ASTORE: op is a returnAddress
+	INS_FLAG_PROFILED   = 0x04   // for CHECKCAST/INSTANCEOF/AASTORE: test
+	                             // the class seen by the baseline tier first
 };
 
 #define INS_FLAG_ID_SHIFT      5
@@ -220,6 +222,7 @@ struct insinfo_inline {
 	int32_t         paramcount;     /* number of parameters of original call  */
 	int32_t         stackvarscount; /* source stackdepth at INLINE_START      */
 	int32_t        *stackvars;      /* stack vars at INLINE_START             */
+	int32_t         line;           /* line of the call in the outer method   */
 
 	/* fields set by inlining ------------------------------------------------*/
 	int32_t    *javalocals_start; /* javalocals at start of inlined body      */
@@ -232,6 +235,7 @@ struct insinfo_inline {
 
 	/* fields set by the codegen ---------------------------------------------*/
 	int32_t     startmpc;       /* machine code offset of start of inlining   */
+	int32_t     scope;          /* linenumber table scope of the body         */
 };
 
 
@@ -36,15 +36,20 @@
 #include "vm/hook.hpp"                     // for jit_generated
 #include "vm/initialize.hpp"               // for initialize_class
 #include "vm/jit/jit.hpp"
+#include "vm/jit/builtin.hpp"              // for builtin_nanotime
 #include "vm/jit/allocator/simplereg.hpp"  // for regalloc, etc
 #include "vm/jit/cfg.hpp"                  // for cfg_build
 #include "vm/jit/code.hpp"                 // for codeinfo, etc
 #include "vm/jit/codegen-common.hpp"       // for codegen_setup, etc
+#include "vm/jit/compilelog.hpp"           // for compilelog_start, etc
 #include "vm/jit/disass.hpp"
 #include "vm/jit/dseg.hpp"                 // for dseg_display
 #include "vm/jit/ir/bytecode.hpp"
 #include "vm/jit/ir/icmd.hpp"              // for ::ICMD_IFNONNULL, etc
 #include "vm/jit/optimizing/ifconv.hpp"    // for ifconv_static
+#include "vm/jit/optimizing/checkelim.hpp"
+#include "vm/jit/optimizing/lockelision.hpp"
+#include "vm/jit/optimizing/scalar.hpp"
 #include "vm/jit/optimizing/reorder.hpp"
 #include "vm/jit/parse.hpp"                // for parse
 #include "vm/jit/reg.hpp"                  // for reg_setup, registerdata
@@ -81,6 +86,25 @@
 # include "vm/jit/loop/loop.hpp"
 #endif
 
+#if defined(ENABLE_THREADS)
+# include "vm/jit/optimizing/recompiler.hpp"
+# include "vm/jit/optimizing/tiered.hpp"
+# include "vm/jit/optimizing/typeprofile.hpp"
+#endif
+
+/* tiered compilation *********************************************************/
+
+/* With tiered compilation the optional optimizations are only applied
+   by the optimizing tier.  Those marked by JITDATA_FLAG_OPTIMIZE are
+   not applied at all without it, jit_recompile sets the flag. */
+
+#if defined(ENABLE_THREADS)
+# define JIT_IS_BASELINE_TIER(jd) \
+    (opt_TieredCompilation && ((jd)->code->optlevel == TIER_BASELINE))
+#else
+# define JIT_IS_BASELINE_TIER(jd)    false
+#endif
+
 /* debug macros ***************************************************************/
 
 #if !defined(NDEBUG)
@@ -242,6 +266,7 @@ jitdata *jit_jitdata_new(methodinfo *m)
 
 	jd->code                 = code;
 	jd->flags                = 0;
+	jd->log                  = NULL;
 	jd->exceptiontable       = NULL;
 	jd->exceptiontablelength = 0;
 	jd->returncount          = 0;
@@ -265,8 +290,9 @@ static u1 *jit_compile_intern(jitdata *jd);
 
 u1 *jit_compile(methodinfo *m)
 {
-	u1      *r;
-	jitdata *jd;
+	u1               *r;
+	jitdata          *jd;
+	compilelog_entry  log;
 
 	STATISTICS(count_jit_calls++);
 
@@ -315,6 +341,10 @@ u1 *jit_compile(methodinfo *m)
 		compilingtime_start();
 #endif
 
+#if defined(ENABLE_THREADS)
+	int64_t start = opt_TieredCompilation ? builtin_nanotime() : 0;
+#endif
+
 	// Create new dump memory area.
 	DumpMemoryArea dma;
 
@@ -326,6 +356,11 @@ u1 *jit_compile(methodinfo *m)
 
 	jd->flags = JITDATA_FLAG_PARSE;
 
+#if defined(ENABLE_THREADS)
+	if (opt_TieredCompilation)
+		jd->flags |= JITDATA_FLAG_TIERCOUNT;
+#endif
+
 #if defined(ENABLE_VERIFIER)
 	if (opt_verify)
 		jd->flags |= JITDATA_FLAG_VERIFY;
@@ -337,12 +372,12 @@ u1 *jit_compile(methodinfo *m)
 #endif
 
 #if defined(ENABLE_IFCONV)
-	if (opt_ifconv)
+	if (opt_ifconv && !JIT_IS_BASELINE_TIER(jd))
 		jd->flags |= JITDATA_FLAG_IFCONV;
 #endif
 
 #if defined(ENABLE_INLINING) && defined(ENABLE_INLINING_DEBUG)
-	if (opt_Inline && opt_InlineAll)
+	if (opt_Inline && opt_InlineAll && !JIT_IS_BASELINE_TIER(jd))
 		jd->flags |= JITDATA_FLAG_INLINE;
 #endif
 
@@ -375,10 +410,14 @@ u1 *jit_compile(methodinfo *m)
 
 	codegen_setup(jd);
 
+	compilelog_start(jd, &log);
+
 	/* now call internal compile function */
 
 	r = jit_compile_intern(jd);
 
+	compilelog_finish(jd, r != NULL);
+
 	if (r == NULL) {
 		/* We had an exception! Finish stuff here if necessary. */
 
@@ -388,6 +427,11 @@ u1 *jit_compile(methodinfo *m)
 	}
 	else {
 		DEBUG_JIT_COMPILEVERBOSE("Running: ");
+
+#if defined(ENABLE_THREADS)
+		if (opt_TieredCompilation)
+			tiered_compiled(jd->code, builtin_nanotime() - start);
+#endif
 	}
 
 #if defined(ENABLE_STATISTICS)
@@ -418,9 +462,10 @@ u1 *jit_compile(methodinfo *m)
 
 u1 *jit_recompile(methodinfo *m)
 {
-	u1      *r;
-	jitdata *jd;
-	u1       optlevel;
+	u1               *r;
+	jitdata          *jd;
+	u1                optlevel;
+	compilelog_entry  log;
 
 	/* check for max. optimization level */
 
@@ -443,6 +488,10 @@ u1 *jit_recompile(methodinfo *m)
 		compilingtime_start();
 #endif
 
+#if defined(ENABLE_THREADS)
+	int64_t start = opt_TieredCompilation ? builtin_nanotime() : 0;
+#endif
+
 	// Create new dump memory area.
 	DumpMemoryArea dma;
 
@@ -473,6 +522,19 @@ u1 *jit_recompile(methodinfo *m)
 		jd->flags |= JITDATA_FLAG_INLINE;
 #endif
 
+#if defined(ENABLE_THREADS)
+	/* the optimizing tier applies what the baseline tier left out */
+
+	if (opt_TieredCompilation) {
+		jd->flags |= JITDATA_FLAG_OPTIMIZE;
+
+# if defined(ENABLE_IFCONV)
+		if (opt_ifconv)
+			jd->flags |= JITDATA_FLAG_IFCONV;
+# endif
+	}
+#endif
+
 #if defined(ENABLE_JIT)
 # if defined(ENABLE_INTRP)
 	if (!opt_intrp)
@@ -486,10 +548,14 @@ u1 *jit_recompile(methodinfo *m)
 
 	codegen_setup(jd);
 
+	compilelog_start(jd, &log);
+
 	/* now call internal compile function */
 
 	r = jit_compile_intern(jd);
 
+	compilelog_finish(jd, r != NULL);
+
 	if (r == NULL) {
 		/* We had an exception! Finish stuff here if necessary. */
 
@@ -497,6 +563,11 @@ u1 *jit_recompile(methodinfo *m)
 
 		code_codeinfo_free(jd->code);
 	}
+#if defined(ENABLE_THREADS)
+	else if (opt_TieredCompilation) {
+		tiered_compiled(jd->code, builtin_nanotime() - start);
+	}
+#endif
 
 #if defined(ENABLE_STATISTICS)
 	/* measure time */
@@ -630,6 +701,7 @@ static u1 *jit_compile_intern(jitdata *jd)
 	if (!opt_intrp) {
 # endif
 		RT_TIMER_START(stack_timer);
+		COMPILELOG_PHASE(jd, COMPILELOG_PHASE_STACK);
 		DEBUG_JIT_COMPILEVERBOSE("Analysing: ");
 
 		/* call stack analysis pass */
@@ -640,6 +712,7 @@ static u1 *jit_compile_intern(jitdata *jd)
 			return NULL;
 		}
 		RT_TIMER_STOPSTART(stack_timer,typechecker_timer);
+		COMPILELOG_PHASE(jd, COMPILELOG_PHASE_VERIFY);
 
 		DEBUG_JIT_COMPILEVERBOSE("Analysing done: ");
 
@@ -658,6 +731,7 @@ static u1 *jit_compile_intern(jitdata *jd)
 		}
 #endif
 		RT_TIMER_STOPSTART(typechecker_timer,loop_timer);
+		COMPILELOG_PHASE(jd, COMPILELOG_PHASE_OPTIMIZE);
 
 #if defined(ENABLE_IFCONV)
 		if (JITDATA_HAS_FLAG_IFCONV(jd)) {
@@ -678,7 +752,7 @@ static u1 *jit_compile_intern(jitdata *jd)
 #endif
 
 #if defined(ENABLE_SSA)
-		if (opt_lsra) {
+		if (opt_lsra && !JIT_IS_BASELINE_TIER(jd)) {
 			fix_exception_handlers(jd);
 		}
 #endif
@@ -690,7 +764,7 @@ static u1 *jit_compile_intern(jitdata *jd)
 			return NULL;
 
 #if defined(ENABLE_LOOP)
-		if (opt_loops)
+		if (opt_loops && !JIT_IS_BASELINE_TIER(jd))
 		{
 			removeArrayBoundChecks(jd);
 			jit_renumber_basicblocks(jd);
@@ -700,28 +774,57 @@ static u1 *jit_compile_intern(jitdata *jd)
 				return NULL;
 		}
 #endif
+
+		/* propagate constants, remove redundant computations */
+
+		if (opt_ScalarOptimizations && JITDATA_HAS_FLAG_OPTIMIZE(jd)) {
+			if (!scalar_optimize(jd))
+				return NULL;
+		}
+
+		/* remove monitor operations on objects local to the method */
+
+		if (opt_EliminateLocks && JITDATA_HAS_FLAG_OPTIMIZE(jd))
+			lockelision(jd);
+
+		/* remove null and type checks known to succeed */
+
+		if (opt_EliminateChecks && JITDATA_HAS_FLAG_OPTIMIZE(jd))
+			checkelim(jd);
 		RT_TIMER_STOPSTART(ra_timer,loop_timer);
 
-#if defined(ENABLE_PROFILING)
-		/* Basic block reordering.  I think this should be done after
-		   if-conversion, as we could lose the ability to do the
+		/* Basic block reordering: exception handlers and rarely executed
+		   blocks go behind the hot code.  I think this should be done
+		   after if-conversion, as we could lose the ability to do the
 		   if-conversion. */
 
-		if (JITDATA_HAS_FLAG_REORDER(jd)) {
+		if (((opt_HotColdSplitting && JITDATA_HAS_FLAG_OPTIMIZE(jd)) || JITDATA_HAS_FLAG_REORDER(jd))
+#if defined(ENABLE_LSRA) || defined(ENABLE_SSA)
+			&& !opt_lsra
+#endif
+			) {
 			if (!reorder(jd))
 				return NULL;
 			jit_renumber_basicblocks(jd);
 		}
+
+#if defined(ENABLE_THREADS)
+		/* test the classes seen by the checks of the baseline code
+		   first */
+
+		if (!JIT_IS_BASELINE_TIER(jd))
+			typeprofile_select(jd);
 #endif
 
 #if defined(ENABLE_PM_HACKS)
 #include "vm/jit/jit_pm_2.inc"
 #endif
 		DEBUG_JIT_COMPILEVERBOSE("Allocating registers: ");
+		COMPILELOG_PHASE(jd, COMPILELOG_PHASE_REGALLOC);
 
 #if defined(ENABLE_LSRA) && !defined(ENABLE_SSA)
 		/* allocate registers */
-		if (opt_lsra) {
+		if (opt_lsra && !JIT_IS_BASELINE_TIER(jd)) {
 			if (!lsra(jd))
 				return NULL;
 
@@ -762,6 +865,7 @@ static u1 *jit_compile_intern(jitdata *jd)
 # endif
 #endif /* defined(ENABLE_JIT) */
 	RT_TIMER_START(codegen_timer);
+	COMPILELOG_PHASE(jd, COMPILELOG_PHASE_CODEGEN);
 
 #if defined(ENABLE_PROFILING)
 	/* Allocate memory for basic block profiling information. This
@@ -774,6 +878,13 @@ static u1 *jit_compile_intern(jitdata *jd)
 	}
 #endif
 
+#if defined(ENABLE_THREADS)
+	/* Allocate memory for the type profiles of baseline code. */
+
+	if (JITDATA_HAS_FLAG_TIERCOUNT(jd))
+		typeprofile_create(jd);
+#endif
+
 	DEBUG_JIT_COMPILEVERBOSE("Generating code: ");
 
 	/* now generate the machine code */
@@ -1002,6 +1113,13 @@ void* jit_asm_compile(methodinfo *m, void* mptr, void* sp, void* ra)
 
 	md_icacheflush(pa, SIZEOF_VOID_P);
 
+#if defined(ENABLE_THREADS)
+	/* the optimizing tier rebinds statically bound calls */
+
+	if (opt_TieredCompilation)
+		recompile_record_call(m, sfi.pv, pa);
+#endif
+
 	return entrypoint;
 }
 }
@@ -1048,6 +1166,13 @@ void *jit_compile_handle(methodinfo *m, void *pv, void *ra, void *mptr)
 
 	md_cacheflush(pa, SIZEOF_VOID_P);
 
+#if defined(ENABLE_THREADS)
+	/* The optimizing tier rebinds statically bound calls. */
+
+	if (opt_TieredCompilation)
+		recompile_record_call(m, pv, pa);
+#endif
+
 	return newpv;
 }
 #endif /* defined(ENABLE_JIT) */
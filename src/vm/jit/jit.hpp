@@ -57,6 +57,7 @@ struct basicblock;
 struct branchref;
 struct codegendata;
 struct codeinfo;
+struct compilelog_entry;
 struct exception_entry;
 struct insinfo_inline;
 struct instruction;
@@ -136,6 +137,7 @@ struct jitdata {
 #endif
 
 	u4               flags;           /* contains JIT compiler flags          */
+	compilelog_entry *log;            /* compilation log record, or NULL      */
 
 	instruction     *instructions;    /* ICMDs, valid between parse and stack */
 	basicblock      *basicblocks;     /* start of basic block list            */
@@ -189,8 +191,10 @@ struct jitdata {
 #define JITDATA_FLAG_IFCONV              0x00000008
 #define JITDATA_FLAG_REORDER             0x00000010
 #define JITDATA_FLAG_INLINE              0x00000020
+#define JITDATA_FLAG_OPTIMIZE            0x00000040
 
 #define JITDATA_FLAG_COUNTDOWN           0x00000100
+#define JITDATA_FLAG_TIERCOUNT           0x00000200
 
 #define JITDATA_FLAG_SHOWINTERMEDIATE    0x20000000
 #define JITDATA_FLAG_SHOWDISASSEMBLE     0x40000000
@@ -215,9 +219,15 @@ struct jitdata {
 #define JITDATA_HAS_FLAG_INLINE(jd) \
     ((jd)->flags & JITDATA_FLAG_INLINE)
 
+#define JITDATA_HAS_FLAG_OPTIMIZE(jd) \
+    ((jd)->flags & JITDATA_FLAG_OPTIMIZE)
+
 #define JITDATA_HAS_FLAG_COUNTDOWN(jd) \
     ((jd)->flags & JITDATA_FLAG_COUNTDOWN)
 
+#define JITDATA_HAS_FLAG_TIERCOUNT(jd) \
+    ((jd)->flags & JITDATA_FLAG_TIERCOUNT)
+
 #define JITDATA_HAS_FLAG_SHOWINTERMEDIATE(jd) \
     ((jd)->flags & JITDATA_FLAG_SHOWINTERMEDIATE)
 
@@ -283,6 +293,7 @@ static inline bool var_is_saved(const jitdata *jd, s4 i) {
 /* basicblock *****************************************************************/
 
 #define BBFLAG_REPLACEMENT   0x01  /* put a replacement point at the start    */
+#define BBFLAG_LOOPHEADER    0x02  /* target of a backward branch             */
 
 /* XXX basicblock wastes quite a lot of memory by having four flag fields     */
 /* (flags, bitflags, type and lflags). Probably the last three could be       */
@@ -48,8 +48,7 @@ STAT_DECLARE_VAR(int,size_linenumbertable,0)
 /**
  * Resolve the linenumber.
  *
- * If the entry contains an mcode pointer (normal case), resolve it
- * (see doc/inlining_stacktrace.txt for details).
+ * The entry contains an mcode offset, make it a PC.
  *
  * @param code Code structure.
  */
@@ -57,21 +56,21 @@ void Linenumber::resolve(const codeinfo* code)
 {
 	void* pv = ADDR_MASK(void*, code->entrypoint);
 
-	// TODO Use constant.
-	if (_linenumber >= -2)
-		_pc = (void*) ((uintptr_t) pv + (uintptr_t) _pc);
+	_pc = (void*) ((uintptr_t) pv + (uintptr_t) _pc);
 }
 
 
 /**
  * Creates a linenumber table.
  *
- * We allocate an array and store the linenumber entry in
- * reverse-order, so we can search the correct linenumber more easily.
+ * The entries were added in the order the code was generated, so they
+ * are already sorted by PC.
  *
  * @param jd JIT data.
  */
-LinenumberTable::LinenumberTable(jitdata* jd) : _linenumbers(jd->cd->linenumbers->begin(), jd->cd->linenumbers->end())
+LinenumberTable::LinenumberTable(jitdata* jd) :
+	_linenumbers(jd->cd->linenumbers->begin(), jd->cd->linenumbers->end()),
+	_scopes(jd->cd->inlinescopes->begin(), jd->cd->inlinescopes->end())
 {
 	// Get required compiler data.
 	codeinfo* code = jd->code;
@@ -79,7 +78,8 @@ LinenumberTable::LinenumberTable(jitdata* jd) : _linenumbers(jd->cd->linenumbers
 	STATISTICS(count_linenumbertable++);
 	STATISTICS(size_linenumbertable +=
 		sizeof(LinenumberTable) +
-		sizeof(Linenumber) * _linenumbers.size());
+		sizeof(Linenumber) * _linenumbers.size() +
+		sizeof(InlineScope) * _scopes.size());
 
 	// Resolve all linenumbers in the vector.
 	(void) for_each(_linenumbers.begin(), _linenumbers.end(), std::bind2nd(LinenumberResolver(), code));
@@ -87,70 +87,102 @@ LinenumberTable::LinenumberTable(jitdata* jd) : _linenumbers(jd->cd->linenumbers
 
 
 /**
- * Search the the line number table for the line corresponding to a
- * given program counter.
+ * Returns the last entry at or before the given program counter, NULL
+ * if there is none.
  *
  * @param pc Program counter.
- *
- * @return Line number.
  */
-int32_t LinenumberTable::find(methodinfo **pm, void* pc)
+const Linenumber* LinenumberTable::lookup(void* pc) const
 {
 	void* maskpc = ADDR_MASK(void*, pc);
 
-	std::vector<Linenumber>::iterator it = find_if(_linenumbers.begin(), _linenumbers.end(), std::bind2nd(comparator(), maskpc));
+	std::vector<Linenumber>::const_iterator it = std::upper_bound(_linenumbers.begin(), _linenumbers.end(), maskpc, comparator());
+
+	if (it == _linenumbers.begin())
+		return NULL;
+
+	--it;
+
+	return &*it;
+}
+
+
+/**
+ * Search the line number table for the line corresponding to a given
+ * program counter.  If the program counter lies in an inlined method,
+ * the innermost one is returned in pm.
+ *
+ * @param pm Method of the code, set to the inlined method if any.
+ * @param pc Program counter.
+ *
+ * @return Line number, 0 if unknown.
+ */
+int32_t LinenumberTable::find(methodinfo **pm, void* pc)
+{
+	const Linenumber* ln = lookup(pc);
 
 	// No matching entry found.
-	if (it == _linenumbers.end())
+	if (ln == NULL)
 		return 0;
 
-	Linenumber& ln = *it;
-	int32_t linenumber = ln.get_linenumber();
+	if (ln->get_scope() >= 0)
+		*pm = _scopes[ln->get_scope()].get_method();
 
-	// Check for linenumber entry type.
-	if (linenumber < 0) {
-		os::abort("FIX ME!");
+	return ln->get_linenumber();
+}
 
-#if 0
-		// We found a special inline entry (see
-		// doc/inlining_stacktrace.txt for details).
-		switch (linenumber) {
-		case -1:
-			// Begin of an inlined method (ie. INLINE_END instruction.
-			lntinline = --lnte;            /* get entry with methodinfo * */
-			lnte--;                        /* skip the special entry      */
 
-			/* search inside the inlined method */
+/**
+ * Search the line number table for the line corresponding to a given
+ * program counter as seen from one of the virtual frames at that
+ * program counter.  For an enclosing scope this is the line of the
+ * call which was inlined.
+ *
+ * @param pm    Method of the code, set to the method of the scope.
+ * @param pc    Program counter.
+ * @param scope Scope on the chain returned by find_scope.
+ *
+ * @return Line number, 0 if unknown.
+ */
+int32_t LinenumberTable::find(methodinfo **pm, void* pc, int32_t scope)
+{
+	const Linenumber* ln = lookup(pc);
 
-			if (linenumbertable_linenumber_for_pc_intern(pm, lnte, lntsize, pc)) {
-				/* the inlined method contained the pc */
+	if (scope >= 0)
+		*pm = _scopes[scope].get_method();
 
-				*pm = (methodinfo *) lntinline->pc;
+	if (ln == NULL)
+		return 0;
 
-				assert(lntinline->linenumber <= -3);
+	int32_t s = ln->get_scope();
 
-				return (-3) - lntinline->linenumber;
-			}
+	if (s == scope)
+		return ln->get_linenumber();
 
-			/* pc was not in inlined method, continue search.
-			   Entries inside the inlined method will be skipped
-			   because their lntentry->pc is higher than pc.  */
-			break;
+	// Walk up to the scope called from the requested one.
+	while (_scopes[s].get_parent() != scope) {
+		s = _scopes[s].get_parent();
+		assert(s >= 0);
+	}
 
-		case -2: 
-			/* end of inlined method */
+	return _scopes[s].get_linenumber();
+}
 
-			return 0;
 
-			/* default: is only reached for an -3-line entry after
-			   a skipped -2 entry. We can safely ignore it and
-			   continue searching.  */
-		}
-#endif
-	}
+/**
+ * Returns the innermost scope at the given program counter, -1 if it
+ * lies in no inlined method.
+ *
+ * @param pc Program counter.
+ */
+int32_t LinenumberTable::find_scope(void* pc) const
+{
+	if (_scopes.empty())
+		return -1;
 
-	// Normal linenumber entry, return it.
-	return linenumber;
+	const Linenumber* ln = lookup(pc);
+
+	return (ln != NULL) ? ln->get_scope() : -1;
 }
 
 
@@ -167,16 +199,17 @@ int32_t LinenumberTable::find(methodinfo **pm, void* pc)
 void linenumbertable_list_entry_add(codegendata *cd, int32_t linenumber)
 {
 	void* pc = (void*) (cd->mcodeptr - cd->mcodebase);
-	Linenumber ln(linenumber, pc);
+	Linenumber ln(linenumber, pc, cd->inlinescope);
 
-	cd->linenumbers->push_front(ln);
+	cd->linenumbers->push_back(ln);
 }
 
 
 /* linenumbertable_list_entry_add_inline_start *********************************
 
-   Add a marker to the line number table indicating the start of an
-   inlined method body. (see doc/inlining_stacktrace.txt)
+   Open the scope of an inlined method body.  Code generated until the
+   matching linenumbertable_list_entry_add_inline_end belongs to it.
+   (see doc/inlining_stacktrace.txt)
 
    IN:
       cd ..... current codegen data
@@ -186,29 +219,32 @@ void linenumbertable_list_entry_add(codegendata *cd, int32_t linenumber)
 
 void linenumbertable_list_entry_add_inline_start(codegendata *cd, instruction *iptr)
 {
-	void* pc = (void*) (cd->mcodeptr - cd->mcodebase);
+	insinfo_inline* insinfo = iptr->sx.s23.s3.inlineinfo;
 
-	Linenumber ln(-2 /* marks start of inlined method */, pc);
+	// Sanity check.
+	assert(insinfo);
+	assert(insinfo->parent == NULL || insinfo->parent->scope == cd->inlinescope);
 
-	cd->linenumbers->push_front(ln);
+	InlineScope scope(insinfo->method, cd->inlinescope, insinfo->line);
 
-	insinfo_inline* insinfo = iptr->sx.s23.s3.inlineinfo;
-	insinfo->startmpc = (int32_t) (uintptr_t) pc; /* store for corresponding INLINE_END */
+	cd->inlinescopes->push_back(scope);
+
+	insinfo->startmpc = (int32_t) (cd->mcodeptr - cd->mcodebase);
+	insinfo->scope    = cd->inlinescopes->size() - 1;
+
+	cd->inlinescope = insinfo->scope;
 }
 
 
 /* linenumbertable_list_entry_add_inline_end ***********************************
 
-   Add a marker to the line number table indicating the end of an
-   inlined method body. (see doc/inlining_stacktrace.txt)
+   Close the scope of an inlined method body and return to the
+   enclosing one. (see doc/inlining_stacktrace.txt)
 
    IN:
       cd ..... current codegen data
       iptr ... the ICMD_INLINE_END instruction
 
-   Note:
-      iptr->method must point to the inlined callee.
-
 *******************************************************************************/
 
 void linenumbertable_list_entry_add_inline_end(codegendata *cd, instruction *iptr)
@@ -217,16 +253,9 @@ void linenumbertable_list_entry_add_inline_end(codegendata *cd, instruction *ipt
 
 	// Sanity check.
 	assert(insinfo);
+	assert(insinfo->scope == cd->inlinescope);
 
-	// Special entry containing the methodinfo.
-	Linenumber ln((-3) - iptr->line, insinfo->method);
-
-	cd->linenumbers->push_front(ln);
-
-	// End marker with PC of start of body.
-	Linenumber lne(-1, (void*) (std::ptrdiff_t)insinfo->startmpc);
-
-	cd->linenumbers->push_front(lne);
+	cd->inlinescope = (insinfo->parent != NULL) ? insinfo->parent->scope : -1;
 }
 
 
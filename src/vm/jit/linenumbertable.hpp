@@ -48,25 +48,41 @@ struct instruction;
  */
 class Linenumber {
 private:
-	// TODO Add constants.
-	/* -1......start of inlined body              */
-	/* -2......end of inlined body                */
-	/* <= -3...special entry with methodinfo *    */
-	/* (see doc/inlining_stacktrace.txt)          */
-
 	int32_t _linenumber;
 	void*   _pc;
+	int32_t _scope;                     // inline scope, -1 for the method itself
 
 public:
-	Linenumber(int32_t linenumber, void* pc) : _linenumber(linenumber), _pc(pc) {}
+	Linenumber(int32_t linenumber, void* pc, int32_t scope) : _linenumber(linenumber), _pc(pc), _scope(scope) {}
 
 	inline int32_t get_linenumber() const { return _linenumber; }
 	inline void*   get_pc        () const { return _pc; }
+	inline int32_t get_scope     () const { return _scope; }
 
 	void resolve(const codeinfo* code);
 };
 
 
+/**
+ * An inlined method body.  Scopes are numbered in the order their
+ * bodies start, the enclosing scope of an inlined method always has a
+ * smaller number (see doc/inlining_stacktrace.txt).
+ */
+class InlineScope {
+private:
+	methodinfo* _method;                // the inlined method
+	int32_t     _parent;                // enclosing scope, -1 for the method itself
+	int32_t     _linenumber;            // line of the call in the enclosing scope
+
+public:
+	InlineScope(methodinfo* method, int32_t parent, int32_t linenumber) : _method(method), _parent(parent), _linenumber(linenumber) {}
+
+	inline methodinfo* get_method    () const { return _method; }
+	inline int32_t     get_parent    () const { return _parent; }
+	inline int32_t     get_linenumber() const { return _linenumber; }
+};
+
+
 /**
  * Unary function to resolve Linenumber objects.
  */
@@ -82,25 +98,46 @@ public:
 
 /**
  * Linenumber table of a Java method.
+ *
+ * The entries are sorted by PC, each one is valid up to the PC of the
+ * next one.  With inlining a PC belongs to a chain of virtual frames:
+ * the innermost inlined method, the methods it was inlined into, up to
+ * the compiled method itself.  The chain is walked with the scope
+ * numbers returned by find_scope and get_parent_scope.
  */
 class LinenumberTable {
 private:
-	std::vector<Linenumber> _linenumbers;
+	std::vector<Linenumber>  _linenumbers;
+	std::vector<InlineScope> _scopes;
 
 	// Comparator class.
-	class comparator : public std::binary_function<Linenumber, void*, bool> {
+	class comparator : public std::binary_function<void*, Linenumber, bool> {
 	public:
-		bool operator() (const Linenumber& ln, const void* pc) const
+		bool operator() (const void* pc, const Linenumber& ln) const
 		{
-			return (pc >= ln.get_pc());
+			return (pc < ln.get_pc());
 		}
 	};
 
+	const Linenumber* lookup(void* pc) const;
+
 public:
 	LinenumberTable(jitdata* jd);
 	~LinenumberTable();
 
 	int32_t find(methodinfo **pm, void* pc);
+	int32_t find(methodinfo **pm, void* pc, int32_t scope);
+
+	int32_t find_scope(void* pc) const;
+
+	/// Returns the scope enclosing the given one, -1 for the method itself
+	inline int32_t get_parent_scope(int32_t scope) const { return _scopes[scope].get_parent(); }
+
+	/// Returns the inlined method of the given scope
+	inline methodinfo* get_scope_method(int32_t scope) const { return _scopes[scope].get_method(); }
+
+	/// Returns true if the method has inlined bodies
+	inline bool has_scopes() const { return !_scopes.empty(); }
 };
 
 void linenumbertable_list_entry_add(codegendata *cd, int32_t linenumber);
@@ -26,6 +26,7 @@
 #include "Interval.hpp"
 #include "toolbox/logging.hpp"
 #include "vm/jit/ir/icmd.hpp"
+#include "vm/jit/ir/instruction.hpp"
 
 #include <sstream>
 
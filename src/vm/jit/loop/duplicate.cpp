@@ -24,6 +24,7 @@
 
 #include "toolbox/logging.hpp"
 #include "vm/jit/ir/icmd.hpp"
+#include "vm/jit/ir/instruction.hpp"
 
 #include "duplicate.hpp"
 #include "Value.hpp"
@@ -41,9 +42,11 @@ namespace
 	void buildBasicblockList(jitdata* jd, LoopContainer* loop, basicblock* beforeLoop, basicblock* lastBlockInLoop, basicblock* loopSwitch, basicblock* loopTrampoline);
 	void buildBasicblockList(jitdata* jd, LoopContainer* loop, basicblock* beforeLoop, basicblock* lastBlockInLoop, basicblock* loopSwitch1, basicblock* loopSwitch2, basicblock* loopTrampoline);
 	void buildBasicblockList(jitdata* jd, LoopContainer* loop, basicblock* beforeLoop, basicblock* lastBlockInLoop, basicblock* loopSwitch1, basicblock* loopSwitch2, basicblock* loopSwitch3, basicblock* loopTrampoline);
+	void buildBasicblockList(jitdata* jd, LoopContainer* loop, basicblock* beforeLoop, basicblock* lastBlockInLoop, const std::vector<basicblock*>& loopSwitches, basicblock* loopTrampoline);
 	void removeChecks(LoopContainer* loop, s4 array, s4 index);
 	basicblock* createTrampoline(basicblock* target);
 	void redirectJumps(jitdata* jd, basicblock* loopSwitch);
+	void redirectJumps(basicblock* block, basicblock* from, basicblock* to);
 	void optimizeLoop(jitdata* jd, LoopContainer* loop);
 	bool isLocalIntVar(jitdata* jd, s4 varIndex);
 
@@ -294,17 +297,32 @@ namespace
 		buildBasicblockList(jd, loop, beforeLoop, lastBlockInLoop, loopSwitch1, loopSwitch2, 0, loopTrampoline);
 	}
 
+	inline void buildBasicblockList(jitdata* jd, LoopContainer* loop, basicblock* beforeLoop, basicblock* lastBlockInLoop, basicblock* loopSwitch1, basicblock* loopSwitch2, basicblock* loopSwitch3, basicblock* loopTrampoline)
+	{
+		assert(loopSwitch1);
+
+		std::vector<basicblock*> loopSwitches;
+		loopSwitches.push_back(loopSwitch1);
+		if (loopSwitch2)
+			loopSwitches.push_back(loopSwitch2);
+		if (loopSwitch3)
+			loopSwitches.push_back(loopSwitch3);
+
+		buildBasicblockList(jd, loop, beforeLoop, lastBlockInLoop, loopSwitches, loopTrampoline);
+	}
+
 	/**
 	 * Inserts the copied loop, the loop switches and the trampoline into the global basicblock list.
 	 * It also inserts these nodes into the predecessor loops.
 	 *
 	 * loop: The original loop that has been duplicated.
-	 * loopSwitch2: Will be inserted after the first loop switch if it is != 0.
-	 * loopSwitch3: Will be inserted after the first loop switch if it is != 0.
+	 * loopSwitches: Will be inserted in front of the original loop in this order.
 	 */
-	void buildBasicblockList(jitdata* jd, LoopContainer* loop, basicblock* beforeLoop, basicblock* lastBlockInLoop, basicblock* loopSwitch1, basicblock* loopSwitch2, basicblock* loopSwitch3, basicblock* loopTrampoline)
+	void buildBasicblockList(jitdata* jd, LoopContainer* loop, basicblock* beforeLoop, basicblock* lastBlockInLoop, const std::vector<basicblock*>& loopSwitches, basicblock* loopTrampoline)
 	{
-		assert(loopSwitch1);
+		assert(!loopSwitches.empty());
+
+		basicblock* loopSwitch1 = loopSwitches.front();
 
 		// insert first loop switch
 		if (beforeLoop)
@@ -320,22 +338,13 @@ namespace
 
 		basicblock* lastLoopSwitch = loopSwitch1;
 
-		// insert second loop switch
-		if (loopSwitch2)
+		// insert the other loop switches
+		for (std::vector<basicblock*>::const_iterator it = loopSwitches.begin() + 1; it != loopSwitches.end(); ++it)
 		{
-			loopSwitch2->next = lastLoopSwitch->next;
-			lastLoopSwitch->next = loopSwitch2;
+			(*it)->next = lastLoopSwitch->next;
+			lastLoopSwitch->next = *it;
 
-			lastLoopSwitch = loopSwitch2;
-		}
-
-		// insert third loop switch
-		if (loopSwitch3)
-		{
-			loopSwitch3->next = lastLoopSwitch->next;
-			lastLoopSwitch->next = loopSwitch3;
-
-			lastLoopSwitch = loopSwitch3;
+			lastLoopSwitch = *it;
 		}
 
 		// insert trampoline after loop
@@ -369,11 +378,10 @@ namespace
 				pred->nodes.push_back(*it);
 			}
 			pred->nodes.push_back(loopTrampoline);
-			pred->nodes.push_back(loopSwitch1);
-			if (loopSwitch2)
-				pred->nodes.push_back(loopSwitch2);
-			if (loopSwitch3)
-				pred->nodes.push_back(loopSwitch3);
+			for (std::vector<basicblock*>::const_iterator it = loopSwitches.begin(); it != loopSwitches.end(); ++it)
+			{
+				pred->nodes.push_back(*it);
+			}
 		}
 	}
 
@@ -548,6 +556,64 @@ namespace
 		}
 	}
 
+	/**
+	 * Redirects all jumps in the specified basicblock that go to `from` to `to`.
+	 */
+	void redirectJumps(basicblock* block, basicblock* from, basicblock* to)
+	{
+		for (instruction* instr = block->iinstr; instr != block->iinstr + block->icount; instr++)
+		{
+			switch (icmd_table[instr->opc].controlflow)
+			{
+				case CF_IF:
+				case CF_GOTO:
+				case CF_RET:
+					if (instr->dst.block == from)
+						instr->dst.block = to;
+					break;
+				case CF_JSR:
+					if (instr->sx.s23.s3.jsrtarget.block == from)
+						instr->sx.s23.s3.jsrtarget.block = to;
+					break;
+				case CF_TABLE:
+				{
+					// count = (tablehigh - tablelow + 1) + 1 [default branch]
+					s4 count = instr->sx.s23.s3.tablehigh - instr->sx.s23.s2.tablelow + 2;
+
+					branch_target_t* target = instr->dst.table;
+					while (--count >= 0)
+					{
+						if (target->block == from)
+							target->block = to;
+						target++;
+					}
+					break;
+				}
+				case CF_LOOKUP:
+				{
+					// default target
+					if (instr->sx.s23.s3.lookupdefault.block == from)
+						instr->sx.s23.s3.lookupdefault.block = to;
+
+					// other targets
+					lookup_target_t* entry = instr->dst.lookup;
+					s4 count = instr->sx.s23.s2.lookupcount;
+					while (--count >= 0)
+					{
+						if (entry->target.block == from)
+							entry->target.block = to;
+						entry++;
+					}
+					break;
+				}
+				case CF_END:
+				case CF_NORMAL:
+					// nothing
+					break;
+			}
+		}
+	}
+
 	void optimizeLoop(jitdata* jd, LoopContainer* loop)
 	{
 		// Optimize inner loops.
@@ -926,6 +992,77 @@ bool findFreeVariable(jitdata* jd)
 	return false;
 }
 
+bool canInsertPreheader(jitdata* jd, LoopContainer* loop)
+{
+	basicblock *beforeLoop, *lastBlockInLoop;
+	return checkLoop(jd, loop, &beforeLoop, &lastBlockInLoop);
+}
+
+void insertPreheader(jitdata* jd, LoopContainer* loop, const std::vector<basicblock*>& preheader, bool versioning)
+{
+	assert(!preheader.empty());
+
+	basicblock *beforeLoop, *lastBlockInLoop;
+	bool valid = checkLoop(jd, loop, &beforeLoop, &lastBlockInLoop);
+	assert(valid);
+	(void) valid;
+
+	if (versioning)
+	{
+		duplicateLoop(loop);
+
+		// Jumps from the preheader to the header leave for the unoptimized loop.
+		for (std::vector<basicblock*>::const_iterator it = preheader.begin(); it != preheader.end(); ++it)
+		{
+			redirectJumps(*it, loop->header, loop->header->ld->copiedTo);
+		}
+
+		// create basicblock that jumps over the second loop
+		basicblock* loopTrampoline = createTrampoline(jd, lastBlockInLoop->next);
+
+		// Insert loop into basicblock list.
+		redirectJumps(jd, preheader.front());
+		buildBasicblockList(jd, loop, beforeLoop, lastBlockInLoop, preheader, loopTrampoline);
+
+		// Adjust statistical data.
+		jd->basicblockcount += loop->nodes.size() + preheader.size() + 2;
+	}
+	else
+	{
+		// All jumps from outside of the loop go to the header.
+		for (basicblock* block = jd->basicblocks; block; block = block->next)
+		{
+			if (block->ld->belongingTo != loop)
+				redirectJumps(block, loop->header, preheader.front());
+		}
+
+		// insert the preheader in front of the header
+		basicblock* last = beforeLoop;
+		for (std::vector<basicblock*>::const_iterator it = preheader.begin(); it != preheader.end(); ++it)
+		{
+			if (last)
+				last->next = *it;
+			else
+				jd->basicblocks = *it;
+
+			last = *it;
+		}
+		last->next = loop->header;
+
+		// Insert nodes into predecessor loops except the root loop.
+		for (LoopContainer* pred = loop->parent; pred->parent; pred = pred->parent)
+		{
+			for (std::vector<basicblock*>::const_iterator it = preheader.begin(); it != preheader.end(); ++it)
+			{
+				pred->nodes.push_back(*it);
+			}
+		}
+
+		// Adjust statistical data.
+		jd->basicblockcount += preheader.size();
+	}
+}
+
 void removePartiallyRedundantChecks(jitdata* jd)
 {
 	for (std::vector<LoopContainer*>::iterator it = jd->ld->rootLoop->children.begin(); it != jd->ld->rootLoop->children.end(); ++it)
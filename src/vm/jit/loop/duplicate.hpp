@@ -31,6 +31,20 @@ bool findFreeVariable(jitdata* jd);
 void removePartiallyRedundantChecks(jitdata* jd);
 void groupArrayBoundsChecks(jitdata* jd);
 
+/**
+ * Returns true if the loop is a contiguous sequence of basicblocks starting
+ * with the header and the stack is empty when entering and leaving it.
+ */
+bool canInsertPreheader(jitdata* jd, LoopContainer* loop);
+
+/**
+ * Inserts the specified basicblocks in front of the loop header and
+ * redirects all jumps into the loop to the first of them.  If versioning
+ * is set, the loop is duplicated first and the jumps from the inserted
+ * basicblocks to the header go to the unoptimized copy instead.
+ */
+void insertPreheader(jitdata* jd, LoopContainer* loop, const std::vector<basicblock*>& preheader, bool versioning);
+
 #endif
 
 /*
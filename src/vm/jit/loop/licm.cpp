@@ -0,0 +1,1127 @@
+/* src/vm/jit/loop/licm.cpp
+
+   Copyright (C) 1996-2013
+   CACAOVM - Verein zur Foerderung der freien virtuellen Maschine CACAO
+
+   This file is part of CACAO.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation; either version 2, or (at
+   your option) any later version.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA.
+
+*/
+
+#include "mm/dumpmemory.hpp"
+#include "mm/memory.hpp"
+#include "toolbox/logging.hpp"
+#include "vm/field.hpp"
+#include "vm/global.hpp"
+#include "vm/method.hpp"
+#include "vm/options.hpp"
+#include "vm/references.hpp"
+#include "vm/statistics.hpp"
+#include "vm/jit/ir/icmd.hpp"
+#include "vm/jit/ir/instruction.hpp"
+
+#include "licm.hpp"
+#include "duplicate.hpp"
+
+#include <cstring>
+#include <map>
+#include <set>
+
+STAT_REGISTER_VAR(int,count_loop_invariants_hoisted,0,"hoisted invariants","number of loop-invariant computations hoisted")
+STAT_REGISTER_VAR(int,count_loop_typechecks_hoisted,0,"hoisted type checks","number of loop-invariant type checks hoisted")
+STAT_REGISTER_VAR(int,count_loops_versioned,0,"versioned loops","number of loops duplicated for hoisting")
+
+// The number of instructions needed to recompute a hoisted value.
+#define LICM_MAX_EXPRESSION_SIZE 16
+
+// The number of values hoisted out of a single loop.
+#define LICM_MAX_HOISTED 16
+
+// Larger loops are not duplicated, so nothing that needs a guard is hoisted.
+#define LICM_MAX_VERSIONED_INSTRUCTIONS 256
+
+namespace
+{
+	/**
+	 * A computation in the loop whose value is the same in every iteration.
+	 */
+	struct Invariant
+	{
+		instruction*	operands[2];	// the instructions defining the operands, 0 for local variables
+		s4				size;			// the number of instructions needed to recompute the value
+		s4				guard;			// the variable that must not be null for the computation, or UNUSED
+		s4				slot;			// the index of the new local holding the value, or -1
+	};
+
+	/**
+	 * A step of the preheader.
+	 */
+	struct Step
+	{
+		enum Kind { NULL_CHECK, TYPE_CHECK, COMPUTE };
+
+		Kind			kind;
+		s4				variable;		// the checked variable
+		instruction*	instr;			// the CHECKCAST or the hoisted computation
+	};
+
+	/**
+	 * The result of the analysis of a single loop.
+	 */
+	struct LoopInvariants
+	{
+		LoopContainer*						loop;
+		s4									firstLocal;		// the index of the first new local variable
+		s4									nonNullVariable;	// `this' if it is never assigned, otherwise UNUSED
+		bool								guards;			// true if checks may be moved to the preheader
+		bool								heapChanged;	// true if the loop may change any field
+		std::set<fieldinfo*>				writtenFields;
+		std::vector<bool>					written;		// the local variables assigned in the loop
+		std::map<instruction*, Invariant>	invariants;
+		std::vector<instruction*>			hoisted;		// the computations moved to the preheader
+		std::set<instruction*>				typeChecks;		// the CHECKCASTs moved to the preheader
+		std::vector<Step>					steps;
+		std::set<s4>						checked;		// the variables known to be non-null in the preheader
+
+		// The temporary variables defined in the current basicblock.
+		std::vector<instruction*>			tempDef;
+		std::vector<basicblock*>			tempBlock;
+	};
+
+	enum Kind { NONE, PURE, LOAD, CAST };
+
+	s4 getOperands(const instruction* instr, s4* buffer, const s4** operands);
+	bool isCopy(const instruction* instr);
+	fieldinfo* getField(const instruction* instr);
+	s4 findNonNullVariable(jitdata* jd);
+	bool scanLoop(jitdata* jd, LoopInvariants& li);
+	Kind classify(LoopInvariants& li, const instruction* instr);
+	bool isInvariantOperand(jitdata* jd, LoopInvariants& li, basicblock* block, s4 var, instruction** def);
+	instruction* findDefinition(LoopInvariants& li, instruction* def);
+	s4 findLeaf(LoopInvariants& li, s4 var, instruction* def);
+	bool isWorthHoisting(const instruction* instr);
+	void addGuards(LoopInvariants& li, instruction* instr);
+	s4 hoist(LoopInvariants& li, instruction* instr);
+	void analyzeInstruction(jitdata* jd, LoopInvariants& li, basicblock* block, instruction* instr);
+	void renumberVariables(jitdata* jd, s4 first, s4 count);
+	void addLocalVariables(jitdata* jd, const std::vector<Type>& types);
+	s4 newTemporaryVariable(jitdata* jd, Type type);
+	s4 emitOperand(jitdata* jd, LoopInvariants& li, instruction* def, s4 var, s4 slot, std::vector<instruction>& code);
+	void emitComputation(jitdata* jd, LoopInvariants& li, instruction* instr, s4 slot, s4 dst, std::vector<instruction>& code);
+	basicblock* createBasicblock(jitdata* jd, const std::vector<instruction>& code);
+	void rewrite(instruction* instr, ICMD opc);
+	void release(jitdata* jd, std::map<s4, s4>& reads, std::map<s4, instruction*>& defs, s4 var);
+	void optimizeBasicblock(jitdata* jd, LoopInvariants& li, basicblock* block);
+	void optimizeLoop(jitdata* jd, LoopContainer* loop, s4 nonNullVariable);
+
+
+	/**
+	 * Returns the number of variables the instruction reads and points
+	 * operands at them.
+	 */
+	s4 getOperands(const instruction* instr, s4* buffer, const s4** operands)
+	{
+		*operands = buffer;
+
+		switch (icmd_table[instr->opc].dataflow)
+		{
+			case DF_3_TO_0:
+			case DF_3_TO_1:
+				buffer[0] = instr->s1.varindex;
+				buffer[1] = instr->sx.s23.s2.varindex;
+				buffer[2] = instr->sx.s23.s3.varindex;
+				return 3;
+
+			case DF_2_TO_0:
+			case DF_2_TO_1:
+				buffer[0] = instr->s1.varindex;
+				buffer[1] = instr->sx.s23.s2.varindex;
+				return 2;
+
+			case DF_1_TO_0:
+			case DF_1_TO_1:
+			case DF_COPY:
+			case DF_MOVE:
+				buffer[0] = instr->s1.varindex;
+				return 1;
+
+			case DF_INVOKE:
+			case DF_BUILTIN:
+			case DF_N_TO_1:
+				*operands = instr->sx.s23.s2.args;
+				return instr->s1.argcount;
+
+			default:
+				// The stack of the caller is kept alive for on-stack replacement.
+				if (instr->opc == ICMD_INLINE_START)
+				{
+					*operands = instr->sx.s23.s3.inlineinfo->stackvars;
+					return instr->sx.s23.s3.inlineinfo->stackvarscount;
+				}
+				return 0;
+		}
+	}
+
+	/**
+	 * Returns true for loads, stores and copies.
+	 */
+	bool isCopy(const instruction* instr)
+	{
+		s4 dataflow = icmd_table[instr->opc].dataflow;
+		return dataflow == DF_COPY || dataflow == DF_MOVE;
+	}
+
+	/**
+	 * Returns the field accessed by a field instruction or 0 if it is unresolved.
+	 */
+	fieldinfo* getField(const instruction* instr)
+	{
+		if (INSTRUCTION_IS_UNRESOLVED(instr))
+			return 0;
+
+		return instr->sx.s23.s3.fmiref->p.field;
+	}
+
+	/**
+	 * Returns the variable holding `this' if the method never assigns it, otherwise UNUSED.
+	 */
+	s4 findNonNullVariable(jitdata* jd)
+	{
+		if (jd->m->flags & ACC_STATIC)
+			return jitdata::UNUSED;
+
+		s4 var = jd->local_map[0 * 5 + TYPE_ADR];
+
+		if (var == jitdata::UNUSED)
+			return jitdata::UNUSED;
+
+		for (basicblock* block = jd->basicblocks; block; block = block->next)
+		{
+			for (instruction* instr = block->iinstr; instr != block->iinstr + block->icount; instr++)
+			{
+				if (instruction_has_dst(instr) && instr->dst.varindex == var &&
+					!(isCopy(instr) && instr->s1.varindex == var))
+					return jitdata::UNUSED;
+			}
+		}
+
+		return var;
+	}
+
+	/**
+	 * Collects the local variables and fields the loop assigns.  Returns
+	 * false if the loop contains subroutines.
+	 */
+	bool scanLoop(jitdata* jd, LoopInvariants& li)
+	{
+		LoopContainer* loop = li.loop;
+		s4 size = 0;
+
+		li.written.assign(jd->localcount, false);
+		li.heapChanged = false;
+
+		for (size_t i = 0; i <= loop->nodes.size(); i++)
+		{
+			basicblock* block = (i == 0) ? loop->header : loop->nodes[i - 1];
+
+			size += block->icount;
+
+			for (instruction* instr = block->iinstr; instr != block->iinstr + block->icount; instr++)
+			{
+				// loads and stores coalesced with the local change nothing
+				if (instruction_has_dst(instr) && var_is_local(jd, instr->dst.varindex) &&
+					!(isCopy(instr) && instr->s1.varindex == instr->dst.varindex))
+				{
+					li.written[instr->dst.varindex] = true;
+				}
+
+				switch (icmd_table[instr->opc].controlflow)
+				{
+					case CF_JSR:
+					case CF_RET:
+						return false;
+				}
+
+				switch (icmd_table[instr->opc].dataflow)
+				{
+					case DF_INVOKE:
+					case DF_BUILTIN:
+						li.heapChanged = true;
+						break;
+				}
+
+				switch (instr->opc)
+				{
+					case ICMD_MONITORENTER:
+					case ICMD_MONITOREXIT:
+						li.heapChanged = true;
+						break;
+
+					case ICMD_GETFIELD:
+					case ICMD_GETSTATIC:
+					case ICMD_PUTFIELD:
+					case ICMD_PUTSTATIC:
+					case ICMD_PUTFIELDCONST:
+					case ICMD_PUTSTATICCONST:
+					{
+						// volatile accesses order the other memory accesses
+						fieldinfo* field = getField(instr);
+
+						if (!field || (field->flags & ACC_VOLATILE))
+							li.heapChanged = true;
+						else if (instr->opc != ICMD_GETFIELD && instr->opc != ICMD_GETSTATIC)
+							li.writtenFields.insert(field);
+						break;
+					}
+
+					default:
+						break;
+				}
+			}
+		}
+
+		li.guards = (size <= LICM_MAX_VERSIONED_INSTRUCTIONS);
+
+		return true;
+	}
+
+	/**
+	 * Returns how the instruction can be moved out of the loop if its operands are invariant.
+	 */
+	Kind classify(LoopInvariants& li, const instruction* instr)
+	{
+		switch (instr->opc)
+		{
+			case ICMD_ICONST:
+			case ICMD_LCONST:
+			case ICMD_FCONST:
+			case ICMD_DCONST:
+				return PURE;
+
+			case ICMD_ACONST:
+			case ICMD_INSTANCEOF:
+				return INSTRUCTION_IS_RESOLVED(instr) ? PURE : NONE;
+
+			case ICMD_COPY:
+			case ICMD_MOVE:
+			case ICMD_ILOAD:
+			case ICMD_LLOAD:
+			case ICMD_FLOAD:
+			case ICMD_DLOAD:
+			case ICMD_ALOAD:
+			case ICMD_ISTORE:
+			case ICMD_LSTORE:
+			case ICMD_FSTORE:
+			case ICMD_DSTORE:
+				return PURE;
+
+			case ICMD_ASTORE:
+				return (instr->flags.bits & INS_FLAG_RETADDR) ? NONE : PURE;
+
+			case ICMD_IADD:
+			case ICMD_ISUB:
+			case ICMD_IMUL:
+			case ICMD_INEG:
+			case ICMD_IAND:
+			case ICMD_IOR:
+			case ICMD_IXOR:
+			case ICMD_ISHL:
+			case ICMD_ISHR:
+			case ICMD_IUSHR:
+			case ICMD_IADDCONST:
+			case ICMD_ISUBCONST:
+			case ICMD_IMULCONST:
+			case ICMD_IANDCONST:
+			case ICMD_IORCONST:
+			case ICMD_IXORCONST:
+			case ICMD_ISHLCONST:
+			case ICMD_ISHRCONST:
+			case ICMD_IUSHRCONST:
+			case ICMD_IMULPOW2:
+			case ICMD_IDIVPOW2:
+			case ICMD_IREMPOW2:
+			case ICMD_LADD:
+			case ICMD_LSUB:
+			case ICMD_LMUL:
+			case ICMD_LNEG:
+			case ICMD_LAND:
+			case ICMD_LOR:
+			case ICMD_LXOR:
+			case ICMD_LSHL:
+			case ICMD_LSHR:
+			case ICMD_LUSHR:
+			case ICMD_LADDCONST:
+			case ICMD_LSUBCONST:
+			case ICMD_LMULCONST:
+			case ICMD_LANDCONST:
+			case ICMD_LORCONST:
+			case ICMD_LXORCONST:
+			case ICMD_LSHLCONST:
+			case ICMD_LSHRCONST:
+			case ICMD_LUSHRCONST:
+			case ICMD_LMULPOW2:
+			case ICMD_LDIVPOW2:
+			case ICMD_LREMPOW2:
+			case ICMD_LCMP:
+			case ICMD_I2L:
+			case ICMD_L2I:
+			case ICMD_INT2BYTE:
+			case ICMD_INT2CHAR:
+			case ICMD_INT2SHORT:
+			case ICMD_FADD:
+			case ICMD_FSUB:
+			case ICMD_FMUL:
+			case ICMD_FDIV:
+			case ICMD_FNEG:
+			case ICMD_DADD:
+			case ICMD_DSUB:
+			case ICMD_DMUL:
+			case ICMD_DDIV:
+			case ICMD_DNEG:
+			case ICMD_I2F:
+			case ICMD_I2D:
+			case ICMD_F2D:
+			case ICMD_D2F:
+				return PURE;
+
+			case ICMD_ARRAYLENGTH:
+				return li.guards ? LOAD : NONE;
+
+			case ICMD_GETFIELD:
+			{
+				fieldinfo* field = getField(instr);
+
+				if (!li.guards || li.heapChanged || !field || (field->flags & ACC_VOLATILE))
+					return NONE;
+
+				return (li.writtenFields.find(field) == li.writtenFields.end()) ? LOAD : NONE;
+			}
+
+			case ICMD_CHECKCAST:
+				if (!li.guards || INSTRUCTION_IS_UNRESOLVED(instr) || (instr->flags.bits & INS_FLAG_ARRAY))
+					return NONE;
+				return CAST;
+
+			default:
+				return NONE;
+		}
+	}
+
+	/**
+	 * Returns true if the variable has the same value in every iteration
+	 * at this point of the basicblock.  def is set to the instruction
+	 * defining a temporary variable.
+	 */
+	bool isInvariantOperand(jitdata* jd, LoopInvariants& li, basicblock* block, s4 var, instruction** def)
+	{
+		*def = 0;
+
+		if (var_is_local(jd, var))
+			return !li.written[var];
+
+		if (var_is_temp(jd, var) && li.tempBlock[var] == block && li.tempDef[var])
+		{
+			*def = li.tempDef[var];
+			return true;
+		}
+
+		return false;
+	}
+
+	/**
+	 * Skips the copies and casts defining a value.  Returns 0 for a local variable.
+	 */
+	instruction* findDefinition(LoopInvariants& li, instruction* def)
+	{
+		while (def && (isCopy(def) || def->opc == ICMD_CHECKCAST))
+		{
+			def = li.invariants[def].operands[0];
+		}
+
+		return def;
+	}
+
+	/**
+	 * Returns the local variable holding the value in the preheader or UNUSED if it has to be computed.
+	 */
+	s4 findLeaf(LoopInvariants& li, s4 var, instruction* def)
+	{
+		while (def && (isCopy(def) || def->opc == ICMD_CHECKCAST))
+		{
+			var = def->s1.varindex;
+			def = li.invariants[def].operands[0];
+		}
+
+		if (!def)
+			return var;
+
+		s4 slot = li.invariants[def].slot;
+
+		return (slot >= 0) ? li.firstLocal + slot : (s4) jitdata::UNUSED;
+	}
+
+	/**
+	 * Copies and constants are cheaper to repeat than to keep in a variable.
+	 */
+	bool isWorthHoisting(const instruction* instr)
+	{
+		if (isCopy(instr) || instr->opc == ICMD_CHECKCAST)
+			return false;
+
+		return icmd_table[instr->opc].dataflow != DF_0_TO_1;
+	}
+
+	/**
+	 * Adds the null checks needed to recompute the value to the preheader.
+	 */
+	void addGuards(LoopInvariants& li, instruction* instr)
+	{
+		Invariant& inv = li.invariants[instr];
+
+		for (s4 i = 0; i < 2; i++)
+		{
+			if (inv.operands[i] && li.invariants[inv.operands[i]].slot < 0)
+				addGuards(li, inv.operands[i]);
+		}
+
+		if (inv.guard != jitdata::UNUSED && li.checked.find(inv.guard) == li.checked.end())
+		{
+			Step step = { Step::NULL_CHECK, inv.guard, 0 };
+			li.steps.push_back(step);
+			li.checked.insert(inv.guard);
+		}
+	}
+
+	/**
+	 * Moves the computation to the preheader.  Returns the index of the
+	 * new local variable holding its value or -1.
+	 */
+	s4 hoist(LoopInvariants& li, instruction* instr)
+	{
+		Invariant& inv = li.invariants[instr];
+
+		if (inv.slot >= 0)
+			return inv.slot;
+
+		if (li.hoisted.size() >= LICM_MAX_HOISTED)
+			return -1;
+
+		addGuards(li, instr);
+
+		inv.slot = li.hoisted.size();
+		li.hoisted.push_back(instr);
+
+		Step step = { Step::COMPUTE, jitdata::UNUSED, instr };
+		li.steps.push_back(step);
+
+		return inv.slot;
+	}
+
+	/**
+	 * Decides whether the instruction computes an invariant value and
+	 * hoists the invariant values it consumes otherwise.
+	 */
+	void analyzeInstruction(jitdata* jd, LoopInvariants& li, basicblock* block, instruction* instr)
+	{
+		s4 buffer[3];
+		const s4* operands;
+		s4 count = getOperands(instr, buffer, &operands);
+
+		instruction* defs[3] = { 0, 0, 0 };
+		bool invariant = (count <= 2);
+
+		for (s4 i = 0; i < count; i++)
+		{
+			instruction* def;
+
+			if (!isInvariantOperand(jd, li, block, operands[i], &def))
+				invariant = false;
+			else if (i < 3)
+				defs[i] = def;
+		}
+
+		Kind kind = invariant ? classify(li, instr) : NONE;
+
+		Invariant inv;
+		inv.operands[0] = defs[0];
+		inv.operands[1] = defs[1];
+		inv.size  = 1;
+		inv.guard = jitdata::UNUSED;
+		inv.slot  = -1;
+
+		if (kind == LOAD || kind == CAST)
+		{
+			s4 object = findLeaf(li, operands[0], defs[0]);
+
+			// A computed object is held in a local, so it can be checked.
+			if (object == jitdata::UNUSED)
+			{
+				s4 slot = hoist(li, findDefinition(li, defs[0]));
+
+				if (slot < 0)
+					kind = NONE;
+				else
+					object = li.firstLocal + slot;
+			}
+
+			if (kind == LOAD && object != li.nonNullVariable)
+			{
+				inv.guard = object;
+			}
+			else if (kind == CAST)
+			{
+				// The cast succeeds in the optimized loop if the object is an instance in the preheader.
+				bool found = false;
+
+				for (std::vector<Step>::iterator it = li.steps.begin(); it != li.steps.end(); ++it)
+				{
+					if (it->kind == Step::TYPE_CHECK && it->variable == object &&
+						it->instr->sx.s23.s3.c.cls == instr->sx.s23.s3.c.cls)
+						found = true;
+				}
+
+				if (!found)
+				{
+					Step step = { Step::TYPE_CHECK, object, instr };
+					li.steps.push_back(step);
+					li.checked.insert(object);
+				}
+
+				li.typeChecks.insert(instr);
+			}
+		}
+
+		if (kind != NONE)
+		{
+			for (s4 i = 0; i < 2; i++)
+			{
+				if (defs[i] && li.invariants[defs[i]].slot < 0)
+					inv.size += li.invariants[defs[i]].size;
+			}
+
+			if (inv.size > LICM_MAX_EXPRESSION_SIZE && kind != CAST)
+				kind = NONE;
+		}
+
+		s4 dst = instruction_has_dst(instr) ? instr->dst.varindex : (s4) jitdata::UNUSED;
+		bool temp = (dst != jitdata::UNUSED) && var_is_temp(jd, dst);
+
+		if (temp)
+		{
+			li.tempDef[dst] = 0;
+			li.tempBlock[dst] = block;
+		}
+
+		if (kind != NONE)
+		{
+			li.invariants[instr] = inv;
+
+			if (temp)
+			{
+				li.tempDef[dst] = instr;
+				return;
+			}
+
+			// a local or stack variable assigned an invariant value
+			if (isWorthHoisting(instr))
+			{
+				hoist(li, instr);
+				return;
+			}
+		}
+
+		// The invariant values consumed here are computed in the preheader.
+		for (s4 i = 0; i < count && i < 3; i++)
+		{
+			instruction* def = findDefinition(li, defs[i]);
+
+			if (def && isWorthHoisting(def))
+				hoist(li, def);
+		}
+	}
+
+	/**
+	 * Adds count to all variable indices from first on.
+	 */
+	void renumberVariables(jitdata* jd, s4 first, s4 count)
+	{
+		// Copied basicblocks share these arrays with the original.
+		std::set<s4*> renumbered;
+
+		for (basicblock* block = jd->basicblocks; block; block = block->next)
+		{
+			if (block->invars && renumbered.insert(block->invars).second)
+			{
+				for (s4 i = 0; i < block->indepth; i++)
+				{
+					if (block->invars[i] >= first)
+						block->invars[i] += count;
+				}
+			}
+
+			if (block->outvars && renumbered.insert(block->outvars).second)
+			{
+				for (s4 i = 0; i < block->outdepth; i++)
+				{
+					if (block->outvars[i] >= first)
+						block->outvars[i] += count;
+				}
+			}
+
+			for (instruction* instr = block->iinstr; instr != block->iinstr + block->icount; instr++)
+			{
+				s4* vars[3] = { 0, 0, 0 };
+				s4* array = 0;
+				s4 arraySize = 0;
+
+				switch (icmd_table[instr->opc].dataflow)
+				{
+					case DF_3_TO_0:
+					case DF_3_TO_1:
+						vars[2] = &instr->sx.s23.s3.varindex;
+						// fall through
+					case DF_2_TO_0:
+					case DF_2_TO_1:
+						vars[1] = &instr->sx.s23.s2.varindex;
+						// fall through
+					case DF_1_TO_0:
+					case DF_1_TO_1:
+					case DF_COPY:
+					case DF_MOVE:
+						vars[0] = &instr->s1.varindex;
+						break;
+
+					case DF_INVOKE:
+					case DF_BUILTIN:
+					case DF_N_TO_1:
+						array = instr->sx.s23.s2.args;
+						arraySize = instr->s1.argcount;
+						break;
+
+					default:
+						if (instr->opc == ICMD_INLINE_START)
+						{
+							array = instr->sx.s23.s3.inlineinfo->stackvars;
+							arraySize = instr->sx.s23.s3.inlineinfo->stackvarscount;
+						}
+						break;
+				}
+
+				for (s4 i = 0; i < 3; i++)
+				{
+					if (vars[i] && *vars[i] >= first)
+						*vars[i] += count;
+				}
+
+				if (array && renumbered.insert(array).second)
+				{
+					for (s4 i = 0; i < arraySize; i++)
+					{
+						if (array[i] >= first)
+							array[i] += count;
+					}
+				}
+
+				if (instruction_has_dst(instr) && instr->dst.varindex >= first)
+					instr->dst.varindex += count;
+			}
+		}
+
+		if (jd->ld->freeVariable >= first)
+			jd->ld->freeVariable += count;
+	}
+
+	/**
+	 * Appends local variables of the specified types.  All other
+	 * variables are moved up, as the locals come first.
+	 */
+	void addLocalVariables(jitdata* jd, const std::vector<Type>& types)
+	{
+		s4 first = jd->localcount;
+		s4 count = types.size();
+
+		if (jd->vartop + count > jd->varcount)
+		{
+			s4 varcount = jd->vartop + count;
+			jd->var = DMREALLOC(jd->var, varinfo, jd->varcount, varcount);
+			MZERO(jd->var + jd->varcount, varinfo, varcount - jd->varcount);
+			jd->varcount = varcount;
+		}
+
+		memmove(jd->var + first + count, jd->var + first, sizeof(varinfo) * (jd->vartop - first));
+		MZERO(jd->var + first, varinfo, count);
+
+		renumberVariables(jd, first, count);
+
+		jd->localcount += count;
+		jd->vartop     += count;
+
+		// The new locals get Java indices after the existing ones, so the register allocator finds them.
+		jd->local_map = DMREALLOC(jd->local_map, s4, 5 * jd->maxlocals, 5 * (jd->maxlocals + count));
+
+		for (s4 i = 0; i < count; i++)
+		{
+			for (s4 t = 0; t < 5; t++)
+				jd->local_map[5 * (jd->maxlocals + i) + t] = jitdata::UNUSED;
+
+			jd->local_map[5 * (jd->maxlocals + i) + types[i]] = first + i;
+			jd->var[first + i].type = types[i];
+		}
+
+		jd->maxlocals += count;
+	}
+
+	s4 newTemporaryVariable(jitdata* jd, Type type)
+	{
+		if (jd->vartop >= jd->varcount)
+		{
+			s4 varcount = jd->vartop + 16;
+			jd->var = DMREALLOC(jd->var, varinfo, jd->varcount, varcount);
+			MZERO(jd->var + jd->varcount, varinfo, varcount - jd->varcount);
+			jd->varcount = varcount;
+		}
+
+		s4 index = jd->vartop++;
+
+		varinfo* v = VAR(index);
+		v->type  = type;
+		v->flags = 0;
+
+		return index;
+	}
+
+	/**
+	 * Returns the variable holding the value of an operand in the
+	 * preheader, recomputing it if it is not held by a local.
+	 */
+	s4 emitOperand(jitdata* jd, LoopInvariants& li, instruction* def, s4 var, s4 slot, std::vector<instruction>& code)
+	{
+		while (def && (isCopy(def) || def->opc == ICMD_CHECKCAST))
+		{
+			var = def->s1.varindex;
+			def = li.invariants[def].operands[0];
+		}
+
+		if (!def)
+			return var;
+
+		s4 defSlot = li.invariants[def].slot;
+
+		if (defSlot >= 0 && defSlot < slot)
+			return li.firstLocal + defSlot;
+
+		s4 temp = newTemporaryVariable(jd, VAR(def->dst.varindex)->type);
+		emitComputation(jd, li, def, slot, temp, code);
+
+		return temp;
+	}
+
+	/**
+	 * Appends the instructions computing the value of instr into dst to the preheader.
+	 */
+	void emitComputation(jitdata* jd, LoopInvariants& li, instruction* instr, s4 slot, s4 dst, std::vector<instruction>& code)
+	{
+		Invariant& inv = li.invariants[instr];
+		instruction copy = *instr;
+
+		switch (icmd_table[instr->opc].dataflow)
+		{
+			case DF_2_TO_1:
+				copy.s1.varindex = emitOperand(jd, li, inv.operands[0], instr->s1.varindex, slot, code);
+				copy.sx.s23.s2.varindex = emitOperand(jd, li, inv.operands[1], instr->sx.s23.s2.varindex, slot, code);
+				break;
+
+			case DF_1_TO_1:
+				copy.s1.varindex = emitOperand(jd, li, inv.operands[0], instr->s1.varindex, slot, code);
+				break;
+		}
+
+		copy.dst.varindex = dst;
+		copy.flags.bits &= ~INS_FLAG_BASICBLOCK;
+
+		code.push_back(copy);
+	}
+
+	basicblock* createBasicblock(jitdata* jd, const std::vector<instruction>& code)
+	{
+		basicblock* block = new basicblock;
+		memset(block, 0, sizeof(basicblock));
+		block->ld     = new BasicblockLoopData;
+		block->method = jd->m;
+		block->state  = basicblock::FINISHED;
+		block->mpc    = -1;
+		block->icount = code.size();
+		block->iinstr = new instruction[code.size()];
+		memcpy(block->iinstr, &code[0], sizeof(instruction) * code.size());
+		return block;
+	}
+
+	/**
+	 * Changes the opcode, keeping the basicblock start and the instruction id.
+	 */
+	void rewrite(instruction* instr, ICMD opc)
+	{
+		instr->opc = opc;
+		instr->flags.bits &= (INS_FLAG_BASICBLOCK | INS_FLAG_ID_MASK);
+	}
+
+	/**
+	 * Removes a read of the variable.  The computation of a temporary
+	 * variable nobody reads any more is removed as well, as the register
+	 * allocator expects every temporary variable to be read.
+	 */
+	void release(jitdata* jd, std::map<s4, s4>& reads, std::map<s4, instruction*>& defs, s4 var)
+	{
+		if (!var_is_temp(jd, var) || --reads[var] > 0)
+			return;
+
+		instruction* def = defs[var];
+
+		if (!def)
+			return;
+
+		s4 buffer[3];
+		const s4* operands;
+		s4 count = getOperands(def, buffer, &operands);
+
+		s4 released[3];
+		for (s4 i = 0; i < count; i++)
+			released[i] = operands[i];
+
+		rewrite(def, ICMD_NOP);
+
+		for (s4 i = 0; i < count; i++)
+			release(jd, reads, defs, released[i]);
+	}
+
+	/**
+	 * Replaces the hoisted computations and the casts checked in the preheader.
+	 */
+	void optimizeBasicblock(jitdata* jd, LoopInvariants& li, basicblock* block)
+	{
+		std::map<s4, s4> reads;
+		std::map<s4, instruction*> defs;
+
+		for (instruction* instr = block->iinstr; instr != block->iinstr + block->icount; instr++)
+		{
+			s4 buffer[3];
+			const s4* operands;
+			s4 count = getOperands(instr, buffer, &operands);
+
+			for (s4 i = 0; i < count; i++)
+			{
+				if (var_is_temp(jd, operands[i]))
+					reads[operands[i]]++;
+			}
+
+			if (instruction_has_dst(instr) && var_is_temp(jd, instr->dst.varindex))
+				defs[instr->dst.varindex] = li.invariants.count(instr) ? instr : 0;
+		}
+
+		for (instruction* instr = block->iinstr; instr != block->iinstr + block->icount; instr++)
+		{
+			if (li.typeChecks.count(instr))
+			{
+				rewrite(instr, (instr->dst.varindex == instr->s1.varindex) ? ICMD_NOP : ICMD_MOVE);
+				continue;
+			}
+
+			std::map<instruction*, Invariant>::iterator it = li.invariants.find(instr);
+
+			if (it == li.invariants.end() || it->second.slot < 0)
+				continue;
+
+			s4 buffer[3];
+			const s4* operands;
+			s4 count = getOperands(instr, buffer, &operands);
+
+			s4 released[3];
+			for (s4 i = 0; i < count; i++)
+				released[i] = operands[i];
+
+			s4 local = li.firstLocal + it->second.slot;
+
+			rewrite(instr, (ICMD) (ICMD_ILOAD + VAR(local)->type));
+			instr->s1.varindex = local;
+
+			for (s4 i = 0; i < count; i++)
+				release(jd, reads, defs, released[i]);
+		}
+	}
+
+	void optimizeLoop(jitdata* jd, LoopContainer* loop, s4 nonNullVariable)
+	{
+#if defined(ENABLE_REPLACEMENT)
+		// On-stack replacement would enter the loop without passing the preheader.
+		if (loop->header->bitflags & BBFLAG_REPLACEMENT)
+			return;
+#endif
+
+		// The blocks inserted by groupArrayBoundsChecks are not part of the loop.
+		if (loop->header->ld->arrayIndexCheck)
+			return;
+
+		for (std::vector<basicblock*>::iterator it = loop->nodes.begin(); it != loop->nodes.end(); ++it)
+		{
+			if ((*it)->ld->arrayIndexCheck)
+				return;
+		}
+
+		if (!canInsertPreheader(jd, loop))
+			return;
+
+		LoopInvariants li;
+		li.loop            = loop;
+		li.firstLocal      = jd->localcount;
+		li.nonNullVariable = nonNullVariable;
+
+		if (!scanLoop(jd, li))
+			return;
+
+		li.tempDef.assign(jd->vartop, (instruction*) 0);
+		li.tempBlock.assign(jd->vartop, (basicblock*) 0);
+
+		for (size_t i = 0; i <= loop->nodes.size(); i++)
+		{
+			basicblock* block = (i == 0) ? loop->header : loop->nodes[i - 1];
+
+			for (instruction* instr = block->iinstr; instr != block->iinstr + block->icount; instr++)
+			{
+				analyzeInstruction(jd, li, block, instr);
+			}
+		}
+
+		if (li.hoisted.empty() && li.typeChecks.empty())
+			return;
+
+		// Create the locals holding the hoisted values.
+		std::vector<Type> types;
+
+		for (std::vector<instruction*>::iterator it = li.hoisted.begin(); it != li.hoisted.end(); ++it)
+		{
+			types.push_back(VAR((*it)->dst.varindex)->type);
+		}
+
+		if (!types.empty())
+			addLocalVariables(jd, types);
+
+		// Build the preheader, a branch to the loop header leaves for the unoptimized loop.
+		std::vector<basicblock*> preheader;
+		std::vector<instruction> code;
+		bool versioning = false;
+
+		for (std::vector<Step>::iterator it = li.steps.begin(); it != li.steps.end(); ++it)
+		{
+			instruction instr;
+			memset(&instr, 0, sizeof(instruction));
+
+			switch (it->kind)
+			{
+				case Step::NULL_CHECK:
+					// if (object == null) goto unoptimized_loop
+					instr.opc = ICMD_IFNULL;
+					instr.s1.varindex = it->variable;
+					instr.dst.block = loop->header;
+					code.push_back(instr);
+					break;
+
+				case Step::TYPE_CHECK:
+				{
+					// if (!(object instanceof class)) goto unoptimized_loop
+					s4 result = newTemporaryVariable(jd, TYPE_INT);
+
+					instr = *it->instr;
+					instr.opc = ICMD_INSTANCEOF;
+					instr.flags.bits &= ~(INS_FLAG_BASICBLOCK | INS_FLAG_CHECK);
+					instr.s1.varindex = it->variable;
+					instr.dst.varindex = result;
+					code.push_back(instr);
+
+					memset(&instr, 0, sizeof(instruction));
+					instr.opc = ICMD_IFEQ;
+					instr.s1.varindex = result;
+					instr.sx.val.i = 0;
+					instr.dst.block = loop->header;
+					code.push_back(instr);
+					break;
+				}
+
+				case Step::COMPUTE:
+				{
+					s4 slot = li.invariants[it->instr].slot;
+					emitComputation(jd, li, it->instr, slot, li.firstLocal + slot, code);
+					break;
+				}
+			}
+
+			if (it->kind != Step::COMPUTE)
+			{
+				preheader.push_back(createBasicblock(jd, code));
+				code.clear();
+				versioning = true;
+			}
+		}
+
+		if (!code.empty())
+			preheader.push_back(createBasicblock(jd, code));
+
+		insertPreheader(jd, loop, preheader, versioning);
+
+		// The unoptimized copy has been made, now change the loop.
+		optimizeBasicblock(jd, li, loop->header);
+
+		for (std::vector<basicblock*>::iterator it = loop->nodes.begin(); it != loop->nodes.end(); ++it)
+		{
+			optimizeBasicblock(jd, li, *it);
+		}
+
+		STATISTICS(count_loop_invariants_hoisted += li.hoisted.size());
+		STATISTICS(count_loop_typechecks_hoisted += li.typeChecks.size());
+		if (versioning)
+			STATISTICS(count_loops_versioned++);
+	}
+}
+
+
+void hoistLoopInvariants(jitdata* jd)
+{
+	if (!opt_LoopInvariantCodeMotion)
+		return;
+
+	s4 nonNullVariable = findNonNullVariable(jd);
+
+	for (std::vector<LoopContainer*>::iterator it = jd->ld->loops.begin(); it != jd->ld->loops.end(); ++it)
+	{
+		// only innermost loops
+		if ((*it)->children.empty())
+			optimizeLoop(jd, *it, nonNullVariable);
+	}
+}
+
+/*
+ * These are local overrides for various environment variables in Emacs.
+ * Please do not remove this and leave it at the end of the file, where
+ * Emacs will automagically detect them.
+ * ---------------------------------------------------------------------
+ * Local variables:
+ * mode: c++
+ * indent-tabs-mode: t
+ * c-basic-offset: 4
+ * tab-width: 4
+ * End:
+ * vim:noexpandtab:sw=4:ts=4:
+ */
@@ -0,0 +1,55 @@
+/* src/vm/jit/loop/licm.hpp
+
+   Copyright (C) 1996-2013
+   CACAOVM - Verein zur Foerderung der freien virtuellen Maschine CACAO
+
+   This file is part of CACAO.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation; either version 2, or (at
+   your option) any later version.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA.
+
+*/
+
+#ifndef _LICM_HPP
+#define _LICM_HPP
+
+#include "loop.hpp"
+
+/**
+ * Hoists computations whose value is the same in every iteration out of
+ * inner loops into a preheader: arithmetic on invariant variables, the
+ * length of invariant arrays, loads of fields of invariant objects that
+ * the loop does not store, and type tests and casts of invariant objects.
+ * Loads and casts that may throw are guarded by null and type checks in
+ * the preheader, which branch to an unoptimized copy of the loop.
+ */
+void hoistLoopInvariants(jitdata* jd);
+
+#endif
+
+/*
+ * These are local overrides for various environment variables in Emacs.
+ * Please do not remove this and leave it at the end of the file, where
+ * Emacs will automagically detect them.
+ * ---------------------------------------------------------------------
+ * Local variables:
+ * mode: c++
+ * indent-tabs-mode: t
+ * c-basic-offset: 4
+ * tab-width: 4
+ * End:
+ * vim:noexpandtab:sw=4:ts=4:
+ */
+
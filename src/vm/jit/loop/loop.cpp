@@ -30,6 +30,8 @@
 #include "dominator.hpp"
 #include "analyze.hpp"
 #include "duplicate.hpp"
+#include "licm.hpp"
+#include "unroll.hpp"
 #include "toolbox/logging.hpp"
 
 #define INDENT 2
@@ -431,6 +433,9 @@ void removeArrayBoundChecks(jitdata* jd)
 			removePartiallyRedundantChecks(jd);
 			groupArrayBoundsChecks(jd);
 		}
+
+		hoistLoopInvariants(jd);
+		unrollLoops(jd);
 	}
 	else
 	{
@@ -0,0 +1,319 @@
+/* src/vm/jit/loop/unroll.cpp
+
+   Copyright (C) 1996-2013
+   CACAOVM - Verein zur Foerderung der freien virtuellen Maschine CACAO
+
+   This file is part of CACAO.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation; either version 2, or (at
+   your option) any later version.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA.
+
+*/
+
+#include "toolbox/logging.hpp"
+#include "vm/jit/ir/icmd.hpp"
+#include "vm/jit/ir/instruction.hpp"
+#include "vm/options.hpp"
+#include "vm/statistics.hpp"
+
+#include "unroll.hpp"
+
+#include <cstring>
+
+STAT_REGISTER_VAR(int,count_loops_unrolled,0,"unrolled loops","number of unrolled loops")
+
+// The unrolled loop body must not get larger than this (in instructions).
+#define UNROLL_MAX_INSTRUCTIONS 96
+
+namespace
+{
+	basicblock* copyBasicblock(const basicblock* block);
+	bool checkUnrollCandidate(jitdata* jd, LoopContainer* loop);
+	bool isJumpTarget(jitdata* jd, basicblock* target);
+	void unrollLoop(jitdata* jd, LoopContainer* loop, s4 factor);
+
+
+	/**
+	 * Creates a copy of a basicblock that contains no switches.
+	 */
+	basicblock* copyBasicblock(const basicblock* block)
+	{
+		basicblock* copy = new basicblock(*block);
+		copy->ld = new BasicblockLoopData;
+
+		copy->iinstr = new instruction[block->icount];
+		memcpy(copy->iinstr, block->iinstr, sizeof(instruction) * block->icount);
+
+		// There must be only one replacement point and one back-edge
+		// count per loop iteration.
+		copy->bitflags &= ~(BBFLAG_REPLACEMENT | BBFLAG_LOOPHEADER);
+
+		return copy;
+	}
+
+	/**
+	 * Returns true if there is a jump to the specified basicblock.
+	 */
+	bool isJumpTarget(jitdata* jd, basicblock* target)
+	{
+		for (basicblock* block = jd->basicblocks; block; block = block->next)
+		{
+			for (instruction* instr = block->iinstr; instr != block->iinstr + block->icount; instr++)
+			{
+				switch (icmd_table[instr->opc].controlflow)
+				{
+					case CF_IF:
+					case CF_GOTO:
+					case CF_RET:
+						if (instr->dst.block == target)
+							return true;
+						break;
+					case CF_JSR:
+						if (instr->sx.s23.s3.jsrtarget.block == target)
+							return true;
+						break;
+					case CF_TABLE:
+					{
+						// count = (tablehigh - tablelow + 1) + 1 [default branch]
+						s4 count = instr->sx.s23.s3.tablehigh - instr->sx.s23.s2.tablelow + 2;
+
+						branch_target_t* t = instr->dst.table;
+						while (--count >= 0)
+						{
+							if (t->block == target)
+								return true;
+							t++;
+						}
+						break;
+					}
+					case CF_LOOKUP:
+					{
+						if (instr->sx.s23.s3.lookupdefault.block == target)
+							return true;
+
+						lookup_target_t* entry = instr->dst.lookup;
+						s4 count = instr->sx.s23.s2.lookupcount;
+						while (--count >= 0)
+						{
+							if (entry->target.block == target)
+								return true;
+							entry++;
+						}
+						break;
+					}
+					case CF_END:
+					case CF_NORMAL:
+						break;
+				}
+			}
+		}
+
+		return false;
+	}
+
+	/**
+	 * Returns true (otherwise false) if the specified loop has the shape
+	 *
+	 *   header:  ...                          (no branches)
+	 *            if (...) goto exit           (exit is outside of the loop)
+	 *   body:    ...                          (no branches, no calls)
+	 *            goto header
+	 *
+	 * where the header directly precedes the body in the basicblock list,
+	 * the stack is empty at both block boundaries, and the loop has a
+	 * counter variable.  This is the shape javac generates for counted
+	 * for-loops over arrays.
+	 */
+	bool checkUnrollCandidate(jitdata* jd, LoopContainer* loop)
+	{
+		// only innermost counted loops
+		if (!loop->children.empty() || !loop->hasCounterVariable)
+			return false;
+
+		if (loop->nodes.size() != 1 || loop->footers.size() != 1)
+			return false;
+
+		basicblock* header = loop->header;
+		basicblock* body   = loop->nodes[0];
+
+		if (header->next != body || loop->footers[0] != body)
+			return false;
+
+		if (header->type != basicblock::TYPE_STD || body->type != basicblock::TYPE_STD)
+			return false;
+
+		if (header->indepth != 0 || header->outdepth != 0 || body->indepth != 0 || body->outdepth != 0)
+			return false;
+
+		if (header->icount < 1 || body->icount < 1)
+			return false;
+
+		// header: the last instruction leaves the loop, no other branches
+
+		instruction* exitJump = header->iinstr + header->icount - 1;
+
+		if (icmd_table[exitJump->opc].controlflow != CF_IF)
+			return false;
+
+		if (exitJump->dst.block == header || exitJump->dst.block == body)
+			return false;
+
+		for (instruction* instr = header->iinstr; instr != exitJump; instr++)
+		{
+			if (icmd_table[instr->opc].controlflow != CF_NORMAL)
+				return false;
+		}
+
+		// body: the last instruction jumps back, no other branches or calls
+
+		instruction* backJump = body->iinstr + body->icount - 1;
+
+		if (backJump->opc != ICMD_GOTO || backJump->dst.block != header)
+			return false;
+
+		for (instruction* instr = body->iinstr; instr != backJump; instr++)
+		{
+			if (icmd_table[instr->opc].controlflow != CF_NORMAL)
+				return false;
+
+			switch (instr->opc)
+			{
+				case ICMD_INVOKEVIRTUAL:
+				case ICMD_INVOKESPECIAL:
+				case ICMD_INVOKESTATIC:
+				case ICMD_INVOKEINTERFACE:
+				case ICMD_BUILTIN:
+				case ICMD_MONITORENTER:
+				case ICMD_MONITOREXIT:
+					return false;
+
+				default:
+					break;
+			}
+		}
+
+		// the body must only be reachable through the header
+		if (isJumpTarget(jd, body))
+			return false;
+
+		return true;
+	}
+
+	/**
+	 * Unrolls the loop by the specified factor.  The exit test is kept
+	 * in every copy, so no trip count is needed:
+	 *
+	 *   header:  if (...) goto exit
+	 *   body:    ...                          (falls through)
+	 *   header2: if (...) goto exit
+	 *   body2:   ...                          (falls through)
+	 *            ...
+	 *   bodyN:   ...
+	 *            goto header
+	 *
+	 * This removes all but one back jump per factor iterations and gives
+	 * the register allocator and code generator one straight-line
+	 * sequence per copy.
+	 */
+	void unrollLoop(jitdata* jd, LoopContainer* loop, s4 factor)
+	{
+		basicblock* header = loop->header;
+		basicblock* body   = loop->nodes[0];
+		basicblock* after  = body->next;
+
+		std::vector<basicblock*> copies;
+		copies.reserve(2 * (factor - 1));
+
+		for (s4 i = 1; i < factor; i++)
+		{
+			copies.push_back(copyBasicblock(header));
+			copies.push_back(copyBasicblock(body));
+		}
+
+		// All but the last body fall through into the next header copy.
+		basicblock* last = body;
+
+		for (std::vector<basicblock*>::iterator it = copies.begin(); it != copies.end(); it += 2)
+		{
+			last->icount--;
+			last->next = *it;
+			(*it)->next = *(it + 1);
+
+			last = *(it + 1);
+		}
+
+		last->next = after;
+
+		loop->footers[0] = last;
+
+		// Insert the copies into the loop and all enclosing loops except the root loop.
+		for (LoopContainer* l = loop; l->parent; l = l->parent)
+		{
+			for (std::vector<basicblock*>::iterator it = copies.begin(); it != copies.end(); ++it)
+			{
+				l->nodes.push_back(*it);
+			}
+		}
+
+		// Adjust statistical data.
+		jd->basicblockcount += copies.size();
+	}
+}
+
+
+void unrollLoops(jitdata* jd)
+{
+	s4 factor = opt_LoopUnrollFactor;
+
+	if (factor < 2)
+		return;
+
+	for (std::vector<LoopContainer*>::iterator it = jd->ld->loops.begin(); it != jd->ld->loops.end(); ++it)
+	{
+		LoopContainer* loop = *it;
+
+		if (!checkUnrollCandidate(jd, loop))
+			continue;
+
+		// limit the code growth
+		s4 size = loop->header->icount + loop->nodes[0]->icount;
+		s4 f = factor;
+
+		while (f > 1 && size * f > UNROLL_MAX_INSTRUCTIONS)
+			f--;
+
+		if (f < 2)
+			continue;
+
+		unrollLoop(jd, loop, f);
+
+		STATISTICS(count_loops_unrolled++);
+	}
+}
+
+/*
+ * These are local overrides for various environment variables in Emacs.
+ * Please do not remove this and leave it at the end of the file, where
+ * Emacs will automagically detect them.
+ * ---------------------------------------------------------------------
+ * Local variables:
+ * mode: c++
+ * indent-tabs-mode: t
+ * c-basic-offset: 4
+ * tab-width: 4
+ * End:
+ * vim:noexpandtab:sw=4:ts=4:
+ */
+
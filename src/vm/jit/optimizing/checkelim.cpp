@@ -0,0 +1,738 @@
+/* src/vm/jit/optimizing/checkelim.cpp - null and type check elimination
+
+   Copyright (C) 1996-2013
+   CACAOVM - Verein zur Foerderung der freien virtuellen Maschine CACAO
+
+   This file is part of CACAO.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation; either version 2, or (at
+   your option) any later version.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA.
+
+*/
+
+
+#include "config.h"
+
+#include <cassert>
+
+#include "mm/dumpmemory.hpp"
+#include "mm/memory.hpp"
+
+#include "vm/class.hpp"
+#include "vm/descriptor.hpp"
+#include "vm/method.hpp"
+#include "vm/references.hpp"
+#include "vm/statistics.hpp"
+#include "vm/types.hpp"
+
+#include "vm/jit/builtin.hpp"
+#include "vm/jit/compilelog.hpp"
+#include "vm/jit/jit.hpp"
+
+#include "vm/jit/ir/icmd.hpp"
+#include "vm/jit/ir/instruction.hpp"
+
+#include "vm/jit/optimizing/checkelim.hpp"
+
+
+STAT_REGISTER_VAR(int,count_nullchecks_removed,0,"null checks removed","explicit null checks removed by check elimination")
+STAT_REGISTER_VAR(int,count_typechecks_removed,0,"type checks removed","checkcast and instanceof removed by check elimination")
+
+
+/* limits *********************************************************************/
+
+#define CHECKELIM_MAX_STATES    (1 << 20)   // basic blocks * local variables
+
+
+struct checkelim_t {
+	jitdata     *jd;
+	bool         rewrite;           // remove checks during the walk
+	s4           nullchecks;        // removed explicit null checks
+	s4           typechecks;        // removed CHECKCASTs and INSTANCEOFs
+
+	/* facts at the current point of the walk; for variables other than
+	   locals only valid if their stamp is that of the walk */
+
+	u1          *nonnull;
+	classinfo  **type;              // class the value is an instance of,
+	                                // if it is not null
+	classinfo  **constclass;        // class of a class constant
+	s4          *origin;            // local the value was copied from
+	s4          *originversion;
+	s4          *version;           // per local, counts the assignments
+	s4          *stamp;
+	s4           curstamp;
+
+	/* facts of the locals at the start and end of each block */
+
+	u1          *innonnull;
+	classinfo  **intype;
+	u1          *outnonnull;
+	classinfo  **outtype;
+	u1          *visited;
+
+	/* the local an IFNULL/IFNONNULL ending the block tests, and the
+	   successor on which it is not null */
+
+	s4          *testedlocal;
+	basicblock **nonnullsucc;
+};
+
+
+static bool checkelim_valid(checkelim_t *ce, s4 v)
+{
+	return var_is_local(ce->jd, v) || (ce->stamp[v] == ce->curstamp);
+}
+
+
+static bool checkelim_is_nonnull(checkelim_t *ce, s4 v)
+{
+	return checkelim_valid(ce, v) && ce->nonnull[v];
+}
+
+
+static classinfo *checkelim_type(checkelim_t *ce, s4 v)
+{
+	return checkelim_valid(ce, v) ? ce->type[v] : NULL;
+}
+
+
+/* checkelim_origin ************************************************************
+
+   Returns the local holding the same value as the variable, or UNUSED.
+
+*******************************************************************************/
+
+static s4 checkelim_origin(checkelim_t *ce, s4 v)
+{
+	if (var_is_local(ce->jd, v))
+		return v;
+
+	if (!checkelim_valid(ce, v))
+		return jitdata::UNUSED;
+
+	s4 o = ce->origin[v];
+
+	if ((o == jitdata::UNUSED) || (ce->originversion[v] != ce->version[o]))
+		return jitdata::UNUSED;
+
+	return o;
+}
+
+
+/* checkelim_define ************************************************************
+
+   Records the facts of a variable at its assignment.
+
+*******************************************************************************/
+
+static void checkelim_define(checkelim_t *ce, s4 v, bool nonnull, classinfo *type, s4 origin)
+{
+	if (var_is_local(ce->jd, v)) {
+		ce->version[v]++;
+	}
+	else {
+		ce->stamp[v]         = ce->curstamp;
+		ce->constclass[v]    = NULL;
+		ce->origin[v]        = origin;
+		ce->originversion[v] = (origin != jitdata::UNUSED) ? ce->version[origin] : 0;
+	}
+
+	ce->nonnull[v] = nonnull;
+	ce->type[v]    = type;
+}
+
+
+static void checkelim_mark_nonnull(checkelim_t *ce, s4 v)
+{
+	s4 o = checkelim_origin(ce, v);
+
+	if (!checkelim_valid(ce, v))
+		checkelim_define(ce, v, true, NULL, jitdata::UNUSED);
+
+	ce->nonnull[v] = 1;
+
+	if (o != jitdata::UNUSED)
+		ce->nonnull[o] = 1;
+}
+
+
+static void checkelim_mark_type(checkelim_t *ce, s4 v, classinfo *c)
+{
+	s4 o = checkelim_origin(ce, v);
+
+	if (!checkelim_valid(ce, v))
+		checkelim_define(ce, v, false, NULL, jitdata::UNUSED);
+
+	ce->type[v] = c;
+
+	if (o != jitdata::UNUSED)
+		ce->type[o] = c;
+}
+
+
+/* checkelim_usable_class ******************************************************
+
+   Returns the class if subtype tests against it can be done at
+   compile time, NULL otherwise.
+
+*******************************************************************************/
+
+static classinfo *checkelim_usable_class(classinfo *c)
+{
+	if ((c == NULL) || !(c->state & CLASS_LINKED) || (c->vftbl->arraydesc != NULL))
+		return NULL;
+
+	return c;
+}
+
+
+/* checkelim_check_class *******************************************************
+
+   Returns the class a CHECKCAST or INSTANCEOF tests for, or NULL.
+
+*******************************************************************************/
+
+static classinfo *checkelim_check_class(const instruction *iptr)
+{
+	if (INSTRUCTION_IS_UNRESOLVED(iptr) || (iptr->flags.bits & INS_FLAG_ARRAY))
+		return NULL;
+
+	return checkelim_usable_class(iptr->sx.s23.s3.c.cls);
+}
+
+
+static bool checkelim_is_instance(checkelim_t *ce, s4 v, classinfo *c)
+{
+	classinfo *t = checkelim_type(ce, v);
+
+	if ((c == NULL) || (t == NULL))
+		return false;
+
+	if (t == c)
+		return true;
+
+	/* the value may be of any class implementing the interface */
+
+	if (t->flags & ACC_INTERFACE)
+		return (c == class_java_lang_Object);
+
+	return class_isanysubclass(t, c);
+}
+
+
+/* checkelim_dereferenced ******************************************************
+
+   Returns the variable the instruction throws a NullPointerException
+   for if it is null, or UNUSED.
+
+*******************************************************************************/
+
+static s4 checkelim_dereferenced(const instruction *iptr)
+{
+	switch (iptr->opc) {
+	case ICMD_GETFIELD:
+	case ICMD_PUTFIELD:
+	case ICMD_PUTFIELDCONST:
+	case ICMD_ARRAYLENGTH:
+	case ICMD_IALOAD:
+	case ICMD_LALOAD:
+	case ICMD_FALOAD:
+	case ICMD_DALOAD:
+	case ICMD_AALOAD:
+	case ICMD_BALOAD:
+	case ICMD_CALOAD:
+	case ICMD_SALOAD:
+	case ICMD_IASTORE:
+	case ICMD_LASTORE:
+	case ICMD_FASTORE:
+	case ICMD_DASTORE:
+	case ICMD_AASTORE:
+	case ICMD_BASTORE:
+	case ICMD_CASTORE:
+	case ICMD_SASTORE:
+	case ICMD_IASTORECONST:
+	case ICMD_LASTORECONST:
+	case ICMD_FASTORECONST:
+	case ICMD_DASTORECONST:
+	case ICMD_AASTORECONST:
+	case ICMD_BASTORECONST:
+	case ICMD_CASTORECONST:
+	case ICMD_SASTORECONST:
+	case ICMD_MONITORENTER:
+	case ICMD_MONITOREXIT:
+		return iptr->s1.varindex;
+
+	case ICMD_CHECKNULL:
+		return INSTRUCTION_MUST_CHECK(iptr) ? iptr->s1.varindex : (s4) jitdata::UNUSED;
+
+	case ICMD_INVOKESPECIAL:
+		if (!INSTRUCTION_MUST_CHECK(iptr))
+			return jitdata::UNUSED;
+		return iptr->sx.s23.s2.args[0];
+
+	case ICMD_INVOKEVIRTUAL:
+	case ICMD_INVOKEINTERFACE:
+		return iptr->sx.s23.s2.args[0];
+
+	case ICMD_BUILTIN:
+		switch (iptr->sx.s23.s3.bte->opcode) {
+		case ICMD_MONITORENTER:
+		case ICMD_MONITOREXIT:
+			return iptr->sx.s23.s2.args[0];
+		default:
+			return jitdata::UNUSED;
+		}
+
+	default:
+		return jitdata::UNUSED;
+	}
+}
+
+
+/* checkelim_rewrite ***********************************************************
+
+   Changes the opcode of an instruction, keeping the basic block start
+   and the instruction id.
+
+*******************************************************************************/
+
+static void checkelim_rewrite(instruction *iptr, ICMD opc)
+{
+	iptr->opc         = opc;
+	iptr->flags.bits &= (INS_FLAG_BASICBLOCK | INS_FLAG_ID_MASK);
+}
+
+
+/* checkelim_remove ************************************************************
+
+   Removes the check the instruction does if it is known to succeed.
+
+*******************************************************************************/
+
+static void checkelim_remove(checkelim_t *ce, instruction *iptr)
+{
+	jitdata *jd = ce->jd;
+	s4       s1 = iptr->s1.varindex;
+
+	switch (iptr->opc) {
+	case ICMD_CHECKNULL:
+		if (!INSTRUCTION_MUST_CHECK(iptr) || !checkelim_is_nonnull(ce, s1))
+			return;
+
+		checkelim_rewrite(iptr, (iptr->dst.varindex == s1) ? ICMD_NOP : ICMD_MOVE);
+		ce->nullchecks++;
+		return;
+
+	case ICMD_INVOKESPECIAL:
+		if (!INSTRUCTION_MUST_CHECK(iptr) || !checkelim_is_nonnull(ce, iptr->sx.s23.s2.args[0]))
+			return;
+
+		iptr->flags.bits &= ~INS_FLAG_CHECK;
+		ce->nullchecks++;
+		return;
+
+	case ICMD_CHECKCAST:
+		if (!checkelim_is_instance(ce, s1, checkelim_check_class(iptr)))
+			return;
+
+		checkelim_rewrite(iptr, (iptr->dst.varindex == s1) ? ICMD_NOP : ICMD_MOVE);
+		ce->typechecks++;
+		return;
+
+	case ICMD_INSTANCEOF:
+
+		/* the register allocator expects stack slots to be read, so
+		   only tests of locals are folded */
+
+		if (!var_is_local(jd, s1) || !checkelim_is_nonnull(ce, s1) ||
+			!checkelim_is_instance(ce, s1, checkelim_check_class(iptr)))
+			return;
+
+		checkelim_rewrite(iptr, ICMD_ICONST);
+		iptr->sx.val.i = 1;
+		ce->typechecks++;
+		return;
+
+	default:
+		return;
+	}
+}
+
+
+/* checkelim_transfer **********************************************************
+
+   Updates the facts for the effects of an instruction.
+
+*******************************************************************************/
+
+static void checkelim_transfer(checkelim_t *ce, const instruction *iptr)
+{
+	s4 v = checkelim_dereferenced(iptr);
+
+	if (v != jitdata::UNUSED)
+		checkelim_mark_nonnull(ce, v);
+
+	if (!instruction_has_dst(iptr))
+		return;
+
+	s4         dst     = iptr->dst.varindex;
+	s4         s1      = iptr->s1.varindex;
+	bool       nonnull = false;
+	classinfo *type    = NULL;
+	s4         origin  = jitdata::UNUSED;
+	classinfo *c       = NULL;
+
+	switch (iptr->opc) {
+	case ICMD_COPY:
+	case ICMD_MOVE:
+	case ICMD_ALOAD:
+	case ICMD_ASTORE:
+	case ICMD_CHECKNULL:
+	case ICMD_CHECKCAST:
+		if ((iptr->opc == ICMD_CHECKCAST) && ((c = checkelim_check_class(iptr)) != NULL)) {
+
+			/* the object passed the cast, so the local it came from
+			   holds an instance of the class as well */
+
+			checkelim_mark_type(ce, s1, c);
+			c = NULL;
+		}
+
+		if (s1 == dst)
+			return;
+
+		nonnull = checkelim_is_nonnull(ce, s1);
+		type    = checkelim_type(ce, s1);
+		origin  = checkelim_origin(ce, s1);
+		break;
+
+	case ICMD_ACONST:
+		if (iptr->flags.bits & INS_FLAG_CLASS) {
+			nonnull = true;
+
+			if (INSTRUCTION_IS_RESOLVED(iptr))
+				c = iptr->sx.val.c.cls;
+		}
+		else {
+			nonnull = INSTRUCTION_IS_UNRESOLVED(iptr) || (iptr->sx.val.anyptr != NULL);
+		}
+		break;
+
+	case ICMD_BUILTIN:
+		switch (iptr->sx.s23.s3.bte->opcode) {
+		case ICMD_NEW:
+			nonnull = true;
+
+			if (checkelim_valid(ce, iptr->sx.s23.s2.args[0]))
+				type = checkelim_usable_class(ce->constclass[iptr->sx.s23.s2.args[0]]);
+			break;
+
+		case ICMD_NEWARRAY:
+		case ICMD_ANEWARRAY:
+		case ICMD_MULTIANEWARRAY:
+			nonnull = true;
+			break;
+
+		default:
+			break;
+		}
+		break;
+
+	default:
+		break;
+	}
+
+	checkelim_define(ce, dst, nonnull, type, origin);
+
+	if (!var_is_local(ce->jd, dst))
+		ce->constclass[dst] = c;
+}
+
+
+/* checkelim_find_test *********************************************************
+
+   Records the local tested by an IFNULL or IFNONNULL ending the block,
+   and the successor reached if it is not null.
+
+*******************************************************************************/
+
+static void checkelim_find_test(checkelim_t *ce, basicblock *bptr)
+{
+	instruction *iptr = bptr->iinstr + bptr->icount - 1;
+	basicblock  *fallthrough;
+
+	ce->testedlocal[bptr->nr] = jitdata::UNUSED;
+
+	while ((iptr->opc == ICMD_NOP) && (iptr != bptr->iinstr))
+		iptr--;
+
+	if (iptr->opc == ICMD_GOTO) {
+		fallthrough = iptr->dst.block;
+
+		if (iptr == bptr->iinstr)
+			return;
+
+		iptr--;
+
+		while ((iptr->opc == ICMD_NOP) && (iptr != bptr->iinstr))
+			iptr--;
+	}
+	else {
+		fallthrough = bptr->next;
+	}
+
+	basicblock *succ;
+
+	if (iptr->opc == ICMD_IFNULL)
+		succ = fallthrough;
+	else if (iptr->opc == ICMD_IFNONNULL)
+		succ = iptr->dst.block;
+	else
+		return;
+
+	/* both edges may lead to the same block */
+
+	if (iptr->dst.block == fallthrough)
+		return;
+
+	ce->testedlocal[bptr->nr] = checkelim_origin(ce, iptr->s1.varindex);
+	ce->nonnullsucc[bptr->nr] = succ;
+}
+
+
+/* checkelim_walk **************************************************************
+
+   Walks a block starting with the facts recorded for its start and
+   records the facts at its end.  Returns true if they changed.
+
+*******************************************************************************/
+
+static bool checkelim_walk(checkelim_t *ce, basicblock *bptr)
+{
+	jitdata     *jd = ce->jd;
+	instruction *iptr;
+	s4           n  = jd->localcount;
+
+	ce->curstamp++;
+
+	MCOPY(ce->nonnull, ce->innonnull + bptr->nr * n, u1, n);
+	MCOPY(ce->type, ce->intype + bptr->nr * n, classinfo*, n);
+
+	FOR_EACH_INSTRUCTION(bptr, iptr) {
+		if (ce->rewrite)
+			checkelim_remove(ce, iptr);
+
+		checkelim_transfer(ce, iptr);
+	}
+
+	checkelim_find_test(ce, bptr);
+
+	u1         *outnonnull = ce->outnonnull + bptr->nr * n;
+	classinfo **outtype    = ce->outtype + bptr->nr * n;
+	bool        changed    = !ce->visited[bptr->nr];
+
+	for (s4 i = 0; i < n; i++) {
+		if ((outnonnull[i] != ce->nonnull[i]) || (outtype[i] != ce->type[i])) {
+			outnonnull[i] = ce->nonnull[i];
+			outtype[i]    = ce->type[i];
+			changed       = true;
+		}
+	}
+
+	ce->visited[bptr->nr] = 1;
+
+	return changed;
+}
+
+
+/* checkelim_merge *************************************************************
+
+   Computes the facts at the start of a block from those at the end of
+   its predecessors walked so far.  Returns false if none was walked.
+
+*******************************************************************************/
+
+static bool checkelim_merge(checkelim_t *ce, basicblock *bptr)
+{
+	jitdata     *jd        = ce->jd;
+	basicblock **pred;
+	s4           n         = jd->localcount;
+	u1          *innonnull = ce->innonnull + bptr->nr * n;
+	classinfo  **intype    = ce->intype + bptr->nr * n;
+	bool         first     = true;
+
+	if (bptr->type == basicblock::TYPE_EXH) {
+		MZERO(innonnull, u1, n);
+		MZERO(intype, classinfo*, n);
+		return true;
+	}
+
+	/* the method entry: `this' is not null */
+
+	if (bptr == jd->basicblocks) {
+		MZERO(innonnull, u1, n);
+		MZERO(intype, classinfo*, n);
+
+		if (!(jd->m->flags & ACC_STATIC)) {
+			s4 v = jd->local_map[0 * 5 + TYPE_ADR];
+
+			if (v != jitdata::UNUSED)
+				innonnull[v] = 1;
+		}
+
+		first = false;
+	}
+
+	FOR_EACH_PREDECESSOR(bptr, pred) {
+		s4 p = (*pred)->nr;
+
+		if (!ce->visited[p])
+			continue;
+
+		u1         *outnonnull = ce->outnonnull + p * n;
+		classinfo **outtype    = ce->outtype + p * n;
+		s4          tested     = (ce->nonnullsucc[p] == bptr) ? ce->testedlocal[p] : (s4) jitdata::UNUSED;
+
+		for (s4 i = 0; i < n; i++) {
+			u1 nonnull = outnonnull[i] || (i == tested);
+
+			if (first) {
+				innonnull[i] = nonnull;
+				intype[i]    = outtype[i];
+			}
+			else {
+				innonnull[i] &= nonnull;
+
+				if (intype[i] != outtype[i])
+					intype[i] = NULL;
+			}
+		}
+
+		first = false;
+	}
+
+	return !first;
+}
+
+
+/* checkelim *******************************************************************
+
+   Removes the null and type checks known to succeed.  Returns the
+   number of checks removed.
+
+*******************************************************************************/
+
+int32_t checkelim(jitdata *jd)
+{
+	basicblock  *bptr;
+	instruction *iptr;
+	checkelim_t  ce;
+	s4           n = jd->localcount;
+
+	if ((s8) jd->basicblockcount * n > CHECKELIM_MAX_STATES)
+		return 0;
+
+	/* the CFG does not describe subroutines and empty blocks falling
+	   through */
+
+	FOR_EACH_BASICBLOCK(jd, bptr) {
+		if (bptr->state < basicblock::REACHED)
+			continue;
+
+		if ((bptr->icount == 0) || (bptr->nr < 0) || (bptr->nr >= jd->basicblockcount))
+			return 0;
+
+		FOR_EACH_INSTRUCTION(bptr, iptr) {
+			if ((iptr->opc == ICMD_JSR) || (iptr->opc == ICMD_RET))
+				return 0;
+		}
+	}
+
+	ce.jd            = jd;
+	ce.rewrite       = false;
+	ce.nullchecks    = 0;
+	ce.typechecks    = 0;
+	ce.nonnull       = DMNEW(u1, jd->vartop);
+	ce.type          = DMNEW(classinfo*, jd->vartop);
+	ce.constclass    = DMNEW(classinfo*, jd->vartop);
+	ce.origin        = DMNEW(s4, jd->vartop);
+	ce.originversion = DMNEW(s4, jd->vartop);
+	ce.version       = DMNEW(s4, n + 1);
+	ce.stamp         = DMNEW(s4, jd->vartop);
+	ce.curstamp      = 0;
+	ce.innonnull     = DMNEW(u1, jd->basicblockcount * n + 1);
+	ce.intype        = DMNEW(classinfo*, jd->basicblockcount * n + 1);
+	ce.outnonnull    = DMNEW(u1, jd->basicblockcount * n + 1);
+	ce.outtype       = DMNEW(classinfo*, jd->basicblockcount * n + 1);
+	ce.visited       = DMNEW(u1, jd->basicblockcount);
+	ce.testedlocal   = DMNEW(s4, jd->basicblockcount);
+	ce.nonnullsucc   = DMNEW(basicblock*, jd->basicblockcount);
+
+	MZERO(ce.version, s4, n + 1);
+	MZERO(ce.stamp, s4, jd->vartop);
+	MZERO(ce.visited, u1, jd->basicblockcount);
+	MZERO(ce.nonnullsucc, basicblock*, jd->basicblockcount);
+
+	/* compute the facts at the block boundaries */
+
+	bool changed;
+
+	do {
+		changed = false;
+
+		FOR_EACH_BASICBLOCK(jd, bptr) {
+			if ((bptr->state >= basicblock::REACHED) && checkelim_merge(&ce, bptr) &&
+				checkelim_walk(&ce, bptr))
+				changed = true;
+		}
+	} while (changed);
+
+	/* remove the checks */
+
+	ce.rewrite = true;
+
+	FOR_EACH_BASICBLOCK(jd, bptr) {
+		if ((bptr->state >= basicblock::REACHED) && ce.visited[bptr->nr]) {
+			checkelim_merge(&ce, bptr);
+			checkelim_walk(&ce, bptr);
+		}
+	}
+
+	STATISTICS(count_nullchecks_removed += ce.nullchecks);
+	STATISTICS(count_typechecks_removed += ce.typechecks);
+
+	if (jd->log != NULL) {
+		jd->log->nullchecks += ce.nullchecks;
+		jd->log->typechecks += ce.typechecks;
+	}
+
+	return ce.nullchecks + ce.typechecks;
+}
+
+
+/*
+ * These are local overrides for various environment variables in Emacs.
+ * Please do not remove this and leave it at the end of the file, where
+ * Emacs will automagically detect them.
+ * ---------------------------------------------------------------------
+ * Local variables:
+ * mode: c++
+ * indent-tabs-mode: t
+ * c-basic-offset: 4
+ * tab-width: 4
+ * End:
+ * vim:noexpandtab:sw=4:ts=4:
+ */
@@ -0,0 +1,74 @@
+/* src/vm/jit/optimizing/checkelim.hpp - null and type check elimination
+
+   Copyright (C) 1996-2013
+   CACAOVM - Verein zur Foerderung der freien virtuellen Maschine CACAO
+
+   This file is part of CACAO.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation; either version 2, or (at
+   your option) any later version.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA.
+
+*/
+
+
+#ifndef _CHECKELIM_HPP
+#define _CHECKELIM_HPP
+
+#include "config.h"
+
+#include <stdint.h>
+
+struct jitdata;
+
+
+/* Check elimination **********************************************************
+
+   Removes explicit null checks (CHECKNULL, the receiver check of
+   INVOKESPECIAL) on values known to be non-null, CHECKCASTs on values
+   known to be instances of the target class, and INSTANCEOFs that are
+   known to succeed.
+
+   A value is known to be non-null after NEW, for constants, for `this'
+   and after it has been dereferenced or passed an explicit null check,
+   and on the non-null edge of IFNULL/IFNONNULL.  Its class is known
+   after NEW and after a CHECKCAST.  The facts of the local variables
+   hold at the start of a block if they hold at the end of all its
+   predecessors, the facts of stack slots only within their block.
+
+   Must run after the CFG has been built.  Disabled with
+   -XX:-EliminateChecks.
+
+*******************************************************************************/
+
+/* function prototypes ********************************************************/
+
+int32_t checkelim(jitdata *jd);
+
+#endif /* _CHECKELIM_HPP */
+
+
+/*
+ * These are local overrides for various environment variables in Emacs.
+ * Please do not remove this and leave it at the end of the file, where
+ * Emacs will automagically detect them.
+ * ---------------------------------------------------------------------
+ * Local variables:
+ * mode: c++
+ * indent-tabs-mode: t
+ * c-basic-offset: 4
+ * tab-width: 4
+ * End:
+ * vim:noexpandtab:sw=4:ts=4:
+ */
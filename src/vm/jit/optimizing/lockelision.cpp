@@ -0,0 +1,521 @@
+/* src/vm/jit/optimizing/lockelision.cpp - lock elision
+
+   Copyright (C) 1996-2013
+   CACAOVM - Verein zur Foerderung der freien virtuellen Maschine CACAO
+
+   This file is part of CACAO.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation; either version 2, or (at
+   your option) any later version.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA.
+
+*/
+
+
+#include "config.h"
+
+#include <cassert>
+
+#include "mm/dumpmemory.hpp"
+#include "mm/memory.hpp"
+
+#include "vm/class.hpp"
+#include "vm/descriptor.hpp"
+#include "vm/references.hpp"
+#include "vm/statistics.hpp"
+#include "vm/types.hpp"
+
+#include "vm/jit/builtin.hpp"
+#include "vm/jit/compilelog.hpp"
+#include "vm/jit/jit.hpp"
+
+#include "vm/jit/ir/icmd.hpp"
+#include "vm/jit/ir/instruction.hpp"
+
+#include "vm/jit/optimizing/lockelision.hpp"
+
+
+STAT_REGISTER_VAR(int,count_monitors_elided,0,"monitors elided","monitor operations removed by lock elision")
+
+
+/* flags of a set of variables ************************************************/
+
+#define LOCKELISION_ALLOCATED    0x01   // holds objects allocated by NEW
+#define LOCKELISION_NULL         0x02   // may hold null
+#define LOCKELISION_ESCAPES      0x04   // may hold objects of other origin,
+                                        // or objects other threads can reach
+
+struct lockelision_t {
+	jitdata     *jd;
+	s4          *parent;                // union-find forest over the variables
+	u1          *flags;                 // valid for the roots
+	classinfo  **constclass;            // class constant held by a variable
+	s4          *defcount;              // number of definitions of a variable
+};
+
+
+/* lockelision_find ************************************************************
+
+   Returns the representative of the set containing the variable.
+
+*******************************************************************************/
+
+static s4 lockelision_find(lockelision_t *le, s4 v)
+{
+	while (le->parent[v] != v) {
+		le->parent[v] = le->parent[le->parent[v]];
+		v = le->parent[v];
+	}
+
+	return v;
+}
+
+
+static void lockelision_union(lockelision_t *le, s4 a, s4 b)
+{
+	a = lockelision_find(le, a);
+	b = lockelision_find(le, b);
+
+	if (a == b)
+		return;
+
+	le->parent[b] = a;
+	le->flags[a] |= le->flags[b];
+}
+
+
+static void lockelision_mark(lockelision_t *le, s4 v, u1 flags)
+{
+	le->flags[lockelision_find(le, v)] |= flags;
+}
+
+
+static bool lockelision_is_adr(lockelision_t *le, s4 v)
+{
+	return (v != jitdata::UNUSED) && (le->jd->var[v].type == TYPE_ADR);
+}
+
+
+/* lockelision_is_monitor ******************************************************
+
+   Returns the builtin opcode of a monitor operation, 0 for other
+   instructions.
+
+*******************************************************************************/
+
+static s4 lockelision_is_monitor(const instruction *iptr)
+{
+	if (iptr->opc != ICMD_BUILTIN)
+		return 0;
+
+	s4 opcode = iptr->sx.s23.s3.bte->opcode;
+
+	return (opcode == ICMD_MONITORENTER || opcode == ICMD_MONITOREXIT) ? opcode : 0;
+}
+
+
+/* lockelision_dst *************************************************************
+
+   Returns the variable defined by the instruction, jitdata::UNUSED if
+   there is none.
+
+*******************************************************************************/
+
+static s4 lockelision_dst(const instruction *iptr)
+{
+	methoddesc *md;
+
+	switch (icmd_table[iptr->opc].dataflow) {
+	case DF_INVOKE:
+		INSTRUCTION_GET_METHODDESC(iptr, md);
+		break;
+
+	case DF_BUILTIN:
+		md = iptr->sx.s23.s3.bte->md;
+		break;
+
+	default:
+		if (icmd_table[iptr->opc].dataflow >= DF_DST_BASE)
+			return iptr->dst.varindex;
+		return jitdata::UNUSED;
+	}
+
+	return (md->returntype.type == TYPE_VOID) ? jitdata::UNUSED : iptr->dst.varindex;
+}
+
+
+/* lockelision_is_local_use ****************************************************
+
+   Returns true if using the value as the given operand (0 for s1, 1
+   for s2, 2 for s3 or the argument number) publishes neither the value
+   itself nor its contents.
+
+*******************************************************************************/
+
+static bool lockelision_is_local_use(const instruction *iptr, s4 operand)
+{
+	switch (iptr->opc) {
+	case ICMD_COPY:
+	case ICMD_MOVE:
+	case ICMD_ALOAD:
+	case ICMD_ASTORE:
+	case ICMD_CHECKNULL:
+	case ICMD_CHECKCAST:
+	case ICMD_INSTANCEOF:
+	case ICMD_IFNULL:
+	case ICMD_IFNONNULL:
+	case ICMD_IF_CLASSNE:
+	case ICMD_IF_ACMPEQ:
+	case ICMD_IF_ACMPNE:
+	case ICMD_ARRAYLENGTH:
+	case ICMD_GETFIELD:
+	case ICMD_IALOAD:
+	case ICMD_LALOAD:
+	case ICMD_FALOAD:
+	case ICMD_DALOAD:
+	case ICMD_AALOAD:
+	case ICMD_BALOAD:
+	case ICMD_CALOAD:
+	case ICMD_SALOAD:
+		return true;
+
+	/* storing into the object is fine, storing the object is not */
+
+	case ICMD_PUTFIELD:
+	case ICMD_PUTFIELDCONST:
+	case ICMD_IASTORE:
+	case ICMD_LASTORE:
+	case ICMD_FASTORE:
+	case ICMD_DASTORE:
+	case ICMD_AASTORE:
+	case ICMD_BASTORE:
+	case ICMD_CASTORE:
+	case ICMD_SASTORE:
+	case ICMD_IASTORECONST:
+	case ICMD_LASTORECONST:
+	case ICMD_FASTORECONST:
+	case ICMD_DASTORECONST:
+	case ICMD_AASTORECONST:
+	case ICMD_BASTORECONST:
+	case ICMD_CASTORECONST:
+	case ICMD_SASTORECONST:
+		return (operand == 0);
+
+	case ICMD_BUILTIN:
+		return (lockelision_is_monitor(iptr) != 0) && (operand == 0);
+
+	default:
+		return false;
+	}
+}
+
+
+static void lockelision_use(lockelision_t *le, const instruction *iptr, s4 v, s4 operand)
+{
+	if (lockelision_is_adr(le, v) && !lockelision_is_local_use(iptr, operand))
+		lockelision_mark(le, v, LOCKELISION_ESCAPES);
+}
+
+
+/* lockelision_scan_uses *******************************************************
+
+   Marks the sets of all values the instruction lets escape.  Returns
+   false for instructions the analysis does not understand.
+
+*******************************************************************************/
+
+static bool lockelision_scan_uses(lockelision_t *le, const instruction *iptr)
+{
+	methoddesc *md;
+	s4          argcount;
+
+	switch (icmd_table[iptr->opc].dataflow) {
+	case DF_3_TO_0:
+	case DF_3_TO_1:
+		lockelision_use(le, iptr, iptr->sx.s23.s3.varindex, 2);
+		/* fall through */
+
+	case DF_2_TO_0:
+	case DF_2_TO_1:
+		lockelision_use(le, iptr, iptr->sx.s23.s2.varindex, 1);
+		/* fall through */
+
+	case DF_1_TO_0:
+	case DF_1_TO_1:
+	case DF_COPY:
+	case DF_MOVE:
+		lockelision_use(le, iptr, iptr->s1.varindex, 0);
+		return true;
+
+	case DF_0_TO_0:
+	case DF_0_TO_1:
+		return true;
+
+	case DF_INVOKE:
+		INSTRUCTION_GET_METHODDESC(iptr, md);
+		argcount = md->paramcount;
+		break;
+
+	case DF_BUILTIN:
+		/* inlined monitor exits carry pass-through variables behind
+		   the arguments */
+		argcount = iptr->sx.s23.s3.bte->md->paramcount;
+		break;
+
+	case DF_N_TO_1:
+		argcount = iptr->s1.argcount;
+		break;
+
+	default:
+		return false;
+	}
+
+	for (s4 i = 0; i < argcount; i++)
+		lockelision_use(le, iptr, iptr->sx.s23.s2.args[i], i);
+
+	return true;
+}
+
+
+/* lockelision_scan_def ********************************************************
+
+   Merges the set of the variable defined by the instruction with the
+   set of its source, or records where the value comes from.
+
+*******************************************************************************/
+
+static void lockelision_scan_def(lockelision_t *le, const instruction *iptr)
+{
+	s4 dst = lockelision_dst(iptr);
+
+	if (!lockelision_is_adr(le, dst))
+		return;
+
+	switch (iptr->opc) {
+	case ICMD_COPY:
+	case ICMD_MOVE:
+	case ICMD_ALOAD:
+	case ICMD_ASTORE:
+	case ICMD_CHECKNULL:
+	case ICMD_CHECKCAST:
+		lockelision_union(le, iptr->s1.varindex, dst);
+		return;
+
+	case ICMD_ACONST:
+		if (!(iptr->flags.bits & (INS_FLAG_CLASS | INS_FLAG_UNRESOLVED)) &&
+			(iptr->sx.val.anyptr == NULL))
+			lockelision_mark(le, dst, LOCKELISION_NULL);
+		else
+			lockelision_mark(le, dst, LOCKELISION_ESCAPES);
+		return;
+
+	case ICMD_BUILTIN:
+		if (iptr->sx.s23.s3.bte->opcode == ICMD_NEW) {
+			s4         cv = iptr->sx.s23.s2.args[0];
+			classinfo *c  = (le->defcount[cv] == 1) ? le->constclass[cv] : NULL;
+
+			/* the finalizer thread may see objects with a finalizer,
+			   and the finalizer is only known once the class is linked */
+
+			if ((c != NULL) && (c->state & CLASS_LINKED) && (c->finalizer == NULL)) {
+				lockelision_mark(le, dst, LOCKELISION_ALLOCATED);
+				return;
+			}
+		}
+		break;
+
+	default:
+		break;
+	}
+
+	lockelision_mark(le, dst, LOCKELISION_ESCAPES);
+}
+
+
+/* lockelision_scan_arguments **************************************************
+
+   The address parameters of the method come from the caller.
+
+*******************************************************************************/
+
+static void lockelision_scan_arguments(lockelision_t *le)
+{
+	jitdata    *jd = le->jd;
+	methoddesc *md = jd->m->parseddesc;
+
+	for (s4 p = 0, l = 0; p < md->paramcount; p++) {
+		s4 t = md->paramtypes[p].type;
+
+		if (t == TYPE_ADR) {
+			s4 v = jd->local_map[l * 5 + t];
+
+			if (v != jitdata::UNUSED)
+				lockelision_mark(le, v, LOCKELISION_ESCAPES);
+		}
+
+		l += IS_2_WORD_TYPE(t) ? 2 : 1;
+	}
+}
+
+
+/* lockelision *****************************************************************
+
+   Replaces the monitor operations on local objects by a null check, or
+   by nothing if the object cannot be null.  Returns the number of
+   monitor operations removed.
+
+*******************************************************************************/
+
+int32_t lockelision(jitdata *jd)
+{
+	basicblock   *bptr;
+	basicblock  **succ;
+	instruction  *iptr;
+	s4            monitors = 0;
+
+	FOR_EACH_BASICBLOCK(jd, bptr) {
+		if (bptr->state < basicblock::REACHED)
+			continue;
+
+		FOR_EACH_INSTRUCTION(bptr, iptr) {
+			if (lockelision_is_monitor(iptr))
+				monitors++;
+		}
+	}
+
+	if (monitors == 0)
+		return 0;
+
+	lockelision_t le;
+
+	le.jd         = jd;
+	le.parent     = DMNEW(s4, jd->vartop);
+	le.flags      = DMNEW(u1, jd->vartop);
+	le.constclass = DMNEW(classinfo*, jd->vartop);
+	le.defcount   = DMNEW(s4, jd->vartop);
+
+	MZERO(le.flags, u1, jd->vartop);
+	MZERO(le.constclass, classinfo*, jd->vartop);
+	MZERO(le.defcount, s4, jd->vartop);
+
+	for (s4 i = 0; i < jd->vartop; i++)
+		le.parent[i] = i;
+
+	/* class constants used by NEW */
+
+	FOR_EACH_BASICBLOCK(jd, bptr) {
+		if (bptr->state < basicblock::REACHED)
+			continue;
+
+		FOR_EACH_INSTRUCTION(bptr, iptr) {
+			s4 dst = lockelision_dst(iptr);
+
+			if (!lockelision_is_adr(&le, dst))
+				continue;
+
+			le.defcount[dst]++;
+
+			if ((iptr->opc == ICMD_ACONST) && (iptr->flags.bits & INS_FLAG_CLASS) &&
+				INSTRUCTION_IS_RESOLVED(iptr))
+				le.constclass[dst] = iptr->sx.val.c.cls;
+		}
+	}
+
+	/* build the sets */
+
+	lockelision_scan_arguments(&le);
+
+	FOR_EACH_BASICBLOCK(jd, bptr) {
+		if (bptr->state < basicblock::REACHED)
+			continue;
+
+		/* the stack of an exception handler holds the exception */
+
+		if (bptr->type == basicblock::TYPE_EXH) {
+			for (s4 i = 0; i < bptr->indepth; i++)
+				if (lockelision_is_adr(&le, bptr->invars[i]))
+					lockelision_mark(&le, bptr->invars[i], LOCKELISION_ESCAPES);
+		}
+
+		FOR_EACH_SUCCESSOR(bptr, succ) {
+			if ((*succ)->indepth != bptr->outdepth)
+				return 0;
+
+			for (s4 i = 0; i < bptr->outdepth; i++)
+				if (lockelision_is_adr(&le, bptr->outvars[i]))
+					lockelision_union(&le, bptr->outvars[i], (*succ)->invars[i]);
+		}
+
+		FOR_EACH_INSTRUCTION(bptr, iptr) {
+			if (!lockelision_scan_uses(&le, iptr))
+				return 0;
+
+			lockelision_scan_def(&le, iptr);
+		}
+	}
+
+	/* remove the monitor operations on local objects */
+
+	int32_t elided = 0;
+
+	FOR_EACH_BASICBLOCK(jd, bptr) {
+		if (bptr->state < basicblock::REACHED)
+			continue;
+
+		FOR_EACH_INSTRUCTION(bptr, iptr) {
+			if (!lockelision_is_monitor(iptr))
+				continue;
+
+			s4 v     = iptr->sx.s23.s2.args[0];
+			u1 flags = le.flags[lockelision_find(&le, v)];
+
+			if (!(flags & LOCKELISION_ALLOCATED) || (flags & LOCKELISION_ESCAPES))
+				continue;
+
+			if (flags & LOCKELISION_NULL) {
+				iptr->opc           = ICMD_CHECKNULL;
+				iptr->s1.varindex   = v;
+				iptr->dst.varindex  = v;
+				iptr->flags.bits   |= INS_FLAG_CHECK;
+			}
+			else {
+				iptr->opc = ICMD_NOP;
+			}
+
+			elided++;
+		}
+	}
+
+	STATISTICS(count_monitors_elided += elided);
+
+	if (jd->log != NULL)
+		jd->log->elided += elided;
+
+	return elided;
+}
+
+
+/*
+ * These are local overrides for various environment variables in Emacs.
+ * Please do not remove this and leave it at the end of the file, where
+ * Emacs will automagically detect them.
+ * ---------------------------------------------------------------------
+ * Local variables:
+ * mode: c++
+ * indent-tabs-mode: t
+ * c-basic-offset: 4
+ * tab-width: 4
+ * End:
+ * vim:noexpandtab:sw=4:ts=4:
+ */
@@ -0,0 +1,73 @@
+/* src/vm/jit/optimizing/lockelision.hpp - lock elision
+
+   Copyright (C) 1996-2013
+   CACAOVM - Verein zur Foerderung der freien virtuellen Maschine CACAO
+
+   This file is part of CACAO.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation; either version 2, or (at
+   your option) any later version.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA.
+
+*/
+
+
+#ifndef _LOCKELISION_HPP
+#define _LOCKELISION_HPP
+
+#include "config.h"
+
+#include <stdint.h>
+
+struct jitdata;
+
+
+/* Lock elision ***************************************************************
+
+   Removes MONITORENTER and MONITOREXIT on objects allocated in the
+   compiled method that no other thread can reach, e.g. a StringBuffer
+   built and consumed within the method.  The monitor operations of
+   synchronized callees are covered once the callee has been inlined.
+
+   The analysis is flow-insensitive: variables connected by copies,
+   casts and basic block boundaries form one set, and a set is local
+   if all its values come from NEW (or are null) and none of them is
+   stored into the heap, passed to a call, returned or thrown.  NEW of
+   a class with a finalizer is not local, see escape.cpp.
+
+   Must run after the CFG has been built.  Disabled with
+   -XX:-EliminateLocks.
+
+*******************************************************************************/
+
+/* function prototypes ********************************************************/
+
+int32_t lockelision(jitdata *jd);
+
+#endif /* _LOCKELISION_HPP */
+
+
+/*
+ * These are local overrides for various environment variables in Emacs.
+ * Please do not remove this and leave it at the end of the file, where
+ * Emacs will automagically detect them.
+ * ---------------------------------------------------------------------
+ * Local variables:
+ * mode: c++
+ * indent-tabs-mode: t
+ * c-basic-offset: 4
+ * tab-width: 4
+ * End:
+ * vim:noexpandtab:sw=4:ts=4:
+ */
@@ -26,13 +26,19 @@
 #include "config.h"
 
 #include <assert.h>
+#include <stdint.h>
+
+#include "md.hpp"
 
 #include "threads/condition.hpp"
 #include "threads/mutex.hpp"
 #include "threads/thread.hpp"
 
+#include "mm/memory.hpp"
+
 #include "vm/classcache.hpp"
 #include "vm/exceptions.hpp"
+#include "vm/method.hpp"
 #include "vm/options.hpp"
 
 #include "vm/jit/builtin.hpp"
@@ -48,18 +54,85 @@
 Recompiler::~Recompiler()
 {
 	// Set the running flag to false.
+	_mutex.lock();
 	_run = false;
 
 	// Now signal the worker thread.
 	_cond.signal();
+	_mutex.unlock();
 
 	// TODO We should wait here until the thread exits.
 }
 
 
+/* recompile_record_call *******************************************************
+
+   Records the data segment slot <slot> of the code with the procedure
+   vector <pv>, which jit_asm_compile or jit_compile_handle has just
+   bound to the code of <m>.  Static, private and final methods and constructors are called
+   through such a slot.  Patch addresses outside the data segment of
+   the caller, vftbl and interface table entries, are not recorded.
+
+   If <m> was recompiled since its entrypoint was patched in, the slot
+   is bound to the current code.
+
+*******************************************************************************/
+
+void recompile_record_call(methodinfo *m, void *pv, void *slot)
+{
+	codeinfo        *caller;
+	method_callsite *cs;
+
+	/* asm_vm_call_method has no codeinfo */
+
+	caller = code_get_codeinfo_for_pv(pv);
+
+	if (caller == NULL)
+		return;
+
+	if (((u1 *) slot < caller->mcode) || ((u1 *) slot >= caller->entrypoint))
+		return;
+
+	cs = NEW(method_callsite);
+	cs->slot = (uintptr_t *) slot;
+
+	m->mutex->lock();
+
+	cs->next     = m->callsites;
+	m->callsites = cs;
+
+	if (*cs->slot != (uintptr_t) m->code->entrypoint) {
+		*cs->slot = (uintptr_t) m->code->entrypoint;
+		md_dcacheflush(cs->slot, SIZEOF_VOID_P);
+	}
+
+	m->mutex->unlock();
+}
+
+
+/* recompile_replace_calls *****************************************************
+
+   Binds the recorded statically bound calls of <m> to its current
+   code, see recompile_record_call.  Must be called with the method
+   lock held.
+
+*******************************************************************************/
+
+static void recompile_replace_calls(methodinfo *m)
+{
+	method_callsite *cs;
+
+	for (cs = m->callsites; cs != NULL; cs = cs->next) {
+		*cs->slot = (uintptr_t) m->code->entrypoint;
+		md_dcacheflush(cs->slot, SIZEOF_VOID_P);
+	}
+}
+
+
 /* recompile_replace_vftbl *****************************************************
 
-   XXX
+   Replaces the entrypoint of the previous code of a recompiled method
+   in the vftbls of all loaded classes.
 
 *******************************************************************************/
 
@@ -115,8 +188,10 @@ static void recompile_replace_vftbl(methodinfo *m)
 				for (i = 0; i < vftbl->vftbllength; i++) {
 					if (vftbl->table[i] == pcode->entrypoint) {
 #if !defined(NDEBUG)
-						printf("replacing vftbl in: ");
-						class_println(c);
+						if (compileverbose) {
+							printf("replacing vftbl in: ");
+							class_println(c);
+						}
 #endif
 						vftbl->table[i] = code->entrypoint;
 					}
@@ -139,32 +214,41 @@ void Recompiler::thread()
 		// Enter the recompile mutex, so we can call wait.
 		r._mutex.lock();
 
-		// Wait forever on that condition until we are signaled.
-		r._cond.wait(r._mutex);
+		// Wait until there is some work to do.  Methods queued while
+		// we were recompiling are picked up without waiting.
+		while (r._run == true && r._methods.empty() == true)
+			r._cond.wait(r._mutex);
+
+		if (r._run == false) {
+			r._mutex.unlock();
+			break;
+		}
+
+		// Get the next method from the queue.
+		methodinfo* m = r._methods.front();
+		r._methods.pop();
 
-		// Leave the mutex.
+		// Leave the mutex, so other threads can queue methods.
 		r._mutex.unlock();
 
-		// FIXME Move this into the for loop.
-		if (r._run == false)
-			break;
+		// Recompile this method.  The method lock keeps the JIT from
+		// compiling it concurrently, and from recording new calls
+		// while the recorded ones are rebound.
+		m->mutex->lock();
+		u1* entrypoint = jit_recompile(m);
 
-		// Get the next method form the queue and recompile it.
-		while (r._methods.empty() == false) {
-			methodinfo* m = r._methods.front();
+		if (entrypoint != NULL)
+			recompile_replace_calls(m);
 
-			// Recompile this method.
-			if (jit_recompile(m) != NULL) {
-				// Replace in vftbl's.
-				recompile_replace_vftbl(m);
-			}
-			else {
-				// XXX What is the right-thing(tm) to do here?
-				exceptions_print_current_exception();
-			}
+		m->mutex->unlock();
 
-			// Remove the method from the queue.
-			r._methods.pop();
+		if (entrypoint != NULL) {
+			// Replace in vftbl's.
+			recompile_replace_vftbl(m);
+		}
+		else {
+			// XXX What is the right-thing(tm) to do here?
+			exceptions_print_current_exception();
 		}
 	}
 }
@@ -194,12 +278,13 @@ bool Recompiler::start()
  */
 void Recompiler::queue_method(methodinfo *m)
 {
+	// Enter the recompile mutex, the queue is shared with the
+	// worker thread.
+	_mutex.lock();
+
 	// Add the method to the queue.
 	_methods.push(m);
 
-	// Enter the recompile mutex, so we can call notify.
-	_mutex.lock();
-
 	// Signal the recompiler thread.
 	_cond.signal();
 
@@ -65,6 +65,7 @@ struct list_method_entry {
 /* function prototypes ********************************************************/
 
 void Recompiler_queue_method(methodinfo *m);
+void recompile_record_call(methodinfo *m, void *pv, void *slot);
 
 #endif // _RECOMPILER_HPP
 
@@ -1,4 +1,4 @@
-/* src/vm/reorder.c - basic block reordering
+/* src/vm/jit/optimizing/reorder.cpp - basic block reordering
 
    Copyright (C) 1996-2014
    CACAOVM - Verein zu Foerderung der freien virtuellen Machine CACAO
@@ -20,364 +20,588 @@
    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
    02110-1301, USA.
 
-   Contact: cacao@cacaojvm.org
-
-   Authors: Christian Thalinger
-
-   Changes:
-
 */
 
-#include "vm/jit/optimizing/reorder.hpp"
 
 #include "config.h"
 
-#include <assert.h>
+#include <cassert>
 
 #include "mm/dumpmemory.hpp"
+#include "mm/memory.hpp"
 
+#include "vm/method.hpp"
+#include "vm/statistics.hpp"
 #include "vm/types.hpp"
 
 #include "vm/jit/code.hpp"
+#include "vm/jit/compilelog.hpp"
 #include "vm/jit/jit.hpp"
 
+#include "vm/jit/ir/icmd.hpp"
 #include "vm/jit/ir/instruction.hpp"
 
-/* reorder_place_next_unplaced_block *******************************************
+#include "vm/jit/optimizing/reorder.hpp"
+
+
+STAT_REGISTER_VAR(int,count_cold_blocks_moved,0,"cold blocks moved","basic blocks moved behind the hot code")
+STAT_REGISTER_VAR(int,count_cold_branches_inverted,0,"branches inverted","conditional branches inverted to fall through to hot code")
+
+
+struct reorder_t {
+	jitdata     *jd;
+	s4           count;             // basic blocks including the end marker
+	basicblock **blocks;            // the blocks in the original order
+	u1          *cold;
+	u1          *movable;
+	s4          *predcount;         // predecessors by normal control flow
+	s4          *coldpredcount;     // ... of which are cold
+	u4          *frequency;         // profiled block frequencies, or NULL
+	basicblock **succ;              // successors of the current block
+};
+
+
+/* reorder_fallthrough *********************************************************
+
+   Returns the block control falls through to at the end of the block
+   in the original order, or NULL if the block ends with a jump.
+
+*******************************************************************************/
+
+static basicblock *reorder_fallthrough(reorder_t *ro, basicblock *bptr)
+{
+	if (bptr->icount > 0) {
+		s4 cf = icmd_table[bptr->iinstr[bptr->icount - 1].opc].controlflow;
+
+		if ((cf != CF_NORMAL) && (cf != CF_IF))
+			return NULL;
+	}
+
+	return (bptr->nr + 1 < ro->count) ? ro->blocks[bptr->nr + 1] : NULL;
+}
+
+
+/* reorder_successors **********************************************************
 
-   Find next unplaced basic block in the array and place it.
+   Stores the successors of the block by normal control flow in
+   ro->succ and returns their number.
 
 *******************************************************************************/
 
-static basicblock *reorder_place_next_unplaced_block(jitdata *jd, u1 *blocks,
-													 basicblock *bptr)
+static s4 reorder_successors(reorder_t *ro, basicblock *bptr)
 {
-	basicblock *tbptr;
-	s4          i;
+	basicblock **succ = ro->succ;
+	s4           n    = 0;
 
-	for (i = 0; i < jd->basicblockcount; i++) {
-		if (blocks[i] == false) {
-			tbptr = &jd->basicblocks[i];
+	if (bptr->icount > 0) {
+		instruction *iptr = bptr->iinstr + bptr->icount - 1;
 
-			/* place the block */
+		switch (icmd_table[iptr->opc].controlflow) {
+		case CF_IF:
+		case CF_GOTO:
+			succ[n++] = iptr->dst.block;
+			break;
 
-			blocks[tbptr->nr] = true;
+		case CF_TABLE:
+		{
+			branch_target_t *table = iptr->dst.table;
+			s4 i = iptr->sx.s23.s3.tablehigh - iptr->sx.s23.s2.tablelow + 1;
 
-			/* change the basic block order */
+			succ[n++] = (table++)->block;     // default target
+			while (--i >= 0)
+				succ[n++] = (table++)->block;
+			return n;
+		}
 
-			bptr->next = tbptr;
+		case CF_LOOKUP:
+		{
+			lookup_target_t *lookup = iptr->dst.lookup;
+			s4 i = iptr->sx.s23.s2.lookupcount;
 
-			return tbptr;
+			succ[n++] = iptr->sx.s23.s3.lookupdefault.block;
+			while (--i >= 0)
+				succ[n++] = (lookup++)->target.block;
+			return n;
+		}
 		}
 	}
 
-	return NULL;
+	basicblock *next = reorder_fallthrough(ro, bptr);
+
+	if (next != NULL)
+		succ[n++] = next;
+
+	return n;
 }
 
 
-/* reorder *********************************************************************
+/* reorder_find_cold ***********************************************************
 
-   Reorders basic blocks in respect to their execution frequency.
+   Marks the blocks which are rarely executed: exception handlers,
+   blocks ending with a throw, blocks which never executed according to
+   the profile, the blocks only leading to them and the blocks only
+   reached from them.
 
 *******************************************************************************/
 
-bool reorder(jitdata *jd)
+static void reorder_find_cold(reorder_t *ro)
 {
-	methodinfo  *m;
-	codeinfo    *pcode;
 	basicblock  *bptr;
-	basicblock  *tbptr;                 /* taken basic block pointer          */
-	basicblock  *ntbptr;                /* not-taken basic block pointer      */
-	basicblock  *pbptr;                 /* predecessor basic block pointer    */
-	u4           freq;
-	u4           tfreq;
-	u4           ntfreq;
-	u4           pfreq;
-	instruction *iptr;
-	u1          *blocks;                /* flag array                         */
-	s4           placed;                /* number of placed basic blocks      */
-	s4           i;
+	s4           i, j, n;
+	bool         changed;
 
-	/* get required compiler data */
+	for (i = 0; i < ro->count; i++) {
+		bptr = ro->blocks[i];
 
-	m = jd->m;
+		ro->cold[i] = false;
 
-#if !defined(NDEBUG)
-	method_println(m);
-#endif
+		if (bptr->state < basicblock::REACHED)
+			continue;
 
-	/* get the codeinfo of the previous method */
+		if (bptr->type == basicblock::TYPE_EXH)
+			ro->cold[i] = true;
+		else if ((bptr->icount > 0) && (bptr->iinstr[bptr->icount - 1].opc == ICMD_ATHROW))
+			ro->cold[i] = true;
+		else if ((ro->frequency != NULL) && (ro->frequency[i] == 0))
+			ro->cold[i] = true;
+	}
 
-	pcode = m->code;
+	/* the blocks whose successors are all cold */
 
-	/* XXX debug */
-	if (jd->basicblockcount > 8)
-		return true;
+	do {
+		changed = false;
 
-	/* allocate flag array for blocks which are placed */
+		for (i = 0; i < ro->count; i++) {
+			bptr = ro->blocks[i];
 
-	blocks = DMNEW(u1, jd->basicblockcount);
+			if (ro->cold[i] || (bptr->state < basicblock::REACHED))
+				continue;
 
-	MZERO(blocks, u1, jd->basicblockcount);
+			n = reorder_successors(ro, bptr);
 
-	/* Get the entry block and iterate over all basic blocks until we
-	   have placed all blocks. */
+			if (n == 0)
+				continue;
 
-	bptr   = jd->basicblocks;
-	placed = 0;
+			for (j = 0; j < n; j++)
+				if (!ro->cold[ro->succ[j]->nr])
+					break;
 
-	/* the first block is always placed as the first one */
+			if (j == n) {
+				ro->cold[i] = true;
+				changed = true;
+			}
+		}
+	} while (changed);
 
-	blocks[0] = true;
-	placed++;
+	/* the blocks whose predecessors are all cold */
 
-	while (placed <= jd->basicblockcount + 1) {
-		/* get last instruction of basic block */
+	do {
+		changed = false;
 
-		iptr = bptr->iinstr + bptr->icount - 1;
+		MZERO(ro->predcount, s4, ro->count);
+		MZERO(ro->coldpredcount, s4, ro->count);
 
-		printf("L%03d, ", bptr->nr);
+		for (i = 0; i < ro->count; i++) {
+			bptr = ro->blocks[i];
 
-		switch (bptr->type) {
-		case basicblock::TYPE_STD:
-			printf("STD");
-			break;
-		case basicblock::TYPE_EXH:
-			printf("EXH");
-			break;
-		case basicblock::TYPE_SBR:
-			printf("SBR");
-			break;
+			if (bptr->state < basicblock::REACHED)
+				continue;
+
+			n = reorder_successors(ro, bptr);
+
+			for (j = 0; j < n; j++) {
+				ro->predcount[ro->succ[j]->nr]++;
+				if (ro->cold[i])
+					ro->coldpredcount[ro->succ[j]->nr]++;
+			}
 		}
 
-		printf(", predecessors: %d, successors: %d, frequency: %d -> ",
-			   bptr->predecessorcount, bptr->successorcount,
-			   pcode->bbfrequency[bptr->nr]);
+		/* the first block is entered by the method call */
 
-		switch (iptr->opc) {
-		case ICMD_RETURN:
-		case ICMD_IRETURN:
-		case ICMD_LRETURN:
-		case ICMD_FRETURN:
-		case ICMD_DRETURN:
-		case ICMD_ARETURN:
-		case ICMD_ATHROW:
-			puts("return");
+		for (i = 1; i < ro->count; i++) {
+			if (!ro->cold[i] && (ro->predcount[i] > 0) &&
+				(ro->predcount[i] == ro->coldpredcount[i]))
+			{
+				ro->cold[i] = true;
+				changed = true;
+			}
+		}
+	} while (changed);
+}
 
-			tbptr = reorder_place_next_unplaced_block(jd, blocks, bptr);
 
-			placed++;
+/* reorder_find_movable ********************************************************
 
-			/* all blocks placed? return. */
+   Marks the cold blocks which can be moved behind the hot code.  The
+   code between the start and the end of an inlined method body is
+   attributed to the inlined method, so only blocks outside of inlined
+   bodies are moved.  Returns the number of movable blocks.
 
-			if (tbptr == NULL)
-				continue;
+*******************************************************************************/
 
-			/* set last placed block */
+static s4 reorder_find_movable(reorder_t *ro)
+{
+	basicblock  *bptr;
+	instruction *iptr;
+	s4           depth;
+	s4           moved;
+	s4           i;
 
-			bptr = tbptr;
-			break;
+	depth = 0;
+	moved = 0;
 
-		case ICMD_IFEQ:
-		case ICMD_IFNE:
-		case ICMD_IFLT:
-		case ICMD_IFGE:
-		case ICMD_IFGT:
-		case ICMD_IFLE:
+	for (i = 0; i < ro->count; i++) {
+		bptr = ro->blocks[i];
 
-		case ICMD_IF_ICMPEQ:
-		case ICMD_IF_ICMPNE:
-		case ICMD_IF_ICMPLT:
-		case ICMD_IF_ICMPGE:
-		case ICMD_IF_ICMPGT:
-		case ICMD_IF_ICMPLE:
+		bool inlined = (depth != 0);
 
-		case ICMD_IF_ACMPEQ:
-		case ICMD_IF_ACMPNE:
+		FOR_EACH_INSTRUCTION(bptr, iptr) {
+			if (iptr->opc == ICMD_INLINE_BODY) {
+				depth++;
+				inlined = true;
+			}
+			else if (iptr->opc == ICMD_INLINE_END) {
+				depth--;
+				inlined = true;
+			}
+		}
 
-		case ICMD_IFNULL:
-		case ICMD_IFNONNULL:
+		/* the first block and the end marker stay in place */
 
-		case ICMD_IF_LEQ:
-		case ICMD_IF_LNE:
-		case ICMD_IF_LLT:
-		case ICMD_IF_LGE:
-		case ICMD_IF_LGT:
-		case ICMD_IF_LLE:
+		ro->movable[i] = ro->cold[i] && !inlined && (i > 0) && (i < ro->count - 1) &&
+			(bptr->state >= basicblock::REACHED);
 
-		case ICMD_IF_LCMPEQ:
-		case ICMD_IF_LCMPNE:
-		case ICMD_IF_LCMPLT:
-		case ICMD_IF_LCMPGE:
-		case ICMD_IF_LCMPGT:
-		case ICMD_IF_LCMPLE:
-			tbptr  = iptr->dst.block;
-			ntbptr = bptr->next;
+		if (ro->movable[i])
+			moved++;
+	}
 
-			printf("cond. L%03d\n", tbptr->nr);
+	/* the scopes of inlined bodies must be properly nested */
 
-			tfreq  = pcode->bbfrequency[tbptr->nr];
-			ntfreq = pcode->bbfrequency[ntbptr->nr];
+	return (depth == 0) ? moved : 0;
+}
 
-			/* check which branch is more frequently */
 
-			if ((blocks[tbptr->nr] == false) && (tfreq > ntfreq)) {
-				/* If we place the taken block, we need to change the
-				   conditional instruction (opcode and target). */
+/* reorder_append_goto *********************************************************
 
-				iptr->opc       = jit_complement_condition(iptr->opc);
-				iptr->dst.block = ntbptr;
+   Appends a jump to the target to the block.
 
-				/* change the basic block order */
+*******************************************************************************/
 
-				bptr->next = tbptr;
+static void reorder_append_goto(basicblock *bptr, basicblock *target)
+{
+	instruction *iinstr = DMNEW(instruction, bptr->icount + 1);
 
-				/* place taken block */
+	if (bptr->icount > 0)
+		MCOPY(iinstr, bptr->iinstr, instruction, bptr->icount);
 
-				blocks[tbptr->nr] = true;
-				placed++;
+	instruction *iptr = iinstr + bptr->icount;
 
-				/* set last placed block */
+	MZERO(iptr, instruction, 1);
+	iptr->opc       = ICMD_GOTO;
+	iptr->dst.block = target;
+	iptr->line      = (bptr->icount > 0) ? iptr[-1].line : 0;
 
-				bptr = tbptr;
-			}
-			else if (blocks[ntbptr->nr] == false) {
-				/* place not-taken block */
+	bptr->iinstr = iinstr;
+	bptr->icount++;
+}
 
-				blocks[ntbptr->nr] = true;
-				placed++;
 
-				/* set last placed block */
+/* reorder_can_invert **********************************************************
 
-				bptr = ntbptr;
-			}
-			else {
-				tbptr = reorder_place_next_unplaced_block(jd, blocks, bptr);
+   Returns true for the conditional branches whose condition can be
+   complemented.
 
-				placed++;
+*******************************************************************************/
 
-				/* all blocks placed? return. */
+static bool reorder_can_invert(ICMD opc)
+{
+	switch (opc) {
+	case ICMD_IFEQ:
+	case ICMD_IFNE:
+	case ICMD_IFLT:
+	case ICMD_IFGE:
+	case ICMD_IFGT:
+	case ICMD_IFLE:
+	case ICMD_IF_ICMPEQ:
+	case ICMD_IF_ICMPNE:
+	case ICMD_IF_ICMPLT:
+	case ICMD_IF_ICMPGE:
+	case ICMD_IF_ICMPGT:
+	case ICMD_IF_ICMPLE:
+	case ICMD_IF_ACMPEQ:
+	case ICMD_IF_ACMPNE:
+	case ICMD_IFNULL:
+	case ICMD_IFNONNULL:
+	case ICMD_IF_LEQ:
+	case ICMD_IF_LNE:
+	case ICMD_IF_LLT:
+	case ICMD_IF_LGE:
+	case ICMD_IF_LGT:
+	case ICMD_IF_LLE:
+	case ICMD_IF_LCMPEQ:
+	case ICMD_IF_LCMPNE:
+	case ICMD_IF_LCMPLT:
+	case ICMD_IF_LCMPGE:
+	case ICMD_IF_LCMPGT:
+	case ICMD_IF_LCMPLE:
+		return true;
 
-				if (tbptr == NULL)
-					continue;
+	default:
+		return false;
+	}
+}
 
-				/* set last placed block */
 
-				bptr = tbptr;
-			}
-			break;
+/* reorder_exceptiontable ******************************************************
+
+   Splits the ranges of the exception table, which are given by blocks
+   of the original order, into ranges of the new order.  The entries
+   created for one range keep its priority.
+
+*******************************************************************************/
+
+static void reorder_exceptiontable(reorder_t *ro)
+{
+	jitdata         *jd = ro->jd;
+	exception_entry *ex;
+	exception_entry *entries;
+	exception_entry *last;
+	basicblock      *bptr;
+	s4               length;
+
+	/* count the entries first */
+
+	length = 0;
+
+	for (ex = jd->exceptiontable; ex != NULL; ex = ex->down) {
+		bool covered = false;
 
-		case ICMD_GOTO:
-			tbptr = iptr->dst.block;
+		for (bptr = jd->basicblocks; bptr != NULL; bptr = bptr->next) {
+			bool in = (ex->start->nr <= bptr->nr) && (bptr->nr < ex->end->nr);
 
-			printf("L%03d\n", tbptr->nr);
+			if (in && !covered)
+				length++;
+			covered = in;
+		}
+	}
 
-			/* If next block is already placed, search for another
-			   one. */
+	entries = DMNEW(exception_entry, length + 1);
+	last    = NULL;
+	length  = 0;
 
-			if (blocks[tbptr->nr] == true) {
-				tbptr = reorder_place_next_unplaced_block(jd, blocks, bptr);
+	for (ex = jd->exceptiontable; ex != NULL; ex = ex->down) {
+		exception_entry *run = NULL;
 
-				placed++;
+		for (bptr = jd->basicblocks; bptr != NULL; bptr = bptr->next) {
+			bool in = (ex->start->nr <= bptr->nr) && (bptr->nr < ex->end->nr);
 
-				/* all block placed? return. */
+			if (in && (run == NULL)) {
+				run = &entries[length++];
 
-				if (tbptr == NULL)
-					continue;
+				*run = *ex;
+				run->start = bptr;
+				run->next  = NULL;
+				run->down  = NULL;
+
+				if (last != NULL)
+					last->down = run;
+				last = run;
+			}
+			else if (!in && (run != NULL)) {
+				run->end = bptr;
+				run = NULL;
 			}
-			else if (tbptr->predecessorcount > 1) {
-				/* Check if the target block has other predecessors.
-				   And if the other predecessors have a higher
-				   frequency, don't place it. */
+		}
+
+		/* the end marker is never covered */
+
+		assert(run == NULL);
+	}
+
+	jd->exceptiontable       = (length > 0) ? entries : NULL;
+	jd->exceptiontablelength = length;
+}
+
+
+/* reorder *********************************************************************
+
+   Lays out the hot blocks contiguously and moves the cold blocks
+   behind them, in their original order.  Blocks falling through to a
+   block which is no longer their successor get an explicit jump.  A
+   conditional branch to the hot successor of a block followed by a
+   cold one is inverted, so the hot path falls through.
+
+   Block frequencies are taken from the basic block profile of the
+   previous code of the method, if it has the same blocks, otherwise
+   the cold blocks are estimated statically.
+
+*******************************************************************************/
+
+bool reorder(jitdata *jd)
+{
+	reorder_t    ro;
+	basicblock  *bptr;
+	basicblock  *hot;
+	basicblock  *cold;
+	basicblock  *coldfirst;
+	basicblock  *end;
+	instruction *iptr;
+	s4           i;
 
-				freq = pcode->bbfrequency[bptr->nr];
+#if defined(ENABLE_PROFILING)
+	/* the profile of instrumented code is indexed by the block numbers
+	   before reordering */
 
-				for (i = 0; i < tbptr->predecessorcount; i++) {
-					pbptr = tbptr->predecessors[i];
+	if (JITDATA_HAS_FLAG_INSTRUMENT(jd))
+		return true;
+#endif
 
-					/* skip the current basic block */
+	jit_renumber_basicblocks(jd);
 
-					if (pbptr->nr != bptr->nr) {
-						pfreq = pcode->bbfrequency[pbptr->nr];
+	ro.jd            = jd;
+	ro.count         = jd->basicblockcount + 1;
+	ro.blocks        = DMNEW(basicblock*, ro.count);
+	ro.cold          = DMNEW(u1, ro.count);
+	ro.movable       = DMNEW(u1, ro.count);
+	ro.predcount     = DMNEW(s4, ro.count);
+	ro.coldpredcount = DMNEW(s4, ro.count);
+	ro.frequency     = NULL;
 
-						/* Other predecessor has a higher frequency?
-						   Search for another block to place. */
+	if (ro.count < 3)
+		return true;
 
- 						if (pfreq > freq) {
-							tbptr = reorder_place_next_unplaced_block(jd,
-																	  blocks,
-																	  bptr);
+	/* subroutines return to the block following the JSR */
 
-							placed++;
+	s4 maxsucc = 2;
 
-							/* all block placed? return. */
+	FOR_EACH_BASICBLOCK(jd, bptr) {
+		ro.blocks[bptr->nr] = bptr;
 
-							if (tbptr == NULL)
-								break;
+		FOR_EACH_INSTRUCTION(bptr, iptr) {
+			switch (iptr->opc) {
+			case ICMD_JSR:
+			case ICMD_RET:
+				return true;
 
-							goto goto_continue;
-						}
-					}
-				}
+			case ICMD_TABLESWITCH:
+				i = iptr->sx.s23.s3.tablehigh - iptr->sx.s23.s2.tablelow + 2;
+				maxsucc = MAX(maxsucc, i);
+				break;
 
-			goto_continue:
-				/* place block */
+			case ICMD_LOOKUPSWITCH:
+				i = iptr->sx.s23.s2.lookupcount + 1;
+				maxsucc = MAX(maxsucc, i);
+				break;
 
-				blocks[tbptr->nr] = true;
-				placed++;
+			default:
+				break;
 			}
+		}
+	}
 
-			/* set last placed block */
+	ro.succ = DMNEW(basicblock*, maxsucc);
 
-			bptr = tbptr;
-			break;
+	/* the exception ranges must refer to blocks in the list */
+
+	for (exception_entry *ex = jd->exceptiontable; ex != NULL; ex = ex->down) {
+		if ((ex->start->nr < 0) || (ex->start->nr >= ro.count) || (ro.blocks[ex->start->nr] != ex->start) ||
+			(ex->end->nr < 0) || (ex->end->nr >= ro.count) || (ro.blocks[ex->end->nr] != ex->end))
+			return true;
+	}
+
+#if defined(ENABLE_PROFILING)
+	codeinfo *pcode = jd->m->code;
 
-		default:
-			/* No control flow instruction at the end of the basic
-			   block (fall-through).  Just place the block. */
+	if ((pcode != NULL) && (pcode->bbfrequency != NULL) && (pcode->frequency > 0) &&
+		(pcode->basicblockcount == jd->basicblockcount))
+		ro.frequency = pcode->bbfrequency;
+#endif
+
+	reorder_find_cold(&ro);
 
-			puts("next");
+	s4 moved = reorder_find_movable(&ro);
 
-			tbptr = bptr->next;
+	if (moved == 0)
+		return true;
 
-			/* If next block is already placed, search for another
-			   one. */
+	/* insert the jumps needed in the new order */
 
-			if (blocks[tbptr->nr] == true) {
-				tbptr = reorder_place_next_unplaced_block(jd, blocks, bptr);
+	for (i = 0; i < ro.count - 1; i++) {
+		bptr = ro.blocks[i];
 
-				placed++;
+		if (bptr->state < basicblock::REACHED)
+			continue;
 
-				/* all block placed? return. */
+		basicblock *target = reorder_fallthrough(&ro, bptr);
 
-				if (tbptr == NULL)
-					continue;
-			}
-			else {
-				/* place block */
+		if (target == NULL)
+			continue;
 
-				blocks[tbptr->nr] = true;
-				placed++;
+		/* the block executed next in the new order */
+
+		basicblock *next = NULL;
+
+		for (s4 j = i + 1; j < ro.count; j++) {
+			if ((ro.movable[j] == ro.movable[i]) && (ro.blocks[j]->state >= basicblock::REACHED)) {
+				next = ro.blocks[j];
+				break;
 			}
+		}
 
-			/* set last placed block */
+		if (next == target)
+			continue;
 
-			bptr = tbptr;
-			break;
+		iptr = (bptr->icount > 0) ? bptr->iinstr + bptr->icount - 1 : NULL;
+
+		if ((iptr != NULL) && reorder_can_invert(iptr->opc) && (iptr->dst.block == next) &&
+			(next->type != basicblock::TYPE_EXH) && (target->type != basicblock::TYPE_EXH))
+		{
+			iptr->opc       = jit_complement_condition(iptr->opc);
+			iptr->dst.block = target;
+			STATISTICS(count_cold_branches_inverted++);
+		}
+		else {
+			reorder_append_goto(bptr, target);
 		}
 	}
 
-	/* close the basic block chain with the last dummy basic block */
+	/* build the new order */
 
-	bptr->next = &jd->basicblocks[jd->basicblockcount];
+	end       = ro.blocks[ro.count - 1];
+	hot       = NULL;
+	cold      = NULL;
+	coldfirst = NULL;
 
-	puts("");
+	for (i = 0; i < ro.count - 1; i++) {
+		bptr = ro.blocks[i];
 
-	for (bptr = jd->basicblocks; bptr != NULL; bptr = bptr->next) {
-		printf("L%03d\n", bptr->nr);
+		if (ro.movable[i]) {
+			if (cold == NULL)
+				coldfirst = bptr;
+			else
+				cold->next = bptr;
+			cold = bptr;
+		}
+		else {
+			if (hot != NULL)
+				hot->next = bptr;
+			hot = bptr;
+		}
 	}
 
-	/* everything's ok */
+	hot->next  = coldfirst;
+	cold->next = end;
+	end->next  = NULL;
+
+	/* the exception ranges are given in the original numbering */
+
+	if (jd->exceptiontable != NULL)
+		reorder_exceptiontable(&ro);
+
+	STATISTICS(count_cold_blocks_moved += moved);
+
+	if (jd->log != NULL)
+		jd->log->coldblocks += moved;
 
 	return true;
 }
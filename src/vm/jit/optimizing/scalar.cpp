@@ -0,0 +1,2202 @@
+/* src/vm/jit/optimizing/scalar.cpp - scalar optimizations
+
+   Copyright (C) 1996-2013
+   CACAOVM - Verein zur Foerderung der freien virtuellen Maschine CACAO
+
+   This file is part of CACAO.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation; either version 2, or (at
+   your option) any later version.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA.
+
+*/
+
+
+#include "config.h"
+
+#include <cassert>
+#include <stdint.h>
+
+#include "arch.hpp"
+
+#include "mm/dumpmemory.hpp"
+#include "mm/memory.hpp"
+
+#include "vm/class.hpp"
+#include "vm/field.hpp"
+#include "vm/references.hpp"
+#include "vm/statistics.hpp"
+#include "vm/types.hpp"
+
+#include "vm/jit/builtin.hpp"
+#include "vm/jit/cfg.hpp"
+#include "vm/jit/jit.hpp"
+
+#include "vm/jit/ir/icmd.hpp"
+#include "vm/jit/ir/instruction.hpp"
+
+#include "vm/jit/optimizing/scalar.hpp"
+
+
+STAT_REGISTER_GROUP(scalar_stat,"scalar opt.","scalar optimizations")
+STAT_REGISTER_GROUP_VAR(int,count_scalar_constants,0,"constants","computations replaced by constants",scalar_stat)
+STAT_REGISTER_GROUP_VAR(int,count_scalar_branches,0,"branches","conditional branches and switches folded",scalar_stat)
+STAT_REGISTER_GROUP_VAR(int,count_scalar_reduced,0,"reduced","instructions strength-reduced",scalar_stat)
+STAT_REGISTER_GROUP_VAR(int,count_scalar_redundant,0,"redundant","redundant computations replaced by copies",scalar_stat)
+STAT_REGISTER_GROUP_VAR(int,count_scalar_dead,0,"dead","instructions defining unused temporaries removed",scalar_stat)
+
+
+/* limits *********************************************************************/
+
+#define CONSTPROP_MAX_STATES    (1 << 20)   // basic blocks * local variables
+#define GVN_MAX_FACTS           512
+
+
+/* common data ****************************************************************/
+
+struct scalar_t {
+	jitdata      *jd;
+	s4           *uses;                 // number of reads of each variable
+	s4           *defcount;             // number of definitions
+	instruction **def;                  // the last definition
+};
+
+
+/* scalar_operands *************************************************************
+
+   Returns the number of variables the instruction reads and points
+   <ops> at them.  Calls list the whole stack, and the start of an
+   inlined method the stack of the caller, as these values are kept
+   alive for on-stack replacement.
+
+*******************************************************************************/
+
+static s4 scalar_operands(const instruction *iptr, s4 *buf, const s4 **ops)
+{
+	*ops = buf;
+
+	switch (icmd_table[iptr->opc].dataflow) {
+	case DF_3_TO_0:
+	case DF_3_TO_1:
+		buf[2] = iptr->sx.s23.s3.varindex;
+		buf[1] = iptr->sx.s23.s2.varindex;
+		buf[0] = iptr->s1.varindex;
+		return 3;
+
+	case DF_2_TO_0:
+	case DF_2_TO_1:
+		buf[1] = iptr->sx.s23.s2.varindex;
+		buf[0] = iptr->s1.varindex;
+		return 2;
+
+	case DF_1_TO_0:
+	case DF_1_TO_1:
+	case DF_COPY:
+	case DF_MOVE:
+		buf[0] = iptr->s1.varindex;
+		return 1;
+
+	case DF_INVOKE:
+	case DF_BUILTIN:
+	case DF_N_TO_1:
+		*ops = iptr->sx.s23.s2.args;
+		return iptr->s1.argcount;
+
+	default:
+		if (iptr->opc == ICMD_INLINE_START) {
+			*ops = iptr->sx.s23.s3.inlineinfo->stackvars;
+			return iptr->sx.s23.s3.inlineinfo->stackvarscount;
+		}
+		return 0;
+	}
+}
+
+
+static s4 scalar_dst(const instruction *iptr)
+{
+	return instruction_has_dst(iptr) ? iptr->dst.varindex : (s4) jitdata::UNUSED;
+}
+
+
+static bool scalar_is_temp(scalar_t *sc, s4 v)
+{
+	return (v != jitdata::UNUSED) && var_is_temp(sc->jd, v);
+}
+
+
+/* scalar_check_method *********************************************************
+
+   Returns false for methods whose control flow the CFG does not
+   describe completely: subroutines, and reached blocks without
+   instructions, which fall through without an edge.
+
+*******************************************************************************/
+
+static bool scalar_check_method(jitdata *jd)
+{
+	basicblock  *bptr;
+	instruction *iptr;
+
+	FOR_EACH_BASICBLOCK(jd, bptr) {
+		if (bptr->state < basicblock::REACHED)
+			continue;
+
+		if ((bptr->icount == 0) || (bptr->nr < 0) || (bptr->nr >= jd->basicblockcount))
+			return false;
+
+		FOR_EACH_INSTRUCTION(bptr, iptr) {
+			if ((iptr->opc == ICMD_JSR) || (iptr->opc == ICMD_RET))
+				return false;
+		}
+	}
+
+	return true;
+}
+
+
+/* scalar_count ****************************************************************
+
+   Counts the reads and definitions of all variables.
+
+*******************************************************************************/
+
+static void scalar_count(scalar_t *sc)
+{
+	jitdata     *jd = sc->jd;
+	basicblock  *bptr;
+	instruction *iptr;
+	s4           buf[3];
+	const s4    *ops;
+
+	MZERO(sc->uses, s4, jd->vartop);
+	MZERO(sc->defcount, s4, jd->vartop);
+	MZERO(sc->def, instruction*, jd->vartop);
+
+	FOR_EACH_BASICBLOCK(jd, bptr) {
+		if (bptr->state < basicblock::REACHED)
+			continue;
+
+		FOR_EACH_INSTRUCTION(bptr, iptr) {
+			s4 n = scalar_operands(iptr, buf, &ops);
+
+			for (s4 i = 0; i < n; i++)
+				sc->uses[ops[i]]++;
+
+			s4 dst = scalar_dst(iptr);
+
+			if (dst != jitdata::UNUSED) {
+				sc->defcount[dst]++;
+				sc->def[dst] = iptr;
+			}
+		}
+	}
+}
+
+
+/* scalar_is_pure **************************************************************
+
+   Returns true if the instruction has no effect besides defining its
+   destination, so it may be removed if that is unused.
+
+*******************************************************************************/
+
+static bool scalar_is_pure(const instruction *iptr)
+{
+	switch (iptr->opc) {
+	case ICMD_ACONST:
+		return INSTRUCTION_IS_RESOLVED(iptr);
+
+	case ICMD_ICONST:
+	case ICMD_LCONST:
+	case ICMD_FCONST:
+	case ICMD_DCONST:
+	case ICMD_COPY:
+	case ICMD_MOVE:
+	case ICMD_ILOAD:
+	case ICMD_LLOAD:
+	case ICMD_FLOAD:
+	case ICMD_DLOAD:
+	case ICMD_ALOAD:
+
+	case ICMD_IADD:
+	case ICMD_ISUB:
+	case ICMD_IMUL:
+	case ICMD_INEG:
+	case ICMD_ISHL:
+	case ICMD_ISHR:
+	case ICMD_IUSHR:
+	case ICMD_IAND:
+	case ICMD_IOR:
+	case ICMD_IXOR:
+	case ICMD_IADDCONST:
+	case ICMD_ISUBCONST:
+	case ICMD_IMULCONST:
+	case ICMD_IMULPOW2:
+	case ICMD_IDIVPOW2:
+	case ICMD_IREMPOW2:
+	case ICMD_IANDCONST:
+	case ICMD_IORCONST:
+	case ICMD_IXORCONST:
+	case ICMD_ISHLCONST:
+	case ICMD_ISHRCONST:
+	case ICMD_IUSHRCONST:
+
+	case ICMD_LADD:
+	case ICMD_LSUB:
+	case ICMD_LMUL:
+	case ICMD_LNEG:
+	case ICMD_LSHL:
+	case ICMD_LSHR:
+	case ICMD_LUSHR:
+	case ICMD_LAND:
+	case ICMD_LOR:
+	case ICMD_LXOR:
+	case ICMD_LADDCONST:
+	case ICMD_LSUBCONST:
+	case ICMD_LMULCONST:
+	case ICMD_LMULPOW2:
+	case ICMD_LDIVPOW2:
+	case ICMD_LREMPOW2:
+	case ICMD_LANDCONST:
+	case ICMD_LORCONST:
+	case ICMD_LXORCONST:
+	case ICMD_LSHLCONST:
+	case ICMD_LSHRCONST:
+	case ICMD_LUSHRCONST:
+	case ICMD_LCMP:
+
+	case ICMD_I2L:
+	case ICMD_L2I:
+	case ICMD_INT2BYTE:
+	case ICMD_INT2CHAR:
+	case ICMD_INT2SHORT:
+		return true;
+
+	default:
+		return false;
+	}
+}
+
+
+/* scalar_is_removable *********************************************************
+
+   Returns true if the temporary is defined by a pure instruction that
+   can be removed together with the temporaries only it reads.
+
+*******************************************************************************/
+
+static bool scalar_is_removable(scalar_t *sc, s4 v)
+{
+	s4        buf[3];
+	const s4 *ops;
+
+	if (!scalar_is_temp(sc, v) || (sc->defcount[v] != 1))
+		return false;
+
+	instruction *iptr = sc->def[v];
+
+	if (!scalar_is_pure(iptr))
+		return false;
+
+	s4 n = scalar_operands(iptr, buf, &ops);
+
+	for (s4 i = 0; i < n; i++) {
+		if (scalar_is_temp(sc, ops[i]) && (sc->uses[ops[i]] == 1) &&
+			!scalar_is_removable(sc, ops[i]))
+			return false;
+	}
+
+	return true;
+}
+
+
+/* scalar_can_drop *************************************************************
+
+   Returns true if a read of the variable may be removed.  A temporary
+   left without reads must be removable, as the register allocator
+   would never free it.
+
+*******************************************************************************/
+
+static bool scalar_can_drop(scalar_t *sc, s4 v)
+{
+	if (!scalar_is_temp(sc, v))
+		return true;
+
+	return (sc->uses[v] > 1) || scalar_is_removable(sc, v);
+}
+
+
+static bool scalar_can_drop_operands(scalar_t *sc, const instruction *iptr)
+{
+	s4        buf[3];
+	const s4 *ops;
+	s4        n = scalar_operands(iptr, buf, &ops);
+
+	for (s4 i = 0; i < n; i++) {
+		if (!scalar_can_drop(sc, ops[i]))
+			return false;
+	}
+
+	return true;
+}
+
+
+static void scalar_drop_operands(scalar_t *sc, const instruction *iptr)
+{
+	s4        buf[3];
+	const s4 *ops;
+	s4        n = scalar_operands(iptr, buf, &ops);
+
+	for (s4 i = 0; i < n; i++)
+		sc->uses[ops[i]]--;
+}
+
+
+/* scalar_rewrite **************************************************************
+
+   Changes the opcode of an instruction, keeping the basic block start
+   and the instruction id.
+
+*******************************************************************************/
+
+static void scalar_rewrite(instruction *iptr, ICMD opc)
+{
+	iptr->opc         = opc;
+	iptr->flags.bits &= (INS_FLAG_BASICBLOCK | INS_FLAG_ID_MASK);
+}
+
+
+/* scalar_remove_dead **********************************************************
+
+   Removes the pure instructions defining temporaries without reads.
+
+*******************************************************************************/
+
+static void scalar_remove_dead(scalar_t *sc)
+{
+	jitdata     *jd = sc->jd;
+	basicblock  *bptr;
+	instruction *iptr;
+	s4           removed = 0;
+	bool         changed;
+
+	do {
+		changed = false;
+
+		FOR_EACH_BASICBLOCK(jd, bptr) {
+			if (bptr->state < basicblock::REACHED)
+				continue;
+
+			FOR_EACH_INSTRUCTION_REV(bptr, iptr) {
+				s4 dst = scalar_dst(iptr);
+
+				if (!scalar_is_temp(sc, dst) || (sc->uses[dst] != 0) ||
+					(sc->defcount[dst] != 1) || !scalar_is_pure(iptr) ||
+					!scalar_can_drop_operands(sc, iptr))
+					continue;
+
+				scalar_drop_operands(sc, iptr);
+				scalar_rewrite(iptr, ICMD_NOP);
+
+				sc->defcount[dst] = 0;
+				sc->def[dst]      = NULL;
+
+				removed++;
+				changed = true;
+			}
+		}
+	} while (changed);
+
+	STATISTICS(count_scalar_dead += removed);
+}
+
+
+/* scalar_find_branch **********************************************************
+
+   Finds the instruction deciding between the successors of a block,
+   and the goto following it, the same way as cfg_build.
+
+*******************************************************************************/
+
+static void scalar_find_branch(basicblock *bptr, instruction **cond, instruction **jump)
+{
+	instruction *iptr = bptr->iinstr + bptr->icount - 1;
+
+	*cond = NULL;
+	*jump = NULL;
+
+	while ((iptr->opc == ICMD_NOP) && (iptr != bptr->iinstr))
+		iptr--;
+
+	if (iptr->opc == ICMD_GOTO) {
+		*jump = iptr;
+
+		if (iptr == bptr->iinstr)
+			return;
+
+		iptr--;
+
+		while ((iptr->opc == ICMD_NOP) && (iptr != bptr->iinstr))
+			iptr--;
+
+		if (icmd_table[iptr->opc].controlflow == CF_IF)
+			*cond = iptr;
+		return;
+	}
+
+	switch (icmd_table[iptr->opc].controlflow) {
+	case CF_IF:
+	case CF_TABLE:
+	case CF_LOOKUP:
+		*cond = iptr;
+		break;
+	default:
+		break;
+	}
+}
+
+
+/* constant propagation *******************************************************/
+
+#define CONSTPROP_TOP         0     // no value seen yet
+#define CONSTPROP_CONSTANT    1
+#define CONSTPROP_BOTTOM      2     // not a constant
+
+struct constprop_value_t {
+	s4 state;
+	s8 value;                       // ints are sign-extended
+};
+
+struct constprop_t {
+	scalar_t           *sc;
+	constprop_value_t  *values;     // of the variables besides the locals
+	constprop_value_t  *entry;      // locals at the start of each block
+	u1                 *executable; // per block
+	constprop_value_t  *cur;        // locals in the block being evaluated
+	bool                changed;
+};
+
+
+static bool constprop_is_scalar(jitdata *jd, s4 v)
+{
+	return (jd->var[v].type == TYPE_INT) || (jd->var[v].type == TYPE_LNG);
+}
+
+
+static constprop_value_t *constprop_entry(constprop_t *cp, basicblock *bptr)
+{
+	return cp->entry + bptr->nr * cp->sc->jd->localcount;
+}
+
+
+static constprop_value_t constprop_get(constprop_t *cp, s4 v)
+{
+	if (var_is_local(cp->sc->jd, v))
+		return cp->cur[v];
+
+	return cp->values[v];
+}
+
+
+static bool constprop_meet(constprop_value_t *dst, constprop_value_t src)
+{
+	if ((src.state == CONSTPROP_TOP) || (dst->state == CONSTPROP_BOTTOM))
+		return false;
+
+	if (dst->state == CONSTPROP_TOP) {
+		*dst = src;
+		return true;
+	}
+
+	if ((src.state == CONSTPROP_CONSTANT) && (src.value == dst->value))
+		return false;
+
+	dst->state = CONSTPROP_BOTTOM;
+	return true;
+}
+
+
+static bool constprop_is_power_of_two(s8 c, s4 maxshift, s4 *shift)
+{
+	for (s4 i = 1; i <= maxshift; i++) {
+		if (c == ((s8) 1 << i)) {
+			*shift = i;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+
+/* constprop_fold_int **********************************************************
+
+   Computes a binary int operation with Java semantics.  Returns false
+   for a division by zero.
+
+*******************************************************************************/
+
+static bool constprop_fold_int(s4 opc, s4 a, s4 b, s4 *result)
+{
+	switch (opc) {
+	case ICMD_IADD:  *result = (s4) ((u4) a + (u4) b);          break;
+	case ICMD_ISUB:  *result = (s4) ((u4) a - (u4) b);          break;
+	case ICMD_IMUL:  *result = (s4) ((u4) a * (u4) b);          break;
+	case ICMD_IAND:  *result = a & b;                           break;
+	case ICMD_IOR:   *result = a | b;                           break;
+	case ICMD_IXOR:  *result = a ^ b;                           break;
+	case ICMD_ISHL:  *result = (s4) ((u4) a << (b & 0x1f));     break;
+	case ICMD_ISHR:  *result = a >> (b & 0x1f);                 break;
+	case ICMD_IUSHR: *result = (s4) ((u4) a >> (b & 0x1f));     break;
+
+	case ICMD_IDIV:
+		if (b == 0)
+			return false;
+		*result = (b == -1) ? (s4) (0 - (u4) a) : a / b;
+		break;
+
+	case ICMD_IREM:
+		if (b == 0)
+			return false;
+		*result = (b == -1) ? 0 : a % b;
+		break;
+
+	default:
+		return false;
+	}
+
+	return true;
+}
+
+
+static bool constprop_fold_long(s4 opc, s8 a, s8 b, s8 *result)
+{
+	switch (opc) {
+	case ICMD_LADD:  *result = (s8) ((u8) a + (u8) b);          break;
+	case ICMD_LSUB:  *result = (s8) ((u8) a - (u8) b);          break;
+	case ICMD_LMUL:  *result = (s8) ((u8) a * (u8) b);          break;
+	case ICMD_LAND:  *result = a & b;                           break;
+	case ICMD_LOR:   *result = a | b;                           break;
+	case ICMD_LXOR:  *result = a ^ b;                           break;
+	case ICMD_LSHL:  *result = (s8) ((u8) a << (b & 0x3f));     break;
+	case ICMD_LSHR:  *result = a >> (b & 0x3f);                 break;
+	case ICMD_LUSHR: *result = (s8) ((u8) a >> (b & 0x3f));     break;
+
+	case ICMD_LDIV:
+		if (b == 0)
+			return false;
+		*result = (b == -1) ? (s8) (0 - (u8) a) : a / b;
+		break;
+
+	case ICMD_LREM:
+		if (b == 0)
+			return false;
+		*result = (b == -1) ? 0 : a % b;
+		break;
+
+	case ICMD_LCMP:
+		*result = (a < b) ? -1 : ((a > b) ? 1 : 0);
+		break;
+
+	default:
+		return false;
+	}
+
+	return true;
+}
+
+
+/* constprop_binary ************************************************************
+
+   Returns the base operation of a binary int or long instruction, or
+   of its immediate form together with the immediate, or -1 for other
+   instructions.  The operation of LCMP yields an int.
+
+*******************************************************************************/
+
+static s4 constprop_binary(const instruction *iptr, bool *immediate, s8 *imm)
+{
+	*immediate = true;
+
+	switch (iptr->opc) {
+	case ICMD_IADDCONST:  *imm = iptr->sx.val.i;                      return ICMD_IADD;
+	case ICMD_ISUBCONST:  *imm = iptr->sx.val.i;                      return ICMD_ISUB;
+	case ICMD_IMULCONST:  *imm = iptr->sx.val.i;                      return ICMD_IMUL;
+	case ICMD_IANDCONST:  *imm = iptr->sx.val.i;                      return ICMD_IAND;
+	case ICMD_IORCONST:   *imm = iptr->sx.val.i;                      return ICMD_IOR;
+	case ICMD_IXORCONST:  *imm = iptr->sx.val.i;                      return ICMD_IXOR;
+	case ICMD_ISHLCONST:  *imm = iptr->sx.val.i;                      return ICMD_ISHL;
+	case ICMD_ISHRCONST:  *imm = iptr->sx.val.i;                      return ICMD_ISHR;
+	case ICMD_IUSHRCONST: *imm = iptr->sx.val.i;                      return ICMD_IUSHR;
+	case ICMD_IMULPOW2:   *imm = iptr->sx.val.i;                      return ICMD_ISHL;
+	case ICMD_IDIVPOW2:   *imm = (s4) ((u4) 1 << iptr->sx.val.i);     return ICMD_IDIV;
+	case ICMD_IREMPOW2:   *imm = (s4) ((u4) iptr->sx.val.i + 1);      return ICMD_IREM;
+	case ICMD_IINC:       *imm = iptr->sx.val.i;                      return ICMD_IADD;
+
+	case ICMD_LADDCONST:  *imm = iptr->sx.val.l;                      return ICMD_LADD;
+	case ICMD_LSUBCONST:  *imm = iptr->sx.val.l;                      return ICMD_LSUB;
+	case ICMD_LMULCONST:  *imm = iptr->sx.val.l;                      return ICMD_LMUL;
+	case ICMD_LANDCONST:  *imm = iptr->sx.val.l;                      return ICMD_LAND;
+	case ICMD_LORCONST:   *imm = iptr->sx.val.l;                      return ICMD_LOR;
+	case ICMD_LXORCONST:  *imm = iptr->sx.val.l;                      return ICMD_LXOR;
+	case ICMD_LSHLCONST:  *imm = iptr->sx.val.i;                      return ICMD_LSHL;
+	case ICMD_LSHRCONST:  *imm = iptr->sx.val.i;                      return ICMD_LSHR;
+	case ICMD_LUSHRCONST: *imm = iptr->sx.val.i;                      return ICMD_LUSHR;
+	case ICMD_LMULPOW2:   *imm = iptr->sx.val.i;                      return ICMD_LSHL;
+	case ICMD_LDIVPOW2:   *imm = (s8) ((u8) 1 << iptr->sx.val.i);     return ICMD_LDIV;
+	case ICMD_LREMPOW2:   *imm = (s8) ((u8) iptr->sx.val.l + 1);      return ICMD_LREM;
+
+	default:
+		break;
+	}
+
+	*immediate = false;
+
+	switch (iptr->opc) {
+	case ICMD_IADD:
+	case ICMD_ISUB:
+	case ICMD_IMUL:
+	case ICMD_IDIV:
+	case ICMD_IREM:
+	case ICMD_IAND:
+	case ICMD_IOR:
+	case ICMD_IXOR:
+	case ICMD_ISHL:
+	case ICMD_ISHR:
+	case ICMD_IUSHR:
+	case ICMD_LADD:
+	case ICMD_LSUB:
+	case ICMD_LMUL:
+	case ICMD_LDIV:
+	case ICMD_LREM:
+	case ICMD_LAND:
+	case ICMD_LOR:
+	case ICMD_LXOR:
+	case ICMD_LSHL:
+	case ICMD_LSHR:
+	case ICMD_LUSHR:
+	case ICMD_LCMP:
+		return iptr->opc;
+
+	default:
+		return -1;
+	}
+}
+
+
+static bool constprop_is_long_operation(s4 opc)
+{
+	switch (opc) {
+	case ICMD_LADD:
+	case ICMD_LSUB:
+	case ICMD_LMUL:
+	case ICMD_LDIV:
+	case ICMD_LREM:
+	case ICMD_LAND:
+	case ICMD_LOR:
+	case ICMD_LXOR:
+	case ICMD_LSHL:
+	case ICMD_LSHR:
+	case ICMD_LUSHR:
+	case ICMD_LCMP:
+		return true;
+	default:
+		return false;
+	}
+}
+
+
+/* constprop_eval **************************************************************
+
+   Returns the value the instruction assigns to its destination.
+
+*******************************************************************************/
+
+static constprop_value_t constprop_eval(constprop_t *cp, const instruction *iptr)
+{
+	jitdata           *jd = cp->sc->jd;
+	constprop_value_t  r;
+	constprop_value_t  a;
+	constprop_value_t  b;
+	bool               immediate;
+	s8                 imm;
+
+	r.state = CONSTPROP_BOTTOM;
+	r.value = 0;
+
+	if (!constprop_is_scalar(jd, iptr->dst.varindex))
+		return r;
+
+	switch (iptr->opc) {
+	case ICMD_ICONST:
+		r.state = CONSTPROP_CONSTANT;
+		r.value = iptr->sx.val.i;
+		return r;
+
+	case ICMD_LCONST:
+		r.state = CONSTPROP_CONSTANT;
+		r.value = iptr->sx.val.l;
+		return r;
+
+	case ICMD_ILOAD:
+	case ICMD_LLOAD:
+	case ICMD_ISTORE:
+	case ICMD_LSTORE:
+	case ICMD_COPY:
+	case ICMD_MOVE:
+		return constprop_get(cp, iptr->s1.varindex);
+
+	case ICMD_INEG:
+	case ICMD_LNEG:
+	case ICMD_I2L:
+	case ICMD_L2I:
+	case ICMD_INT2BYTE:
+	case ICMD_INT2CHAR:
+	case ICMD_INT2SHORT:
+		a = constprop_get(cp, iptr->s1.varindex);
+
+		if (a.state != CONSTPROP_CONSTANT)
+			return a;
+
+		switch (iptr->opc) {
+		case ICMD_INEG:      r.value = (s4) (0 - (u4) a.value);  break;
+		case ICMD_LNEG:      r.value = (s8) (0 - (u8) a.value);  break;
+		case ICMD_I2L:       r.value = a.value;                  break;
+		case ICMD_L2I:       r.value = (s4) a.value;             break;
+		case ICMD_INT2BYTE:  r.value = (s1) a.value;             break;
+		case ICMD_INT2CHAR:  r.value = (u2) a.value;             break;
+		case ICMD_INT2SHORT: r.value = (s2) a.value;             break;
+		default:                                                 break;
+		}
+
+		r.state = CONSTPROP_CONSTANT;
+		return r;
+
+	default:
+		break;
+	}
+
+	s4 opc = constprop_binary(iptr, &immediate, &imm);
+
+	if (opc == -1)
+		return r;
+
+	a = constprop_get(cp, iptr->s1.varindex);
+
+	if (immediate) {
+		b.state = CONSTPROP_CONSTANT;
+		b.value = imm;
+	}
+	else {
+		b = constprop_get(cp, iptr->sx.s23.s2.varindex);
+	}
+
+	if ((a.state == CONSTPROP_BOTTOM) || (b.state == CONSTPROP_BOTTOM))
+		return r;
+
+	if ((a.state == CONSTPROP_TOP) || (b.state == CONSTPROP_TOP)) {
+		r.state = CONSTPROP_TOP;
+		return r;
+	}
+
+	if (constprop_is_long_operation(opc)) {
+		if (!constprop_fold_long(opc, a.value, b.value, &r.value))
+			return r;
+	}
+	else {
+		s4 i;
+
+		if (!constprop_fold_int(opc, (s4) a.value, (s4) b.value, &i))
+			return r;
+
+		r.value = i;
+	}
+
+	r.state = CONSTPROP_CONSTANT;
+	return r;
+}
+
+
+/* constprop_transfer **********************************************************
+
+   Evaluates an instruction and records the value of its destination.
+
+*******************************************************************************/
+
+static void constprop_transfer(constprop_t *cp, const instruction *iptr, constprop_value_t value)
+{
+	s4 dst = scalar_dst(iptr);
+
+	if (dst == jitdata::UNUSED)
+		return;
+
+	if (var_is_local(cp->sc->jd, dst))
+		cp->cur[dst] = value;
+	else if (constprop_meet(cp->values + dst, value))
+		cp->changed = true;
+}
+
+
+static bool constprop_compare(s4 condition, s8 a, s8 b)
+{
+	switch (condition) {
+	case 0:  return a == b;
+	case 1:  return a != b;
+	case 2:  return a <  b;
+	case 3:  return a >= b;
+	case 4:  return a >  b;
+	default: return a <= b;
+	}
+}
+
+
+/* constprop_decide ************************************************************
+
+   Returns the only successor a branch can take with the current
+   values, or NULL if it cannot be decided.
+
+*******************************************************************************/
+
+static basicblock *constprop_decide(constprop_t *cp, basicblock *bptr, instruction *cond, instruction *jump)
+{
+	constprop_value_t  a;
+	constprop_value_t  b;
+	s4                 condition;
+
+	if (cond == NULL)
+		return NULL;
+
+	a = constprop_get(cp, cond->s1.varindex);
+	b.state = CONSTPROP_CONSTANT;
+
+	switch (cond->opc) {
+	case ICMD_IFEQ:
+	case ICMD_IFNE:
+	case ICMD_IFLT:
+	case ICMD_IFGE:
+	case ICMD_IFGT:
+	case ICMD_IFLE:
+		condition = cond->opc - ICMD_IFEQ;
+		b.value   = cond->sx.val.i;
+		break;
+
+	case ICMD_IF_LEQ:
+	case ICMD_IF_LNE:
+	case ICMD_IF_LLT:
+	case ICMD_IF_LGE:
+	case ICMD_IF_LGT:
+	case ICMD_IF_LLE:
+		condition = cond->opc - ICMD_IF_LEQ;
+		b.value   = cond->sx.val.l;
+		break;
+
+	case ICMD_IF_ICMPEQ:
+	case ICMD_IF_ICMPNE:
+	case ICMD_IF_ICMPLT:
+	case ICMD_IF_ICMPGE:
+	case ICMD_IF_ICMPGT:
+	case ICMD_IF_ICMPLE:
+		condition = cond->opc - ICMD_IF_ICMPEQ;
+		b = constprop_get(cp, cond->sx.s23.s2.varindex);
+		break;
+
+	case ICMD_IF_LCMPEQ:
+	case ICMD_IF_LCMPNE:
+	case ICMD_IF_LCMPLT:
+	case ICMD_IF_LCMPGE:
+	case ICMD_IF_LCMPGT:
+	case ICMD_IF_LCMPLE:
+		condition = cond->opc - ICMD_IF_LCMPEQ;
+		b = constprop_get(cp, cond->sx.s23.s2.varindex);
+		break;
+
+	case ICMD_TABLESWITCH:
+		if (a.state != CONSTPROP_CONSTANT)
+			return NULL;
+
+		if ((a.value < cond->sx.s23.s2.tablelow) || (a.value > cond->sx.s23.s3.tablehigh))
+			return cond->dst.table[0].block;
+
+		return cond->dst.table[1 + a.value - cond->sx.s23.s2.tablelow].block;
+
+	case ICMD_LOOKUPSWITCH:
+		if (a.state != CONSTPROP_CONSTANT)
+			return NULL;
+
+		for (u4 i = 0; i < cond->sx.s23.s2.lookupcount; i++) {
+			if (cond->dst.lookup[i].value == a.value)
+				return cond->dst.lookup[i].target.block;
+		}
+
+		return cond->sx.s23.s3.lookupdefault.block;
+
+	default:
+		return NULL;
+	}
+
+	/* an undecided branch is taken both ways, as a value still unknown
+	   at the fixpoint must not hide a successor */
+
+	if ((a.state != CONSTPROP_CONSTANT) || (b.state != CONSTPROP_CONSTANT))
+		return NULL;
+
+	if (constprop_compare(condition, a.value, b.value))
+		return cond->dst.block;
+
+	return (jump != NULL) ? jump->dst.block : bptr->next;
+}
+
+
+/* constprop_propagate *********************************************************
+
+   Merges the values at the end of a block into the start of a
+   successor and marks it executable.
+
+*******************************************************************************/
+
+static void constprop_propagate(constprop_t *cp, basicblock *bptr, basicblock *succ)
+{
+	jitdata           *jd    = cp->sc->jd;
+	constprop_value_t *entry = constprop_entry(cp, succ);
+
+	if (!cp->executable[succ->nr]) {
+		cp->executable[succ->nr] = 1;
+		cp->changed = true;
+	}
+
+	for (s4 i = 0; i < jd->localcount; i++) {
+		if (constprop_meet(entry + i, cp->cur[i]))
+			cp->changed = true;
+	}
+
+	for (s4 i = 0; i < succ->indepth; i++) {
+		s4 v = succ->invars[i];
+
+		if (var_is_local(jd, v))
+			continue;
+
+		constprop_value_t value;
+
+		if (i < bptr->outdepth) {
+			value = constprop_get(cp, bptr->outvars[i]);
+		}
+		else {
+			value.state = CONSTPROP_BOTTOM;
+			value.value = 0;
+		}
+
+		if (constprop_meet(cp->values + v, value))
+			cp->changed = true;
+	}
+}
+
+
+static void constprop_evaluate_block(constprop_t *cp, basicblock *bptr)
+{
+	basicblock  **succ;
+	instruction  *iptr;
+	instruction  *cond;
+	instruction  *jump;
+
+	MCOPY(cp->cur, constprop_entry(cp, bptr), constprop_value_t, cp->sc->jd->localcount);
+
+	FOR_EACH_INSTRUCTION(bptr, iptr) {
+		if (instruction_has_dst(iptr))
+			constprop_transfer(cp, iptr, constprop_eval(cp, iptr));
+	}
+
+	scalar_find_branch(bptr, &cond, &jump);
+
+	basicblock *target = constprop_decide(cp, bptr, cond, jump);
+
+	if (target != NULL) {
+		constprop_propagate(cp, bptr, target);
+	}
+	else {
+		FOR_EACH_SUCCESSOR(bptr, succ)
+			constprop_propagate(cp, bptr, *succ);
+	}
+}
+
+
+/* constprop_is_foldable *******************************************************
+
+   Returns true if the instruction may be replaced by the constant it
+   computes.  Divisions fold only when the divisor is not zero.
+
+*******************************************************************************/
+
+static bool constprop_is_foldable(const instruction *iptr)
+{
+	switch (iptr->opc) {
+	case ICMD_ICONST:
+	case ICMD_LCONST:
+		return false;
+
+	case ICMD_ISTORE:
+	case ICMD_LSTORE:
+	case ICMD_IDIV:
+	case ICMD_IREM:
+	case ICMD_LDIV:
+	case ICMD_LREM:
+		return true;
+
+	default:
+		return scalar_is_pure(iptr);
+	}
+}
+
+
+/* constprop_reduce ************************************************************
+
+   Folds constant operands into the immediate forms and reduces
+   multiplications, divisions and remainders by powers of two, the
+   same way stack analysis does for constants pushed right before the
+   operation.  Returns true if the instruction was changed.
+
+*******************************************************************************/
+
+static bool constprop_reduce(constprop_t *cp, instruction *iptr)
+{
+	scalar_t          *sc = cp->sc;
+	constprop_value_t  a;
+	constprop_value_t  b;
+	s4                 shift;
+
+	switch (iptr->opc) {
+	case ICMD_IMULCONST:
+		if (!constprop_is_power_of_two(iptr->sx.val.i, 30, &shift))
+			return false;
+		scalar_rewrite(iptr, ICMD_ISHLCONST);
+		iptr->sx.val.i = shift;
+		return true;
+
+#if SUPPORT_LONG_SHIFT
+	case ICMD_LMULCONST:
+		if (!constprop_is_power_of_two(iptr->sx.val.l, 62, &shift))
+			return false;
+		scalar_rewrite(iptr, ICMD_LSHLCONST);
+		iptr->sx.val.i = shift;
+		return true;
+#endif
+
+	case ICMD_IF_ICMPEQ:
+	case ICMD_IF_ICMPNE:
+	case ICMD_IF_ICMPLT:
+	case ICMD_IF_ICMPGE:
+	case ICMD_IF_ICMPGT:
+	case ICMD_IF_ICMPLE:
+	case ICMD_IF_LCMPEQ:
+	case ICMD_IF_LCMPNE:
+	case ICMD_IF_LCMPLT:
+	case ICMD_IF_LCMPGE:
+	case ICMD_IF_LCMPGT:
+	case ICMD_IF_LCMPLE:
+	case ICMD_IADD:
+	case ICMD_ISUB:
+	case ICMD_IMUL:
+	case ICMD_IDIV:
+	case ICMD_IREM:
+	case ICMD_IAND:
+	case ICMD_IOR:
+	case ICMD_IXOR:
+	case ICMD_ISHL:
+	case ICMD_ISHR:
+	case ICMD_IUSHR:
+	case ICMD_LADD:
+	case ICMD_LSUB:
+	case ICMD_LMUL:
+	case ICMD_LDIV:
+	case ICMD_LREM:
+	case ICMD_LAND:
+	case ICMD_LOR:
+	case ICMD_LXOR:
+	case ICMD_LSHL:
+	case ICMD_LSHR:
+	case ICMD_LUSHR:
+		break;
+
+	default:
+		return false;
+	}
+
+	a = constprop_get(cp, iptr->s1.varindex);
+	b = constprop_get(cp, iptr->sx.s23.s2.varindex);
+
+	/* bring the constant into s2, mirroring comparisons */
+
+	if ((b.state != CONSTPROP_CONSTANT) && (a.state == CONSTPROP_CONSTANT)) {
+		ICMD mirrored;
+
+		switch (iptr->opc) {
+		case ICMD_IF_ICMPLT: mirrored = ICMD_IF_ICMPGT; break;
+		case ICMD_IF_ICMPGE: mirrored = ICMD_IF_ICMPLE; break;
+		case ICMD_IF_ICMPGT: mirrored = ICMD_IF_ICMPLT; break;
+		case ICMD_IF_ICMPLE: mirrored = ICMD_IF_ICMPGE; break;
+		case ICMD_IF_LCMPLT: mirrored = ICMD_IF_LCMPGT; break;
+		case ICMD_IF_LCMPGE: mirrored = ICMD_IF_LCMPLE; break;
+		case ICMD_IF_LCMPGT: mirrored = ICMD_IF_LCMPLT; break;
+		case ICMD_IF_LCMPLE: mirrored = ICMD_IF_LCMPGE; break;
+
+		case ICMD_IF_ICMPEQ:
+		case ICMD_IF_ICMPNE:
+		case ICMD_IF_LCMPEQ:
+		case ICMD_IF_LCMPNE:
+		case ICMD_IADD:
+		case ICMD_IMUL:
+		case ICMD_IAND:
+		case ICMD_IOR:
+		case ICMD_IXOR:
+		case ICMD_LADD:
+		case ICMD_LMUL:
+		case ICMD_LAND:
+		case ICMD_LOR:
+		case ICMD_LXOR:
+			mirrored = iptr->opc;
+			break;
+
+		default:
+			return false;
+		}
+
+		s4 v = iptr->s1.varindex;
+
+		iptr->s1.varindex        = iptr->sx.s23.s2.varindex;
+		iptr->sx.s23.s2.varindex = v;
+		iptr->opc                = mirrored;
+
+		constprop_value_t t = a;
+		a = b;
+		b = t;
+	}
+
+	if ((b.state != CONSTPROP_CONSTANT) || !scalar_can_drop(sc, iptr->sx.s23.s2.varindex))
+		return false;
+
+	s4   i = (s4) b.value;
+	s8   l = b.value;
+	ICMD opc;
+
+	switch (iptr->opc) {
+	case ICMD_IF_ICMPEQ:
+	case ICMD_IF_ICMPNE:
+	case ICMD_IF_ICMPLT:
+	case ICMD_IF_ICMPGE:
+	case ICMD_IF_ICMPGT:
+	case ICMD_IF_ICMPLE:
+		opc = (ICMD) (ICMD_IFEQ + (iptr->opc - ICMD_IF_ICMPEQ));
+		break;
+
+	case ICMD_IF_LCMPEQ:
+	case ICMD_IF_LCMPNE:
+	case ICMD_IF_LCMPLT:
+	case ICMD_IF_LCMPGE:
+	case ICMD_IF_LCMPGT:
+	case ICMD_IF_LCMPLE:
+		opc = (ICMD) (ICMD_IF_LEQ + (iptr->opc - ICMD_IF_LCMPEQ));
+		break;
+
+	case ICMD_IADD: opc = ICMD_IADDCONST; break;
+	case ICMD_ISUB: opc = ICMD_ISUBCONST; break;
+
+	case ICMD_IMUL:
+		if (constprop_is_power_of_two(i, 30, &shift)) {
+			opc = ICMD_ISHLCONST;
+			i   = shift;
+			break;
+		}
+#if SUPPORT_CONST_MUL
+		opc = ICMD_IMULCONST;
+		break;
+#else
+		return false;
+#endif
+
+	case ICMD_IDIV:
+		if (!constprop_is_power_of_two(i, 30, &shift))
+			return false;
+		opc = ICMD_IDIVPOW2;
+		i   = shift;
+		break;
+
+	case ICMD_IREM:
+		if (!constprop_is_power_of_two(i, 30, &shift))
+			return false;
+		opc = ICMD_IREMPOW2;
+		i  -= 1;
+		break;
+
+#if SUPPORT_CONST_LOGICAL
+	case ICMD_IAND: opc = ICMD_IANDCONST; break;
+	case ICMD_IOR:  opc = ICMD_IORCONST;  break;
+	case ICMD_IXOR: opc = ICMD_IXORCONST; break;
+#endif
+
+	case ICMD_ISHL:  opc = ICMD_ISHLCONST;  i &= 0x1f; break;
+	case ICMD_ISHR:  opc = ICMD_ISHRCONST;  i &= 0x1f; break;
+	case ICMD_IUSHR: opc = ICMD_IUSHRCONST; i &= 0x1f; break;
+
+#if SUPPORT_LONG_ADD
+	case ICMD_LADD: opc = ICMD_LADDCONST; break;
+	case ICMD_LSUB: opc = ICMD_LSUBCONST; break;
+#endif
+
+#if SUPPORT_LONG_SHIFT
+	case ICMD_LSHL:  opc = ICMD_LSHLCONST;  i &= 0x3f; break;
+	case ICMD_LSHR:  opc = ICMD_LSHRCONST;  i &= 0x3f; break;
+	case ICMD_LUSHR: opc = ICMD_LUSHRCONST; i &= 0x3f; break;
+#endif
+
+	case ICMD_LMUL:
+#if SUPPORT_LONG_SHIFT
+		if (constprop_is_power_of_two(l, 62, &shift)) {
+			opc = ICMD_LSHLCONST;
+			i   = shift;
+			break;
+		}
+#endif
+#if SUPPORT_LONG_MUL && SUPPORT_CONST_MUL
+		opc = ICMD_LMULCONST;
+		break;
+#else
+		return false;
+#endif
+
+#if SUPPORT_LONG_DIV_POW2
+	case ICMD_LDIV:
+		if (!constprop_is_power_of_two(l, 62, &shift))
+			return false;
+		opc = ICMD_LDIVPOW2;
+		i   = shift;
+		break;
+#endif
+
+#if SUPPORT_LONG_REM_POW2
+	case ICMD_LREM:
+		if (!constprop_is_power_of_two(l, 62, &shift))
+			return false;
+		opc = ICMD_LREMPOW2;
+		l  -= 1;
+		break;
+#endif
+
+#if SUPPORT_CONST_LOGICAL
+	case ICMD_LAND: opc = ICMD_LANDCONST; break;
+	case ICMD_LOR:  opc = ICMD_LORCONST;  break;
+	case ICMD_LXOR: opc = ICMD_LXORCONST; break;
+#endif
+
+	default:
+		return false;
+	}
+
+	sc->uses[iptr->sx.s23.s2.varindex]--;
+
+	scalar_rewrite(iptr, opc);
+
+	/* shift counts and powers of two are ints, the other long
+	   immediates are longs */
+
+	switch (opc) {
+	case ICMD_IF_LEQ:
+	case ICMD_IF_LNE:
+	case ICMD_IF_LLT:
+	case ICMD_IF_LGE:
+	case ICMD_IF_LGT:
+	case ICMD_IF_LLE:
+	case ICMD_LADDCONST:
+	case ICMD_LSUBCONST:
+	case ICMD_LMULCONST:
+	case ICMD_LREMPOW2:
+	case ICMD_LANDCONST:
+	case ICMD_LORCONST:
+	case ICMD_LXORCONST:
+		iptr->sx.val.l = l;
+		break;
+
+	default:
+		iptr->sx.val.l = 0;
+		iptr->sx.val.i = i;
+		break;
+	}
+
+	return true;
+}
+
+
+/* constprop_fold_branch *******************************************************
+
+   Replaces a decided branch by a goto to its target, or removes it if
+   the block falls through.  Returns true if the branch was folded.
+
+*******************************************************************************/
+
+static bool constprop_fold_branch(constprop_t *cp, basicblock *bptr, instruction *cond, instruction *jump)
+{
+	basicblock *target = constprop_decide(cp, bptr, cond, jump);
+
+	if ((target == NULL) || !scalar_can_drop_operands(cp->sc, cond))
+		return false;
+
+	scalar_drop_operands(cp->sc, cond);
+
+	if (target == ((jump != NULL) ? jump->dst.block : bptr->next)) {
+		scalar_rewrite(cond, ICMD_NOP);
+	}
+	else {
+		scalar_rewrite(cond, ICMD_GOTO);
+		cond->dst.block = target;
+
+		if (jump != NULL)
+			scalar_rewrite(jump, ICMD_NOP);
+	}
+
+	return true;
+}
+
+
+/* constprop_rewrite_block *****************************************************
+
+   Applies the values of the fixpoint to the instructions of a block.
+
+*******************************************************************************/
+
+static void constprop_rewrite_block(constprop_t *cp, basicblock *bptr, s4 *counts)
+{
+	jitdata      *jd = cp->sc->jd;
+	instruction  *iptr;
+	instruction  *cond;
+	instruction  *jump;
+
+	MCOPY(cp->cur, constprop_entry(cp, bptr), constprop_value_t, jd->localcount);
+
+	scalar_find_branch(bptr, &cond, &jump);
+
+	FOR_EACH_INSTRUCTION(bptr, iptr) {
+		if (iptr == cond) {
+			if (constprop_fold_branch(cp, bptr, cond, jump))
+				counts[1]++;
+			else if (constprop_reduce(cp, iptr))
+				counts[2]++;
+			break;
+		}
+
+		if (!instruction_has_dst(iptr))
+			continue;
+
+		constprop_value_t value = constprop_eval(cp, iptr);
+		s4                dst   = iptr->dst.varindex;
+
+		/* replace the computation by its constant result, unless it
+		   is a constant or a copy of a variable to itself already */
+
+		if ((value.state == CONSTPROP_CONSTANT) && constprop_is_foldable(iptr) &&
+			!((icmd_table[iptr->opc].dataflow >= DF_COPY) && (iptr->s1.varindex == dst)) &&
+			scalar_can_drop_operands(cp->sc, iptr))
+		{
+			scalar_drop_operands(cp->sc, iptr);
+
+			if (jd->var[dst].type == TYPE_INT) {
+				scalar_rewrite(iptr, ICMD_ICONST);
+				iptr->sx.val.i = (s4) value.value;
+			}
+			else {
+				scalar_rewrite(iptr, ICMD_LCONST);
+				iptr->sx.val.l = value.value;
+			}
+
+			counts[0]++;
+		}
+		else if ((iptr->opc == ICMD_IINC) && (value.state == CONSTPROP_CONSTANT)) {
+			scalar_rewrite(iptr, ICMD_ICONST);
+			iptr->sx.val.i = (s4) value.value;
+			counts[0]++;
+		}
+		else if (constprop_reduce(cp, iptr)) {
+			counts[2]++;
+		}
+
+		constprop_transfer(cp, iptr, value);
+	}
+}
+
+
+/* constprop *******************************************************************
+
+   Conditional constant propagation over the executable edges of the
+   CFG.  The locals are tracked per block, the temporaries and block
+   interface variables, which have a single definition or are joined
+   at block boundaries, once for the method.  Returns true if branches
+   were folded.
+
+*******************************************************************************/
+
+static bool constprop(scalar_t *sc)
+{
+	jitdata    *jd = sc->jd;
+	basicblock *bptr;
+	s4          counts[3] = { 0, 0, 0 };
+
+	if ((s8) jd->basicblockcount * jd->localcount > CONSTPROP_MAX_STATES)
+		return false;
+
+	constprop_t cp;
+
+	cp.sc         = sc;
+	cp.values     = DMNEW(constprop_value_t, jd->vartop);
+	cp.entry      = DMNEW(constprop_value_t, jd->basicblockcount * jd->localcount + 1);
+	cp.executable = DMNEW(u1, jd->basicblockcount);
+	cp.cur        = DMNEW(constprop_value_t, jd->localcount + 1);
+
+	MZERO(cp.entry, constprop_value_t, jd->basicblockcount * jd->localcount);
+	MZERO(cp.executable, u1, jd->basicblockcount);
+
+	for (s4 i = 0; i < jd->vartop; i++) {
+		cp.values[i].state = constprop_is_scalar(jd, i) ? CONSTPROP_TOP : CONSTPROP_BOTTOM;
+		cp.values[i].value = 0;
+	}
+
+	/* the method is entered with unknown arguments, exception handlers
+	   with unknown locals and stack */
+
+	FOR_EACH_BASICBLOCK(jd, bptr) {
+		if (bptr->state < basicblock::REACHED)
+			continue;
+
+		if ((bptr != jd->basicblocks) && (bptr->type != basicblock::TYPE_EXH))
+			continue;
+
+		constprop_value_t *entry = constprop_entry(&cp, bptr);
+
+		for (s4 i = 0; i < jd->localcount; i++)
+			entry[i].state = CONSTPROP_BOTTOM;
+
+		for (s4 i = 0; i < bptr->indepth; i++)
+			cp.values[bptr->invars[i]].state = CONSTPROP_BOTTOM;
+
+		cp.executable[bptr->nr] = 1;
+	}
+
+	do {
+		cp.changed = false;
+
+		FOR_EACH_BASICBLOCK(jd, bptr) {
+			if ((bptr->state >= basicblock::REACHED) && cp.executable[bptr->nr])
+				constprop_evaluate_block(&cp, bptr);
+		}
+	} while (cp.changed);
+
+	FOR_EACH_BASICBLOCK(jd, bptr) {
+		if ((bptr->state >= basicblock::REACHED) && cp.executable[bptr->nr])
+			constprop_rewrite_block(&cp, bptr, counts);
+	}
+
+	STATISTICS(count_scalar_constants += counts[0]);
+	STATISTICS(count_scalar_branches += counts[1]);
+	STATISTICS(count_scalar_reduced += counts[2]);
+
+	return (counts[1] > 0);
+}
+
+
+/* value numbering ************************************************************/
+
+#define GVN_NAME_NONE        0
+#define GVN_NAME_LOCAL       1      // the value of a local variable
+#define GVN_NAME_CONSTANT    2
+
+struct gvn_name_t {
+	s4 kind;
+	s8 value;                       // variable index or constant
+};
+
+struct gvn_expr_t {
+	s4         opc;
+	s8         imm;                 // immediate or fieldinfo
+	gvn_name_t a;
+	gvn_name_t b;
+};
+
+/* a fact states that a local variable holds the value of an expression */
+
+struct gvn_fact_t {
+	s4         holder;
+	gvn_expr_t expr;
+};
+
+struct gvn_t {
+	scalar_t   *sc;
+	gvn_fact_t *facts;
+	s4          factcount;
+	bool        collect;            // add the facts found to the universe
+	u1         *avail;              // facts holding at the current point
+
+	gvn_name_t *tempname;           // what a temporary is a copy of
+	gvn_expr_t *tempexpr;           // the expression a temporary holds
+	s4         *tempstamp;          // tempname/tempexpr are valid for the
+	s4          stamp;              // block walk with this stamp
+};
+
+
+static bool gvn_name_equal(const gvn_name_t *a, const gvn_name_t *b)
+{
+	return (a->kind == b->kind) && (a->value == b->value);
+}
+
+
+static bool gvn_expr_equal(const gvn_expr_t *a, const gvn_expr_t *b)
+{
+	return (a->opc == b->opc) && (a->imm == b->imm) &&
+		gvn_name_equal(&a->a, &b->a) && gvn_name_equal(&a->b, &b->b);
+}
+
+
+static bool gvn_expr_reads(const gvn_expr_t *e, s4 local)
+{
+	return ((e->a.kind == GVN_NAME_LOCAL) && (e->a.value == local)) ||
+		((e->b.kind == GVN_NAME_LOCAL) && (e->b.value == local));
+}
+
+
+static bool gvn_expr_reads_heap(const gvn_expr_t *e)
+{
+	switch (e->opc) {
+	case ICMD_GETFIELD:
+	case ICMD_GETSTATIC:
+	case ICMD_IALOAD:
+	case ICMD_LALOAD:
+	case ICMD_FALOAD:
+	case ICMD_DALOAD:
+	case ICMD_AALOAD:
+	case ICMD_BALOAD:
+	case ICMD_CALOAD:
+	case ICMD_SALOAD:
+		return true;
+	default:
+		return false;
+	}
+}
+
+
+static gvn_name_t gvn_name(gvn_t *g, s4 v)
+{
+	gvn_name_t n;
+
+	n.kind  = GVN_NAME_NONE;
+	n.value = 0;
+
+	if (var_is_local(g->sc->jd, v)) {
+		n.kind  = GVN_NAME_LOCAL;
+		n.value = v;
+	}
+	else if (scalar_is_temp(g->sc, v) && (g->tempstamp[v] == g->stamp)) {
+		n = g->tempname[v];
+	}
+
+	return n;
+}
+
+
+/* gvn_field *******************************************************************
+
+   Returns the field accessed, or NULL if it is unresolved or volatile.
+
+*******************************************************************************/
+
+static fieldinfo *gvn_field(const instruction *iptr)
+{
+	if (INSTRUCTION_IS_UNRESOLVED(iptr))
+		return NULL;
+
+	fieldinfo *fi = iptr->sx.s23.s3.fmiref->p.field;
+
+	return (fi->flags & ACC_VOLATILE) ? NULL : fi;
+}
+
+
+/* gvn_key *********************************************************************
+
+   Describes the value the instruction computes.  Returns false if
+   the instruction is not a candidate or its operands have no name.
+
+*******************************************************************************/
+
+static bool gvn_key(gvn_t *g, const instruction *iptr, gvn_expr_t *e)
+{
+	fieldinfo *fi;
+	bool       binary = false;
+
+	e->opc     = iptr->opc;
+	e->imm     = 0;
+	e->a.kind  = GVN_NAME_NONE;
+	e->a.value = 0;
+	e->b       = e->a;
+
+	switch (iptr->opc) {
+	case ICMD_IADD:
+	case ICMD_ISUB:
+	case ICMD_IMUL:
+	case ICMD_IDIV:
+	case ICMD_IREM:
+	case ICMD_IAND:
+	case ICMD_IOR:
+	case ICMD_IXOR:
+	case ICMD_ISHL:
+	case ICMD_ISHR:
+	case ICMD_IUSHR:
+	case ICMD_LADD:
+	case ICMD_LSUB:
+	case ICMD_LMUL:
+	case ICMD_LDIV:
+	case ICMD_LREM:
+	case ICMD_LAND:
+	case ICMD_LOR:
+	case ICMD_LXOR:
+	case ICMD_LSHL:
+	case ICMD_LSHR:
+	case ICMD_LUSHR:
+	case ICMD_LCMP:
+	case ICMD_IALOAD:
+	case ICMD_LALOAD:
+	case ICMD_FALOAD:
+	case ICMD_DALOAD:
+	case ICMD_AALOAD:
+	case ICMD_BALOAD:
+	case ICMD_CALOAD:
+	case ICMD_SALOAD:
+		binary = true;
+		break;
+
+	case ICMD_IADDCONST:
+	case ICMD_ISUBCONST:
+	case ICMD_IMULCONST:
+	case ICMD_IANDCONST:
+	case ICMD_IORCONST:
+	case ICMD_IXORCONST:
+	case ICMD_ISHLCONST:
+	case ICMD_ISHRCONST:
+	case ICMD_IUSHRCONST:
+	case ICMD_IMULPOW2:
+	case ICMD_IDIVPOW2:
+	case ICMD_IREMPOW2:
+	case ICMD_LSHLCONST:
+	case ICMD_LSHRCONST:
+	case ICMD_LUSHRCONST:
+	case ICMD_LMULPOW2:
+	case ICMD_LDIVPOW2:
+		e->imm = iptr->sx.val.i;
+		break;
+
+	case ICMD_LADDCONST:
+	case ICMD_LSUBCONST:
+	case ICMD_LMULCONST:
+	case ICMD_LANDCONST:
+	case ICMD_LORCONST:
+	case ICMD_LXORCONST:
+	case ICMD_LREMPOW2:
+		e->imm = iptr->sx.val.l;
+		break;
+
+	case ICMD_INEG:
+	case ICMD_LNEG:
+	case ICMD_I2L:
+	case ICMD_L2I:
+	case ICMD_INT2BYTE:
+	case ICMD_INT2CHAR:
+	case ICMD_INT2SHORT:
+	case ICMD_ARRAYLENGTH:
+		break;
+
+	case ICMD_GETFIELD:
+		if ((fi = gvn_field(iptr)) == NULL)
+			return false;
+		e->imm = (s8) (intptr_t) fi;
+		break;
+
+	case ICMD_GETSTATIC:
+		if ((fi = gvn_field(iptr)) == NULL)
+			return false;
+		e->imm = (s8) (intptr_t) fi;
+		return true;
+
+	default:
+		return false;
+	}
+
+	e->a = gvn_name(g, iptr->s1.varindex);
+
+	if (e->a.kind == GVN_NAME_NONE)
+		return false;
+
+	if (binary) {
+		e->b = gvn_name(g, iptr->sx.s23.s2.varindex);
+
+		if (e->b.kind == GVN_NAME_NONE)
+			return false;
+	}
+
+	return true;
+}
+
+
+/* gvn_kill_heap ***************************************************************
+
+   Removes the heap loads the instruction may change.  Calls, monitor
+   operations and the resolution or initialization of classes may run
+   arbitrary code and kill all of them.
+
+*******************************************************************************/
+
+static void gvn_kill_heap(gvn_t *g, const instruction *iptr)
+{
+	fieldinfo *fi;
+	s4         killopc;
+	s8         killimm = 0;
+
+	switch (iptr->opc) {
+	case ICMD_PUTFIELD:
+	case ICMD_PUTFIELDCONST:
+		killopc = ICMD_GETFIELD;
+		if ((fi = gvn_field(iptr)) == NULL)
+			killopc = -1;
+		else
+			killimm = (s8) (intptr_t) fi;
+		break;
+
+	case ICMD_PUTSTATIC:
+	case ICMD_PUTSTATICCONST:
+		killopc = ICMD_GETSTATIC;
+		if (((fi = gvn_field(iptr)) == NULL) || !class_is_or_almost_initialized(fi->clazz))
+			killopc = -1;
+		else
+			killimm = (s8) (intptr_t) fi;
+		break;
+
+	case ICMD_GETFIELD:
+		if (gvn_field(iptr) != NULL)
+			return;
+		killopc = -1;
+		break;
+
+	case ICMD_GETSTATIC:
+		if (((fi = gvn_field(iptr)) != NULL) && class_is_or_almost_initialized(fi->clazz))
+			return;
+		killopc = -1;
+		break;
+
+	case ICMD_IASTORE:
+	case ICMD_IASTORECONST: killopc = ICMD_IALOAD; break;
+	case ICMD_LASTORE:
+	case ICMD_LASTORECONST: killopc = ICMD_LALOAD; break;
+	case ICMD_FASTORE:
+	case ICMD_FASTORECONST: killopc = ICMD_FALOAD; break;
+	case ICMD_DASTORE:
+	case ICMD_DASTORECONST: killopc = ICMD_DALOAD; break;
+	case ICMD_AASTORE:
+	case ICMD_AASTORECONST: killopc = ICMD_AALOAD; break;
+	case ICMD_BASTORE:
+	case ICMD_BASTORECONST: killopc = ICMD_BALOAD; break;
+	case ICMD_CASTORE:
+	case ICMD_CASTORECONST: killopc = ICMD_CALOAD; break;
+	case ICMD_SASTORE:
+	case ICMD_SASTORECONST: killopc = ICMD_SALOAD; break;
+
+	case ICMD_ACONST:
+	case ICMD_CHECKCAST:
+	case ICMD_INSTANCEOF:
+		if (INSTRUCTION_IS_RESOLVED(iptr))
+			return;
+		killopc = -1;
+		break;
+
+	case ICMD_MONITORENTER:
+	case ICMD_MONITOREXIT:
+		killopc = -1;
+		break;
+
+	default:
+		switch (icmd_table[iptr->opc].dataflow) {
+		case DF_INVOKE:
+		case DF_BUILTIN:
+		case DF_N_TO_1:
+			killopc = -1;
+			break;
+		default:
+			return;
+		}
+		break;
+	}
+
+	for (s4 f = 0; f < g->factcount; f++) {
+		gvn_expr_t *e = &g->facts[f].expr;
+
+		if (!g->avail[f] || !gvn_expr_reads_heap(e))
+			continue;
+
+		if ((killopc == -1) ||
+			((e->opc == killopc) && ((killimm == 0) || (e->imm == killimm))))
+			g->avail[f] = 0;
+	}
+}
+
+
+/* gvn_kill_local **************************************************************
+
+   Removes the facts and temporary names invalidated by an assignment
+   to a local variable.
+
+*******************************************************************************/
+
+static void gvn_kill_local(gvn_t *g, s4 local, const s4 *temps, s4 tempcount)
+{
+	for (s4 f = 0; f < g->factcount; f++) {
+		if ((g->facts[f].holder == local) || gvn_expr_reads(&g->facts[f].expr, local))
+			g->avail[f] = 0;
+	}
+
+	for (s4 i = 0; i < tempcount; i++) {
+		s4 t = temps[i];
+
+		if (g->tempstamp[t] != g->stamp)
+			continue;
+
+		if ((g->tempname[t].kind == GVN_NAME_LOCAL) && (g->tempname[t].value == local))
+			g->tempname[t].kind = GVN_NAME_NONE;
+
+		if (gvn_expr_reads(&g->tempexpr[t], local))
+			g->tempexpr[t].opc = ICMD_NOP;
+	}
+}
+
+
+/* gvn_gen *********************************************************************
+
+   Records that the local holds the value of the expression.
+
+*******************************************************************************/
+
+static void gvn_gen(gvn_t *g, s4 holder, const gvn_expr_t *e)
+{
+	if ((e->opc == ICMD_NOP) || gvn_expr_reads(e, holder))
+		return;
+
+	for (s4 f = 0; f < g->factcount; f++) {
+		if ((g->facts[f].holder == holder) && gvn_expr_equal(&g->facts[f].expr, e)) {
+			g->avail[f] = 1;
+			return;
+		}
+	}
+
+	if (!g->collect || (g->factcount == GVN_MAX_FACTS))
+		return;
+
+	g->facts[g->factcount].holder = holder;
+	g->facts[g->factcount].expr   = *e;
+	g->factcount++;
+}
+
+
+/* gvn_replace *****************************************************************
+
+   Replaces the instruction by a copy of a local holding its value.
+   Returns true if it was replaced.
+
+*******************************************************************************/
+
+static bool gvn_replace(gvn_t *g, instruction *iptr, const gvn_expr_t *e)
+{
+	jitdata *jd  = g->sc->jd;
+	s4       dst = iptr->dst.varindex;
+
+	for (s4 f = 0; f < g->factcount; f++) {
+		s4 holder = g->facts[f].holder;
+
+		if (!g->avail[f] || !gvn_expr_equal(&g->facts[f].expr, e))
+			continue;
+
+		if ((jd->var[holder].type != jd->var[dst].type) ||
+			!scalar_can_drop_operands(g->sc, iptr))
+			return false;
+
+		scalar_drop_operands(g->sc, iptr);
+
+		/* a local assigned the value it already holds */
+
+		if (holder == dst) {
+			scalar_rewrite(iptr, ICMD_NOP);
+			return true;
+		}
+
+		scalar_rewrite(iptr, (ICMD) (ICMD_ILOAD + jd->var[dst].type));
+		iptr->s1.varindex = holder;
+		g->sc->uses[holder]++;
+
+		return true;
+	}
+
+	return false;
+}
+
+
+/* gvn_walk ********************************************************************
+
+   Walks a block, starting with the facts in g->avail and leaving the
+   facts at its end there.  Replaces redundant computations if
+   <replace> is set and returns their number.
+
+*******************************************************************************/
+
+static s4 gvn_walk(gvn_t *g, basicblock *bptr, s4 *temps, bool replace)
+{
+	jitdata     *jd        = g->sc->jd;
+	instruction *iptr;
+	s4           tempcount = 0;
+	s4           replaced  = 0;
+	gvn_expr_t   e;
+
+	g->stamp++;
+
+	FOR_EACH_INSTRUCTION(bptr, iptr) {
+		bool valid = gvn_key(g, iptr, &e);
+
+		if (valid && replace && gvn_replace(g, iptr, &e))
+			replaced++;
+
+		gvn_kill_heap(g, iptr);
+
+		s4 dst = scalar_dst(iptr);
+
+		if (dst == jitdata::UNUSED)
+			continue;
+
+		/* loads and stores coalesced with the local change nothing */
+
+		s4   src  = iptr->s1.varindex;
+		bool copy = (icmd_table[iptr->opc].dataflow >= DF_COPY);
+
+		if (copy && (src == dst))
+			continue;
+
+		if (!valid)
+			e.opc = ICMD_NOP;
+
+		/* copies pass on what their source holds */
+
+		if (copy && scalar_is_temp(g->sc, src) &&
+			(g->tempstamp[src] == g->stamp))
+			e = g->tempexpr[src];
+
+		if (var_is_local(jd, dst)) {
+			gvn_kill_local(g, dst, temps, tempcount);
+			gvn_gen(g, dst, &e);
+		}
+		else if (scalar_is_temp(g->sc, dst)) {
+			gvn_name_t n;
+
+			n.kind  = GVN_NAME_NONE;
+			n.value = 0;
+
+			if (iptr->opc == ICMD_ICONST) {
+				n.kind  = GVN_NAME_CONSTANT;
+				n.value = iptr->sx.val.i;
+			}
+			else if (copy) {
+				n = gvn_name(g, src);
+			}
+
+			g->tempname[dst]  = n;
+			g->tempexpr[dst]  = e;
+			g->tempstamp[dst] = g->stamp;
+
+			temps[tempcount++] = dst;
+		}
+	}
+
+	return replaced;
+}
+
+
+/* gvn *************************************************************************
+
+   Global value numbering as an available expressions problem: a fact
+   holds at the start of a block if it holds at the end of all
+   predecessors.  Returns the number of computations replaced.
+
+*******************************************************************************/
+
+static s4 gvn(scalar_t *sc)
+{
+	jitdata     *jd = sc->jd;
+	basicblock  *bptr;
+	basicblock **pred;
+	s4           maxicount = 0;
+
+	gvn_t g;
+
+	g.sc        = sc;
+	g.facts     = DMNEW(gvn_fact_t, GVN_MAX_FACTS);
+	g.factcount = 0;
+	g.tempname  = DMNEW(gvn_name_t, jd->vartop);
+	g.tempexpr  = DMNEW(gvn_expr_t, jd->vartop);
+	g.tempstamp = DMNEW(s4, jd->vartop);
+	g.stamp     = 0;
+
+	MZERO(g.tempstamp, s4, jd->vartop);
+
+	FOR_EACH_BASICBLOCK(jd, bptr) {
+		if (bptr->icount > maxicount)
+			maxicount = bptr->icount;
+	}
+
+	s4 *temps = DMNEW(s4, maxicount);
+
+	/* collect the facts */
+
+	g.avail   = DMNEW(u1, GVN_MAX_FACTS);
+	g.collect = true;
+
+	MZERO(g.avail, u1, GVN_MAX_FACTS);
+
+	FOR_EACH_BASICBLOCK(jd, bptr) {
+		if (bptr->state >= basicblock::REACHED)
+			gvn_walk(&g, bptr, temps, false);
+	}
+
+	g.collect = false;
+
+	if (g.factcount == 0)
+		return 0;
+
+	s4  n   = g.factcount;
+	u1 *in  = DMNEW(u1, jd->basicblockcount * n);
+	u1 *out = DMNEW(u1, jd->basicblockcount * n);
+
+	MSET(out, 1, u1, jd->basicblockcount * n);
+
+	/* solve the dataflow problem */
+
+	bool changed;
+
+	do {
+		changed = false;
+
+		FOR_EACH_BASICBLOCK(jd, bptr) {
+			if (bptr->state < basicblock::REACHED)
+				continue;
+
+			u1 *bin = in + bptr->nr * n;
+
+			if ((bptr == jd->basicblocks) || (bptr->type == basicblock::TYPE_EXH) ||
+				(bptr->predecessorcount <= 0))
+			{
+				MZERO(bin, u1, n);
+			}
+			else {
+				MSET(bin, 1, u1, n);
+
+				FOR_EACH_PREDECESSOR(bptr, pred) {
+					u1 *pout = out + (*pred)->nr * n;
+
+					for (s4 f = 0; f < n; f++)
+						bin[f] &= pout[f];
+				}
+			}
+
+			MCOPY(g.avail, bin, u1, n);
+
+			gvn_walk(&g, bptr, temps, false);
+
+			u1 *bout = out + bptr->nr * n;
+
+			for (s4 f = 0; f < n; f++) {
+				if (bout[f] != g.avail[f]) {
+					bout[f] = g.avail[f];
+					changed = true;
+				}
+			}
+		}
+	} while (changed);
+
+	/* replace the redundant computations */
+
+	s4 replaced = 0;
+
+	FOR_EACH_BASICBLOCK(jd, bptr) {
+		if (bptr->state < basicblock::REACHED)
+			continue;
+
+		MCOPY(g.avail, in + bptr->nr * n, u1, n);
+
+		replaced += gvn_walk(&g, bptr, temps, true);
+	}
+
+	STATISTICS(count_scalar_redundant += replaced);
+
+	return replaced;
+}
+
+
+/* scalar_optimize *************************************************************
+
+   Runs constant propagation, value numbering and the removal of the
+   temporaries they left unused.  Returns false if the CFG could not be
+   rebuilt.
+
+*******************************************************************************/
+
+bool scalar_optimize(jitdata *jd)
+{
+	if (!scalar_check_method(jd))
+		return true;
+
+	scalar_t sc;
+
+	sc.jd       = jd;
+	sc.uses     = DMNEW(s4, jd->vartop);
+	sc.defcount = DMNEW(s4, jd->vartop);
+	sc.def      = DMNEW(instruction*, jd->vartop);
+
+	scalar_count(&sc);
+
+	bool folded = constprop(&sc);
+
+	gvn(&sc);
+
+	scalar_remove_dead(&sc);
+
+	if (folded) {
+		cfg_clear(jd);
+
+		if (!cfg_build(jd))
+			return false;
+	}
+
+	return true;
+}
+
+
+/*
+ * These are local overrides for various environment variables in Emacs.
+ * Please do not remove this and leave it at the end of the file, where
+ * Emacs will automagically detect them.
+ * ---------------------------------------------------------------------
+ * Local variables:
+ * mode: c++
+ * indent-tabs-mode: t
+ * c-basic-offset: 4
+ * tab-width: 4
+ * End:
+ * vim:noexpandtab:sw=4:ts=4:
+ */
@@ -0,0 +1,84 @@
+/* src/vm/jit/optimizing/scalar.hpp - scalar optimizations
+
+   Copyright (C) 1996-2013
+   CACAOVM - Verein zur Foerderung der freien virtuellen Maschine CACAO
+
+   This file is part of CACAO.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation; either version 2, or (at
+   your option) any later version.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA.
+
+*/
+
+
+#ifndef _OPTIMIZING_SCALAR_HPP
+#define _OPTIMIZING_SCALAR_HPP
+
+#include "config.h"
+
+struct jitdata;
+
+
+/* Scalar optimizations *******************************************************
+
+   Optimizes the int and long computations of a method on the
+   intermediate representation produced by stack analysis, where local
+   variables may be assigned several times and stack slots are single
+   assignment temporaries:
+
+   - Conditional constant propagation evaluates the method over the
+     executable edges of the CFG, replaces computations with constant
+     results by constants and conditional branches and switches on
+     constants by gotos.
+
+   - Strength reduction folds constant operands into the immediate
+     forms of the instructions and turns multiplications, divisions
+     and remainders by powers of two into shifts and masks.
+
+   - Value numbering replaces arithmetic, field, array and array
+     length loads whose value is still held in a local variable by a
+     copy of that variable.  Heap loads are killed by stores to the
+     same field or array type, calls, monitor operations and class
+     initialization.
+
+   No optimization extends the lifetime of a temporary, as the simple
+   register allocator relies on them being used in stack order.
+   Temporaries left without uses are removed afterwards.
+
+   Must run after the CFG has been built and rebuilds it if branches
+   were folded.  Disabled with -XX:-ScalarOptimizations.
+
+*******************************************************************************/
+
+/* function prototypes ********************************************************/
+
+bool scalar_optimize(jitdata *jd);
+
+#endif /* _OPTIMIZING_SCALAR_HPP */
+
+
+/*
+ * These are local overrides for various environment variables in Emacs.
+ * Please do not remove this and leave it at the end of the file, where
+ * Emacs will automagically detect them.
+ * ---------------------------------------------------------------------
+ * Local variables:
+ * mode: c++
+ * indent-tabs-mode: t
+ * c-basic-offset: 4
+ * tab-width: 4
+ * End:
+ * vim:noexpandtab:sw=4:ts=4:
+ */
@@ -0,0 +1,367 @@
+/* src/vm/jit/optimizing/tiered.cpp - tiered compilation policy
+
+   Copyright (C) 1996-2013
+   CACAOVM - Verein zur Foerderung der freien virtuellen Maschine CACAO
+
+   This file is part of CACAO.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation; either version 2, or (at
+   your option) any later version.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA.
+
+*/
+
+
+#include "config.h"
+
+#include <cassert>
+#include <vector>
+
+#include "arch.hpp"                     // for SUPPORT_TIERED_COUNTERS
+
+#include "threads/mutex.hpp"
+#include "threads/thread.hpp"
+
+#include "toolbox/logging.hpp"
+
+#include "vm/method.hpp"
+#include "vm/options.hpp"
+#include "vm/statistics.hpp"
+#include "vm/vm.hpp"
+
+#include "vm/jit/code.hpp"
+#include "vm/jit/jit.hpp"
+
+#include "vm/jit/optimizing/recompiler.hpp"
+#include "vm/jit/optimizing/tiered.hpp"
+#include "vm/jit/optimizing/typeprofile.hpp"
+
+
+STAT_REGISTER_GROUP(tiered_stat,"tiered","tiered compilation")
+STAT_REGISTER_GROUP_VAR(int,count_tiered_promotions_invocation,0,"promotions (invocations)","methods promoted by the invocation counter",tiered_stat)
+STAT_REGISTER_GROUP_VAR(int,count_tiered_promotions_backedge,0,"promotions (loops)","methods promoted by the back-edge counter",tiered_stat)
+STAT_REGISTER_GROUP_VAR(int,count_tiered_deoptimizations,0,"deoptimizations","methods deoptimized after failed receiver checks",tiered_stat)
+
+
+/* per-tier statistics ********************************************************/
+
+struct tier_statistics {
+	int32_t methods;                    // methods compiled by this tier
+	int64_t bytecodesize;               // bytes of bytecode compiled
+	int64_t mcodesize;                  // bytes of machine code generated
+	int64_t nanos;                      // time spent compiling
+};
+
+
+/* global variables ***********************************************************/
+
+static Mutex                  *tiered_mutex      = NULL;
+static std::vector<codeinfo*> *tiered_candidates = NULL;
+static std::vector<codeinfo*> *tiered_guarded    = NULL;
+
+static tier_statistics         tiers[TIER_COUNT];
+
+static int32_t                 promotions_invocation = 0;
+static int32_t                 promotions_backedge   = 0;
+static int32_t                 guards                = 0;
+static int32_t                 deoptimizations       = 0;
+
+
+/* tiered_init *****************************************************************
+
+   Initializes the tiered compilation policy.  Tiered compilation is
+   switched off if the architecture cannot emit the counters.
+
+*******************************************************************************/
+
+bool tiered_init(void)
+{
+	TRACESUBSYSTEMINITIALIZATION("tiered_init");
+
+	if (!opt_TieredCompilation)
+		return true;
+
+#if !SUPPORT_TIERED_COUNTERS
+	log_println("[Tiered compilation is not supported on this architecture]");
+	opt_TieredCompilation = 0;
+	return true;
+#endif
+
+	tiered_mutex      = new Mutex();
+	tiered_candidates = new std::vector<codeinfo*>();
+	tiered_guarded    = new std::vector<codeinfo*>();
+
+	return typeprofile_init();
+}
+
+
+/* tiered_compiled *************************************************************
+
+   Records a finished compilation.  Code of the baseline tier becomes a
+   candidate for promotion, optimized code with inlined receiver checks
+   is watched for failing checks.
+
+   IN:
+       code.............the newly generated code
+       nanos............time spent compiling
+
+*******************************************************************************/
+
+void tiered_compiled(codeinfo *code, int64_t nanos)
+{
+	methodinfo *m = code->m;
+
+	if (tiered_mutex == NULL)
+		return;
+
+	/* native stubs and empty methods are not tiered */
+
+	if ((m->flags & ACC_NATIVE) || (m->jcode == NULL))
+		return;
+
+	int tier = (code->optlevel == TIER_BASELINE) ? TIER_BASELINE : TIER_OPTIMIZING;
+
+	MutexLocker lock(*tiered_mutex);
+
+	tiers[tier].methods++;
+	tiers[tier].bytecodesize += m->jcodelength;
+	tiers[tier].mcodesize    += code->mcodelength;
+	tiers[tier].nanos        += nanos;
+
+	if (tier == TIER_BASELINE)
+		tiered_candidates->push_back(code);
+	else if (code->guardcount > 0) {
+		guards += code->guardcount;
+		tiered_guarded->push_back(code);
+	}
+}
+
+
+/* tiered_check_guards *********************************************************
+
+   Collects the methods whose receiver checks failed at least
+   -XX:GuardedInliningMisses times since the last scan and resets the
+   miss counters of the others.  Must be called with the tiered mutex
+   held.
+
+   OUT:
+       deopt............methods to deoptimize
+
+*******************************************************************************/
+
+static void tiered_check_guards(std::vector<methodinfo*>& deopt)
+{
+#if defined(ENABLE_INLINING)
+	std::vector<codeinfo*>::iterator it = tiered_guarded->begin();
+
+	while (it != tiered_guarded->end()) {
+		codeinfo   *code = *it;
+		methodinfo *m    = code->m;
+
+		if (m->code != code) {
+			it = tiered_guarded->erase(it);
+			continue;
+		}
+
+		uint32_t misses = code->guardmisses;
+		code->guardmisses = 0;
+
+		if (misses < (uint32_t) opt_GuardedInliningMisses) {
+			it++;
+			continue;
+		}
+
+		deoptimizations++;
+		STATISTICS(count_tiered_deoptimizations++);
+
+		deopt.push_back(m);
+		it = tiered_guarded->erase(it);
+	}
+#endif
+}
+
+
+/* tiered_deoptimize ***********************************************************
+
+   Throws away the optimized code of a method whose inlined receiver
+   checks keep failing.  With replacement the code is invalidated, so
+   running activations leave it at their next replacement point and
+   the next call recompiles the method.  Otherwise the method is
+   recompiled on the recompilation thread.  The recompiled code
+   inlines no guarded calls, as the method has no type profiles any
+   more.
+
+   IN:
+       m................the method
+
+*******************************************************************************/
+
+static void tiered_deoptimize(methodinfo *m)
+{
+	if (compileverbose)
+		log_message_method("Deoptimizing after failed receiver checks: ", m);
+
+#if defined(ENABLE_REPLACEMENT)
+	m->mutex->lock();
+	jit_invalidate_code(m);
+	m->mutex->unlock();
+#else
+	VM::get_current()->get_recompiler().queue_method(m);
+#endif
+}
+
+
+/* tiered_thread ***************************************************************
+
+   Checks the counters of the baseline code and queues hot methods for
+   recompilation.  Deoptimizes optimized code whose receiver checks
+   fail too often.
+
+*******************************************************************************/
+
+static void tiered_thread(void)
+{
+	std::vector<methodinfo*> hot;
+	std::vector<methodinfo*> deopt;
+
+	while (true) {
+		threads_sleep(opt_TieredScanInterval > 0 ? opt_TieredScanInterval : 1, 0);
+
+		tiered_mutex->lock();
+
+		std::vector<codeinfo*>::iterator it = tiered_candidates->begin();
+
+		while (it != tiered_candidates->end()) {
+			codeinfo   *code = *it;
+			methodinfo *m    = code->m;
+
+			/* code replaced in the meantime, e.g. by replacement */
+
+			if (m->code != code) {
+				it = tiered_candidates->erase(it);
+				continue;
+			}
+
+			if (code->invocations >= (uint32_t) opt_TieredInvocationThreshold) {
+				promotions_invocation++;
+				STATISTICS(count_tiered_promotions_invocation++);
+			}
+			else if (code->backedges >= (uint32_t) opt_TieredBackEdgeThreshold) {
+				promotions_backedge++;
+				STATISTICS(count_tiered_promotions_backedge++);
+			}
+			else {
+				it++;
+				continue;
+			}
+
+			hot.push_back(m);
+			it = tiered_candidates->erase(it);
+		}
+
+		tiered_check_guards(deopt);
+
+		tiered_mutex->unlock();
+
+		/* queue outside of the lock, the recompiler calls back into
+		   tiered_compiled */
+
+		for (std::vector<methodinfo*>::iterator mit = hot.begin(); mit != hot.end(); mit++) {
+			if (compileverbose)
+				log_message_method("Promoting to optimizing tier: ", *mit);
+
+			VM::get_current()->get_recompiler().queue_method(*mit);
+		}
+
+		hot.clear();
+
+		for (std::vector<methodinfo*>::iterator mit = deopt.begin(); mit != deopt.end(); mit++)
+			tiered_deoptimize(*mit);
+
+		deopt.clear();
+	}
+}
+
+
+/* tiered_start_thread *********************************************************
+
+   Starts the tiered compilation thread.
+
+*******************************************************************************/
+
+bool tiered_start_thread(void)
+{
+	if (tiered_mutex == NULL)
+		return true;
+
+	Utf8String name = Utf8String::from_utf8("Tiered Compilation");
+
+	if (!threads_thread_start_internal(name, tiered_thread))
+		return false;
+
+	return true;
+}
+
+
+/* tiered_print_statistics *****************************************************
+
+   Prints the per-tier statistics (-XX:+PrintTieredStatistics).
+
+*******************************************************************************/
+
+void tiered_print_statistics(void)
+{
+	static const char *names[TIER_COUNT] = { "baseline", "optimizing" };
+
+	if (tiered_mutex == NULL)
+		return;
+
+	MutexLocker lock(*tiered_mutex);
+
+	log_println("Tiered compilation:");
+
+	for (int i = 0; i < TIER_COUNT; i++) {
+		tier_statistics *t = &tiers[i];
+
+		log_println("  tier %d (%s): %d methods, %lld bytes bytecode, %lld bytes code, %lld ms",
+					i, names[i], t->methods,
+					(long long) t->bytecodesize, (long long) t->mcodesize,
+					(long long) (t->nanos / 1000000));
+	}
+
+	log_println("  promoted: %d by invocations, %d by loop iterations, %d pending or failed",
+				promotions_invocation, promotions_backedge,
+				promotions_invocation + promotions_backedge - tiers[TIER_OPTIMIZING].methods);
+
+	if (guards > 0)
+		log_println("  guarded inlining: %d receiver checks compiled, %d methods deoptimized",
+					guards, deoptimizations);
+
+	typeprofile_print_statistics();
+}
+
+
+/*
+ * These are local overrides for various environment variables in Emacs.
+ * Please do not remove this and leave it at the end of the file, where
+ * Emacs will automagically detect them.
+ * ---------------------------------------------------------------------
+ * Local variables:
+ * mode: c++
+ * indent-tabs-mode: t
+ * c-basic-offset: 4
+ * tab-width: 4
+ * End:
+ * vim:noexpandtab:sw=4:ts=4:
+ */
@@ -0,0 +1,82 @@
+/* src/vm/jit/optimizing/tiered.hpp - tiered compilation policy
+
+   Copyright (C) 1996-2013
+   CACAOVM - Verein zur Foerderung der freien virtuellen Maschine CACAO
+
+   This file is part of CACAO.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation; either version 2, or (at
+   your option) any later version.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA.
+
+*/
+
+
+#ifndef _TIERED_HPP
+#define _TIERED_HPP
+
+#include "config.h"
+
+#include <stdint.h>
+
+struct codeinfo;
+
+
+/* Tiered compilation *********************************************************
+
+   With -XX:+TieredCompilation every method is first compiled by the
+   baseline tier (optimization level 0) without the optional
+   optimizations (inlining, if-conversion, loop optimization, SSA).
+   The baseline code counts method invocations and loop iterations in
+   its codeinfo.  The tiered compilation thread periodically checks the
+   counters and queues methods crossing -XX:TieredInvocationThreshold
+   or -XX:TieredBackEdgeThreshold for recompilation by the optimizing
+   tier (optimization level 1) on the recompilation thread.
+
+   The thread also counts the failed receiver checks of calls inlined
+   speculatively by the optimizing tier and deoptimizes methods whose
+   checks fail -XX:GuardedInliningMisses times between two scans.
+
+*******************************************************************************/
+
+#define TIER_BASELINE      0
+#define TIER_OPTIMIZING    1
+#define TIER_COUNT         2
+
+
+/* function prototypes ********************************************************/
+
+bool tiered_init(void);
+bool tiered_start_thread(void);
+
+void tiered_compiled(codeinfo *code, int64_t nanos);
+
+void tiered_print_statistics(void);
+
+#endif /* _TIERED_HPP */
+
+
+/*
+ * These are local overrides for various environment variables in Emacs.
+ * Please do not remove this and leave it at the end of the file, where
+ * Emacs will automagically detect them.
+ * ---------------------------------------------------------------------
+ * Local variables:
+ * mode: c++
+ * indent-tabs-mode: t
+ * c-basic-offset: 4
+ * tab-width: 4
+ * End:
+ * vim:noexpandtab:sw=4:ts=4:
+ */
@@ -0,0 +1,496 @@
+/* src/vm/jit/optimizing/typeprofile.cpp - type profiles of casts and array stores
+
+   Copyright (C) 1996-2013
+   CACAOVM - Verein zur Foerderung der freien virtuellen Maschine CACAO
+
+   This file is part of CACAO.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation; either version 2, or (at
+   your option) any later version.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA.
+
+*/
+
+
+#include "config.h"
+
+#include <algorithm>
+#include <cassert>
+
+#include "arch.hpp"                     // for SUPPORT_TYPE_PROFILES, etc.
+
+#include "mm/memory.hpp"
+
+#include "threads/mutex.hpp"
+
+#include "toolbox/logging.hpp"
+
+#include "vm/array.hpp"
+#include "vm/class.hpp"
+#include "vm/method.hpp"
+#include "vm/options.hpp"
+#include "vm/statistics.hpp"
+#include "vm/vftbl.hpp"
+
+#include "vm/jit/code.hpp"
+#include "vm/jit/compilelog.hpp"
+#include "vm/jit/jit.hpp"
+
+#include "vm/jit/ir/icmd.hpp"
+#include "vm/jit/ir/instruction.hpp"
+
+#include "vm/jit/optimizing/typeprofile.hpp"
+
+
+STAT_REGISTER_VAR(int,count_typeprofile_guards,0,"type guards","checks testing a profiled class first")
+
+
+/* site statistics ************************************************************/
+
+struct typeprofile_statistics {
+	int32_t profiled;                   // sites instrumented by the baseline tier
+	int32_t calls;                      // calls instrumented by the baseline tier
+	int32_t receivers;                  // calls dominated by one receiver class
+	int32_t unexecuted;                 // sites never reached with an object
+	int32_t monomorphic;                // sites which only saw one class
+	int32_t dominant;                   // sites dominated by one class
+	int32_t polymorphic;                // sites without a dominant class
+	int32_t guarded;                    // sites testing the dominant class first
+};
+
+
+/* global variables ***********************************************************/
+
+static Mutex                  *typeprofile_mutex = NULL;
+static bool                    typeprofile_calls = false;
+static typeprofile_statistics  typeprofile_stats;
+
+
+/* typeprofile_init ************************************************************
+
+   Enables the type profiles.  Called by tiered_init, as only the
+   baseline code of tiered compilation is profiled.
+
+*******************************************************************************/
+
+bool typeprofile_init(void)
+{
+	TRACESUBSYSTEMINITIALIZATION("typeprofile_init");
+
+#if SUPPORT_TYPE_PROFILES
+	if (opt_TypeProfiles)
+		typeprofile_mutex = new Mutex();
+#endif
+
+	/* the receivers are only used for guarded inlining */
+
+#if SUPPORT_TYPE_PROFILES && SUPPORT_GUARDED_INLINING && defined(ENABLE_INLINING)
+	typeprofile_calls = opt_TypeProfiles && opt_Inline && opt_GuardedInlining;
+#endif
+
+	return true;
+}
+
+
+/* typeprofile_is_check ********************************************************
+
+   Returns true for the checks which are profiled.
+
+*******************************************************************************/
+
+static inline bool typeprofile_is_check(instruction *iptr)
+{
+	return (iptr->opc == ICMD_CHECKCAST) || (iptr->opc == ICMD_INSTANCEOF) ||
+		(iptr->opc == ICMD_AASTORE);
+}
+
+
+/* typeprofile_is_site *********************************************************
+
+   Returns true for the checks and calls which are profiled.
+
+*******************************************************************************/
+
+static inline bool typeprofile_is_site(instruction *iptr)
+{
+	if (typeprofile_calls &&
+		((iptr->opc == ICMD_INVOKEVIRTUAL) || (iptr->opc == ICMD_INVOKEINTERFACE)))
+		return true;
+
+	return typeprofile_is_check(iptr);
+}
+
+
+static inline int32_t typeprofile_id(instruction *iptr)
+{
+	return iptr->flags.bits >> INS_FLAG_ID_SHIFT;
+}
+
+
+static bool typeprofile_compare(const typeprofile &a, const typeprofile &b)
+{
+	return a.id < b.id;
+}
+
+
+/* typeprofile_create **********************************************************
+
+   Allocates a profile for each check of the method compiled by the
+   baseline tier.  The profiles are sorted by instruction id and freed
+   with the code.
+
+*******************************************************************************/
+
+void typeprofile_create(jitdata *jd)
+{
+	codeinfo    *code;
+	basicblock  *bptr;
+	instruction *iptr;
+	int32_t      count;
+	int32_t      calls;
+	int32_t      i;
+
+	if (typeprofile_mutex == NULL)
+		return;
+
+	code  = jd->code;
+	count = 0;
+	calls = 0;
+
+	FOR_EACH_BASICBLOCK(jd, bptr) {
+		if (bptr->state < basicblock::REACHED)
+			continue;
+
+		FOR_EACH_INSTRUCTION(bptr, iptr) {
+			if (typeprofile_is_site(iptr)) {
+				count++;
+				if (!typeprofile_is_check(iptr))
+					calls++;
+			}
+		}
+	}
+
+	if (count == 0)
+		return;
+
+	code->typeprofiles     = MNEW(typeprofile, count);
+	code->typeprofilecount = count;
+
+	i = 0;
+
+	FOR_EACH_BASICBLOCK(jd, bptr) {
+		if (bptr->state < basicblock::REACHED)
+			continue;
+
+		FOR_EACH_INSTRUCTION(bptr, iptr) {
+			if (typeprofile_is_site(iptr))
+				code->typeprofiles[i++].id = typeprofile_id(iptr);
+		}
+	}
+
+	std::sort(code->typeprofiles, code->typeprofiles + count, typeprofile_compare);
+
+	MutexLocker lock(*typeprofile_mutex);
+
+	typeprofile_stats.profiled += count - calls;
+	typeprofile_stats.calls    += calls;
+}
+
+
+/* typeprofile_find ************************************************************
+
+   Returns the profile of the given check or call in the given code, or
+   NULL.
+
+*******************************************************************************/
+
+typeprofile *typeprofile_find(codeinfo *code, instruction *iptr)
+{
+	typeprofile  key;
+	typeprofile *end;
+	typeprofile *tp;
+
+	if ((code->typeprofiles == NULL) || !typeprofile_is_site(iptr))
+		return NULL;
+
+	key.id = typeprofile_id(iptr);
+	end    = code->typeprofiles + code->typeprofilecount;
+	tp     = std::lower_bound(code->typeprofiles, end, key, typeprofile_compare);
+
+	if ((tp == end) || (tp->id != key.id))
+		return NULL;
+
+	return tp;
+}
+
+
+/* typeprofile_check ***********************************************************
+
+   Decides how the check of the given instruction treats the class
+   recorded in the profile.  The profile is read once, as baseline
+   code may still update it.
+
+   RETURN VALUE:
+      true.....the check may test the class first, see tg
+      false....the class would fail the check or cannot be used
+
+*******************************************************************************/
+
+static bool typeprofile_check(instruction *iptr, typeprofile *tp, typeguard *tg)
+{
+	vftbl_t   *vftbl      = tp->vftbl;
+	vftbl_t   *arrayvftbl = tp->arrayvftbl;
+	classinfo *c;
+
+	if (vftbl == NULL)
+		return false;
+
+	tg->vftbl      = vftbl;
+	tg->arrayvftbl = NULL;
+	tg->result     = true;
+
+	switch (iptr->opc) {
+	case ICMD_CHECKCAST:
+	case ICMD_INSTANCEOF:
+		if (INSTRUCTION_IS_UNRESOLVED(iptr))
+			return false;
+
+		c = iptr->sx.s23.s3.c.cls;
+
+		tg->result = class_isanysubclass(vftbl->clazz, c);
+
+		/* a class failing a cast is left to the exception path */
+
+		if ((iptr->opc == ICMD_CHECKCAST) && !tg->result)
+			return false;
+		break;
+
+	case ICMD_AASTORE:
+		if ((arrayvftbl == NULL) || (arrayvftbl->arraydesc == NULL) ||
+			(arrayvftbl->arraydesc->componentvftbl == NULL))
+			return false;
+
+		if (!class_isanysubclass(vftbl->clazz, arrayvftbl->arraydesc->componentvftbl->clazz))
+			return false;
+
+		tg->arrayvftbl = arrayvftbl;
+		break;
+
+	default:
+		return false;
+	}
+
+	return true;
+}
+
+
+/* typeprofile_select **********************************************************
+
+   Marks the checks of the method whose baseline profile is dominated
+   by one class with INS_FLAG_PROFILED.  Checks of inlined methods are
+   not marked, their ids refer to the callee.  Run by the optimizing
+   tier after all passes which move or copy instructions.
+
+   RETURN VALUE:
+      the number of marked checks
+
+*******************************************************************************/
+
+int32_t typeprofile_select(jitdata *jd)
+{
+	codeinfo               *pcode;
+	basicblock             *bptr;
+	instruction            *iptr;
+	typeprofile            *tp;
+	typeguard               tg;
+	typeprofile_statistics  stats;
+	uint32_t                count;
+	uint32_t                hits;
+
+	pcode = jd->m->code;
+
+	if ((typeprofile_mutex == NULL) || (pcode == NULL) || (pcode == jd->code) ||
+		(pcode->typeprofiles == NULL))
+		return 0;
+
+	stats = typeprofile_statistics();
+
+	FOR_EACH_BASICBLOCK(jd, bptr) {
+		if ((bptr->state < basicblock::REACHED) || (bptr->method != jd->m))
+			continue;
+
+		FOR_EACH_INSTRUCTION(bptr, iptr) {
+			if (!typeprofile_is_check(iptr))
+				continue;
+
+			tp = typeprofile_find(pcode, iptr);
+
+			if (tp == NULL)
+				continue;
+
+			count = tp->count;
+			hits  = tp->hits;
+
+			if (count == 0) {
+				stats.unexecuted++;
+				continue;
+			}
+
+			if (hits >= count)
+				stats.monomorphic++;
+			else if ((uint64_t) hits * 100 >= (uint64_t) count * opt_TypeProfileThreshold)
+				stats.dominant++;
+			else {
+				stats.polymorphic++;
+				continue;
+			}
+
+			if ((count < TYPEPROFILE_MIN_COUNT) || !typeprofile_check(iptr, tp, &tg))
+				continue;
+
+			iptr->flags.bits |= INS_FLAG_PROFILED;
+			stats.guarded++;
+		}
+	}
+
+	STATISTICS(count_typeprofile_guards += stats.guarded);
+
+	if (jd->log != NULL)
+		jd->log->typeguards += stats.guarded;
+
+	MutexLocker lock(*typeprofile_mutex);
+
+	typeprofile_stats.unexecuted  += stats.unexecuted;
+	typeprofile_stats.monomorphic += stats.monomorphic;
+	typeprofile_stats.dominant    += stats.dominant;
+	typeprofile_stats.polymorphic += stats.polymorphic;
+	typeprofile_stats.guarded     += stats.guarded;
+
+	return stats.guarded;
+}
+
+
+/* typeprofile_guard ***********************************************************
+
+   Returns the class the code generator tests first for a check marked
+   with INS_FLAG_PROFILED.  The profile is checked again, it may have
+   changed since typeprofile_select.
+
+   RETURN VALUE:
+      true.....emit the test, see tg
+      false....emit the generic check only
+
+*******************************************************************************/
+
+bool typeprofile_guard(jitdata *jd, instruction *iptr, typeguard *tg)
+{
+	codeinfo    *pcode = jd->m->code;
+	typeprofile *tp;
+
+	if (!(iptr->flags.bits & INS_FLAG_PROFILED) || (pcode == NULL))
+		return false;
+
+	tp = typeprofile_find(pcode, iptr);
+
+	if (tp == NULL)
+		return false;
+
+	return typeprofile_check(iptr, tp, tg);
+}
+
+
+/* typeprofile_receiver ********************************************************
+
+   Returns the receiver class dominating the profile of the given
+   virtual or interface call in the given baseline code.  Used by the
+   inliner, which checks the class before the inlined body.
+
+   RETURN VALUE:
+      the vftbl of the class, or
+      NULL if the call was not profiled or is polymorphic
+
+*******************************************************************************/
+
+vftbl_t *typeprofile_receiver(codeinfo *code, instruction *iptr)
+{
+	typeprofile *tp;
+	vftbl_t     *vftbl;
+	uint32_t     count;
+	uint32_t     hits;
+
+	if ((typeprofile_mutex == NULL) || (code == NULL) ||
+		typeprofile_is_check(iptr))
+		return NULL;
+
+	tp = typeprofile_find(code, iptr);
+
+	if (tp == NULL)
+		return NULL;
+
+	count = tp->count;
+	hits  = tp->hits;
+	vftbl = tp->vftbl;
+
+	if ((vftbl == NULL) || (count < TYPEPROFILE_MIN_COUNT) ||
+		((uint64_t) hits * 100 < (uint64_t) count * opt_TypeProfileThreshold))
+		return NULL;
+
+	MutexLocker lock(*typeprofile_mutex);
+
+	typeprofile_stats.receivers++;
+
+	return vftbl;
+}
+
+
+/* typeprofile_print_statistics ************************************************
+
+   Prints how polymorphic the profiled checks of the methods promoted
+   to the optimizing tier were (-XX:+PrintTieredStatistics).
+
+*******************************************************************************/
+
+void typeprofile_print_statistics(void)
+{
+	if (typeprofile_mutex == NULL)
+		return;
+
+	MutexLocker lock(*typeprofile_mutex);
+
+	typeprofile_statistics *s = &typeprofile_stats;
+
+	log_println("  type profiles: %d checks profiled", s->profiled);
+	log_println("    in promoted methods: %d never executed, %d monomorphic, %d dominated by one class, %d polymorphic",
+				s->unexecuted, s->monomorphic, s->dominant, s->polymorphic);
+	log_println("    %d checks test the profiled class first", s->guarded);
+
+	if (typeprofile_calls)
+		log_println("    %d calls profiled, %d dominated by one receiver class",
+					s->calls, s->receivers);
+}
+
+
+/*
+ * These are local overrides for various environment variables in Emacs.
+ * Please do not remove this and leave it at the end of the file, where
+ * Emacs will automagically detect them.
+ * ---------------------------------------------------------------------
+ * Local variables:
+ * mode: c++
+ * indent-tabs-mode: t
+ * c-basic-offset: 4
+ * tab-width: 4
+ * End:
+ * vim:noexpandtab:sw=4:ts=4:
+ */
@@ -0,0 +1,118 @@
+/* src/vm/jit/optimizing/typeprofile.hpp - type profiles of casts and array stores
+
+   Copyright (C) 1996-2013
+   CACAOVM - Verein zur Foerderung der freien virtuellen Maschine CACAO
+
+   This file is part of CACAO.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation; either version 2, or (at
+   your option) any later version.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA.
+
+*/
+
+
+#ifndef _TYPEPROFILE_HPP
+#define _TYPEPROFILE_HPP
+
+#include "config.h"
+
+#include <stdint.h>
+
+struct codeinfo;
+struct instruction;
+struct jitdata;
+struct vftbl_t;
+
+
+/* Type profiles **************************************************************
+
+   With -XX:+TieredCompilation the baseline tier records, for every
+   CHECKCAST, INSTANCEOF and AASTORE, the first class seen by the
+   check and how often the check saw it.  For AASTORE the class is
+   that of the stored value, together with the class of the array.
+
+   When the method is recompiled, the optimizing tier marks the checks
+   whose profile is dominated by one class (-XX:TypeProfileThreshold)
+   with INS_FLAG_PROFILED.  The code generator compares the vftbl of
+   the object with that class before the generic subtype test and
+   skips the test if they are equal.  Whether the class passes the
+   check is decided at compile time, so a stale profile only costs the
+   compare.
+
+   With -XX:+Inline and -XX:+GuardedInlining the receivers of
+   INVOKEVIRTUAL and INVOKEINTERFACE are profiled too, and the inliner
+   inlines the method of a dominating receiver class behind a check of
+   that class, see inline.cpp.
+
+   The profiles are updated without synchronization, concurrent
+   updates may lose samples.  Disabled with -XX:-TypeProfiles.
+
+*******************************************************************************/
+
+/* minimum number of profiled checks before a site is considered */
+
+#define TYPEPROFILE_MIN_COUNT    100
+
+
+/* typeprofile ****************************************************************/
+
+struct typeprofile {
+	int32_t   id;                       // instruction id of the check or call
+	uint32_t  count;                    // checks of a non-null object
+	uint32_t  hits;                     // checks of the recorded class
+	vftbl_t  *vftbl;                    // first class seen
+	vftbl_t  *arrayvftbl;               // AASTORE: array class seen with it
+};
+
+
+/* typeguard ******************************************************************/
+
+struct typeguard {
+	vftbl_t  *vftbl;                    // class tested first
+	vftbl_t  *arrayvftbl;               // AASTORE: array class tested too
+	bool      result;                   // INSTANCEOF: result for the class
+};
+
+
+/* function prototypes ********************************************************/
+
+bool         typeprofile_init(void);
+
+void         typeprofile_create(jitdata *jd);
+typeprofile *typeprofile_find(codeinfo *code, instruction *iptr);
+
+int32_t      typeprofile_select(jitdata *jd);
+bool         typeprofile_guard(jitdata *jd, instruction *iptr, typeguard *tg);
+
+vftbl_t     *typeprofile_receiver(codeinfo *code, instruction *iptr);
+
+void         typeprofile_print_statistics(void);
+
+#endif /* _TYPEPROFILE_HPP */
+
+
+/*
+ * These are local overrides for various environment variables in Emacs.
+ * Please do not remove this and leave it at the end of the file, where
+ * Emacs will automagically detect them.
+ * ---------------------------------------------------------------------
+ * Local variables:
+ * mode: c++
+ * indent-tabs-mode: t
+ * c-basic-offset: 4
+ * tab-width: 4
+ * End:
+ * vim:noexpandtab:sw=4:ts=4:
+ */
@@ -1324,6 +1324,13 @@ void show_icmd(jitdata *jd, instruction *iptr, bool deadcode, int stage)
 		SHOW_TARGET(iptr->dst);
 		break;
 
+	case ICMD_IF_CLASSNE:
+		SHOW_S1(iptr);
+		class_classref_or_classinfo_print(iptr->sx.s23.s3.c);
+		putchar(' ');
+		SHOW_TARGET(iptr->dst);
+		break;
+
 	case ICMD_IF_ICMPEQ:
 	case ICMD_IF_ICMPNE:
 	case ICMD_IF_ICMPLT:
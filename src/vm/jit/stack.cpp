@@ -1261,7 +1261,7 @@ static basicblock *stack_mark_reached(stackdata_t *sd, basicblock *b, stackeleme
 	/* mark targets of backward branches */
 
 	if (b->nr <= sd->bptr->nr)
-		b->bitflags |= BBFLAG_REPLACEMENT;
+		b->bitflags |= BBFLAG_REPLACEMENT | BBFLAG_LOOPHEADER;
 
 	if (b->state < basicblock::REACHED) {
 		/* b is reached for the first time. Create its invars. */
@@ -1311,7 +1311,7 @@ static basicblock *stack_mark_reached_from_outvars(stackdata_t *sd, basicblock *
 	/* mark targets of backward branches */
 
 	if (b->nr <= sd->bptr->nr)
-		b->bitflags |= BBFLAG_REPLACEMENT;
+		b->bitflags |= BBFLAG_REPLACEMENT | BBFLAG_LOOPHEADER;
 
 	if (b->state < basicblock::REACHED) {
 		/* b is reached for the first time. Create its invars. */
@@ -443,6 +443,122 @@ static inline bool stacktrace_stackframeinfo_end_check(stackframeinfo_t *tmpsfi)
 }
 
 
+/* stacktrace_vframe_t *********************************************************
+
+   A stackframe of code with inlined methods contains one virtual
+   frame for every inlined method active at its PC, and one for the
+   compiled method itself, which is visited last.
+
+*******************************************************************************/
+
+struct stacktrace_vframe_t {
+	stackframeinfo_t  sfi;              /* the stackframe                     */
+	int32_t           scope;            /* inlined scope, -1 for code->m      */
+	methodinfo       *m;                /* method of this virtual frame       */
+};
+
+
+/* stacktrace_vframe_set_scope *************************************************
+
+   Switch the virtual frame to the given scope of its stackframe.
+
+*******************************************************************************/
+
+static inline void stacktrace_vframe_set_scope(stacktrace_vframe_t *vf, int32_t scope)
+{
+	codeinfo *code = vf->sfi.code;
+
+	vf->scope = scope;
+	vf->m     = (scope >= 0) ? code->linenumbertable->get_scope_method(scope) : code->m;
+}
+
+/* stacktrace_vframe_enter *****************************************************
+
+   Start at the innermost method inlined at the PC of a new stackframe.
+
+*******************************************************************************/
+
+static inline void stacktrace_vframe_enter(stacktrace_vframe_t *vf)
+{
+	codeinfo *code = vf->sfi.code;
+	int32_t   scope;
+
+	vf->scope = -1;
+	vf->m     = NULL;
+
+	if ((code == NULL) || (code->linenumbertable == NULL))
+		scope = -1;
+	else
+		scope = code->linenumbertable->find_scope(vf->sfi.xpc);
+
+	if (code != NULL)
+		stacktrace_vframe_set_scope(vf, scope);
+}
+
+/* stacktrace_vframe_fill ******************************************************
+
+   Like stacktrace_stackframeinfo_fill, for virtual frames.
+
+   IN:
+       vf .... virtual frame to fill
+       sfi ... stackframeinfo where to start
+
+*******************************************************************************/
+
+static inline void stacktrace_vframe_fill(stacktrace_vframe_t *vf, stackframeinfo_t *sfi)
+{
+	stacktrace_stackframeinfo_fill(&vf->sfi, sfi);
+	stacktrace_vframe_enter(vf);
+}
+
+
+/* stacktrace_vframe_next ******************************************************
+
+   Walk to the method the current virtual frame was inlined into, or
+   to the next stackframe.
+
+   ATTENTION: This function does NOT skip builtin methods!
+
+*******************************************************************************/
+
+static inline void stacktrace_vframe_next(stacktrace_vframe_t *vf)
+{
+	if (vf->scope >= 0) {
+		stacktrace_vframe_set_scope(vf, vf->sfi.code->linenumbertable->get_parent_scope(vf->scope));
+		return;
+	}
+
+	stacktrace_stackframeinfo_next(&vf->sfi);
+	stacktrace_vframe_enter(vf);
+}
+
+
+/* stacktrace_vframe_end_check *************************************************
+
+   Check if we reached the end of the virtual frames.
+
+*******************************************************************************/
+
+static inline bool stacktrace_vframe_end_check(stacktrace_vframe_t *vf)
+{
+	return stacktrace_stackframeinfo_end_check(&vf->sfi);
+}
+
+
+/* stacktrace_vframe_linenumber ************************************************
+
+   Returns the line number of the current virtual frame.
+
+*******************************************************************************/
+
+static inline int32_t stacktrace_vframe_linenumber(stacktrace_vframe_t *vf)
+{
+	methodinfo *m = vf->m;
+
+	return vf->sfi.code->linenumbertable->find(&m, vf->sfi.xpc, vf->scope);
+}
+
+
 /* stacktrace_depth ************************************************************
 
    Calculates and returns the depth of the current stacktrace.
@@ -457,7 +573,7 @@ static inline bool stacktrace_stackframeinfo_end_check(stackframeinfo_t *tmpsfi)
 
 static int stacktrace_depth(stackframeinfo_t *sfi)
 {
-	stackframeinfo_t  tmpsfi;
+	stacktrace_vframe_t vf;
 	int               depth;
 	methodinfo       *m;
 
@@ -476,12 +592,12 @@ static int stacktrace_depth(stackframeinfo_t *sfi)
 
 	depth = 0;
 
-	for (stacktrace_stackframeinfo_fill(&tmpsfi, sfi);
-		 stacktrace_stackframeinfo_end_check(&tmpsfi) == false;
-		 stacktrace_stackframeinfo_next(&tmpsfi)) {
+	for (stacktrace_vframe_fill(&vf, sfi);
+		 stacktrace_vframe_end_check(&vf) == false;
+		 stacktrace_vframe_next(&vf)) {
 		/* Get methodinfo. */
 
-		m = tmpsfi.code->m;
+		m = vf.m;
 
 		/* Skip builtin methods. */
 
@@ -550,14 +666,14 @@ java_handle_bytearray_t *stacktrace_get(stackframeinfo_t *sfi)
 	ste = st->entries;
 
 	// Iterate over the whole stack.
-	stackframeinfo_t tmpsfi;
+	stacktrace_vframe_t vf;
 
-	for (stacktrace_stackframeinfo_fill(&tmpsfi, sfi);
-		 stacktrace_stackframeinfo_end_check(&tmpsfi) == false;
-		 stacktrace_stackframeinfo_next(&tmpsfi)) {
+	for (stacktrace_vframe_fill(&vf, sfi);
+		 stacktrace_vframe_end_check(&vf) == false;
+		 stacktrace_vframe_next(&vf)) {
 		// Get the methodinfo
 
-		methodinfo *m = tmpsfi.code->m;
+		methodinfo *m = vf.m;
 
 		// Skip builtin methods
 
@@ -597,8 +713,9 @@ java_handle_bytearray_t *stacktrace_get(stackframeinfo_t *sfi)
 
 		// Store the stacktrace entry and increment the pointer.
 
-		ste->code = tmpsfi.code;
-		ste->pc   = tmpsfi.xpc;
+		ste->code  = vf.sfi.code;
+		ste->pc    = vf.sfi.xpc;
+		ste->scope = vf.scope;
 
 		ste++;
 	}
@@ -670,6 +787,10 @@ java_handle_t* stacktrace_get_StackTraceElement(stacktrace_t* st, int32_t index)
 	// Get the codeinfo, methodinfo and classinfo.
 	codeinfo*   code = ste->code;
 	methodinfo* m    = code->m;
+
+	// Get line number (and the inlined method, if any).
+	int32_t linenumber = code->linenumbertable->find(&m, ste->pc, ste->scope);
+
 	classinfo*  c    = m->clazz;
 
 	// Get filename.
@@ -684,9 +805,6 @@ java_handle_t* stacktrace_get_StackTraceElement(stacktrace_t* st, int32_t index)
 	else
 		filename = NULL;
 
-	// Get line number.
-	int32_t linenumber;
-
 	if (m->flags & ACC_NATIVE) {
 #if defined(WITH_JAVA_RUNTIME_LIBRARY_GNU_CLASSPATH)
 		linenumber = -1;
@@ -696,12 +814,8 @@ java_handle_t* stacktrace_get_StackTraceElement(stacktrace_t* st, int32_t index)
 # error unknown classpath configuration
 #endif
 	}
-	else {
-		// FIXME linenumbertable->find could change the methodinfo
-		// pointer when hitting an inlined method.
-		linenumber = code->linenumbertable->find(&m, ste->pc);
+	else
 		linenumber = (linenumber == 0) ? -1 : linenumber;
-	}
 
 	// Get declaring class name.
 	java_handle_t* declaringclass = JavaString(class_get_classname(c)).intern();
@@ -784,7 +898,7 @@ java_handle_objectarray_t* stacktrace_get_StackTraceElements(stacktrace_t* st)
 classinfo *stacktrace_get_caller_class(int depth)
 {
 	stackframeinfo_t *sfi;
-	stackframeinfo_t  tmpsfi;
+	stacktrace_vframe_t vf;
 	methodinfo       *m;
 	classinfo        *c;
 	int               i;
@@ -803,11 +917,11 @@ classinfo *stacktrace_get_caller_class(int depth)
 
 	i = 0;
 
-	for (stacktrace_stackframeinfo_fill(&tmpsfi, sfi);
-		 stacktrace_stackframeinfo_end_check(&tmpsfi) == false;
-		 stacktrace_stackframeinfo_next(&tmpsfi)) {
+	for (stacktrace_vframe_fill(&vf, sfi);
+		 stacktrace_vframe_end_check(&vf) == false;
+		 stacktrace_vframe_next(&vf)) {
 
-		m = tmpsfi.code->m;
+		m = vf.m;
 		c = m->clazz;
 
 		/* Skip builtin methods. */
@@ -851,7 +965,7 @@ classinfo *stacktrace_get_caller_class(int depth)
 classloader_t* stacktrace_first_nonnull_classloader(void)
 {
 	stackframeinfo_t *sfi;
-	stackframeinfo_t  tmpsfi;
+	stacktrace_vframe_t vf;
 	methodinfo       *m;
 	classloader_t    *cl;
 
@@ -866,11 +980,11 @@ classloader_t* stacktrace_first_nonnull_classloader(void)
 
 	/* Iterate over the whole stack. */
 
-	for (stacktrace_stackframeinfo_fill(&tmpsfi, sfi);
-		 stacktrace_stackframeinfo_end_check(&tmpsfi) == false;
-		 stacktrace_stackframeinfo_next(&tmpsfi)) {
+	for (stacktrace_vframe_fill(&vf, sfi);
+		 stacktrace_vframe_end_check(&vf) == false;
+		 stacktrace_vframe_next(&vf)) {
 
-		m  = tmpsfi.code->m;
+		m  = vf.m;
 		cl = class_get_classloader(m->clazz);
 
 #if defined(WITH_JAVA_RUNTIME_LIBRARY_OPENJDK)
@@ -926,7 +1040,7 @@ static bool is_ancestor_of(classloader_t* loader, classloader_t* parent)
 classloader_t* stacktrace_first_nonsystem_classloader(void)
 {
 	stackframeinfo_t *sfi;
-	stackframeinfo_t  tmpsfi;
+	stacktrace_vframe_t vf;
 	methodinfo       *m;
 	classloader_t    *cl;
 	classloader_t    *syscl;
@@ -943,11 +1057,11 @@ classloader_t* stacktrace_first_nonsystem_classloader(void)
 	syscl = java_lang_ClassLoader::invoke_getSystemClassLoader();
 
 	// Iterate over the whole stack.
-	for (stacktrace_stackframeinfo_fill(&tmpsfi, sfi);
-		 stacktrace_stackframeinfo_end_check(&tmpsfi) == false;
-		 stacktrace_stackframeinfo_next(&tmpsfi)) {
+	for (stacktrace_vframe_fill(&vf, sfi);
+		 stacktrace_vframe_end_check(&vf) == false;
+		 stacktrace_vframe_next(&vf)) {
 
-		m  = tmpsfi.code->m;
+		m  = vf.m;
 		cl = class_get_classloader(m->clazz);
 
 		if (cl == NULL)
@@ -978,7 +1092,7 @@ classloader_t* stacktrace_first_nonsystem_classloader(void)
 java_handle_objectarray_t *stacktrace_getClassContext(void)
 {
 	stackframeinfo_t           *sfi;
-	stackframeinfo_t            tmpsfi;
+	stacktrace_vframe_t         vf;
 	int                         depth;
 	int                         i;
 	methodinfo                 *m;
@@ -1001,8 +1115,8 @@ java_handle_objectarray_t *stacktrace_getClassContext(void)
 	   entry. */
 
 	depth--;
-	stacktrace_stackframeinfo_fill(&tmpsfi, sfi);
-	stacktrace_stackframeinfo_next(&tmpsfi);
+	stacktrace_vframe_fill(&vf, sfi);
+	stacktrace_vframe_next(&vf);
 
 	/* Allocate the Class array. */
 
@@ -1020,11 +1134,11 @@ java_handle_objectarray_t *stacktrace_getClassContext(void)
 	i = 0;
 
 	for (;
-		 stacktrace_stackframeinfo_end_check(&tmpsfi) == false;
-		 stacktrace_stackframeinfo_next(&tmpsfi)) {
+		 stacktrace_vframe_end_check(&vf) == false;
+		 stacktrace_vframe_next(&vf)) {
 		/* Get methodinfo. */
 
-		m = tmpsfi.code->m;
+		m = vf.m;
 
 		/* Skip builtin methods. */
 
@@ -1067,7 +1181,7 @@ java_handle_objectarray_t *stacktrace_getClassContext(void)
 classinfo *stacktrace_get_current_class(void)
 {
 	stackframeinfo_t *sfi;
-	stackframeinfo_t  tmpsfi;
+	stacktrace_vframe_t vf;
 	methodinfo       *m;
 
 	CYCLES_STATS_DECLARE_AND_START;
@@ -1092,12 +1206,12 @@ classinfo *stacktrace_get_current_class(void)
 
 	/* Iterate over the whole stack. */
 
-	for (stacktrace_stackframeinfo_fill(&tmpsfi, sfi);
-		 stacktrace_stackframeinfo_end_check(&tmpsfi) == false;
-		 stacktrace_stackframeinfo_next(&tmpsfi)) {
+	for (stacktrace_vframe_fill(&vf, sfi);
+		 stacktrace_vframe_end_check(&vf) == false;
+		 stacktrace_vframe_next(&vf)) {
 		/* Get the methodinfo. */
 
-		m = tmpsfi.code->m;
+		m = vf.m;
 
 		if (m->clazz == class_java_security_PrivilegedAction) {
 			CYCLES_STATS_END(stacktrace_getCurrentClass);
@@ -1135,7 +1249,7 @@ classinfo *stacktrace_get_current_class(void)
 java_handle_objectarray_t *stacktrace_get_stack(void)
 {
 	stackframeinfo_t *sfi;
-	stackframeinfo_t  tmpsfi;
+	stacktrace_vframe_t vf;
 	int               depth;
 	methodinfo       *m;
 	java_handle_t    *string;
@@ -1185,12 +1299,12 @@ java_handle_objectarray_t *stacktrace_get_stack(void)
 
 	i = 0;
 
-	for (stacktrace_stackframeinfo_fill(&tmpsfi, sfi);
-		 stacktrace_stackframeinfo_end_check(&tmpsfi) == false;
-		 stacktrace_stackframeinfo_next(&tmpsfi)) {
+	for (stacktrace_vframe_fill(&vf, sfi);
+		 stacktrace_vframe_end_check(&vf) == false;
+		 stacktrace_vframe_next(&vf)) {
 		/* Get the methodinfo. */
 
-		m = tmpsfi.code->m;
+		m = vf.m;
 
 		/* Skip builtin methods. */
 
@@ -1297,7 +1411,7 @@ void stacktrace_print(stacktrace_t *st)
 
 		/* Get the line number. */
 
-		linenumber = ste->code->linenumbertable->find(&m, ste->pc);
+		linenumber = ste->code->linenumbertable->find(&m, ste->pc, ste->scope);
 
 		stacktrace_print_entry(m, linenumber);
 	}
@@ -1316,9 +1430,7 @@ void stacktrace_print(stacktrace_t *st)
 void stacktrace_print_current(void)
 {
 	stackframeinfo_t *sfi;
-	stackframeinfo_t  tmpsfi;
-	codeinfo         *code;
-	methodinfo       *m;
+	stacktrace_vframe_t vf;
 	int32_t           linenumber;
 
 	sfi = threads_get_current_stackframeinfo();
@@ -1329,18 +1441,13 @@ void stacktrace_print_current(void)
 		return;
 	}
 
-	for (stacktrace_stackframeinfo_fill(&tmpsfi, sfi);
-		 stacktrace_stackframeinfo_end_check(&tmpsfi) == false;
-		 stacktrace_stackframeinfo_next(&tmpsfi)) {
-		/* Get the methodinfo. */
-
-		code = tmpsfi.code;
-		m    = code->m;
-
+	for (stacktrace_vframe_fill(&vf, sfi);
+		 stacktrace_vframe_end_check(&vf) == false;
+		 stacktrace_vframe_next(&vf)) {
 		// Get the line number.
-		linenumber = code->linenumbertable->find(&m, tmpsfi.xpc);
+		linenumber = stacktrace_vframe_linenumber(&vf);
 
-		stacktrace_print_entry(m, linenumber);
+		stacktrace_print_entry(vf.m, linenumber);
 	}
 }
 
@@ -1388,9 +1495,7 @@ stacktrace_t* stacktrace_get_of_thread(threadobject* t)
 void stacktrace_print_of_thread(threadobject *t)
 {
 	stackframeinfo_t *sfi;
-	stackframeinfo_t  tmpsfi;
-	codeinfo         *code;
-	methodinfo       *m;
+	stacktrace_vframe_t vf;
 	int32_t           linenumber;
 
 	/* Build a stacktrace for the passed thread. */
@@ -1403,18 +1508,13 @@ void stacktrace_print_of_thread(threadobject *t)
 		return;
 	}
 
-	for (stacktrace_stackframeinfo_fill(&tmpsfi, sfi);
-		 stacktrace_stackframeinfo_end_check(&tmpsfi) == false;
-		 stacktrace_stackframeinfo_next(&tmpsfi)) {
-		/* Get the methodinfo. */
-
-		code = tmpsfi.code;
-		m    = code->m;
-
+	for (stacktrace_vframe_fill(&vf, sfi);
+		 stacktrace_vframe_end_check(&vf) == false;
+		 stacktrace_vframe_next(&vf)) {
 		// Get the line number.
-		linenumber = code->linenumbertable->find(&m, tmpsfi.xpc);
+		linenumber = stacktrace_vframe_linenumber(&vf);
 
-		stacktrace_print_entry(m, linenumber);
+		stacktrace_print_entry(vf.m, linenumber);
 	}
 }
 
@@ -67,6 +67,7 @@ struct stackframeinfo_t {
 struct stacktrace_entry_t {
 	codeinfo *code;                     /* codeinfo pointer of this method    */
 	void     *pc;                       /* PC in this method                  */
+	int32_t   scope;                    /* inlined method, -1 for code->m     */
 };
 
 
@@ -33,21 +33,33 @@
 #include "md.hpp"
 #include "md-trap.hpp"
 
+#include "mm/gc.hpp"
 #include "mm/memory.hpp"
 
 #include "native/llni.hpp"
+#include "native/native.hpp"
+
+#include "threads/atomic.hpp"
 
 #include "toolbox/logging.hpp"
 
+#include "vm/array.hpp"
+#include "vm/class.hpp"
 #include "vm/exceptions.hpp"
+#include "vm/javaobjects.hpp"
+#include "vm/loader.hpp"
+#include "vm/method.hpp"
 #include "vm/options.hpp"
 #include "vm/os.hpp"
+#include "vm/statistics.hpp"
+#include "vm/utf8.hpp"
 #include "vm/vm.hpp"
 
 #include "vm/jit/code.hpp"
 #include "vm/jit/disass.hpp"
 #include "vm/jit/executionstate.hpp"
 #include "vm/jit/jit.hpp"
+#include "vm/jit/linenumbertable.hpp"
 #include "vm/jit/methodtree.hpp"
 #include "vm/jit/patcher-common.hpp"
 #include "vm/jit/replace.hpp"
@@ -60,6 +72,49 @@
 #define N_PV_OFFSET 0
 #endif
 
+using namespace cacao;
+
+
+STAT_REGISTER_VAR(int,count_trap_preallocated,0,"preallocated implicit exceptions","implicit exceptions thrown preallocated")
+
+
+/**
+ * The implicit exception types counted per trap site, each with its
+ * own preallocated exception.
+ */
+enum {
+	TRAP_PREALLOCATED_NPE,
+	TRAP_PREALLOCATED_ARITHMETIC,
+	TRAP_PREALLOCATED_AIOOBE,
+	TRAP_PREALLOCATED_COUNT
+};
+
+/**
+ * Implicit exceptions thrown at one trap instruction.  A slot is
+ * claimed by setting its xpc with compare-and-swap, the other fields
+ * are written without a lock: they only feed a heuristic and the
+ * statistics.
+ */
+struct trapsite_t {
+	void       *xpc;        ///< Trap instruction, NULL if the slot is free.
+	codeinfo   *code;       ///< Code containing the trap, only compared.
+	methodinfo *m;          ///< Method (possibly inlined) of the trap.
+	int32_t     linenumber;
+	int32_t     count;      ///< Exceptions thrown here.
+};
+
+#define TRAPSITE_SLOTS     1024     ///< Per type, must be a power of two.
+#define TRAPSITE_PROBES    8        ///< Slots tried before giving up.
+
+static trapsite_t *trapsites = NULL;
+
+/**
+ * The preallocated exceptions, one per implicit exception type.  The
+ * array is a GC root.
+ */
+static java_object_t **trap_preallocated = NULL;
+
+
 /**
  * Mmap the first memory page to support hardware exceptions and check
  * the maximum hardware trap displacement on the architectures where
@@ -87,6 +142,248 @@ void trap_init(void)
 	if (TRAP_END > OFFSET(java_bytearray_t, data))
 		vm_abort("trap_init: maximum hardware trap displacement is greater than the array-data offset: %d > %d", TRAP_END, OFFSET(java_bytearray_t, data));
 #endif
+
+	if (opt_ImplicitExceptionThreshold < 0)
+		opt_ImplicitExceptionThreshold = 0;
+
+	if (opt_ImplicitExceptionThreshold > 0 || opt_PrintImplicitExceptionStatistics)
+		trapsites = MNEW(trapsite_t, TRAP_PREALLOCATED_COUNT * TRAPSITE_SLOTS);
+
+	if (opt_ImplicitExceptionThreshold > 0) {
+		trap_preallocated = (java_object_t **) heap_alloc_uncollectable(sizeof(java_object_t *) * TRAP_PREALLOCATED_COUNT);
+
+		for (int i = 0; i < TRAP_PREALLOCATED_COUNT; i++) {
+			trap_preallocated[i] = NULL;
+
+#if defined(ENABLE_GC_CACAO)
+			gc_reference_register(&(trap_preallocated[i]), GC_REFTYPE_JNI_GLOBALREF);
+#endif
+		}
+	}
+}
+
+
+/**
+ * Returns the preallocated exception of the given kind, creating it
+ * on first use.  It has no message and its stack trace is replaced by
+ * an empty one, as it is shared by all trap sites.
+ *
+ * @param kind TRAP_PREALLOCATED_NPE, ...
+ * @return the exception, NULL if it could not be created
+ */
+static java_handle_t *trap_get_preallocated(int kind)
+{
+	java_object_t *o = trap_preallocated[kind];
+
+	if (o != NULL)
+		return LLNI_WRAP(o);
+
+	Utf8String name;
+
+	switch (kind) {
+	case TRAP_PREALLOCATED_NPE:
+		name = utf8::java_lang_NullPointerException;
+		break;
+	case TRAP_PREALLOCATED_ARITHMETIC:
+		name = utf8::java_lang_ArithmeticException;
+		break;
+	default:
+		name = utf8::java_lang_ArrayIndexOutOfBoundsException;
+		break;
+	}
+
+	// Only an exception created here is cached, a failure leaves its
+	// own exception pending and the trap creates a new one.
+
+	classinfo *c = load_class_bootstrap(name);
+
+	if (c == NULL)
+		return NULL;
+
+	java_handle_t *h = native_new_and_init(c);
+
+	if (h == NULL)
+		return NULL;
+
+	// An empty stacktrace_t is all zeros.
+
+	ByteArray ba(sizeof(stacktrace_t));
+
+	if (ba.is_null())
+		return NULL;
+
+#if defined(WITH_JAVA_RUNTIME_LIBRARY_GNU_CLASSPATH)
+	java_lang_Throwable   jlt(h);
+	java_lang_VMThrowable vmt(jlt.get_vmState());
+
+	if (vmt.is_null())
+		return NULL;
+
+	vmt.set_vmdata(ba.get_handle());
+#elif defined(WITH_JAVA_RUNTIME_LIBRARY_OPENJDK)
+	java_lang_Throwable jlt(h, ba.get_handle());
+#else
+	// Only GNU Classpath and OpenJDK keep the backtrace where we can
+	// replace it.
+	return NULL;
+#endif
+
+	LLNI_CRITICAL_START;
+
+	o = LLNI_DIRECT(h);
+
+	// Another thread may have won the race, use its exception then.
+
+	java_object_t *old = Atomic::compare_and_swap(&trap_preallocated[kind], (java_object_t *) NULL, o);
+
+	if (old != NULL)
+		o = old;
+
+	LLNI_CRITICAL_END;
+
+	return LLNI_WRAP(o);
+}
+
+
+/**
+ * Returns the slot of a trap site, claiming a free one for a new
+ * site.
+ *
+ * @param kind TRAP_PREALLOCATED_NPE, ...
+ * @param xpc  exception PC
+ * @return the slot, NULL if the probed slots all belong to other sites
+ */
+static trapsite_t *trap_find_site(int kind, void *xpc)
+{
+	trapsite_t *slots = trapsites + kind * TRAPSITE_SLOTS;
+	uintptr_t   h     = (uintptr_t) xpc;
+
+	h ^= h >> 12;
+
+	for (int i = 0; i < TRAPSITE_PROBES; i++) {
+		trapsite_t *site = &slots[(h + i) & (TRAPSITE_SLOTS - 1)];
+		void       *x    = site->xpc;
+
+		if (x == NULL)
+			x = Atomic::compare_and_swap(&site->xpc, (void *) NULL, xpc);
+
+		if (x == NULL || x == xpc)
+			return site;
+	}
+
+	return NULL;
+}
+
+
+/**
+ * Counts an implicit exception thrown at a trap site and returns the
+ * preallocated exception to throw instead of a new one once the site
+ * threw -XX:ImplicitExceptionThreshold times.
+ *
+ * @param type trap type
+ * @param xpc  exception PC
+ * @param code code containing the trap
+ * @return the preallocated exception, or NULL to create a new one
+ */
+static java_handle_t *trap_implicit_exception(int type, void *xpc, codeinfo *code)
+{
+	if (trapsites == NULL)
+		return NULL;
+
+	int kind;
+
+	switch (type) {
+	case TRAP_NullPointerException:
+		kind = TRAP_PREALLOCATED_NPE;
+		break;
+	case TRAP_ArithmeticException:
+		kind = TRAP_PREALLOCATED_ARITHMETIC;
+		break;
+	default:
+		kind = TRAP_PREALLOCATED_AIOOBE;
+		break;
+	}
+
+	trapsite_t *site = trap_find_site(kind, xpc);
+
+	if (site == NULL)
+		return NULL;
+
+	// The code at this address may have been freed and replaced.
+
+	if (site->code != code) {
+		methodinfo *m          = (code != NULL) ? code->m : NULL;
+		int32_t     linenumber = 0;
+
+		if (code != NULL && code->linenumbertable != NULL)
+			linenumber = code->linenumbertable->find(&m, xpc);
+
+		site->m          = m;
+		site->linenumber = linenumber;
+		site->count      = 0;
+		site->code       = code;
+	}
+
+	int32_t count;
+
+	do {
+		count = site->count;
+	} while (Atomic::compare_and_swap(&site->count, count, count + 1) != count);
+
+	count++;
+
+	if (opt_ImplicitExceptionThreshold == 0 || count <= opt_ImplicitExceptionThreshold)
+		return NULL;
+
+	java_handle_t *h = trap_get_preallocated(kind);
+
+	if (h != NULL)
+		STATISTICS(count_trap_preallocated++);
+
+	return h;
+}
+
+
+/**
+ * Prints the implicit exceptions thrown per trap site, for
+ * -XX:+PrintImplicitExceptionStatistics.
+ */
+void trap_print_statistics(void)
+{
+	static const char *names[TRAP_PREALLOCATED_COUNT] = {
+		"NullPointerException",
+		"ArithmeticException",
+		"ArrayIndexOutOfBoundsException"
+	};
+
+	if (trapsites == NULL)
+		return;
+
+	log_println("Implicit exceptions per trap site (threshold %d):", opt_ImplicitExceptionThreshold);
+
+	for (int kind = 0; kind < TRAP_PREALLOCATED_COUNT; kind++) {
+		for (int i = 0; i < TRAPSITE_SLOTS; i++) {
+			trapsite_t& site = trapsites[kind * TRAPSITE_SLOTS + i];
+			const char *name = names[kind];
+
+			if (site.xpc == NULL || site.count == 0)
+				continue;
+
+			bool preallocated = (opt_ImplicitExceptionThreshold > 0) && (site.count > opt_ImplicitExceptionThreshold);
+
+			if (site.m == NULL) {
+				log_println("  %p: %d %s%s", site.xpc, site.count, name, preallocated ? " (preallocated)" : "");
+				continue;
+			}
+
+			log_println("  %p: %d %s%s in %.*s.%.*s%.*s:%d",
+						site.xpc, site.count, name, preallocated ? " (preallocated)" : "",
+						(int) site.m->clazz->name.size(), site.m->clazz->name.begin(),
+						(int) site.m->name.size(), site.m->name.begin(),
+						(int) site.m->descriptor.size(), site.m->descriptor.begin(),
+						site.linenumber);
+		}
+	}
 }
 
 
@@ -230,15 +527,21 @@ void trap_handle(int sig, void *xpc, void *context)
 
 	switch (type) {
 	case TRAP_NullPointerException:
-		p = exceptions_new_nullpointerexception();
+		p = trap_implicit_exception(type, xpc, sfi.code);
+		if (p == NULL)
+			p = exceptions_new_nullpointerexception();
 		break;
 
 	case TRAP_ArithmeticException:
-		p = exceptions_new_arithmeticexception();
+		p = trap_implicit_exception(type, xpc, sfi.code);
+		if (p == NULL)
+			p = exceptions_new_arithmeticexception();
 		break;
 
 	case TRAP_ArrayIndexOutOfBoundsException:
-		p = exceptions_new_arrayindexoutofboundsexception(index);
+		p = trap_implicit_exception(type, xpc, sfi.code);
+		if (p == NULL)
+			p = exceptions_new_arrayindexoutofboundsexception(index);
 		break;
 
 	case TRAP_ArrayStoreException:
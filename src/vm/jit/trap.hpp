@@ -69,6 +69,8 @@ void trap_init(void);
 
 void trap_handle(int sig, void* xpc, void* context);
 
+void trap_print_statistics(void);
+
 bool md_trap_decode(trapinfo_t* trp, int sig, void* xpc, executionstate_t* es);
 
 #endif // TRAP_HPP_
@@ -120,6 +120,16 @@
 
 #define USES_NEW_SUBTYPE                 1
 
+/* tiered compilation *********************************************************/
+
+#define SUPPORT_TIERED_COUNTERS          1
+#define SUPPORT_TYPE_PROFILES            1
+#define SUPPORT_GUARDED_INLINING         1
+
+/* register allocation ********************************************************/
+
+#define SUPPORT_LINEARSCAN               1
+
 /* memory barriers ************************************************************/
 
 #define CAS_PROVIDES_FULL_BARRIER        1
@@ -69,6 +69,8 @@
 #include "vm/jit/stacktrace.hpp"
 #include "vm/jit/trap.hpp"
 
+#include "vm/jit/optimizing/typeprofile.hpp"
+
 
 /**
  * Generates machine code for the method prolog.
@@ -222,6 +224,18 @@ static void codegen_fixup_alignment(codegendata *cd, patchref_t *pr, u1 *mcodept
 	cd->mcodeptr = codeptr + disp;
 }
 
+/**
+ * Returns the class a type check tests first, see typeprofile.hpp.
+ */
+static inline bool codegen_typeguard(jitdata* jd, instruction* iptr, typeguard* tg)
+{
+#if defined(ENABLE_THREADS) && SUPPORT_TYPE_PROFILES
+	return typeprofile_guard(jd, iptr, tg);
+#else
+	return false;
+#endif
+}
+
 /**
  * Generates machine code for one ICMD.
  */
@@ -239,6 +253,8 @@ void codegen_emit_instruction(jitdata* jd, instruction* iptr)
 	int32_t             s1, s2, s3, d;
 	int32_t             disp;
 	u1*                 mcodeptr_save = NULL;
+	typeguard           tg;             // Profiled class of a type check.
+	bool                guarded;
 
 	// Get required compiler data.
 	codegendata*  cd = jd->cd;
@@ -1438,12 +1454,34 @@ void codegen_emit_instruction(jitdata* jd, instruction* iptr)
 			emit_arrayindexoutofbounds_check(cd, iptr, s1, s2);
 			s3 = emit_load_s3(jd, iptr, REG_ITMP3);
 
+			/* test the classes seen by the baseline code first, the
+			   index is reloaded for the store */
+
+			guarded = codegen_typeguard(jd, iptr, &tg);
+
+			if (guarded) {
+				M_TEST(s3);
+				emit_label_beq(cd, BRANCH_LABEL_1);
+				M_MOV_IMM(tg.vftbl, REG_ITMP2);
+				M_LCMP_MEMBASE(s3, OFFSET(java_object_t, vftbl), REG_ITMP2);
+				emit_label_bne(cd, BRANCH_LABEL_2);
+				M_MOV_IMM(tg.arrayvftbl, REG_ITMP2);
+				M_LCMP_MEMBASE(s1, OFFSET(java_object_t, vftbl), REG_ITMP2);
+				emit_label_beq(cd, BRANCH_LABEL_3);
+				emit_label(cd, BRANCH_LABEL_2);
+			}
+
 			M_MOV(s1, REG_A0);
 			M_MOV(s3, REG_A1);
 			M_MOV_IMM(BUILTIN_FAST_canstore, REG_ITMP1);
 			M_CALL(REG_ITMP1);
 			emit_arraystore_check(cd, iptr);
 
+			if (guarded) {
+				emit_label(cd, BRANCH_LABEL_1);
+				emit_label(cd, BRANCH_LABEL_3);
+			}
+
 			s1 = emit_load_s1(jd, iptr, REG_ITMP1);
 			s2 = emit_load_s2(jd, iptr, REG_ITMP2);
 			s3 = emit_load_s3(jd, iptr, REG_ITMP3);
@@ -1909,6 +1947,18 @@ void codegen_emit_instruction(jitdata* jd, instruction* iptr)
 
 				s1 = emit_load_s1(jd, iptr, REG_ITMP1);
 
+				/* test the class seen by the baseline code first */
+
+				guarded = codegen_typeguard(jd, iptr, &tg);
+
+				if (guarded) {
+					M_TEST(s1);
+					emit_label_beq(cd, BRANCH_LABEL_11);
+					M_MOV_IMM(tg.vftbl, REG_ITMP3);
+					M_LCMP_MEMBASE(s1, OFFSET(java_object_t, vftbl), REG_ITMP3);
+					emit_label_beq(cd, BRANCH_LABEL_12);
+				}
+
 				/* if class is not resolved, check which code to call */
 
 				if (super == NULL) {
@@ -2029,12 +2079,30 @@ void codegen_emit_instruction(jitdata* jd, instruction* iptr)
 					emit_label(cd, BRANCH_LABEL_4);
 				}
 
+				if (guarded) {
+					emit_label(cd, BRANCH_LABEL_11);
+					emit_label(cd, BRANCH_LABEL_12);
+				}
+
 				d = codegen_reg_of_dst(jd, iptr, REG_ITMP3);
 			}
 			else {
 				/* array type cast-check */
 
 				s1 = emit_load_s1(jd, iptr, REG_ITMP2);
+
+				/* test the class seen by the baseline code first */
+
+				guarded = codegen_typeguard(jd, iptr, &tg);
+
+				if (guarded) {
+					M_TEST(s1);
+					emit_label_beq(cd, BRANCH_LABEL_11);
+					M_MOV_IMM(tg.vftbl, REG_ITMP3);
+					M_LCMP_MEMBASE(s1, OFFSET(java_object_t, vftbl), REG_ITMP3);
+					emit_label_beq(cd, BRANCH_LABEL_12);
+				}
+
 				M_INTMOVE(s1, REG_A0);
 
 				if (INSTRUCTION_IS_UNRESOLVED(iptr)) {
@@ -2058,6 +2126,11 @@ void codegen_emit_instruction(jitdata* jd, instruction* iptr)
 				M_TEST(REG_RESULT);
 				emit_classcast_check(cd, iptr, BRANCH_EQ, REG_RESULT, s1);
 
+				if (guarded) {
+					emit_label(cd, BRANCH_LABEL_11);
+					emit_label(cd, BRANCH_LABEL_12);
+				}
+
 				d = codegen_reg_of_dst(jd, iptr, REG_ITMP2);
 			}
 
@@ -2090,6 +2163,23 @@ void codegen_emit_instruction(jitdata* jd, instruction* iptr)
 
 			M_CLR(d);
 
+			/* test the class seen by the baseline code first, its
+			   result is known */
+
+			guarded = codegen_typeguard(jd, iptr, &tg);
+
+			if (guarded) {
+				M_TEST(s1);
+				emit_label_beq(cd, BRANCH_LABEL_11);
+				M_MOV_IMM(tg.vftbl, REG_ITMP3);
+				M_LCMP_MEMBASE(s1, OFFSET(java_object_t, vftbl), REG_ITMP3);
+				emit_label_bne(cd, BRANCH_LABEL_12);
+				if (tg.result)
+					M_LINC(d);
+				emit_label_br(cd, BRANCH_LABEL_13);
+				emit_label(cd, BRANCH_LABEL_12);
+			}
+
 			/* if class is not resolved, check which code to call */
 
 			if (super == NULL) {
@@ -2224,10 +2314,34 @@ void codegen_emit_instruction(jitdata* jd, instruction* iptr)
 				emit_label(cd, BRANCH_LABEL_4);
 			}
 
+			if (guarded) {
+				emit_label(cd, BRANCH_LABEL_11);
+				emit_label(cd, BRANCH_LABEL_13);
+			}
+
   			emit_store_dst(jd, iptr, d);
 			}
 			break;
 
+		case ICMD_IF_CLASSNE: /* ..., objectref ==> ...                       */
+
+			/* receiver check of an inlined call, misses are counted for
+			   the tiered compilation thread */
+
+			s1 = emit_load_s1(jd, iptr, REG_ITMP1);
+			M_TEST(s1);
+			emit_label_beq(cd, BRANCH_LABEL_1);
+			M_MOV_IMM(iptr->sx.s23.s3.c.cls->vftbl, REG_ITMP3);
+			M_LCMP_MEMBASE(s1, OFFSET(java_object_t, vftbl), REG_ITMP3);
+			emit_label_beq(cd, BRANCH_LABEL_2);
+			emit_label(cd, BRANCH_LABEL_1);
+#if defined(ENABLE_THREADS)
+			emit_tier_counter(cd, &(jd->code->guardmisses));
+#endif
+			emit_br(cd, iptr->dst.block);
+			emit_label(cd, BRANCH_LABEL_2);
+			break;
+
 		case ICMD_MULTIANEWARRAY:/* ..., cnt1, [cnt2, ...] ==> ..., arrayref  */
 
 			/* check for negative sizes and copy sizes to stack if necessary  */
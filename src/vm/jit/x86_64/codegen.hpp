@@ -134,6 +134,7 @@
 
 #define M_ILD(a,b,disp)         emit_movl_membase_reg(cd, (b), (disp), (a))
 #define M_LLD(a,b,disp)         emit_mov_membase_reg(cd, (b), (disp), (a))
+#define M_BLDU(a,b,disp)        emit_movzbq_membase_reg(cd, (b), (disp), (a))
 
 #define M_ILD32(a,b,disp)       emit_movl_membase32_reg(cd, (b), (disp), (a))
 #define M_LLD32(a,b,disp)       emit_mov_membase32_reg(cd, (b), (disp), (a))
@@ -182,6 +183,7 @@
 #define M_ALD_DSEG(a,disp)      M_ALD(a,RIP,disp)
 
 #define M_ALD_MEM(a,disp)       emit_mov_mem_reg(cd, (disp), (a))
+#define M_ALD_TLS(a,disp)       emit_mov_fs_mem_reg(cd, (disp), (a))
 
 #define M_ALD_MEM_GET_OPC(p)     (  *(        (p) + 1))
 #define M_ALD_MEM_GET_MOD(p)     (((*(        (p) + 2)) >> 6) & 0x03)
@@ -203,6 +205,9 @@
 
 #define M_AADD_IMM32(a,b)       M_LADD_IMM32(a,b)
 
+#define M_LADD_IMM_MEMBASE(a,b,c) emit_alu_imm_membase(cd, ALU_ADD, (a), (b), (c))
+#define M_LSUB_IMM_MEMBASE(a,b,c) emit_alu_imm_membase(cd, ALU_SUB, (a), (b), (c))
+
 #define M_ILEA(a,b,c)           emit_leal_membase_reg(cd, (a), (b), (c))
 #define M_LLEA(a,b,c)           emit_lea_membase_reg(cd, (a), (b), (c))
 #define M_ALEA(a,b,c)           M_LLEA(a,b,c)
@@ -342,7 +347,11 @@
 #define M_MFENCE                emit_mfence(cd)
 #define M_RDTSC                 emit_rdtsc(cd)
 
+#define M_ICMPXCHG(a,b,disp)    emit_lock_cmpxchgl_reg_membase(cd, (a), (b), (disp))
+#define M_LCMPXCHG(a,b,disp)    emit_lock_cmpxchg_reg_membase(cd, (a), (b), (disp))
+
 #define M_IINC_MEMBASE(a,b)     emit_incl_membase(cd, (a), (b))
+#define M_LOCK_IINC_MEMBASE(a,b) emit_lock_incl_membase(cd, (a), (b))
 #define M_LINC_MEMBASE(a,b)     emit_incq_membase(cd, (a), (b))
 
 #define M_IADD_MEMBASE(a,b,c)   emit_alul_reg_membase(cd, ALU_ADD, (a), (b), (c))
@@ -37,9 +37,12 @@
 #include "mm/memory.hpp"
 
 #include "threads/lock.hpp"
+#include "threads/lockword.hpp"
+#include "threads/thread.hpp"
 
 #include "vm/descriptor.hpp"            // for typedesc, methoddesc, etc
 #include "vm/options.hpp"
+#include "vm/statistics.hpp"
 
 #include "vm/jit/abi.hpp"
 #include "vm/jit/abi-asm.hpp"
@@ -57,6 +60,8 @@
 
 #include "vm/jit/ir/instruction.hpp"
 
+#include "vm/jit/optimizing/typeprofile.hpp"
+
 
 /* emit_load *******************************************************************
 
@@ -482,6 +487,218 @@ uint32_t emit_trap(codegendata *cd)
 }
 
 
+#if defined(ENABLE_THREADS) && defined(THREAD_CURRENT_STATIC_TLS)
+
+STAT_DECLARE_VAR(int,count_lock_reserved_enter,0)
+
+
+/**
+ * Returns the offset of thread_current from the thread pointer.  The
+ * variable lives in static TLS, so the offset is the same in every
+ * thread.
+ */
+static int32_t emit_thread_current_offset(void)
+{
+	uintptr_t tp;
+
+	__asm__ ("movq %%fs:0, %0" : "=r" (tp));
+
+	return (int32_t) ((uintptr_t) &thread_current - tp);
+}
+
+
+/**
+ * Sets or clears reservation_critical of the current thread, see
+ * lock_reservation_enter.  Uses REG_ITMP3.
+ */
+static void emit_reservation_critical(codegendata* cd, int value)
+{
+	M_ALD_TLS(REG_ITMP3, emit_thread_current_offset());
+	M_IST_IMM(value, REG_ITMP3, OFFSET(threadobject, reservation_critical));
+}
+
+
+/**
+ * Emits the thin lock cases of lock_monitor_enter for the object in
+ * s1: a CAS on an unlocked lockword, or incrementing the recursion
+ * count of a thin lock the current thread holds.  With
+ * -XX:+LockReservation an object reserved for the current thread is
+ * entered with a plain increment first, and a reservable one is
+ * reserved.  Sets d, which must be REG_ITMP1, to non-zero on success
+ * and to zero if the slow-path has to take over (null, contended, fat
+ * or count overflow).  Uses REG_ITMP3.
+ */
+static void emit_thinlock_enter(codegendata* cd, int s1, int d)
+{
+	assert(d == REG_ITMP1);
+	assert(s1 != REG_ITMP1 && s1 != REG_ITMP3);
+
+	M_CLR(d);
+	M_TEST(s1);
+	emit_label_beq(cd, BRANCH_LABEL_1);
+
+	if (opt_LockReservation) {
+		emit_reservation_critical(cd, 1);
+
+		// Reserved for us with a count below the maximum.
+		M_ALD(d, s1, OFFSET(java_object_t, lockword));
+		M_ALD(REG_ITMP3, REG_ITMP3, OFFSET(threadobject, thinlock));
+		M_LXOR(REG_ITMP3, d);
+		M_MOV(d, REG_ITMP3);
+		M_LAND_IMM(~Lockword::THIN_LOCK_COUNT_MASK, REG_ITMP3);
+		M_LCMP_IMM(Lockword::THIN_LOCK_RESERVED_BIT, REG_ITMP3);
+		emit_label_bne(cd, BRANCH_LABEL_6);
+		M_LCMP_IMM(Lockword::THIN_LOCK_RESERVED_BIT | Lockword::THIN_LOCK_COUNT_MASK, d);
+		emit_label_beq(cd, BRANCH_LABEL_10);
+		M_LADD_IMM_MEMBASE(Lockword::THIN_LOCK_COUNT_INCR, s1, OFFSET(java_object_t, lockword));
+		emit_reservation_critical(cd, 0);
+
+#if defined(ENABLE_STATISTICS)
+		M_MOV_IMM(count_lock_reserved_enter.address(), REG_ITMP3);
+		M_LOCK_IINC_MEMBASE(REG_ITMP3, 0);
+#endif
+
+		emit_label_br(cd, BRANCH_LABEL_7);
+
+		// Reserve a reservable object for us.
+		emit_label(cd, BRANCH_LABEL_6);
+		emit_label(cd, BRANCH_LABEL_10);
+		emit_reservation_critical(cd, 0);
+		M_LCMP_IMM_MEMBASE(Lockword::THIN_RESERVABLE, s1, OFFSET(java_object_t, lockword));
+		emit_label_bne(cd, BRANCH_LABEL_8);
+		M_IMOV_IMM(Lockword::THIN_RESERVABLE, d);
+		M_ALD(REG_ITMP3, REG_ITMP3, OFFSET(threadobject, thinlock));
+		M_LOR_IMM(Lockword::THIN_LOCK_RESERVED_BIT | Lockword::THIN_LOCK_COUNT_INCR, REG_ITMP3);
+		M_LCMPXCHG(REG_ITMP3, s1, OFFSET(java_object_t, lockword));
+		emit_label_beq(cd, BRANCH_LABEL_9);
+
+		emit_label(cd, BRANCH_LABEL_8);
+		M_CLR(d);
+	}
+
+	// CMPXCHG compares with RAX, the unlocked lockword is zero.
+	M_ALD_TLS(REG_ITMP3, emit_thread_current_offset());
+	M_ALD(REG_ITMP3, REG_ITMP3, OFFSET(threadobject, thinlock));
+
+	// LOCK CMPXCHG is a full barrier, as required on monitorenter.
+	M_LCMPXCHG(REG_ITMP3, s1, OFFSET(java_object_t, lockword));
+	emit_label_beq(cd, BRANCH_LABEL_2);
+
+	// Only the count may differ from our thin lock, and it must not
+	// be at its maximum.
+	M_LXOR(REG_ITMP3, d);
+	M_MOV(d, REG_ITMP3);
+	M_LAND_IMM(~Lockword::THIN_LOCK_COUNT_MASK, REG_ITMP3);
+	emit_label_bne(cd, BRANCH_LABEL_3);
+	M_LCMP_IMM(Lockword::THIN_LOCK_COUNT_MASK, d);
+	emit_label_beq(cd, BRANCH_LABEL_4);
+	M_LADD_IMM_MEMBASE(Lockword::THIN_LOCK_COUNT_INCR, s1, OFFSET(java_object_t, lockword));
+
+	emit_label(cd, BRANCH_LABEL_2);
+
+	if (opt_LockReservation) {
+		emit_label(cd, BRANCH_LABEL_7);
+		emit_label(cd, BRANCH_LABEL_9);
+	}
+
+	M_IMOV_IMM(1, d);
+	emit_label_br(cd, BRANCH_LABEL_5);
+
+	emit_label(cd, BRANCH_LABEL_1);
+	emit_label(cd, BRANCH_LABEL_3);
+	emit_label(cd, BRANCH_LABEL_4);
+	M_CLR(d);
+	emit_label(cd, BRANCH_LABEL_5);
+}
+
+
+/**
+ * Emits the thin lock cases of lock_monitor_exit for the object in
+ * s1: releasing a thin lock held once, followed by the FLC check, or
+ * decrementing the recursion count.  With -XX:+LockReservation the
+ * count of an object reserved for the current thread is decremented
+ * first.  Sets d, which must be REG_ITMP1, to non-zero on success and
+ * to zero if the slow-path has to take over.  Uses REG_ITMP3 and
+ * destroys all temporary and argument registers if other threads
+ * wait for the lock.
+ */
+static void emit_thinlock_exit(codegendata* cd, int s1, int d)
+{
+	assert(d == REG_ITMP1);
+	assert(s1 != REG_ITMP1 && s1 != REG_ITMP3);
+
+	M_TEST(s1);
+	emit_label_beq(cd, BRANCH_LABEL_1);
+
+	if (opt_LockReservation) {
+		emit_reservation_critical(cd, 1);
+
+		// Reserved for us with a count above zero.
+		M_ALD(d, s1, OFFSET(java_object_t, lockword));
+		M_ALD(REG_ITMP3, REG_ITMP3, OFFSET(threadobject, thinlock));
+		M_LXOR(REG_ITMP3, d);
+		M_MOV(d, REG_ITMP3);
+		M_LAND_IMM(~Lockword::THIN_LOCK_COUNT_MASK, REG_ITMP3);
+		M_LCMP_IMM(Lockword::THIN_LOCK_RESERVED_BIT, REG_ITMP3);
+		emit_label_bne(cd, BRANCH_LABEL_7);
+		M_LCMP_IMM(Lockword::THIN_LOCK_RESERVED_BIT, d);
+		emit_label_beq(cd, BRANCH_LABEL_9);
+		M_LSUB_IMM_MEMBASE(Lockword::THIN_LOCK_COUNT_INCR, s1, OFFSET(java_object_t, lockword));
+		emit_reservation_critical(cd, 0);
+		emit_label_br(cd, BRANCH_LABEL_8);
+
+		emit_label(cd, BRANCH_LABEL_7);
+		emit_label(cd, BRANCH_LABEL_9);
+		emit_reservation_critical(cd, 0);
+	}
+
+	M_ALD_TLS(REG_ITMP3, emit_thread_current_offset());
+	M_ALD(REG_ITMP3, REG_ITMP3, OFFSET(threadobject, thinlock));
+	M_ALD(d, s1, OFFSET(java_object_t, lockword));
+	M_LXOR(REG_ITMP3, d);
+	emit_label_beq(cd, BRANCH_LABEL_2);
+
+	// Held recursively by us, the count is not zero.
+	M_MOV(d, REG_ITMP3);
+	M_LAND_IMM(~Lockword::THIN_LOCK_COUNT_MASK, REG_ITMP3);
+	emit_label_bne(cd, BRANCH_LABEL_3);
+	M_LSUB_IMM_MEMBASE(Lockword::THIN_LOCK_COUNT_INCR, s1, OFFSET(java_object_t, lockword));
+	emit_label_br(cd, BRANCH_LABEL_4);
+
+	// Held once by us: store the unlocked lockword (d is zero here),
+	// then check for flat lock contention after a full barrier.
+	emit_label(cd, BRANCH_LABEL_2);
+	M_AST(d, s1, OFFSET(java_object_t, lockword));
+	M_MFENCE;
+	M_ALD_TLS(REG_ITMP3, emit_thread_current_offset());
+	M_BLDU(REG_ITMP3, REG_ITMP3, OFFSET(threadobject, flc_bit));
+	M_TEST(REG_ITMP3);
+	emit_label_beq(cd, BRANCH_LABEL_5);
+
+	if (s1 != REG_A0)
+		M_MOV(s1, REG_A0);
+
+	M_MOV_IMM(lock_monitor_exit_contended, REG_ITMP1);
+	M_CALL(REG_ITMP1);
+
+	emit_label(cd, BRANCH_LABEL_4);
+	emit_label(cd, BRANCH_LABEL_5);
+
+	if (opt_LockReservation)
+		emit_label(cd, BRANCH_LABEL_8);
+
+	M_IMOV_IMM(1, d);
+	emit_label_br(cd, BRANCH_LABEL_6);
+
+	emit_label(cd, BRANCH_LABEL_1);
+	emit_label(cd, BRANCH_LABEL_3);
+	M_CLR(d);
+	emit_label(cd, BRANCH_LABEL_6);
+}
+
+#endif
+
+
 /**
  * Generates fast-path code for the below builtin.
  *   Function:  LOCK_monitor_enter
@@ -493,8 +710,13 @@ void emit_fastpath_monitor_enter(jitdata* jd, instruction* iptr, int d)
 	// Get required compiler data.
 	codegendata* cd = jd->cd;
 
-	// XXX Currently the fast-path always fails. Implement me!
+#if defined(ENABLE_THREADS) && defined(THREAD_CURRENT_STATIC_TLS)
+	int s1 = emit_load(jd, iptr, VAR(iptr->sx.s23.s2.args[0]), REG_ITMP2);
+
+	emit_thinlock_enter(cd, s1, d);
+#else
 	M_CLR(d);
+#endif
 }
 
 
@@ -509,8 +731,149 @@ void emit_fastpath_monitor_exit(jitdata* jd, instruction* iptr, int d)
 	// Get required compiler data.
 	codegendata* cd = jd->cd;
 
-	// XXX Currently the fast-path always fails. Implement me!
+#if defined(ENABLE_THREADS) && defined(THREAD_CURRENT_STATIC_TLS)
+	int s1 = emit_load(jd, iptr, VAR(iptr->sx.s23.s2.args[0]), REG_ITMP2);
+
+	emit_thinlock_exit(cd, s1, d);
+#else
 	M_CLR(d);
+#endif
+}
+
+
+/**
+ * Loads the address of a sun.misc.Unsafe access, the object plus the
+ * offset given as second and third argument, into REG_ITMP2.  Uses
+ * REG_ITMP3.
+ */
+static void emit_unsafe_address(jitdata* jd, instruction* iptr)
+{
+	// Get required compiler data.
+	codegendata* cd = jd->cd;
+
+	int s1 = emit_load(jd, iptr, VAR(iptr->sx.s23.s2.args[1]), REG_ITMP2);
+	int s2 = emit_load(jd, iptr, VAR(iptr->sx.s23.s2.args[2]), REG_ITMP3);
+
+	if (s1 != REG_ITMP2)
+		M_MOV(s1, REG_ITMP2);
+
+	M_LADD(s2, REG_ITMP2);
+}
+
+
+/**
+ * Generates the code for the below builtins, the call is not needed.
+ *   Function:  BUILTIN_unsafe_compareAndSwap{Int,Long,Object}
+ *   Signature: (Lsun/misc/Unsafe;Ljava/lang/Object;JTT)Z
+ *
+ * LOCK CMPXCHG is a full barrier, no fence is needed.
+ */
+void emit_fastpath_unsafe_cas(jitdata* jd, instruction* iptr, int d)
+{
+	// Get required compiler data.
+	codegendata* cd = jd->cd;
+
+	varinfo* expected = VAR(iptr->sx.s23.s2.args[3]);
+	varinfo* x        = VAR(iptr->sx.s23.s2.args[4]);
+
+	emit_unsafe_address(jd, iptr);
+
+	// CMPXCHG compares with RAX.
+	int s3 = emit_load(jd, iptr, expected, REG_ITMP1);
+	if (s3 != REG_ITMP1)
+		M_MOV(s3, REG_ITMP1);
+
+	int s4 = emit_load(jd, iptr, x, REG_ITMP3);
+
+	if (expected->type == TYPE_INT)
+		M_ICMPXCHG(s4, REG_ITMP2, 0);
+	else
+		M_LCMPXCHG(s4, REG_ITMP2, 0);
+
+	d = codegen_reg_of_dst(jd, iptr, d);
+	M_SETE(d);
+	M_BZEXT(d, d);
+	emit_store_dst(jd, iptr, d);
+}
+
+
+/**
+ * Generates the code for the below builtins, the call is not needed.
+ *   Function:  BUILTIN_unsafe_get{Int,Long,Object}Volatile
+ *   Signature: (Lsun/misc/Unsafe;Ljava/lang/Object;J)T
+ *
+ * Loads are not reordered with other loads on x86_64, a plain load
+ * has acquire semantics.
+ */
+void emit_fastpath_unsafe_get_volatile(jitdata* jd, instruction* iptr, int d)
+{
+	// Get required compiler data.
+	codegendata* cd = jd->cd;
+
+	emit_unsafe_address(jd, iptr);
+
+	d = codegen_reg_of_dst(jd, iptr, d);
+
+	if (VAROP(iptr->dst)->type == TYPE_INT)
+		M_ILD(d, REG_ITMP2, 0);
+	else
+		M_LLD(d, REG_ITMP2, 0);
+
+	emit_store_dst(jd, iptr, d);
+}
+
+
+/**
+ * Stores the value given as fourth argument of a sun.misc.Unsafe
+ * access.
+ */
+static void emit_unsafe_store(jitdata* jd, instruction* iptr)
+{
+	// Get required compiler data.
+	codegendata* cd = jd->cd;
+
+	varinfo* x = VAR(iptr->sx.s23.s2.args[3]);
+
+	emit_unsafe_address(jd, iptr);
+
+	int s3 = emit_load(jd, iptr, x, REG_ITMP3);
+
+	if (x->type == TYPE_INT)
+		M_IST(s3, REG_ITMP2, 0);
+	else
+		M_LST(s3, REG_ITMP2, 0);
+}
+
+
+/**
+ * Generates the code for the below builtins, the call is not needed.
+ *   Function:  BUILTIN_unsafe_put{Int,Long,Object}Volatile
+ *   Signature: (Lsun/misc/Unsafe;Ljava/lang/Object;JT)V
+ *
+ * A store may be reordered with a later load, so a volatile store
+ * needs a fence.
+ */
+void emit_fastpath_unsafe_put_volatile(jitdata* jd, instruction* iptr, int d)
+{
+	// Get required compiler data.
+	codegendata* cd = jd->cd;
+
+	emit_unsafe_store(jd, iptr);
+	M_MFENCE;
+}
+
+
+/**
+ * Generates the code for the below builtins, the call is not needed.
+ *   Function:  BUILTIN_unsafe_putOrdered{Int,Long,Object}
+ *   Signature: (Lsun/misc/Unsafe;Ljava/lang/Object;JT)V
+ *
+ * Stores are not reordered with other stores on x86_64, a plain
+ * store has release semantics.
+ */
+void emit_fastpath_unsafe_put_ordered(jitdata* jd, instruction* iptr, int d)
+{
+	emit_unsafe_store(jd, iptr);
 }
 
 
@@ -549,9 +912,20 @@ void emit_monitor_enter(jitdata* jd, int32_t syncslot_offset)
 	}
 
 	M_AST(REG_A0, REG_SP, syncslot_offset);
+
+#if defined(ENABLE_THREADS) && defined(THREAD_CURRENT_STATIC_TLS)
+	emit_thinlock_enter(cd, REG_A0, REG_ITMP1);
+	M_TEST(REG_ITMP1);
+	emit_label_bne(cd, BRANCH_LABEL_7);
+#endif
+
 	M_MOV_IMM(LOCK_monitor_enter, REG_ITMP1);
 	M_CALL(REG_ITMP1);
 
+#if defined(ENABLE_THREADS) && defined(THREAD_CURRENT_STATIC_TLS)
+	emit_label(cd, BRANCH_LABEL_7);
+#endif
+
 #ifndef NDEBUG
 	if (JITDATA_HAS_FLAG_VERBOSECALL(jd)) {
 
@@ -599,9 +973,19 @@ void emit_monitor_exit(jitdata* jd, int32_t syncslot_offset)
 		break;
 	}
 
+#if defined(ENABLE_THREADS) && defined(THREAD_CURRENT_STATIC_TLS)
+	emit_thinlock_exit(cd, REG_A0, REG_ITMP1);
+	M_TEST(REG_ITMP1);
+	emit_label_bne(cd, BRANCH_LABEL_7);
+#endif
+
 	M_MOV_IMM(LOCK_monitor_exit, REG_ITMP1);
 	M_CALL(REG_ITMP1);
 
+#if defined(ENABLE_THREADS) && defined(THREAD_CURRENT_STATIC_TLS)
+	emit_label(cd, BRANCH_LABEL_7);
+#endif
+
 	/* and now restore the proper return value */
 
 	switch (md->returntype.type) {
@@ -623,6 +1007,85 @@ void emit_monitor_exit(jitdata* jd, int32_t syncslot_offset)
 }
 
 
+/**
+ * Emit code incrementing a tiered compilation counter.
+ */
+#if defined(ENABLE_THREADS)
+void emit_tier_counter(codegendata* cd, u4* counter)
+{
+	M_MOV_IMM(counter, REG_ITMP3);
+	M_IINC_MEMBASE(REG_ITMP3, 0);
+}
+#endif
+
+
+/**
+ * Emit code recording the class seen by a type check or by the
+ * receiver of a virtual or interface call of baseline code.  The first
+ * class seen is stored in the profile, concurrent updates may lose
+ * samples.  For AASTORE the class of the stored value is recorded
+ * together with the class of the array.
+ */
+#if defined(ENABLE_THREADS)
+void emit_typeprofile(jitdata* jd, instruction* iptr, typeprofile* tp)
+{
+	codegendata* cd = jd->cd;
+	int32_t      s1, s3;
+
+	/* calls record the class of the receiver */
+
+	if ((iptr->opc == ICMD_INVOKEVIRTUAL) || (iptr->opc == ICMD_INVOKEINTERFACE))
+		s1 = emit_load(jd, iptr, VAR(iptr->sx.s23.s2.args[0]), REG_ITMP1);
+	else
+		s1 = emit_load_s1(jd, iptr, REG_ITMP1);
+
+	M_TEST(s1);
+	emit_label_beq(cd, BRANCH_LABEL_1);
+
+	if (iptr->opc == ICMD_AASTORE) {
+		s3 = emit_load_s3(jd, iptr, REG_ITMP2);
+		M_TEST(s3);
+		emit_label_beq(cd, BRANCH_LABEL_2);
+		M_ALD(REG_ITMP2, s3, OFFSET(java_object_t, vftbl));
+		M_ALD(REG_ITMP1, s1, OFFSET(java_object_t, vftbl));
+	}
+	else
+		M_ALD(REG_ITMP2, s1, OFFSET(java_object_t, vftbl));
+
+	M_MOV_IMM(tp, REG_ITMP3);
+	M_IINC_MEMBASE(REG_ITMP3, OFFSET(typeprofile, count));
+	M_LCMP_MEMBASE(REG_ITMP3, OFFSET(typeprofile, vftbl), REG_ITMP2);
+	emit_label_beq(cd, BRANCH_LABEL_3);
+
+	/* record the first class */
+
+	M_LCMP_IMM_MEMBASE(0, REG_ITMP3, OFFSET(typeprofile, vftbl));
+	emit_label_bne(cd, BRANCH_LABEL_4);
+	M_AST(REG_ITMP2, REG_ITMP3, OFFSET(typeprofile, vftbl));
+
+	if (iptr->opc == ICMD_AASTORE)
+		M_AST(REG_ITMP1, REG_ITMP3, OFFSET(typeprofile, arrayvftbl));
+
+	emit_label(cd, BRANCH_LABEL_3);
+
+	if (iptr->opc == ICMD_AASTORE) {
+		M_LCMP_MEMBASE(REG_ITMP3, OFFSET(typeprofile, arrayvftbl), REG_ITMP1);
+		emit_label_bne(cd, BRANCH_LABEL_5);
+	}
+
+	M_IINC_MEMBASE(REG_ITMP3, OFFSET(typeprofile, hits));
+
+	emit_label(cd, BRANCH_LABEL_1);
+	emit_label(cd, BRANCH_LABEL_4);
+
+	if (iptr->opc == ICMD_AASTORE) {
+		emit_label(cd, BRANCH_LABEL_2);
+		emit_label(cd, BRANCH_LABEL_5);
+	}
+}
+#endif
+
+
 /**
  * Emit profiling code for method frequency counting.
  */
@@ -1534,6 +1997,15 @@ void emit_movzwq_reg_reg(codegendata *cd, s8 reg, s8 dreg)
 }
 
 
+void emit_movzbq_membase_reg(codegendata *cd, s8 basereg, s8 disp, s8 dreg)
+{
+	emit_rex(1,(dreg),0,(basereg));
+	*(cd->mcodeptr++) = 0x0f;
+	*(cd->mcodeptr++) = 0xb6;
+	emit_membase(cd, (basereg),(disp),(dreg));
+}
+
+
 void emit_movswq_memindex_reg(codegendata *cd, s8 disp, s8 basereg, s8 indexreg, s8 scale, s8 reg) {
 	emit_rex(1,(reg),(indexreg),(basereg));
 	*(cd->mcodeptr++) = 0x0f;
@@ -1604,6 +2076,14 @@ void emit_mov_mem_reg(codegendata *cd, s4 disp, s4 dreg)
 }
 
 
+/* loads from disp relative to the FS segment base, the thread pointer */
+void emit_mov_fs_mem_reg(codegendata *cd, s4 disp, s4 dreg)
+{
+	*(cd->mcodeptr++) = 0x64;
+	emit_mov_mem_reg(cd, disp, dreg);
+}
+
+
 /*
  * alu operations
  */
@@ -1816,6 +2296,12 @@ void emit_incl_membase(codegendata *cd, s8 basereg, s8 disp)
 	emit_membase(cd, (basereg),(disp),0);
 }
 
+void emit_lock_incl_membase(codegendata *cd, s8 basereg, s8 disp)
+{
+	*(cd->mcodeptr++) = 0xf0;
+	emit_incl_membase(cd, basereg, disp);
+}
+
 void emit_incq_membase(codegendata *cd, s8 basereg, s8 disp)
 {
 	emit_rex(1,0,0,(basereg));
@@ -2166,6 +2652,25 @@ void emit_xchg_reg_reg(codegendata *cd, s8 reg, s8 dreg) {
 }
 
 
+/* compares RAX with the memory operand and stores reg there if equal */
+void emit_lock_cmpxchg_reg_membase(codegendata *cd, s8 reg, s8 basereg, s8 disp) {
+	*(cd->mcodeptr++) = 0xf0;
+	emit_rex(1,(reg),0,(basereg));
+	*(cd->mcodeptr++) = 0x0f;
+	*(cd->mcodeptr++) = 0xb1;
+	emit_membase(cd, (basereg),(disp),(reg));
+}
+
+
+void emit_lock_cmpxchgl_reg_membase(codegendata *cd, s8 reg, s8 basereg, s8 disp) {
+	*(cd->mcodeptr++) = 0xf0;
+	emit_rex(0,(reg),0,(basereg));
+	*(cd->mcodeptr++) = 0x0f;
+	*(cd->mcodeptr++) = 0xb1;
+	emit_membase(cd, (basereg),(disp),(reg));
+}
+
+
 
 /*
  * call instructions
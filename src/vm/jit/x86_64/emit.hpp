@@ -218,6 +218,7 @@ void emit_movslq_reg_reg(codegendata *cd, s8 reg, s8 dreg);
 void emit_movslq_membase_reg(codegendata *cd, s8 basereg, s8 disp, s8 dreg);
 void emit_movzbq_reg_reg(codegendata *cd, s8 reg, s8 dreg);
 void emit_movzwq_reg_reg(codegendata *cd, s8 reg, s8 dreg);
+void emit_movzbq_membase_reg(codegendata *cd, s8 basereg, s8 disp, s8 dreg);
 void emit_movzwq_membase_reg(codegendata *cd, s8 basereg, s8 disp, s8 dreg);
 void emit_movswq_memindex_reg(codegendata *cd, s8 disp, s8 basereg, s8 indexreg, s8 scale, s8 reg);
 void emit_movsbq_memindex_reg(codegendata *cd, s8 disp, s8 basereg, s8 indexreg, s8 scale, s8 reg);
@@ -228,6 +229,7 @@ void emit_movw_imm_memindex(codegendata *cd, s4 imm, s4 disp, s4 basereg, s4 ind
 void emit_movb_imm_memindex(codegendata *cd, s4 imm, s4 disp, s4 basereg, s4 indexreg, s4 scale);
 
 void emit_mov_mem_reg(codegendata *cd, s4 disp, s4 dreg);
+void emit_mov_fs_mem_reg(codegendata *cd, s4 disp, s4 dreg);
 
 void emit_alu_reg_reg(codegendata *cd, s8 opc, s8 reg, s8 dreg);
 void emit_alul_reg_reg(codegendata *cd, s8 opc, s8 reg, s8 dreg);
@@ -254,6 +256,7 @@ void emit_leal_membase_reg(codegendata *cd, s8 basereg, s8 disp, s8 reg);
 void emit_incl_reg(codegendata *cd, s8 reg);
 void emit_incq_reg(codegendata *cd, s8 reg);
 void emit_incl_membase(codegendata *cd, s8 basereg, s8 disp);
+void emit_lock_incl_membase(codegendata *cd, s8 basereg, s8 disp);
 void emit_incq_membase(codegendata *cd, s8 basereg, s8 disp);
 
 void emit_cltd(codegendata *cd);
@@ -295,6 +298,8 @@ void emit_push_reg(codegendata *cd, s8 reg);
 void emit_push_imm(codegendata *cd, s8 imm);
 void emit_pop_reg(codegendata *cd, s8 reg);
 void emit_xchg_reg_reg(codegendata *cd, s8 reg, s8 dreg);
+void emit_lock_cmpxchg_reg_membase(codegendata *cd, s8 reg, s8 basereg, s8 disp);
+void emit_lock_cmpxchgl_reg_membase(codegendata *cd, s8 reg, s8 basereg, s8 disp);
 void emit_call_reg(codegendata *cd, s8 reg);
 void emit_call_imm(codegendata *cd, s8 imm);
 void emit_call_mem(codegendata *cd, ptrint mem);
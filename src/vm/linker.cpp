@@ -26,7 +26,9 @@
 #include "vm/linker.hpp"
 #include "config.h"
 
+#include <algorithm>
 #include <cassert>
+#include <cstring>
 #include <vector>
 #include <utility>
 
@@ -64,6 +66,8 @@ using namespace cacao;
 
 
 STAT_DECLARE_VAR(int,count_vftbl_len,0)
+STAT_REGISTER_VAR(int,count_field_layout_compacted,0,"compacted field layouts","classes made smaller by ordering the fields")
+STAT_REGISTER_VAR(int,size_field_layout_saved,0,"field layout bytes saved","instance bytes saved by ordering the fields, summed over classes")
 
 
 /* debugging macros ***********************************************************/
@@ -110,6 +114,7 @@ Mutex *linker_classrenumber_lock;
 
 static classinfo *link_class_intern(classinfo *c);
 static arraydescriptor *link_array(classinfo *c);
+static void link_fields(classinfo *c);
 #if !USES_NEW_SUBTYPE
 static void linker_compute_class_values(classinfo *c);
 #endif
@@ -676,6 +681,9 @@ static classinfo *link_class_intern(classinfo *c)
 	if (c->super == NULL) {
 		c->index = 0;
 		c->instancesize = sizeof(java_object_t);
+#if defined(ENABLE_STATISTICS)
+		c->instancereferences = 0;
+#endif
 
 		vftbllength = supervftbllength = 0;
 
@@ -710,6 +718,9 @@ static classinfo *link_class_intern(classinfo *c)
 			c->index = super->index + 1;
 
 		c->instancesize = super->instancesize;
+#if defined(ENABLE_STATISTICS)
+		c->instancereferences = super->instancereferences;
+#endif
 
 		vftbllength = supervftbllength = super->vftbl->vftbllength;
 
@@ -947,17 +958,7 @@ static classinfo *link_class_intern(classinfo *c)
 
 	/* compute instance size and offset of each field */
 
-	for (i = 0; i < c->fieldscount; i++) {
-		s4 dsize;
-		fieldinfo *f = &(c->fields[i]);
-
-		if (!(f->flags & ACC_STATIC)) {
-			dsize            = f->parseddesc->typesize();
-			c->instancesize  = MEMORY_ALIGN(c->instancesize, dsize);
-			f->offset        = c->instancesize;
-			c->instancesize += dsize;
-		}
-	}
+	link_fields(c);
 	RT_TIMER_STOPSTART(offsets_timer,fill_iftbl_timer);
 
 	/* initialize interfacetable and interfacevftbllength */
@@ -1031,6 +1032,158 @@ static classinfo *link_class_intern(classinfo *c)
 }
 
 
+/* link_fields_may_reorder ***************************************************
+
+   Returns true if the instance fields of the class may be laid out in
+   another order than they are declared.  The VM accesses the fields
+   of some bootstrap classes at fixed offsets (see vm/javaobjects.hpp),
+   so the packages of these classes keep the declared order.
+
+*******************************************************************************/
+
+static bool link_fields_may_reorder(classinfo *c)
+{
+	static const char *fixed_packages[] = {
+		"java/lang/",
+		"java/nio/",
+		"gnu/classpath/",
+		"sun/reflect/",
+		"com/sun/cldchi/",
+		NULL
+	};
+
+	if (!opt_CompactFields)
+		return false;
+
+	if (c->classloader != NULL)
+		return true;
+
+	for (const char **p = fixed_packages; *p != NULL; p++) {
+		size_t len = strlen(*p);
+
+		if (c->name.size() > len && strncmp(c->name.begin(), *p, len) == 0)
+			return false;
+	}
+
+	return true;
+}
+
+
+/* link_fields_compare *********************************************************
+
+   Orders fields by decreasing size, references after the other fields
+   of the same size so they end up next to each other.  Used with a
+   stable sort, so fields of the same kind keep the declared order.
+
+*******************************************************************************/
+
+static bool link_fields_compare(fieldinfo *a, fieldinfo *b)
+{
+	s4 asize = a->parseddesc->typesize();
+	s4 bsize = b->parseddesc->typesize();
+
+	if (asize != bsize)
+		return asize > bsize;
+
+	return !IS_ADR_TYPE(a->type) && IS_ADR_TYPE(b->type);
+}
+
+
+/* link_fields *****************************************************************
+
+   Assigns the offsets of the instance fields and computes the
+   instance size of the class.  The fields start behind the ones of
+   the superclass, c->instancesize must be the size of the superclass
+   instance on entry.
+
+   Unless the declared order must be kept, the fields are placed by
+   decreasing size.  The gap in front of a field which is not yet
+   aligned, e.g. at the end of the superclass fields, is filled with
+   the biggest smaller fields which fit.
+
+*******************************************************************************/
+
+static void link_fields(classinfo *c)
+{
+	std::vector<fieldinfo*> fields;
+	s4                      declaredsize = c->instancesize;
+
+	for (s4 i = 0; i < c->fieldscount; i++) {
+		fieldinfo *f = &(c->fields[i]);
+
+		if (f->flags & ACC_STATIC)
+			continue;
+
+		s4 dsize = f->parseddesc->typesize();
+
+		declaredsize  = MEMORY_ALIGN(declaredsize, dsize);
+		declaredsize += dsize;
+
+		fields.push_back(f);
+
+#if defined(ENABLE_STATISTICS)
+		if (IS_ADR_TYPE(f->type))
+			c->instancereferences++;
+#endif
+	}
+
+	if (!link_fields_may_reorder(c)) {
+		for (size_t i = 0; i < fields.size(); i++) {
+			fieldinfo *f     = fields[i];
+			s4         dsize = f->parseddesc->typesize();
+
+			c->instancesize  = MEMORY_ALIGN(c->instancesize, dsize);
+			f->offset        = c->instancesize;
+			c->instancesize += dsize;
+		}
+
+		return;
+	}
+
+	std::stable_sort(fields.begin(), fields.end(), link_fields_compare);
+
+	s4 offset = c->instancesize;
+
+	while (!fields.empty()) {
+		std::vector<fieldinfo*>::iterator it = fields.begin();
+		s4 dsize = (*it)->parseddesc->typesize();
+
+		if (offset % dsize != 0) {
+			/* fill the gap with a smaller field, or pad by one byte */
+
+			for (++it; it != fields.end(); ++it) {
+				dsize = (*it)->parseddesc->typesize();
+
+				if (offset % dsize == 0)
+					break;
+			}
+
+			if (it == fields.end()) {
+				offset++;
+				continue;
+			}
+		}
+
+		(*it)->offset = offset;
+		offset       += dsize;
+
+		fields.erase(it);
+	}
+
+	c->instancesize = offset;
+
+	if (c->instancesize < declaredsize) {
+		STATISTICS(count_field_layout_compacted++);
+		STATISTICS(size_field_layout_saved += declaredsize - c->instancesize);
+
+		if (opt_PrintFieldLayout)
+			log_println("[Field layout: %.*s: %d bytes instead of %d]",
+						(int) c->name.size(), c->name.begin(),
+						c->instancesize, declaredsize);
+	}
+}
+
+
 /* link_array ******************************************************************
 
    This function is called by link_class to create the arraydescriptor
@@ -47,6 +47,7 @@
 
 #include "vm/class.hpp"                 // for classinfo, etc
 #include "vm/classcache.hpp"            // for classcache_store, etc
+#include "vm/classindex.hpp"            // for ClassIndex
 #include "vm/descriptor.hpp"            // for DescriptorPool, methoddesc, etc
 #include "vm/exceptions.hpp"
 #include "vm/descriptor.hpp"
@@ -59,10 +60,12 @@
 #include "vm/method.hpp"                // for methodinfo, etc
 #include "vm/options.hpp"               // for opt_verify, loadverbose, etc
 #include "vm/package.hpp"               // for Package
+#include "vm/preload.hpp"               // for ClassPreloader
 #include "vm/primitive.hpp"             // for Primitive
 #include "vm/references.hpp"            // for constant_FMIref, etc
 #include "vm/resolve.hpp"
 #include "vm/rt-timing.hpp"
+#include "vm/sharedarchive.hpp"         // for SharedArchive
 #include "vm/statistics.hpp"
 #include "vm/string.hpp"                // for JavaString
 #include "vm/suck.hpp"                  // for suck_check_classbuffer_size, etc
@@ -155,6 +158,18 @@ void loader_preinit(void)
 			lce->mutex = new Mutex();
 	}
 
+	/* Index the class files on the classpath. */
+
+	ClassIndex::initialize(suckclasspath);
+
+	/* Map the shared class archive, if one was requested. */
+
+	SharedArchive::initialize(suckclasspath);
+
+	/* Start reading the class files of the preload list. */
+
+	ClassPreloader::start();
+
 	/* initialize classloader hashtable, 10 entries should be enough */
 
 	hashtable_classloader = NEW(hashtable);
@@ -59,6 +59,7 @@
 
 #include "vm/jit/builtin.hpp"           // for builtintable_entry
 #include "vm/jit/code.hpp"              // for code_free_code_of_method, etc
+#include "vm/jit/invoker.hpp"           // for invoker_free
 #include "vm/jit/methodheader.hpp"
 #include "vm/jit/stubs.hpp"             // for CompilerStub, NativeStub
 
@@ -639,6 +640,18 @@ void method_free(methodinfo *m)
 
 	if (m->breakpoints)
 		delete m->breakpoints;
+
+	if (m->invoker)
+		invoker_free(m->invoker);
+
+#if defined(ENABLE_THREADS)
+	while (m->callsites != NULL) {
+		method_callsite *cs = m->callsites;
+
+		m->callsites = cs->next;
+		FREE(cs, method_callsite);
+	}
+#endif
 }
 
 
@@ -28,7 +28,7 @@
 
 #include "config.h"                     // for ENABLE_JAVASE, etc
 
-#include <stdint.h>                     // for uint16_t, int32_t
+#include <stdint.h>                     // for uint16_t, int32_t, etc
 
 #include "vm/global.hpp"                // for java_handle_bytearray_t, etc
 #include "vm/references.hpp"            // for classref_or_classinfo
@@ -41,9 +41,11 @@ struct builtintable_entry;
 struct classbuffer;
 struct classinfo;
 struct codeinfo;
+struct invokerinfo;
 struct lineinfo;
 struct localvarinfo;
 struct method_assumption;
+struct method_callsite;
 struct method_worklist;
 struct methoddesc;
 struct methodinfo;
@@ -108,9 +110,15 @@ struct methodinfo {                 /* method structure                       */
 
 	methodinfo   *overwrites;       /* method that is directly overwritten    */
 	method_assumption *assumptions; /* list of assumptions about this method  */
+#if defined(ENABLE_THREADS)
+	method_callsite *callsites;     /* statically bound calls of this method  */
+#endif
 
 	BreakpointTable* breakpoints;   /* breakpoints in this method             */
 
+	invokerinfo  *invoker;          /* for reflective calls, see invoker.hpp  */
+	s4            invokecount;      /* reflective calls without an invoker    */
+
 #if defined(ENABLE_REPLACEMENT)
 	s4            hitcountdown;     /* decreased for each hit                 */
 #endif
@@ -136,6 +144,20 @@ struct method_assumption {
 };
 
 
+/* method_callsite *************************************************************
+
+   Data segment slot through which compiled code calls a method
+   statically.  Recorded so the calls can be rebound when the method is
+   recompiled.
+
+*******************************************************************************/
+
+struct method_callsite {
+	method_callsite   *next;
+	uintptr_t         *slot;
+};
+
+
 /* method_worklist *************************************************************
 
    List node used for method worklists.
@@ -162,6 +162,9 @@ int      opt_ThreadStackSize              = 0;
 
 bool     opt_AlwaysEmitLongBranches       = false;
 bool     opt_AlwaysMmapFirstPage          = false;
+int      opt_BoxCache                     = 1;
+int      opt_ClassPathIndex               = 1;
+int      opt_CompactFields                = 1;
 int      opt_CompileAll                   = 0;
 char*    opt_CompileMethod                = NULL;
 char*    opt_CompileSignature             = NULL;
@@ -176,13 +179,30 @@ int      opt_DebugThreads                 = 0;
 #if defined(ENABLE_DISASSEMBLER)
 int      opt_DisassembleStubs             = 0;
 #endif
+int      opt_DumpSharedArchive            = 0;
+char*    opt_DumpLoadedClassList          = NULL;
+#if defined(ENABLE_JIT)
+int      opt_EliminateChecks              = 1;
+int      opt_EliminateLocks               = 1;
+#endif
 #if defined(ENABLE_OPAGENT)
 int      opt_EnableOpagent                = 0;
 #endif
+#if defined(ENABLE_JIT)
+int      opt_ExceptionCache               = 1;
+#endif
 #if defined(ENABLE_GC_CACAO)
 int      opt_GCDebugRootSet               = 0;
 int      opt_GCStress                     = 0;
 #endif
+#if defined(ENABLE_INLINING) && defined(ENABLE_THREADS)
+int      opt_GuardedInlining              = 1;
+int      opt_GuardedInliningMisses        = 1000;
+#endif
+#if defined(ENABLE_JIT)
+int      opt_HotColdSplitting             = 1;
+#endif
+int      opt_ImplicitExceptionThreshold   = 0;
 #if defined(ENABLE_INLINING)
 int      opt_Inline                       = 0;
 #if defined(ENABLE_INLINING_DEBUG) || !defined(NDEBUG)
@@ -192,15 +212,46 @@ int      opt_InlineMaxSize                = INT_MAX;
 int      opt_InlineMinSize                = 0;
 #endif
 #endif
+#if defined(ENABLE_JIT)
+int      opt_LinearScan                   = 1;
+#endif
+int      opt_LockReservation              = 0;
+int      opt_LogCompilation               = 0;
+int      opt_LogCompilationEntries        = 4096;
+char*    opt_LogCompilationFile           = NULL;
+#if defined(ENABLE_LOOP)
+int      opt_LoopInvariantCodeMotion      = 1;
+int      opt_LoopUnrollFactor             = 4;
+#endif
 int      opt_PrintConfig                  = 0;
+int      opt_PrintFieldLayout             = 0;
+int      opt_PrintImplicitExceptionStatistics = 0;
+int      opt_PrintSharedArchiveStatistics = 0;
+#if defined(ENABLE_THREADS)
+int      opt_PrintTieredStatistics        = 0;
+#endif
+char*    opt_PreloadClassList             = NULL;
+int      opt_PreloadThreads               = 2;
+int      opt_PrintPreloadStatistics       = 0;
 int      opt_PrintWarnings                = 0;
 int      opt_ProfileGCMemoryUsage         = 0;
 int      opt_ProfileMemoryUsage           = 0;
 FILE    *opt_ProfileMemoryUsageGNUPlot    = NULL;
+int      opt_ReflectionInvokerThreshold   = 16;
 int      opt_RegallocSpillAll             = 0;
+#if defined(ENABLE_JIT)
+int      opt_ScalarOptimizations          = 1;
+#endif
+char*    opt_SharedArchiveFile            = NULL;
 #if defined(ENABLE_REPLACEMENT)
 int      opt_TestReplacement              = 0;
 #endif
+#if defined(ENABLE_THREADS)
+int      opt_TieredBackEdgeThreshold      = 60000;
+int      opt_TieredCompilation            = 0;
+int      opt_TieredInvocationThreshold    = 10000;
+int      opt_TieredScanInterval           = 10;
+#endif
 int      opt_TraceBuiltinCalls            = 0;
 int      opt_TraceCompilerCalls           = 0;
 int      opt_TraceExceptions              = 0;
@@ -228,6 +279,13 @@ int      opt_TraceReplacement             = 0;
 #endif
 int      opt_TraceSubsystemInitialization = 0;
 int      opt_TraceTraps                   = 0;
+#if defined(ENABLE_THREADS)
+int      opt_TypeProfileThreshold         = 90;
+int      opt_TypeProfiles                 = 1;
+#endif
+#if defined(ENABLE_JIT)
+int      opt_UnsafeIntrinsics             = 1;
+#endif
 
 
 enum {
@@ -248,6 +306,9 @@ enum {
 
 	OPT_AlwaysEmitLongBranches,
 	OPT_AlwaysMmapFirstPage,
+	OPT_BoxCache,
+	OPT_ClassPathIndex,
+	OPT_CompactFields,
 	OPT_CompileAll,
 	OPT_CompileMethod,
 	OPT_CompileSignature,
@@ -259,21 +320,51 @@ enum {
 	OPT_DebugStackTrace,
 	OPT_DebugThreads,
 	OPT_DisassembleStubs,
+	OPT_DumpSharedArchive,
+	OPT_DumpLoadedClassList,
+	OPT_EliminateChecks,
+	OPT_EliminateLocks,
 	OPT_EnableOpagent,
+	OPT_ExceptionCache,
 	OPT_GCDebugRootSet,
 	OPT_GCStress,
+	OPT_GuardedInlining,
+	OPT_GuardedInliningMisses,
+	OPT_HotColdSplitting,
+	OPT_ImplicitExceptionThreshold,
 	OPT_Inline,
 	OPT_InlineAll,
 	OPT_InlineCount,
 	OPT_InlineMaxSize,
 	OPT_InlineMinSize,
+	OPT_LinearScan,
+	OPT_LockReservation,
+	OPT_LogCompilation,
+	OPT_LogCompilationEntries,
+	OPT_LogCompilationFile,
+	OPT_LoopInvariantCodeMotion,
+	OPT_LoopUnrollFactor,
 	OPT_PrintConfig,
+	OPT_PrintFieldLayout,
+	OPT_PrintImplicitExceptionStatistics,
+	OPT_PrintSharedArchiveStatistics,
+	OPT_PrintTieredStatistics,
+	OPT_PreloadClassList,
+	OPT_PreloadThreads,
+	OPT_PrintPreloadStatistics,
 	OPT_PrintWarnings,
 	OPT_ProfileGCMemoryUsage,
 	OPT_ProfileMemoryUsage,
 	OPT_ProfileMemoryUsageGNUPlot,
+	OPT_ReflectionInvokerThreshold,
 	OPT_RegallocSpillAll,
+	OPT_ScalarOptimizations,
+	OPT_SharedArchiveFile,
 	OPT_TestReplacement,
+	OPT_TieredBackEdgeThreshold,
+	OPT_TieredCompilation,
+	OPT_TieredInvocationThreshold,
+	OPT_TieredScanInterval,
 	OPT_TraceBuiltinCalls,
 	OPT_TraceCompilerCalls,
 	OPT_TraceExceptions,
@@ -289,6 +380,9 @@ enum {
 	OPT_TraceReplacement,
 	OPT_TraceSubsystemInitialization,
 	OPT_TraceTraps,
+	OPT_TypeProfileThreshold,
+	OPT_TypeProfiles,
+	OPT_UnsafeIntrinsics,
 	OPT_RtTimingLogfile,
 	OPT_StatisticsLogfile
 };
@@ -307,6 +401,9 @@ option_t options_XX[] = {
 
 	{ "AlwaysEmitLongBranches",       OPT_AlwaysEmitLongBranches,       OPT_TYPE_BOOLEAN, "Always emit long-branches." },
 	{ "AlwaysMmapFirstPage",          OPT_AlwaysMmapFirstPage,          OPT_TYPE_BOOLEAN, "Always mmap memory page at address 0x0." },
+	{ "BoxCache",                     OPT_BoxCache,                     OPT_TYPE_BOOLEAN, "box small values in the VM with the instances cached by valueOf (default: on)" },
+	{ "ClassPathIndex",               OPT_ClassPathIndex,               OPT_TYPE_BOOLEAN, "locate class files through an index of the classpath (default: on)" },
+	{ "CompactFields",                OPT_CompactFields,                OPT_TYPE_BOOLEAN, "order instance fields by size to avoid padding (default: on)" },
 	{ "CompileAll",                   OPT_CompileAll,                   OPT_TYPE_BOOLEAN, "compile all methods, no execution" },
 	{ "CompileMethod",                OPT_CompileMethod,                OPT_TYPE_VALUE,   "compile only a specific method" },
 	{ "CompileSignature",             OPT_CompileSignature,             OPT_TYPE_VALUE,   "specify signature for a specific method" },
@@ -319,14 +416,31 @@ option_t options_XX[] = {
 	{ "DebugThreads",                 OPT_DebugThreads,                 OPT_TYPE_BOOLEAN, "print debug information for threads" },
 #if defined(ENABLE_DISASSEMBLER)
 	{ "DisassembleStubs",             OPT_DisassembleStubs,             OPT_TYPE_BOOLEAN, "disassemble builtin and native stubs when generated" },
+#endif
+	{ "DumpSharedArchive",            OPT_DumpSharedArchive,            OPT_TYPE_BOOLEAN, "record bootstrap class files and write them to the SharedArchiveFile at exit" },
+	{ "DumpLoadedClassList",          OPT_DumpLoadedClassList,          OPT_TYPE_VALUE,   "write the names of all bootstrap classes loaded to <file>" },
+#if defined(ENABLE_JIT)
+	{ "EliminateChecks",              OPT_EliminateChecks,              OPT_TYPE_BOOLEAN, "remove null checks and type checks known to succeed in optimized compilations of -XX:+TieredCompilation (default: on)" },
+	{ "EliminateLocks",               OPT_EliminateLocks,               OPT_TYPE_BOOLEAN, "remove monitor operations on objects not escaping the compiled method in optimized compilations of -XX:+TieredCompilation (default: on)" },
 #endif
 #if defined(ENABLE_OPAGENT)
 	{ "EnableOpagent",                OPT_EnableOpagent,                OPT_TYPE_BOOLEAN, "enable providing JIT output to Oprofile" },
 #endif
+#if defined(ENABLE_JIT)
+	{ "ExceptionCache",               OPT_ExceptionCache,               OPT_TYPE_BOOLEAN, "cache the exception handler found for a throwing PC and exception class (default: on)" },
+#endif
 #if defined(ENABLE_GC_CACAO)
 	{ "GCDebugRootSet",               OPT_GCDebugRootSet,               OPT_TYPE_BOOLEAN, "GC: print root-set at collection" },
 	{ "GCStress",                     OPT_GCStress,                     OPT_TYPE_BOOLEAN, "GC: forced collection at every allocation" },
 #endif
+#if defined(ENABLE_INLINING) && defined(ENABLE_THREADS)
+	{ "GuardedInlining",              OPT_GuardedInlining,              OPT_TYPE_BOOLEAN, "inline virtual and interface calls whose profiled receiver has one class behind a check of that class (default: on)" },
+	{ "GuardedInliningMisses",        OPT_GuardedInliningMisses,        OPT_TYPE_VALUE,   "failed receiver checks per scan of the tiered compilation thread after which a method is deoptimized (default: 1000)" },
+#endif
+#if defined(ENABLE_JIT)
+	{ "HotColdSplitting",             OPT_HotColdSplitting,             OPT_TYPE_BOOLEAN, "move exception handlers and rarely executed blocks behind the hot code in optimized compilations of -XX:+TieredCompilation (default: on)" },
+#endif
+	{ "ImplicitExceptionThreshold",   OPT_ImplicitExceptionThreshold,   OPT_TYPE_VALUE,   "throw preallocated exceptions without stack trace from trap sites that threw <value> times, 0 disables (default: 0)" },
 #if defined(ENABLE_INLINING)
 	{ "Inline",                       OPT_Inline,                       OPT_TYPE_BOOLEAN, "enable method inlining" },
 #if defined(ENABLE_INLINING_DEBUG) || !defined(NDEBUG)
@@ -335,15 +449,46 @@ option_t options_XX[] = {
 	{ "InlineMaxSize",                OPT_InlineMaxSize,                OPT_TYPE_VALUE,   "maximum size for inlined result" },
 	{ "InlineMinSize",                OPT_InlineMinSize,                OPT_TYPE_VALUE,   "minimum size for inlined result" },
 #endif
+#endif
+#if defined(ENABLE_JIT)
+	{ "LinearScan",                   OPT_LinearScan,                   OPT_TYPE_BOOLEAN, "allocate the local variables of a method by linear scan over their live ranges (default: on)" },
+#endif
+	{ "LockReservation",              OPT_LockReservation,              OPT_TYPE_BOOLEAN, "reserve the lock of an object for the first thread locking it" },
+	{ "LogCompilation",               OPT_LogCompilation,               OPT_TYPE_BOOLEAN, "record every compilation in a ring buffer and write it out at exit" },
+	{ "LogCompilationEntries",        OPT_LogCompilationEntries,        OPT_TYPE_VALUE,   "number of compilations kept with -XX:+LogCompilation (default: 4096)" },
+	{ "LogCompilationFile",           OPT_LogCompilationFile,           OPT_TYPE_VALUE,   "write the compilation log to <value> instead of the log file" },
+#if defined(ENABLE_LOOP)
+	{ "LoopInvariantCodeMotion",      OPT_LoopInvariantCodeMotion,      OPT_TYPE_BOOLEAN, "hoist loop-invariant loads, type checks and arithmetic with -oloop (default: on)" },
+	{ "LoopUnrollFactor",             OPT_LoopUnrollFactor,             OPT_TYPE_VALUE,   "unroll small counted inner loops <value> times with -oloop (default: 4)" },
 #endif
 	{ "PrintConfig",                  OPT_PrintConfig,                  OPT_TYPE_BOOLEAN, "print VM configuration" },
+	{ "PrintFieldLayout",             OPT_PrintFieldLayout,             OPT_TYPE_BOOLEAN, "print the instance size of classes made smaller by CompactFields" },
+	{ "PrintImplicitExceptionStatistics", OPT_PrintImplicitExceptionStatistics, OPT_TYPE_BOOLEAN, "print the implicit exceptions thrown per trap site at exit" },
+	{ "PrintSharedArchiveStatistics", OPT_PrintSharedArchiveStatistics, OPT_TYPE_BOOLEAN, "print shared archive usage at exit" },
+#if defined(ENABLE_THREADS)
+	{ "PrintTieredStatistics",        OPT_PrintTieredStatistics,        OPT_TYPE_BOOLEAN, "print tiered compilation statistics at exit" },
+#endif
+	{ "PreloadClassList",             OPT_PreloadClassList,             OPT_TYPE_VALUE,   "read the class files listed in <file> on helper threads during startup" },
+	{ "PreloadThreads",               OPT_PreloadThreads,               OPT_TYPE_VALUE,   "number of helper threads for -XX:PreloadClassList (default: 2)" },
+	{ "PrintPreloadStatistics",       OPT_PrintPreloadStatistics,       OPT_TYPE_BOOLEAN, "print class preloading statistics at exit" },
 	{ "PrintWarnings",                OPT_PrintWarnings,                OPT_TYPE_BOOLEAN, "print warnings about suspicious behavior"},
 	{ "ProfileGCMemoryUsage",         OPT_ProfileGCMemoryUsage,         OPT_TYPE_VALUE,   "profiles GC memory usage in the given interval, <value> is in seconds (default: 5)" },
 	{ "ProfileMemoryUsage",           OPT_ProfileMemoryUsage,           OPT_TYPE_VALUE,   "TODO" },
 	{ "ProfileMemoryUsageGNUPlot",    OPT_ProfileMemoryUsageGNUPlot,    OPT_TYPE_VALUE,   "TODO" },
+	{ "ReflectionInvokerThreshold",   OPT_ReflectionInvokerThreshold,   OPT_TYPE_VALUE,   "reflective calls of a method after which it gets a specialized invoker, 0 disables (default: 16)" },
 	{ "RegallocSpillAll",             OPT_RegallocSpillAll,             OPT_TYPE_BOOLEAN, "spill all variables to the stack" },
+#if defined(ENABLE_JIT)
+	{ "ScalarOptimizations",          OPT_ScalarOptimizations,          OPT_TYPE_BOOLEAN, "propagate constants, remove redundant computations and reduce strength in optimized compilations of -XX:+TieredCompilation (default: on)" },
+#endif
+	{ "SharedArchiveFile",            OPT_SharedArchiveFile,            OPT_TYPE_VALUE,   "shared archive of bootstrap class files to use (or to create with -XX:+DumpSharedArchive)" },
 #if defined(ENABLE_REPLACEMENT)
 	{ "TestReplacement",              OPT_TestReplacement,              OPT_TYPE_BOOLEAN, "activate all replacement points during code generation" },
+#endif
+#if defined(ENABLE_THREADS)
+	{ "TieredBackEdgeThreshold",      OPT_TieredBackEdgeThreshold,      OPT_TYPE_VALUE,   "loop iterations after which a method is promoted to the optimizing tier (default: 60000)" },
+	{ "TieredCompilation",            OPT_TieredCompilation,            OPT_TYPE_BOOLEAN, "compile methods fast first and recompile hot methods with optimizations" },
+	{ "TieredInvocationThreshold",    OPT_TieredInvocationThreshold,    OPT_TYPE_VALUE,   "invocations after which a method is promoted to the optimizing tier (default: 10000)" },
+	{ "TieredScanInterval",           OPT_TieredScanInterval,           OPT_TYPE_VALUE,   "interval in milliseconds in which the invocation counters are checked (default: 10)" },
 #endif
 	{ "TraceBuiltinCalls",            OPT_TraceBuiltinCalls,            OPT_TYPE_BOOLEAN, "trace calls to VM builtin functions" },
 	{ "TraceCompilerCalls",           OPT_TraceCompilerCalls,           OPT_TYPE_BOOLEAN, "trace JIT compiler calls" },
@@ -366,6 +511,13 @@ option_t options_XX[] = {
 #endif
 	{ "TraceSubsystemInitialization", OPT_TraceSubsystemInitialization, OPT_TYPE_BOOLEAN, "trace initialization of subsystems" },
 	{ "TraceTraps",                   OPT_TraceTraps,                   OPT_TYPE_BOOLEAN, "trace traps generated by JIT code" },
+#if defined(ENABLE_THREADS)
+	{ "TypeProfileThreshold",         OPT_TypeProfileThreshold,         OPT_TYPE_VALUE,   "percentage of the profiled checks of a cast or array store that must see one class before the optimizing tier tests for it first (default: 90)" },
+	{ "TypeProfiles",                 OPT_TypeProfiles,                 OPT_TYPE_BOOLEAN, "profile the classes seen by casts and array stores in the baseline tier (default: on)" },
+#endif
+#if defined(ENABLE_JIT)
+	{ "UnsafeIntrinsics",             OPT_UnsafeIntrinsics,             OPT_TYPE_BOOLEAN, "compile the atomic and volatile sun.misc.Unsafe methods inline (default: on)" },
+#endif
 #if defined(ENABLE_RT_TIMING)
 	{ "RtTimingLogfile",              OPT_RtTimingLogfile,              OPT_TYPE_VALUE,   "rt-timing logfile (default: rt-timing.log, use - for stdout)" },
 #endif
@@ -655,6 +807,18 @@ void options_xx(JavaVMInitArgs *vm_args)
 			opt_AlwaysMmapFirstPage = enable;
 			break;
 
+		case OPT_BoxCache:
+			opt_BoxCache = enable;
+			break;
+
+		case OPT_ClassPathIndex:
+			opt_ClassPathIndex = enable;
+			break;
+
+		case OPT_CompactFields:
+			opt_CompactFields = enable;
+			break;
+
 		case OPT_CompileAll:
 			opt_CompileAll = enable;
 			opt_run = false;
@@ -705,12 +869,36 @@ void options_xx(JavaVMInitArgs *vm_args)
 			break;
 #endif
 
+		case OPT_DumpSharedArchive:
+			opt_DumpSharedArchive = enable;
+			break;
+
+		case OPT_DumpLoadedClassList:
+			opt_DumpLoadedClassList = value;
+			break;
+
+#if defined(ENABLE_JIT)
+		case OPT_EliminateChecks:
+			opt_EliminateChecks = enable;
+			break;
+
+		case OPT_EliminateLocks:
+			opt_EliminateLocks = enable;
+			break;
+#endif
+
 #if defined(ENABLE_OPAGENT)
 		case OPT_EnableOpagent:
 			opt_EnableOpagent = enable;
 			break;
 #endif
 
+#if defined(ENABLE_JIT)
+		case OPT_ExceptionCache:
+			opt_ExceptionCache = enable;
+			break;
+#endif
+
 #if defined(ENABLE_GC_CACAO)
 		case OPT_GCDebugRootSet:
 			opt_GCDebugRootSet = enable;
@@ -721,6 +909,27 @@ void options_xx(JavaVMInitArgs *vm_args)
 			break;
 #endif
 
+#if defined(ENABLE_INLINING) && defined(ENABLE_THREADS)
+		case OPT_GuardedInlining:
+			opt_GuardedInlining = enable;
+			break;
+
+		case OPT_GuardedInliningMisses:
+			if (value != NULL)
+				opt_GuardedInliningMisses = os::atoi(value);
+			break;
+#endif
+
+#if defined(ENABLE_JIT)
+		case OPT_HotColdSplitting:
+			opt_HotColdSplitting = enable;
+			break;
+#endif
+
+		case OPT_ImplicitExceptionThreshold:
+			opt_ImplicitExceptionThreshold = os::atoi(value);
+			break;
+
 #if defined(ENABLE_INLINING)
 		case OPT_Inline:
 			opt_Inline = enable;
@@ -747,10 +956,75 @@ void options_xx(JavaVMInitArgs *vm_args)
 #endif
 #endif
 
+#if defined(ENABLE_JIT)
+		case OPT_LinearScan:
+			opt_LinearScan = enable;
+			break;
+#endif
+
+		case OPT_LockReservation:
+			opt_LockReservation = enable;
+			break;
+
+		case OPT_LogCompilation:
+			opt_LogCompilation = enable;
+			break;
+
+		case OPT_LogCompilationEntries:
+			if (value != NULL)
+				opt_LogCompilationEntries = os::atoi(value);
+			break;
+
+		case OPT_LogCompilationFile:
+			opt_LogCompilationFile = value;
+			break;
+
+#if defined(ENABLE_LOOP)
+		case OPT_LoopInvariantCodeMotion:
+			opt_LoopInvariantCodeMotion = enable;
+			break;
+
+		case OPT_LoopUnrollFactor:
+			if (value != NULL)
+				opt_LoopUnrollFactor = os::atoi(value);
+			break;
+#endif
+
 		case OPT_PrintConfig:
 			opt_PrintConfig = enable;
 			break;
 
+		case OPT_PrintFieldLayout:
+			opt_PrintFieldLayout = enable;
+			break;
+
+		case OPT_PrintImplicitExceptionStatistics:
+			opt_PrintImplicitExceptionStatistics = enable;
+			break;
+
+		case OPT_PrintSharedArchiveStatistics:
+			opt_PrintSharedArchiveStatistics = enable;
+			break;
+
+#if defined(ENABLE_THREADS)
+		case OPT_PrintTieredStatistics:
+			opt_PrintTieredStatistics = enable;
+			break;
+#endif
+
+		case OPT_PreloadClassList:
+			opt_PreloadClassList = value;
+			break;
+
+		case OPT_PreloadThreads:
+			if (value != NULL)
+				opt_PreloadThreads = os::atoi(value);
+			break;
+
+		case OPT_PrintPreloadStatistics:
+			opt_PrintPreloadStatistics = enable;
+			break;
+
 		case OPT_PrintWarnings:
 			opt_PrintWarnings = enable;
 			break;
@@ -791,16 +1065,52 @@ void options_xx(JavaVMInitArgs *vm_args)
 			opt_ProfileMemoryUsageGNUPlot = file;
 			break;
 
+		case OPT_ReflectionInvokerThreshold:
+			if (value != NULL)
+				opt_ReflectionInvokerThreshold = os::atoi(value);
+			break;
+
 		case OPT_RegallocSpillAll:
 			opt_RegallocSpillAll = enable;
 			break;
 
+#if defined(ENABLE_JIT)
+		case OPT_ScalarOptimizations:
+			opt_ScalarOptimizations = enable;
+			break;
+#endif
+
+		case OPT_SharedArchiveFile:
+			opt_SharedArchiveFile = value;
+			break;
+
 #if defined(ENABLE_REPLACEMENT)
 		case OPT_TestReplacement:
 			opt_TestReplacement = enable;
 			break;
 #endif
 
+#if defined(ENABLE_THREADS)
+		case OPT_TieredBackEdgeThreshold:
+			if (value != NULL)
+				opt_TieredBackEdgeThreshold = os::atoi(value);
+			break;
+
+		case OPT_TieredCompilation:
+			opt_TieredCompilation = enable;
+			break;
+
+		case OPT_TieredInvocationThreshold:
+			if (value != NULL)
+				opt_TieredInvocationThreshold = os::atoi(value);
+			break;
+
+		case OPT_TieredScanInterval:
+			if (value != NULL)
+				opt_TieredScanInterval = os::atoi(value);
+			break;
+#endif
+
 		case OPT_TraceBuiltinCalls:
 			opt_TraceBuiltinCalls = enable;
 			break;
@@ -874,6 +1184,23 @@ void options_xx(JavaVMInitArgs *vm_args)
 			opt_TraceTraps = enable;
 			break;
 
+#if defined(ENABLE_THREADS)
+		case OPT_TypeProfileThreshold:
+			if (value != NULL)
+				opt_TypeProfileThreshold = os::atoi(value);
+			break;
+
+		case OPT_TypeProfiles:
+			opt_TypeProfiles = enable;
+			break;
+#endif
+
+#if defined(ENABLE_JIT)
+		case OPT_UnsafeIntrinsics:
+			opt_UnsafeIntrinsics = enable;
+			break;
+#endif
+
 #if defined(ENABLE_RT_TIMING)
 		case OPT_RtTimingLogfile:
 			if (value == NULL)
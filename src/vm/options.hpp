@@ -175,6 +175,9 @@ extern int      opt_ThreadStackSize;
 
 extern bool     opt_AlwaysEmitLongBranches;
 extern bool     opt_AlwaysMmapFirstPage;
+extern int      opt_BoxCache;
+extern int      opt_ClassPathIndex;
+extern int      opt_CompactFields;
 extern int      opt_CompileAll;
 extern char*    opt_CompileMethod;
 extern char*    opt_CompileSignature;
@@ -188,13 +191,30 @@ extern int      opt_DebugThreads;
 #if defined(ENABLE_DISASSEMBLER)
 extern int      opt_DisassembleStubs;
 #endif
+extern int      opt_DumpSharedArchive;
+extern char*    opt_DumpLoadedClassList;
+#if defined(ENABLE_JIT)
+extern int      opt_EliminateChecks;
+extern int      opt_EliminateLocks;
+#endif
 #if defined(ENABLE_OPAGENT)
 extern int      opt_EnableOpagent;
 #endif
+#if defined(ENABLE_JIT)
+extern int      opt_ExceptionCache;
+#endif
 #if defined(ENABLE_GC_CACAO)
 extern int      opt_GCDebugRootSet;
 extern int      opt_GCStress;
 #endif
+#if defined(ENABLE_INLINING) && defined(ENABLE_THREADS)
+extern int      opt_GuardedInlining;
+extern int      opt_GuardedInliningMisses;
+#endif
+#if defined(ENABLE_JIT)
+extern int      opt_HotColdSplitting;
+#endif
+extern int      opt_ImplicitExceptionThreshold;
 #if defined(ENABLE_INLINING)
 extern int      opt_Inline;
 #if defined(ENABLE_INLINING_DEBUG) || !defined(NDEBUG)
@@ -204,15 +224,46 @@ extern int      opt_InlineMaxSize;
 extern int      opt_InlineMinSize;
 #endif
 #endif
+#if defined(ENABLE_JIT)
+extern int      opt_LinearScan;
+#endif
+extern int      opt_LockReservation;
+extern int      opt_LogCompilation;
+extern int      opt_LogCompilationEntries;
+extern char*    opt_LogCompilationFile;
+#if defined(ENABLE_LOOP)
+extern int      opt_LoopInvariantCodeMotion;
+extern int      opt_LoopUnrollFactor;
+#endif
 extern int      opt_PrintConfig;
+extern int      opt_PrintFieldLayout;
+extern int      opt_PrintImplicitExceptionStatistics;
+extern int      opt_PrintSharedArchiveStatistics;
+#if defined(ENABLE_THREADS)
+extern int      opt_PrintTieredStatistics;
+#endif
+extern char*    opt_PreloadClassList;
+extern int      opt_PreloadThreads;
+extern int      opt_PrintPreloadStatistics;
 extern int      opt_PrintWarnings;
 extern int      opt_ProfileGCMemoryUsage;
 extern int      opt_ProfileMemoryUsage;
 extern FILE    *opt_ProfileMemoryUsageGNUPlot;
+extern int      opt_ReflectionInvokerThreshold;
 extern int      opt_RegallocSpillAll;
+#if defined(ENABLE_JIT)
+extern int      opt_ScalarOptimizations;
+#endif
+extern char*    opt_SharedArchiveFile;
 #if defined(ENABLE_REPLACEMENT)
 extern int      opt_TestReplacement;
 #endif
+#if defined(ENABLE_THREADS)
+extern int      opt_TieredBackEdgeThreshold;
+extern int      opt_TieredCompilation;
+extern int      opt_TieredInvocationThreshold;
+extern int      opt_TieredScanInterval;
+#endif
 extern int      opt_TraceBuiltinCalls;
 extern int      opt_TraceCompilerCalls;
 extern int      opt_TraceExceptions;
@@ -240,6 +291,13 @@ extern int      opt_TraceReplacement;
 #endif
 extern int      opt_TraceSubsystemInitialization;
 extern int      opt_TraceTraps;
+#if defined(ENABLE_THREADS)
+extern int      opt_TypeProfileThreshold;
+extern int      opt_TypeProfiles;
+#endif
+#if defined(ENABLE_JIT)
+extern int      opt_UnsafeIntrinsics;
+#endif
 
 
 /* function prototypes ********************************************************/
@@ -0,0 +1,448 @@
+/* src/vm/preload.cpp - parallel preloading of bootstrap class files
+
+   Copyright (C) 1996-2013
+   CACAOVM - Verein zur Foerderung der freien virtuellen Maschine CACAO
+
+   This file is part of CACAO.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation; either version 2, or (at
+   your option) any later version.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA.
+
+*/
+
+
+#include "config.h"
+
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#if defined(ENABLE_THREADS)
+# include <pthread.h>
+#endif
+
+#include "mm/memory.hpp"
+
+#include "threads/condition.hpp"
+#include "threads/mutex.hpp"
+
+#include "toolbox/hashtable.hpp"
+#include "toolbox/logging.hpp"
+
+#include "vm/options.hpp"
+#include "vm/os.hpp"
+#include "vm/preload.hpp"
+#include "vm/sharedarchive.hpp"
+#include "vm/statistics.hpp"
+#include "vm/suck.hpp"
+#include "vm/types.hpp"
+#include "vm/utf8.hpp"
+#include "vm/vm.hpp"
+
+using namespace cacao;
+
+
+STAT_DECLARE_GROUP(memory_stat)
+STAT_REGISTER_SUBGROUP(preload_stat,"preload","parallel class preloading",memory_stat)
+STAT_REGISTER_GROUP_VAR(int,count_preload_ready,0,"ready","preloaded class files ready when needed",preload_stat)
+STAT_REGISTER_GROUP_VAR(int,count_preload_waited,0,"waited","preloaded class files waited for",preload_stat)
+STAT_REGISTER_GROUP_VAR(int,count_preload_self,0,"self","listed class files read by the loader itself",preload_stat)
+
+
+/* hashtable entry for listed classes *****************************************/
+
+enum PreloadState {
+	PRELOAD_PENDING,                    // not yet picked up by a helper
+	PRELOAD_RUNNING,                    // a helper is reading the file
+	PRELOAD_DONE,                       // the class file is ready
+	PRELOAD_TAKEN                       // handed to the loader
+};
+
+struct PreloadEntry {
+	Utf8String    name;
+	PreloadState  state;
+	uint8_t      *data;
+	size_t        size;
+	const char   *path;
+	bool          mapped;
+
+	/// interface to HashTable
+	size_t hash() const { return name.hash(); }
+
+	Utf8String key() const { return name; }
+	void set_key(Utf8String u) { name = u; }
+};
+
+typedef HashTable<InsertOnlyNamedEntry<PreloadEntry> > PreloadTable;
+
+
+/* global variables ***********************************************************/
+
+static PreloadTable               *preload_table = NULL;
+static std::vector<PreloadEntry*> *preload_queue = NULL;
+static size_t                      preload_next  = 0;
+
+static Mutex                      *preload_mutex = NULL;
+static Condition                  *preload_cond  = NULL;
+
+static FILE                       *dump_file     = NULL;
+static Mutex                      *dump_mutex    = NULL;
+
+// Counters for -XX:+PrintPreloadStatistics, these are kept
+// independently of the statistics framework.
+static int preload_listed  = 0;
+static int preload_read    = 0;
+static int preload_ready   = 0;
+static int preload_waited  = 0;
+static int preload_self    = 0;
+
+
+/**
+ * Read the class list.  Empty lines and lines starting with '#' are
+ * ignored, class names may be given with dots or slashes.
+ */
+static bool preload_read_list(const char *filename)
+{
+	FILE *f = os::fopen(filename, "r");
+
+	if (f == NULL)
+		return false;
+
+	char                    line[1024];
+	std::vector<Utf8String> names;
+
+	while (fgets(line, sizeof(line), f) != NULL) {
+		size_t len = strlen(line);
+
+		while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r' || line[len - 1] == ' '))
+			len--;
+
+		if (len == 0 || line[0] == '#')
+			continue;
+
+		Utf8String name = Utf8String::from_utf8_dot_to_slash(line, len);
+
+		if (name == NULL)
+			continue;
+
+		// classes from the shared archive need no reading at all
+
+		if (SharedArchive::contains(name))
+			continue;
+
+		PreloadTable::EntryRef ref = preload_table->find(name);
+
+		if (ref)
+			continue;
+
+		PreloadEntry e;
+
+		e.name   = name;
+		e.state  = PRELOAD_PENDING;
+		e.data   = NULL;
+		e.size   = 0;
+		e.path   = NULL;
+		e.mapped = false;
+
+		preload_table->insert(ref, e);
+
+		names.push_back(name);
+	}
+
+	os::fclose(f);
+
+	// inserting invalidates pointers into the table, so the queue is
+	// only built once the table is complete
+
+	for (std::vector<Utf8String>::iterator it = names.begin(); it != names.end(); it++)
+		preload_queue->push_back(&*preload_table->find(*it));
+
+	preload_listed = preload_queue->size();
+
+	return true;
+}
+
+
+#if defined(ENABLE_THREADS)
+/**
+ * Helper thread: read listed class files in list order until the list
+ * is exhausted.  Helper threads are not attached to the VM, they only
+ * do the file I/O into buffers from os::malloc.  The buffers are copied
+ * to VM memory by the loading thread in ClassPreloader::take.
+ */
+static void *preload_thread(void *)
+{
+	for (;;) {
+		PreloadEntry *e;
+
+		{
+			MutexLocker lock(*preload_mutex);
+
+			if (preload_next == preload_queue->size())
+				break;
+
+			e = (*preload_queue)[preload_next++];
+
+			if (e->state != PRELOAD_PENDING)
+				continue;
+
+			e->state = PRELOAD_RUNNING;
+		}
+
+		ClassBuffer cb(e->name);
+
+		MutexLocker lock(*preload_mutex);
+
+		if (cb) {
+			e->data   = const_cast<uint8_t*>(cb.get_data());
+			e->size   = cb.remaining();
+			e->path   = cb.get_path();
+			e->mapped = cb.is_mapped();
+
+			preload_read++;
+		}
+
+		e->state = PRELOAD_DONE;
+
+		preload_cond->broadcast();
+	}
+
+	return NULL;
+}
+#endif
+
+
+/**
+ * Start the preloader.  Must be called after the bootstrap classpath
+ * and the shared archive are initialized.
+ */
+void ClassPreloader::start()
+{
+	TRACESUBSYSTEMINITIALIZATION("preload_init");
+
+	if (opt_DumpLoadedClassList != NULL) {
+		dump_file = os::fopen(opt_DumpLoadedClassList, "w");
+
+		if (dump_file == NULL)
+			log_println("[Could not open class list %s for writing]", opt_DumpLoadedClassList);
+		else
+			dump_mutex = new Mutex();
+	}
+
+	if (opt_PreloadClassList == NULL)
+		return;
+
+	preload_table = new PreloadTable();
+	preload_queue = new std::vector<PreloadEntry*>();
+
+	if (!preload_read_list(opt_PreloadClassList)) {
+		log_println("[Could not read class list %s]", opt_PreloadClassList);
+		return;
+	}
+
+	preload_mutex = new Mutex();
+	preload_cond  = new Condition();
+
+#if defined(ENABLE_THREADS)
+	int threads = opt_PreloadThreads;
+
+	if (threads < 0)
+		threads = 0;
+
+	for (int i = 0; i < threads; i++) {
+		pthread_t      tid;
+		pthread_attr_t attr;
+
+		pthread_attr_init(&attr);
+		pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+
+		int result = pthread_create(&tid, &attr, preload_thread, NULL);
+
+		pthread_attr_destroy(&attr);
+
+		if (result != 0) {
+			if (opt_verbose)
+				log_println("[Could not start class preloading thread: %s]", strerror(result));
+			break;
+		}
+	}
+#endif
+}
+
+
+/**
+ * Hand a preloaded class file to the bootstrap class loader.
+ *
+ * @param name Name of the class.
+ * @param data Returns the class file data, to be freed by the caller
+ *             unless it is mapped.
+ * @param size Returns the size of the class file.
+ * @param path Returns the classpath entry the file was read from.
+ * @param mapped Returns true if the data is mapped from an archive and
+ *               must not be freed.
+ *
+ * @return true if a preloaded class file is returned, false if the
+ *         caller has to read the class file itself.
+ */
+bool ClassPreloader::take(Utf8String name, uint8_t **data, size_t *size, const char **path, bool *mapped)
+{
+	if (preload_mutex == NULL)
+		return false;
+
+	MutexLocker lock(*preload_mutex);
+
+	PreloadTable::EntryRef ref = preload_table->find(name);
+
+	if (!ref)
+		return false;
+
+	PreloadEntry& e = *ref;
+
+	switch (e.state) {
+	case PRELOAD_PENDING:
+		// the loader is faster than the helpers, no point in waiting
+		e.state = PRELOAD_TAKEN;
+
+		preload_self++;
+		STATISTICS(count_preload_self++);
+		return false;
+
+	case PRELOAD_RUNNING:
+		while (e.state == PRELOAD_RUNNING)
+			preload_cond->wait(preload_mutex);
+
+		preload_waited++;
+		STATISTICS(count_preload_waited++);
+		break;
+
+	case PRELOAD_DONE:
+		preload_ready++;
+		STATISTICS(count_preload_ready++);
+		break;
+
+	case PRELOAD_TAKEN:
+		return false;
+	}
+
+	e.state = PRELOAD_TAKEN;
+
+	if (e.data == NULL)
+		return false;
+
+	if (e.mapped)
+		*data = e.data;
+	else {
+		*data = MNEW(uint8_t, e.size);
+		MCOPY(*data, e.data, uint8_t, e.size);
+		os::free(e.data);
+	}
+
+	*size   = e.size;
+	*path   = e.path;
+	*mapped = e.mapped;
+
+	e.data = NULL;
+
+	return true;
+}
+
+
+/**
+ * End of the startup phase: stop the helper threads and release the
+ * class files nobody asked for.  Classes of the list loaded later are
+ * read by the loader itself.
+ */
+void ClassPreloader::finish()
+{
+	if (preload_mutex == NULL)
+		return;
+
+	MutexLocker lock(*preload_mutex);
+
+	// helpers pick up no further entries
+
+	preload_next = preload_queue->size();
+
+	for (std::vector<PreloadEntry*>::iterator it = preload_queue->begin(); it != preload_queue->end(); it++) {
+		PreloadEntry *e = *it;
+
+		while (e->state == PRELOAD_RUNNING)
+			preload_cond->wait(preload_mutex);
+
+		if (e->state == PRELOAD_TAKEN)
+			continue;
+
+		if ((e->data != NULL) && !e->mapped)
+			os::free(e->data);
+
+		e->data = NULL;
+	}
+}
+
+
+/**
+ * Append a class loaded by the bootstrap class loader to the class
+ * list given with -XX:DumpLoadedClassList.
+ */
+void ClassPreloader::loaded(Utf8String name)
+{
+	if (dump_file == NULL)
+		return;
+
+	MutexLocker lock(*dump_mutex);
+
+	fwrite(name.begin(), 1, name.size(), dump_file);
+	fputc('\n', dump_file);
+	fflush(dump_file);
+}
+
+
+/**
+ * Print preloader statistics (-XX:+PrintPreloadStatistics).
+ */
+void ClassPreloader::print_statistics()
+{
+	if (preload_mutex == NULL)
+		return;
+
+	MutexLocker lock(*preload_mutex);
+
+	int unused = 0;
+
+	for (std::vector<PreloadEntry*>::iterator it = preload_queue->begin(); it != preload_queue->end(); it++) {
+		if ((*it)->state != PRELOAD_TAKEN)
+			unused++;
+	}
+
+	log_println("[Class preloading: %d classes listed, %d preloaded by %d threads]", preload_listed, preload_read, opt_PreloadThreads);
+	log_println("[  %d ready when needed, %d waited for, %d read by the loader, %d unused]", preload_ready, preload_waited, preload_self, unused);
+	log_println("[  VM startup took %ld ms]", (long) (VM::get_current()->get_inittime() - VM::get_current()->get_starttime()));
+}
+
+
+/*
+ * These are local overrides for various environment variables in Emacs.
+ * Please do not remove this and leave it at the end of the file, where
+ * Emacs will automagically detect them.
+ * ---------------------------------------------------------------------
+ * Local variables:
+ * mode: c++
+ * indent-tabs-mode: t
+ * c-basic-offset: 4
+ * tab-width: 4
+ * End:
+ * vim:noexpandtab:sw=4:ts=4:
+ */
@@ -0,0 +1,75 @@
+/* src/vm/preload.hpp - parallel preloading of bootstrap class files
+
+   Copyright (C) 1996-2013
+   CACAOVM - Verein zur Foerderung der freien virtuellen Maschine CACAO
+
+   This file is part of CACAO.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation; either version 2, or (at
+   your option) any later version.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA.
+
+*/
+
+
+#ifndef PRELOAD_HPP_
+#define PRELOAD_HPP_ 1
+
+#include "config.h"
+
+#include <cstddef>                      // for size_t
+#include <stdint.h>                     // for uint8_t
+
+#include "vm/utf8.hpp"                  // for Utf8String
+
+
+/**
+ * Reads the class files of a list of bootstrap classes on helper
+ * threads while the VM is starting up.
+ *
+ * The class list (-XX:PreloadClassList) is usually written by a
+ * previous run with -XX:DumpLoadedClassList.  The helper threads only
+ * read and inflate the class files, parsing and linking is still done
+ * by the thread loading the class.  When the loader asks for a class
+ * file that a helper thread is reading right now, it waits for it; if
+ * no helper thread got to it yet, the loader reads it itself.  Class
+ * files not taken when the main method is called are released.
+ */
+class ClassPreloader {
+public:
+	static void start();
+
+	static bool take(Utf8String name, uint8_t **data, size_t *size, const char **path, bool *mapped);
+	static void finish();
+	static void loaded(Utf8String name);
+
+	static void print_statistics();
+};
+
+#endif // PRELOAD_HPP_
+
+
+/*
+ * These are local overrides for various environment variables in Emacs.
+ * Please do not remove this and leave it at the end of the file, where
+ * Emacs will automagically detect them.
+ * ---------------------------------------------------------------------
+ * Local variables:
+ * mode: c++
+ * indent-tabs-mode: t
+ * c-basic-offset: 4
+ * tab-width: 4
+ * End:
+ * vim:noexpandtab:sw=4:ts=4:
+ */
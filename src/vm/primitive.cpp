@@ -27,22 +27,35 @@
 
 #include <assert.h>
 #include <stdint.h>
+#include <stdio.h>
+
+#include "mm/gc.hpp"
 
 #include "native/llni.hpp"
 
+#include "threads/atomic.hpp"
+
 #include "toolbox/logging.hpp"
 
 #include "vm/jit/builtin.hpp"
 #include "vm/class.hpp"
+#include "vm/exceptions.hpp"
 #include "vm/global.hpp"
 #include "vm/globals.hpp"
 #include "vm/javaobjects.hpp"
 #include "vm/options.hpp"
 #include "vm/os.hpp"
 #include "vm/primitive.hpp"
+#include "vm/statistics.hpp"
 #include "vm/utf8.hpp"
+#include "vm/vftbl.hpp"
 #include "vm/vm.hpp"
 
+using namespace cacao;
+
+
+STAT_REGISTER_VAR(int,count_box_cached,0,"cached boxes","primitives boxed with a cached wrapper")
+
 
 /* primitivetype_table *********************************************************
 
@@ -75,6 +88,181 @@ primitivetypeinfo primitivetype_table[PRIMITIVETYPE_MAX] = {
 };
 
 
+/* widening_table **************************************************************
+
+   For every primitive type the wrapper types whose values can be
+   converted to it by an identity or widening primitive conversion
+   (JLS 5.1.2).  Bit n of an entry stands for the source type n.
+   Indexed like primitivetype_table.
+
+*******************************************************************************/
+
+#define PRIMITIVE_BIT(t)     (1 << (t))
+
+#define WIDEN_FROM_BYTE      (PRIMITIVE_BIT(PRIMITIVETYPE_BYTE))
+#define WIDEN_FROM_SHORT     (WIDEN_FROM_BYTE | PRIMITIVE_BIT(PRIMITIVETYPE_SHORT))
+#define WIDEN_FROM_INT       (WIDEN_FROM_SHORT | PRIMITIVE_BIT(PRIMITIVETYPE_CHAR) | \
+                              PRIMITIVE_BIT(PRIMITIVETYPE_INT))
+#define WIDEN_FROM_LONG      (WIDEN_FROM_INT | PRIMITIVE_BIT(PRIMITIVETYPE_LONG))
+#define WIDEN_FROM_FLOAT     (WIDEN_FROM_LONG | PRIMITIVE_BIT(PRIMITIVETYPE_FLOAT))
+#define WIDEN_FROM_DOUBLE    (WIDEN_FROM_FLOAT | PRIMITIVE_BIT(PRIMITIVETYPE_DOUBLE))
+
+static const int32_t widening_table[PRIMITIVETYPE_MAX] = {
+	WIDEN_FROM_INT,                          /* int                        */
+	WIDEN_FROM_LONG,                         /* long                       */
+	WIDEN_FROM_FLOAT,                        /* float                      */
+	WIDEN_FROM_DOUBLE,                       /* double                     */
+	0,
+	WIDEN_FROM_BYTE,                         /* byte                       */
+	PRIMITIVE_BIT(PRIMITIVETYPE_CHAR),       /* char                       */
+	WIDEN_FROM_SHORT,                        /* short                      */
+	PRIMITIVE_BIT(PRIMITIVETYPE_BOOLEAN),    /* boolean                    */
+	0,
+	0                                        /* void                       */
+};
+
+
+/* wrapper vftbls **************************************************************
+
+   Open addressing hash table mapping the vftbls of the wrapper
+   classes to their primitive types, so unboxing finds the type of a
+   wrapper with a single probe.  It has more slots than there are
+   wrapper classes, so every probe sequence ends at an empty slot.
+
+*******************************************************************************/
+
+#define WRAPPER_VFTBL_SLOTS    16
+
+struct wrapper_vftbl_t {
+	vftbl_t *vftbl;
+	int      type;
+};
+
+static wrapper_vftbl_t wrapper_vftbls[WRAPPER_VFTBL_SLOTS];
+
+static inline uint32_t wrapper_vftbl_slot(vftbl_t *v)
+{
+	return ((uintptr_t) v >> 4) % WRAPPER_VFTBL_SLOTS;
+}
+
+static void wrapper_vftbl_add(vftbl_t *v, int type)
+{
+	uint32_t i = wrapper_vftbl_slot(v);
+
+	while (wrapper_vftbls[i].vftbl != NULL)
+		i = (i + 1) % WRAPPER_VFTBL_SLOTS;
+
+	wrapper_vftbls[i].vftbl = v;
+	wrapper_vftbls[i].type  = type;
+}
+
+/**
+ * Returns the primitive type boxed by the given object, -1 if it is
+ * not a wrapper.
+ */
+static inline int wrapper_vftbl_type(java_handle_t *h)
+{
+	vftbl_t *v;
+
+	LLNI_CRITICAL_START;
+
+	v = LLNI_vftbl_direct(h);
+
+	LLNI_CRITICAL_END;
+
+	for (uint32_t i = wrapper_vftbl_slot(v); wrapper_vftbls[i].vftbl != NULL; i = (i + 1) % WRAPPER_VFTBL_SLOTS)
+		if (wrapper_vftbls[i].vftbl == v)
+			return wrapper_vftbls[i].type;
+
+	return -1;
+}
+
+
+/* box cache *******************************************************************
+
+   The wrappers of the values the wrapper classes cache themselves
+   (JLS 5.1.7): both booleans, all bytes, chars up to 127 and shorts
+   and ints from -128 to 127.  Each slot is filled with the result of
+   valueOf the first time the value is boxed, so the VM hands out the
+   same instances as autoboxing does.  The array is a GC root.
+
+*******************************************************************************/
+
+enum {
+	BOXCACHE_BOOLEAN = 0,
+	BOXCACHE_BYTE    = BOXCACHE_BOOLEAN + 2,
+	BOXCACHE_CHAR    = BOXCACHE_BYTE    + 256,
+	BOXCACHE_SHORT   = BOXCACHE_CHAR    + 128,
+	BOXCACHE_INT     = BOXCACHE_SHORT   + 256,
+	BOXCACHE_SIZE    = BOXCACHE_INT     + 256
+};
+
+static java_object_t **boxcache = NULL;
+static methodinfo     *boxcache_valueof[PRIMITIVETYPE_MAX];
+
+/**
+ * Returns the cached wrapper of the value, NULL if it is not cached
+ * and cannot be taken from valueOf right now.
+ *
+ * @param type  Primitive type of the value.
+ * @param slot  Slot of the value in the cache.
+ * @param value Value to box.
+ */
+static java_handle_t *boxcache_get(int type, int slot, int32_t value)
+{
+	if (boxcache == NULL)
+		return NULL;
+
+	java_object_t *o = boxcache[slot];
+
+	if (o != NULL) {
+		STATISTICS(count_box_cached++);
+		return LLNI_WRAP(o);
+	}
+
+	// Calling Java is only safe once the VM is up and no exception
+	// is pending.
+
+	if (!VM::get_current()->is_created() || exceptions_get_exception() != NULL)
+		return NULL;
+
+	methodinfo *m = boxcache_valueof[type];
+
+	if (m == NULL) {
+		classinfo *c = primitivetype_table[type].class_wrap;
+		char       desc[64];
+
+		snprintf(desc, sizeof(desc), "(%c)L%s;",
+				 primitivetype_table[type].typesig,
+				 primitivetype_table[type].wrapname);
+
+		m = class_resolveclassmethod(c, Utf8String::from_utf8("valueOf"), Utf8String::from_utf8(desc), c, false);
+
+		if (m == NULL)
+			return NULL;
+
+		boxcache_valueof[type] = m;
+	}
+
+	java_handle_t *h = vm_call_method(m, NULL, value);
+
+	if (h == NULL) {
+		exceptions_clear_exception();
+		return NULL;
+	}
+
+	LLNI_CRITICAL_START;
+
+	Atomic::write_memory_barrier();
+
+	boxcache[slot] = LLNI_DIRECT(h);
+
+	LLNI_CRITICAL_END;
+
+	return h;
+}
+
+
 /**
  * Fill the primitive type table with the primitive-type classes,
  * array-classes and wrapper classes.  This is important in the VM
@@ -187,6 +375,20 @@ void Primitive::initialize_table()
 		assert(c->state & CLASS_LINKED);
 
 		primitivetype_table[i].class_wrap = c;
+
+		wrapper_vftbl_add(c->vftbl, i);
+	}
+
+	if (opt_BoxCache) {
+		boxcache = (java_object_t **) heap_alloc_uncollectable(sizeof(java_object_t *) * BOXCACHE_SIZE);
+
+		for (int i = 0; i < BOXCACHE_SIZE; i++) {
+			boxcache[i] = NULL;
+
+#if defined(ENABLE_GC_CACAO)
+			gc_reference_register(&(boxcache[i]), GC_REFTYPE_JNI_GLOBALREF);
+#endif
+		}
 	}
 }
 
@@ -360,6 +562,21 @@ int Primitive::get_type_by_wrapperclass(classinfo *c)
 }
 
 
+/**
+ * Returns the primitive type boxed by the given object.  Unlike
+ * get_type_by_wrapperclass this needs a single hash table probe.
+ *
+ * @param h Handle of the object, must not be NULL.
+ *
+ * @return Integer type of the boxed value, -1 if the object is not a
+ * wrapper.
+ */
+int Primitive::get_type_by_wrapper(java_handle_t *h)
+{
+	return wrapper_vftbl_type(h);
+}
+
+
 /**
  * Returns the primitive type of the given primitive-class.
  *
@@ -441,7 +658,6 @@ java_handle_t* Primitive::box(int type, imm_union value)
  */
 imm_union Primitive::unbox(java_handle_t *h)
 {
-	classinfo *c;
 	imm_union  value;
 
 	if (h == NULL) {
@@ -449,9 +665,7 @@ imm_union Primitive::unbox(java_handle_t *h)
 		return value;
 	}
 
-	LLNI_class_get(h, c);
-
-	int type = get_type_by_wrapperclass(c);
+	int type = wrapper_vftbl_type(h);
 
 	switch (type) {
 	case PRIMITIVETYPE_BOOLEAN:
@@ -492,157 +706,109 @@ imm_union Primitive::unbox(java_handle_t *h)
 
 
 /**
- * Unbox a primitive of the given type. Also checks if the
- * boxed primitive type can be widened into the destination
- * type. This conversion is done according to
- * "The Java Language Specification, Third Edition,
- * $5.1.2 Widening Primitive Conversion".
+ * Widens an unboxed value to the given primitive type.  The value
+ * is converted according to "The Java Language Specification, Third
+ * Edition, $5.1.2 Widening Primitive Conversion".  The reflective
+ * calls and Array::set_element use this for their conversions.
  *
- * @param h Handle of the boxing Java object.
+ * @param src_type Primitive type of the value, -1 for an object.
  * @param type Destination type of the conversion.
- * @param value Pointer to union where the resulting primitive
- * value will be stored will.
+ * @param value Value as returned by Primitive::unbox, replaced by the
+ * converted value.
  *
- * @return True of the conversion is allowed, false otherwise.
+ * @return True if the conversion is allowed, false otherwise.
  */
-bool Primitive::unbox_typed(java_handle_t *h, int type, imm_union* value)
+bool Primitive::widen(int src_type, int type, imm_union* value)
 {
-	classinfo *c;
-	int        src_type;
+	float  f;
+	double d;
 
-	if (h == NULL)
+	if ((src_type < 0) || (type < 0) || (type >= PRIMITIVETYPE_MAX))
 		return false;
 
-	LLNI_class_get(h, c);
+	if (!(widening_table[type] & PRIMITIVE_BIT(src_type)))
+		return false;
 
-	src_type = get_type_by_wrapperclass(c);
+	switch (type) {
+	case PRIMITIVETYPE_LONG:
+		if (src_type != PRIMITIVETYPE_LONG)
+			value->l = value->i;
+		break;
 
-	switch (src_type) {
-	case PRIMITIVETYPE_BOOLEAN:
-		switch (type) {
-			case PRIMITIVETYPE_BOOLEAN:
-				value->i = unbox_boolean(h);
-				return true;
-			default:
-				return false;
+	case PRIMITIVETYPE_FLOAT:
+		switch (src_type) {
+		case PRIMITIVETYPE_FLOAT:
+			f = value->f;
+			break;
+		case PRIMITIVETYPE_LONG:
+			f = value->l;
+			break;
+		default:
+			f = value->i;
+			break;
 		}
 
-	case PRIMITIVETYPE_BYTE:
-		switch (type) {
-			case PRIMITIVETYPE_BYTE:
-			case PRIMITIVETYPE_SHORT:
-			case PRIMITIVETYPE_INT:
-				value->i = unbox_byte(h);
-				return true;
-			case PRIMITIVETYPE_LONG:
-				value->l = unbox_byte(h);
-				return true;
-			case PRIMITIVETYPE_FLOAT:
-				value->f = unbox_byte(h);
-				return true;
-			case PRIMITIVETYPE_DOUBLE:
-				value->d = unbox_byte(h);
-				return true;
-			default:
-				return false;
-		}
+		/* clear the unused half, the value is passed in a 64-bit slot */
 
-	case PRIMITIVETYPE_CHAR:
-		switch (type) {
-			case PRIMITIVETYPE_CHAR:
-			case PRIMITIVETYPE_INT:
-				value->i = unbox_char(h);
-				return true;
-			case PRIMITIVETYPE_LONG:
-				value->l = unbox_char(h);
-				return true;
-			case PRIMITIVETYPE_FLOAT:
-				value->f = unbox_char(h);
-				return true;
-			case PRIMITIVETYPE_DOUBLE:
-				value->d = unbox_char(h);
-				return true;
-			default:
-				return false;
-		}
+		value->l = 0;
+		value->f = f;
+		break;
 
-	case PRIMITIVETYPE_SHORT:
-		switch (type) {
-			case PRIMITIVETYPE_SHORT:
-			case PRIMITIVETYPE_INT:
-				value->i = unbox_short(h);
-				return true;
-			case PRIMITIVETYPE_LONG:
-				value->l = unbox_short(h);
-				return true;
-			case PRIMITIVETYPE_FLOAT:
-				value->f = unbox_short(h);
-				return true;
-			case PRIMITIVETYPE_DOUBLE:
-				value->d = unbox_short(h);
-				return true;
-			default:
-				return false;
+	case PRIMITIVETYPE_DOUBLE:
+		switch (src_type) {
+		case PRIMITIVETYPE_DOUBLE:
+			d = value->d;
+			break;
+		case PRIMITIVETYPE_FLOAT:
+			d = value->f;
+			break;
+		case PRIMITIVETYPE_LONG:
+			d = value->l;
+			break;
+		default:
+			d = value->i;
+			break;
 		}
 
-	case PRIMITIVETYPE_INT:
-		switch (type) {
-			case PRIMITIVETYPE_INT:
-				value->i = unbox_int(h);
-				return true;
-			case PRIMITIVETYPE_LONG:
-				value->l = unbox_int(h);
-				return true;
-			case PRIMITIVETYPE_FLOAT:
-				value->f = unbox_int(h);
-				return true;
-			case PRIMITIVETYPE_DOUBLE:
-				value->d = unbox_int(h);
-				return true;
-			default:
-				return false;
-		}
+		value->d = d;
+		break;
 
-	case PRIMITIVETYPE_LONG:
-		switch (type) {
-			case PRIMITIVETYPE_LONG:
-				value->l = unbox_long(h);
-				return true;
-			case PRIMITIVETYPE_FLOAT:
-				value->f = unbox_long(h);
-				return true;
-			case PRIMITIVETYPE_DOUBLE:
-				value->d = unbox_long(h);
-				return true;
-			default:
-				return false;
-		}
+	default:
+		/* the int-like types are all kept in value->i */
+		break;
+	}
 
-	case PRIMITIVETYPE_FLOAT:
-		switch (type) {
-			case PRIMITIVETYPE_FLOAT:
-				value->f = unbox_float(h);
-				return true;
-			case PRIMITIVETYPE_DOUBLE:
-				value->d = unbox_float(h);
-				return true;
-			default:
-				return false;
-		}
+	return true;
+}
 
-	case PRIMITIVETYPE_DOUBLE:
-		switch (type) {
-			case PRIMITIVETYPE_DOUBLE:
-				value->d = unbox_double(h);
-				return true;
-			default:
-				return false;
-		}
 
-	default:
-		os::abort("Primitive::unbox_typed: Invalid primitive type %d", type);
+/**
+ * Unbox a primitive of the given type. Also checks if the
+ * boxed primitive type can be widened into the destination
+ * type, see Primitive::widen.
+ *
+ * @param h Handle of the boxing Java object.
+ * @param type Destination type of the conversion.
+ * @param value Pointer to union where the resulting primitive
+ * value will be stored will.
+ *
+ * @return True of the conversion is allowed, false otherwise.
+ */
+bool Primitive::unbox_typed(java_handle_t *h, int type, imm_union* value)
+{
+	int        src_type;
+
+	if (h == NULL)
 		return false;
-	}
+
+	src_type = wrapper_vftbl_type(h);
+
+	if (src_type < 0)
+		os::abort("Primitive::unbox_typed: Invalid primitive type %d", type);
+
+	*value = unbox(h);
+
+	return widen(src_type, type, value);
 }
 
 
@@ -651,7 +817,12 @@ bool Primitive::unbox_typed(java_handle_t *h, int type, imm_union* value)
  */
 java_handle_t* Primitive::box(uint8_t value)
 {
-	java_handle_t *h = builtin_new(class_java_lang_Boolean);
+	java_handle_t *h = boxcache_get(PRIMITIVETYPE_BOOLEAN, BOXCACHE_BOOLEAN + (value != 0), value != 0);
+
+	if (h != NULL)
+		return h;
+
+	h = builtin_new(class_java_lang_Boolean);
 
 	if (h == NULL)
 		return NULL;
@@ -664,7 +835,12 @@ java_handle_t* Primitive::box(uint8_t value)
 
 java_handle_t* Primitive::box(int8_t value)
 {
-	java_handle_t *h = builtin_new(class_java_lang_Byte);
+	java_handle_t *h = boxcache_get(PRIMITIVETYPE_BYTE, BOXCACHE_BYTE + 128 + value, value);
+
+	if (h != NULL)
+		return h;
+
+	h = builtin_new(class_java_lang_Byte);
 
 	if (h == NULL)
 		return NULL;
@@ -677,7 +853,15 @@ java_handle_t* Primitive::box(int8_t value)
 
 java_handle_t* Primitive::box(uint16_t value)
 {
-	java_handle_t *h = builtin_new(class_java_lang_Character);
+	java_handle_t *h = NULL;
+
+	if (value <= 127)
+		h = boxcache_get(PRIMITIVETYPE_CHAR, BOXCACHE_CHAR + value, value);
+
+	if (h != NULL)
+		return h;
+
+	h = builtin_new(class_java_lang_Character);
 
 	if (h == NULL)
 		return NULL;
@@ -690,7 +874,15 @@ java_handle_t* Primitive::box(uint16_t value)
 
 java_handle_t* Primitive::box(int16_t value)
 {
-	java_handle_t *h = builtin_new(class_java_lang_Short);
+	java_handle_t *h = NULL;
+
+	if (value >= -128 && value <= 127)
+		h = boxcache_get(PRIMITIVETYPE_SHORT, BOXCACHE_SHORT + 128 + value, value);
+
+	if (h != NULL)
+		return h;
+
+	h = builtin_new(class_java_lang_Short);
 
 	if (h == NULL)
 		return NULL;
@@ -703,7 +895,15 @@ java_handle_t* Primitive::box(int16_t value)
 
 java_handle_t* Primitive::box(int32_t value)
 {
-	java_handle_t *h = builtin_new(class_java_lang_Integer);
+	java_handle_t *h = NULL;
+
+	if (value >= -128 && value <= 127)
+		h = boxcache_get(PRIMITIVETYPE_INT, BOXCACHE_INT + 128 + value, value);
+
+	if (h != NULL)
+		return h;
+
+	h = builtin_new(class_java_lang_Integer);
 
 	if (h == NULL)
 		return NULL;
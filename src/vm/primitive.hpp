@@ -79,6 +79,7 @@ public:
 	static classinfo*     get_arrayclass_by_type(int type);
 
 	static int            get_type_by_wrapperclass(classinfo *c);
+	static int            get_type_by_wrapper(java_handle_t *h);
 	static int            get_type_by_primitiveclass(classinfo *c);
 
 	static java_handle_t* box(int type, imm_union value);
@@ -94,6 +95,7 @@ public:
 
 	static imm_union      unbox(java_handle_t *o);
 	static bool           unbox_typed(java_handle_t *o, int type, imm_union* value);
+	static bool           widen(int src_type, int type, imm_union* value);
 
 	static uint8_t        unbox_boolean(java_handle_t* o);
 	static int8_t         unbox_byte(java_handle_t* o);
@@ -0,0 +1,481 @@
+/* src/vm/sharedarchive.cpp - shared archive of bootstrap class files
+
+   Copyright (C) 1996-2013
+   CACAOVM - Verein zur Foerderung der freien virtuellen Maschine CACAO
+
+   This file is part of CACAO.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation; either version 2, or (at
+   your option) any later version.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA.
+
+*/
+
+
+#include "config.h"
+
+#include <cassert>
+#include <cerrno>
+#include <cstdio>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+#include "mm/memory.hpp"
+
+#include "threads/mutex.hpp"
+
+#include "toolbox/buffer.hpp"
+#include "toolbox/hashtable.hpp"
+#include "toolbox/logging.hpp"
+
+#include "vm/options.hpp"
+#include "vm/os.hpp"
+#include "vm/sharedarchive.hpp"
+#include "vm/statistics.hpp"
+#include "vm/suck.hpp"
+#include "vm/types.hpp"
+#include "vm/utf8.hpp"
+#include "vm/vm.hpp"
+
+using namespace cacao;
+
+
+STAT_DECLARE_GROUP(memory_stat)
+STAT_REGISTER_SUBGROUP(sharedarchive_stat,"shared archive","shared class archive",memory_stat)
+STAT_REGISTER_GROUP_VAR(int,count_sharedarchive_hits,0,"hits","classes read from the shared archive",sharedarchive_stat)
+STAT_REGISTER_GROUP_VAR(int,count_sharedarchive_misses,0,"misses","classes read from the classpath",sharedarchive_stat)
+STAT_REGISTER_GROUP_VAR(int,size_sharedarchive_bytes,0,"shared bytes","class file bytes served from the mapping",sharedarchive_stat)
+
+
+/* hashtable entry for archived classes ***************************************/
+
+struct SharedArchiveEntry {
+	Utf8String  name;
+	uint8_t    *data;
+	size_t      size;
+
+	/// interface to HashTable
+	size_t hash() const { return name.hash(); }
+
+	Utf8String key() const { return name; }
+	void set_key(Utf8String u) { name = u; }
+};
+
+typedef HashTable<InsertOnlyNamedEntry<SharedArchiveEntry> > SharedArchiveTable;
+
+
+/* class file recorded in dump mode *******************************************/
+
+struct SharedArchiveRecord {
+	Utf8String  name;
+	uint8_t    *data;
+	size_t      size;
+};
+
+
+/* global variables ***********************************************************/
+
+static SharedArchiveTable               *archive_table = NULL;
+static uint8_t                          *archive_base  = NULL;
+static size_t                            archive_size  = 0;
+
+static Mutex                            *record_mutex  = NULL;
+static std::vector<SharedArchiveRecord> *records       = NULL;
+
+
+/**
+ * Build the stamp identifying the current bootstrap classpath.  Any
+ * change to the classpath or to one of its archives invalidates the
+ * stamp.
+ */
+static void sharedarchive_classpath_stamp(SuckClasspath& scp, Buffer<>& stamp)
+{
+	for (SuckClasspath::iterator it = scp.begin(); it != scp.end(); it++) {
+		list_classpath_entry *lce = *it;
+		struct stat           st;
+
+		stamp.write(lce->path);
+
+		if (os::stat(lce->path, &st) == 0)
+			stamp.writef(":%lld:%lld", (long long) st.st_size, (long long) st.st_mtime);
+
+		stamp.write('\n');
+	}
+}
+
+
+/**
+ * Check that <length> bytes at <offset> lie within an archive of
+ * <size> bytes, without overflowing.
+ */
+static inline bool sharedarchive_in_bounds(uint64_t offset, uint64_t length, uint64_t size)
+{
+	return (offset <= size) && (length <= size - offset);
+}
+
+
+/**
+ * Map the archive file into memory and fill the lookup table.  Every
+ * offset and length read from the file is checked against the size of
+ * the mapping, a truncated or corrupt archive is not used.
+ *
+ * @return true if the archive matches the current classpath.
+ */
+static bool sharedarchive_map(const char *path, SuckClasspath& scp)
+{
+	int fd = ::open(path, O_RDONLY);
+
+	if (fd == -1)
+		return false;
+
+	struct stat st;
+
+	if ((fstat(fd, &st) == -1) || ((size_t) st.st_size < sizeof(sharedarchive_header))) {
+		::close(fd);
+		return false;
+	}
+
+	// The mapping is shared and read-only, so the pages are shared
+	// between all processes mapping the same archive.
+
+	uint8_t *base = (uint8_t*) mmap(0, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+
+	::close(fd);
+
+	if ((ptrint) base == (ptrint) MAP_FAILED)
+		return false;
+
+	const sharedarchive_header *header = (const sharedarchive_header*) base;
+	uint64_t                    size   = st.st_size;
+
+	if ((header->magic       != SHAREDARCHIVE_MAGIC) ||
+		(header->version     != SHAREDARCHIVE_VERSION) ||
+		(header->pointersize != SIZEOF_VOID_P) ||
+		(header->filesize    != size) ||
+		!sharedarchive_in_bounds(header->stampoffset, header->stamplength, size) ||
+		!sharedarchive_in_bounds(header->indexoffset, (uint64_t) header->classcount * sizeof(sharedarchive_index), size) ||
+		(header->indexoffset % sizeof(uint64_t) != 0)) {
+		munmap(base, st.st_size);
+		return false;
+	}
+
+	// Check that the archive was dumped for this classpath.
+
+	Buffer<> stamp;
+
+	sharedarchive_classpath_stamp(scp, stamp);
+
+	if ((header->stamplength != stamp.size()) ||
+		(memcmp(base + header->stampoffset, stamp.data(), stamp.size()) != 0)) {
+		munmap(base, st.st_size);
+		return false;
+	}
+
+	const sharedarchive_index *index = (const sharedarchive_index*) (base + header->indexoffset);
+
+	for (uint32_t i = 0; i < header->classcount; i++) {
+		if (!sharedarchive_in_bounds(index[i].nameoffset, index[i].namelength, size) ||
+			!sharedarchive_in_bounds(index[i].dataoffset, index[i].datalength, size)) {
+			munmap(base, st.st_size);
+			return false;
+		}
+	}
+
+	archive_table = new SharedArchiveTable(header->classcount * 2 + 1);
+
+	for (uint32_t i = 0; i < header->classcount; i++) {
+		SharedArchiveEntry entry;
+
+		entry.name = Utf8String::from_utf8((const char*) (base + index[i].nameoffset), index[i].namelength);
+		entry.data = base + index[i].dataoffset;
+		entry.size = index[i].datalength;
+
+		archive_table->insert(entry);
+	}
+
+	archive_base = base;
+	archive_size = st.st_size;
+
+	return true;
+}
+
+
+/**
+ * Initialize the shared archive.  Must be called after the bootstrap
+ * classpath is complete.
+ */
+void SharedArchive::initialize(SuckClasspath& scp)
+{
+	TRACESUBSYSTEMINITIALIZATION("sharedarchive_init");
+
+	if (opt_SharedArchiveFile == NULL)
+		return;
+
+	if (opt_DumpSharedArchive) {
+		record_mutex = new Mutex();
+		records      = new std::vector<SharedArchiveRecord>();
+		return;
+	}
+
+	if (!sharedarchive_map(opt_SharedArchiveFile, scp)) {
+		if (opt_verbose || opt_PrintSharedArchiveStatistics)
+			log_println("[Shared archive %s not usable, loading classes from the classpath]", opt_SharedArchiveFile);
+		return;
+	}
+
+	if (opt_verboseclass)
+		printf("[Opened %s]\n", opt_SharedArchiveFile);
+}
+
+
+/**
+ * Returns true if class files are recorded for a later dump.
+ */
+bool SharedArchive::is_dumping()
+{
+	return records != NULL;
+}
+
+
+/**
+ * Look up a class file in the shared archive.
+ *
+ * @param name Name of the class.
+ * @param size Returns the size of the class file.
+ *
+ * @return Pointer to the read-only class file data, or NULL if the
+ *         class is not archived.
+ */
+uint8_t *SharedArchive::find(Utf8String name, size_t *size)
+{
+	if (archive_table == NULL)
+		return NULL;
+
+	SharedArchiveTable::EntryRef e = archive_table->find(name);
+
+	if (!e)
+		return NULL;
+
+	*size = e->size;
+
+	STATISTICS(count_sharedarchive_hits++);
+	STATISTICS(size_sharedarchive_bytes += e->size);
+
+	return e->data;
+}
+
+
+/**
+ * Check whether a class file is in the shared archive, without counting
+ * it as a hit.
+ */
+bool SharedArchive::contains(Utf8String name)
+{
+	if (archive_table == NULL)
+		return false;
+
+	return archive_table->find(name);
+}
+
+
+/**
+ * Count a class which had to be read from the classpath although a
+ * shared archive is in use.
+ */
+void SharedArchive::count_miss()
+{
+	if (archive_table == NULL)
+		return;
+
+	STATISTICS(count_sharedarchive_misses++);
+}
+
+
+/**
+ * Record a class file read by the bootstrap class loader.
+ */
+void SharedArchive::record(Utf8String name, const uint8_t *data, size_t size)
+{
+	if (records == NULL)
+		return;
+
+	SharedArchiveRecord r;
+
+	r.name = name;
+	r.data = MNEW(uint8_t, size);
+	r.size = size;
+
+	MCOPY(r.data, data, uint8_t, size);
+
+	MutexLocker lock(*record_mutex);
+
+	records->push_back(r);
+}
+
+
+/**
+ * Write all recorded class files to the archive file.  Other VMs may
+ * have the archive mapped, so it is not rewritten in place: the new
+ * archive is written to a temporary file in the same directory and
+ * renamed over the old one.
+ */
+void SharedArchive::dump(SuckClasspath& scp)
+{
+	if (records == NULL)
+		return;
+
+	MutexLocker lock(*record_mutex);
+
+	Buffer<> stamp;
+
+	sharedarchive_classpath_stamp(scp, stamp);
+
+	std::vector<sharedarchive_index> index(records->size());
+
+	sharedarchive_header header;
+
+	header.magic       = SHAREDARCHIVE_MAGIC;
+	header.version     = SHAREDARCHIVE_VERSION;
+	header.pointersize = SIZEOF_VOID_P;
+	header.classcount  = records->size();
+	header.stampoffset = sizeof(sharedarchive_header);
+	header.stamplength = stamp.size();
+
+	// Lay out names and class data.
+
+	uint64_t offset = header.stampoffset + header.stamplength;
+
+	for (size_t i = 0; i < records->size(); i++) {
+		index[i].nameoffset = offset;
+		index[i].namelength = (*records)[i].name.size();
+		offset += index[i].namelength;
+	}
+
+	for (size_t i = 0; i < records->size(); i++) {
+		offset = MEMORY_ALIGN(offset, 8);
+		index[i].dataoffset = offset;
+		index[i].datalength = (*records)[i].size;
+		offset += index[i].datalength;
+	}
+
+	header.indexoffset = MEMORY_ALIGN(offset, 8);
+	header.filesize    = header.indexoffset + index.size() * sizeof(sharedarchive_index);
+
+	if (header.indexoffset > UINT32_MAX) {
+		log_println("[Shared archive too large, not written]");
+		return;
+	}
+
+	Buffer<> tmppath;
+
+	tmppath.write(opt_SharedArchiveFile)
+	       .writef(".%d.tmp", (int) getpid());
+
+	FILE *file = os::fopen(tmppath.c_str(), "w");
+
+	if (file == NULL) {
+		log_println("[Cannot write shared archive %s: %s]", tmppath.c_str(), os::strerror(errno));
+		return;
+	}
+
+	static const uint8_t padding[8] = { 0 };
+
+	fwrite(&header, sizeof(header), 1, file);
+	fwrite(stamp.data(), 1, stamp.size(), file);
+
+	offset = header.stampoffset + header.stamplength;
+
+	for (size_t i = 0; i < records->size(); i++) {
+		fwrite((*records)[i].name.begin(), 1, index[i].namelength, file);
+		offset += index[i].namelength;
+	}
+
+	for (size_t i = 0; i < records->size(); i++) {
+		fwrite(padding, 1, index[i].dataoffset - offset, file);
+		fwrite((*records)[i].data, 1, index[i].datalength, file);
+		offset = index[i].dataoffset + index[i].datalength;
+	}
+
+	fwrite(padding, 1, header.indexoffset - offset, file);
+	fwrite(&index[0], sizeof(sharedarchive_index), index.size(), file);
+
+	bool failed = ferror(file);
+
+	if ((os::fclose(file) != 0) || failed) {
+		log_println("[Cannot write shared archive %s: %s]", tmppath.c_str(), os::strerror(errno));
+		::unlink(tmppath.c_str());
+		return;
+	}
+
+	if (::rename(tmppath.c_str(), opt_SharedArchiveFile) != 0) {
+		log_println("[Cannot write shared archive %s: %s]", opt_SharedArchiveFile, os::strerror(errno));
+		::unlink(tmppath.c_str());
+		return;
+	}
+
+	if (opt_verbose || opt_PrintSharedArchiveStatistics)
+		log_println("[Dumped %d classes (%lld bytes) to shared archive %s]",
+					(int) records->size(), (long long) header.filesize, opt_SharedArchiveFile);
+}
+
+
+/**
+ * Print how many classes were served from the shared archive and how
+ * much memory was not allocated in the process because of it.
+ */
+void SharedArchive::print_statistics()
+{
+	if (archive_base == NULL)
+		return;
+
+	VM *vm = VM::get_current();
+
+	log_println("[Shared archive %s: %lld bytes mapped]", opt_SharedArchiveFile, (long long) archive_size);
+#if defined(ENABLE_STATISTICS)
+	log_println("[  %d classes read from the shared archive, %d from the classpath]",
+				count_sharedarchive_hits.get(), count_sharedarchive_misses.get());
+	log_println("[  %lld kB of class file data shared instead of allocated per process]",
+				(long long) (size_sharedarchive_bytes.get() / 1024));
+#endif
+
+	if (vm != NULL)
+		log_println("[  VM startup took %lld ms]", (long long) (vm->get_inittime() - vm->get_starttime()));
+}
+
+
+/**
+ * Returns the path of the archive used for class loading, or NULL.
+ */
+const char *SharedArchive::get_path()
+{
+	return (archive_base != NULL) ? opt_SharedArchiveFile : NULL;
+}
+
+
+/*
+ * These are local overrides for various environment variables in Emacs.
+ * Please do not remove this and leave it at the end of the file, where
+ * Emacs will automagically detect them.
+ * ---------------------------------------------------------------------
+ * Local variables:
+ * mode: c++
+ * indent-tabs-mode: t
+ * c-basic-offset: 4
+ * tab-width: 4
+ * End:
+ * vim:noexpandtab:sw=4:ts=4:
+ */
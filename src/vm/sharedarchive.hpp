@@ -0,0 +1,118 @@
+/* src/vm/sharedarchive.hpp - shared archive of bootstrap class files
+
+   Copyright (C) 1996-2013
+   CACAOVM - Verein zur Foerderung der freien virtuellen Maschine CACAO
+
+   This file is part of CACAO.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation; either version 2, or (at
+   your option) any later version.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA.
+
+*/
+
+
+#ifndef SHAREDARCHIVE_HPP_
+#define SHAREDARCHIVE_HPP_ 1
+
+#include "config.h"
+
+#include <cstddef>                      // for size_t
+#include <stdint.h>                     // for uint8_t
+
+#include "vm/utf8.hpp"                  // for Utf8String
+
+class SuckClasspath;
+
+
+/* Shared archive file layout **************************************************
+
+   header                          sharedarchive_header
+   classpath stamp                 (variable size)
+   class names                     (variable size)
+   class file data                 (variable size, 8-byte aligned)
+   index                           classcount * sharedarchive_index
+
+   All offsets are relative to the start of the file, all values are
+   stored in host byte order.  The classpath stamp records path, size
+   and modification time of every bootstrap classpath entry, an
+   archive is only used if the stamp matches the current classpath.
+
+*******************************************************************************/
+
+#define SHAREDARCHIVE_MAGIC      0xcaca05a5
+#define SHAREDARCHIVE_VERSION    1
+
+struct sharedarchive_header {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t pointersize;
+	uint32_t classcount;
+	uint32_t stampoffset;
+	uint32_t stamplength;
+	uint64_t indexoffset;
+	uint64_t filesize;
+};
+
+struct sharedarchive_index {
+	uint32_t nameoffset;
+	uint32_t namelength;
+	uint64_t dataoffset;
+	uint64_t datalength;
+};
+
+
+/**
+ * Archive of the class files read by the bootstrap class loader.
+ *
+ * In dump mode (-XX:+DumpSharedArchive) every class file read from
+ * the bootstrap classpath is recorded and written to the archive file
+ * when the VM exits.  In run mode the archive is mapped read-only and
+ * shared, class buffers for archived classes point directly into the
+ * mapping, so neither the inflate nor the copy into the C heap is done
+ * and the pages are shared between all VMs using the same archive.
+ */
+class SharedArchive {
+public:
+	static void initialize(SuckClasspath& scp);
+
+	static bool is_dumping();
+
+	static uint8_t *find(Utf8String name, size_t *size);
+	static bool     contains(Utf8String name);
+	static void     record(Utf8String name, const uint8_t *data, size_t size);
+	static void     count_miss();
+
+	static void dump(SuckClasspath& scp);
+	static void print_statistics();
+
+	static const char *get_path();
+};
+
+#endif // SHAREDARCHIVE_HPP_
+
+
+/*
+ * These are local overrides for various environment variables in Emacs.
+ * Please do not remove this and leave it at the end of the file, where
+ * Emacs will automagically detect them.
+ * ---------------------------------------------------------------------
+ * Local variables:
+ * mode: c++
+ * indent-tabs-mode: t
+ * c-basic-offset: 4
+ * tab-width: 4
+ * End:
+ * vim:noexpandtab:sw=4:ts=4:
+ */
@@ -40,6 +40,7 @@
 #include "vm/options.hpp"
 #include "vm/os.hpp"                    // for os
 #include "vm/signallocal.hpp"           // for md_signal_handler_sigsegv, etc
+#include "vm/jit/compilelog.hpp"         // for compilelog_dump
 #include "vm/vm.hpp"                    // for vm_abort, vm_call_method, etc
 
 struct methodinfo;
@@ -295,6 +296,10 @@ void signal_thread_handler(int sig)
 		/* print a thread dump */
 		ThreadList::get()->dump_threads();
 
+		/* and the compilation log */
+		if (opt_LogCompilation)
+			compilelog_dump();
+
 #if 0 && defined(ENABLE_STATISTICS)
 		if (opt_stat)
 			statistics_print_memory_usage();
@@ -791,6 +791,11 @@ public:
 		return var;
 	}
 
+	/// for counters incremented by generated code
+	_T* address() {
+		return &var;
+	}
+
 	void print(OStream &O) const {
 		O << setw(30) << name
 		  << setw(10) << var
@@ -40,11 +40,15 @@
 #include "toolbox/list.hpp"
 #include "toolbox/logging.hpp"
 
+#include "vm/classindex.hpp"
 #include "vm/exceptions.hpp"
 #include "vm/loader.hpp"
 #include "vm/options.hpp"
 #include "vm/os.hpp"
+#include "vm/preload.hpp"
 #include "vm/properties.hpp"
+#include "vm/sharedarchive.hpp"
+#include "vm/statistics.hpp"
 #include "vm/suck.hpp"
 #include "vm/vm.hpp"
 #include "vm/zip.hpp"
@@ -52,6 +56,13 @@
 using namespace cacao;
 
 
+STAT_REGISTER_GROUP(classpath_stat,"classpath","classpath lookups")
+STAT_REGISTER_GROUP_VAR(int,count_classpath_lookups,0,"lookups","class files searched on the classpath",classpath_stat)
+STAT_REGISTER_GROUP_VAR(int,count_classpath_probes,0,"probes","hashtable lookups for class files",classpath_stat)
+STAT_REGISTER_GROUP_VAR(int,count_classpath_syscalls,0,"syscalls","system calls for class files",classpath_stat)
+STAT_REGISTER_DIST(unsigned int,unsigned int,count_classpath_probes_dist,0,16,1,0,"probes dist","Distribution of hashtable lookups per class file")
+STAT_REGISTER_DIST(unsigned int,unsigned int,count_classpath_syscalls_dist,0,16,1,0,"syscalls dist","Distribution of system calls per class file")
+
 /* scandir_filter **************************************************************
 
    Filters for zip/jar files.
@@ -330,19 +341,34 @@ void SuckClasspath::add_from_property(const char *key)
 
 
 inline void ClassBuffer::init(classinfo *clazz, uint8_t *data, size_t sz, const char *path) {
-	this->clazz = clazz;
-	this->data  = data;
-	this->pos   = data;
-	this->end   = data + sz;
-	this->path  = path;
+	this->clazz  = clazz;
+	this->data   = data;
+	this->pos    = data;
+	this->end    = data + sz;
+	this->path   = path;
+	this->mapped = false;
 }
 
 ClassBuffer::ClassBuffer(classinfo *clazz, uint8_t *data, size_t sz, const char *path) {
 	init(clazz, data, sz, path);
+	detached = false;
 }
 
 ClassFileVersion ClassBuffer::version() const { return clazz->version; }
 
+/**
+ * Book-keeping for the shared archive and the class preloader after a
+ * class file was read from the classpath.
+ */
+void ClassBuffer::loaded_from_classpath() {
+	ClassPreloader::loaded(clazz->name);
+
+	SharedArchive::count_miss();
+
+	if (SharedArchive::is_dumping())
+		SharedArchive::record(clazz->name, data, end - data);
+}
+
 /***
  *	Loads class file corresponding to given classinfo into new ClassBuffer.
  *	All directories of the searchpath are used to find the classfile (<classname>.class).
@@ -350,79 +376,201 @@ ClassFileVersion ClassBuffer::version() const { return clazz->version; }
  */
 ClassBuffer::ClassBuffer(classinfo *c) {
 	init(NULL, NULL, 0, NULL);
+	detached = false;
 
-	// get the classname as char string 
-	// (do it here for the warning at the end of the function)
+	// classes from the shared archive are used in place
 
-	size_t filenamelen = c->name.size() + strlen(".class") + strlen("0");
+	size_t   size;
+	uint8_t *data = SharedArchive::find(c->name, &size);
 
-	Buffer<> filename(filenamelen);
-	Buffer<> path;
+	if (data != NULL) {
+		init(c, data, size, SharedArchive::get_path());
+		mapped = true;
 
-	filename.write(c->name)
-	        .write(".class");
+		ClassPreloader::loaded(c->name);
+		return;
+	}
+
+	// maybe a preloader thread already read the class file
+
+	const char *path;
+
+	bool mapped;
+
+	if (ClassPreloader::take(c->name, &data, &size, &path, &mapped)) {
+		init(c, data, size, path);
+		this->mapped = mapped;
+		loaded_from_classpath();
+		return;
+	}
 
-	// Get current list of classpath entries.
-	SuckClasspath& suckclasspath = VM::get_current()->get_suckclasspath();
+	load(c, c->name);
 
-	// walk through all classpath entries
+	if (this->data != NULL) {
+		loaded_from_classpath();
+		return;
+	}
 
-	for (SuckClasspath::iterator it = suckclasspath.begin(); it != suckclasspath.end(); it++) {
-		list_classpath_entry *lce = *it;
+	// if we get here, we could not find the file
+	if (opt_verbose) {
+		Buffer<> filename;
 
+		filename.write(c->name)
+		        .write(".class");
+
+		dolog("Warning: Can not open class file '%s'", filename.c_str());
+	}
+}
+
+/***
+ *	Loads class file with the given name into new ClassBuffer, without
+ *	associating it with a class.  This may be called from threads not
+ *	attached to the VM: the classpath is walked without the class index,
+ *	no statistics are counted, and the data comes from os::malloc and
+ *	must be released with os::free unless it is mapped.
+ */
+ClassBuffer::ClassBuffer(Utf8String classname) {
+	init(NULL, NULL, 0, NULL);
+	detached = true;
+
+	load(NULL, classname);
+}
+
+/***
+ *	Reads the class file for <name> from the classpath entry <lce>.
+ *	Returns false if the entry does not contain the class file.
+ */
+bool ClassBuffer::load_from(classinfo *c, Utf8String name, const char *filename,
+                            list_classpath_entry *lce, ClassLookupCost *cost) {
 #if defined(ENABLE_ZLIB)
-		if (lce->type == CLASSPATH_ARCHIVE) {
+	if (lce->type == CLASSPATH_ARCHIVE) {
+		ZipFileEntry entry;
 
-			// enter a monitor on zip/jar archives
+		// the monitor on zip/jar archives is only held for the lookup,
+		// inflating runs in parallel
+		{
 			MutexLocker lock(*lce->mutex);
 
+			cost->probes++;
+
 			// try to get the file in current archive
-			if (ZipFile::EntryRef zip = lce->zip->find(c->name)) {
-				// found class, fill in classbuffer
-				size_t   size = zip->uncompressedsize;
-				uint8_t *data = MNEW(uint8_t, size);
+			ZipFile::EntryRef zip = lce->zip->find(name);
 
-				zip->get(data);
+			if (!zip)
+				return false;
 
-				init(c, data, size, lce->path);
-				return;
-			}
-		} else {
+			entry = *zip;
+		}
+
+		// found class, fill in classbuffer
+		size_t size = entry.uncompressedsize;
+
+		// stored class files are parsed in place
+		if (const uint8_t *stored = entry.get_stored()) {
+			init(c, const_cast<uint8_t*>(stored), size, lce->path);
+			mapped = true;
+			return true;
+		}
+
+		uint8_t *data = detached ? (uint8_t*) os::malloc(size) : MNEW(uint8_t, size);
+
+		entry.get(data);
+
+		init(c, data, size, lce->path);
+		return true;
+	}
 #endif /* defined(ENABLE_ZLIB) */
-			path.reset();
 
-			path.write(lce->path)
-			    .write(filename);
+	Buffer<> path;
 
-			if (FILE *classfile = os::fopen(path.c_str(), "r")) {
-				struct stat stat_buffer;
+	path.write(lce->path)
+	    .write(filename);
 
-				if (os::stat(path.c_str(), &stat_buffer) == -1)
-					continue;
+	cost->syscalls++;
 
-				size_t   size = stat_buffer.st_size;
-				uint8_t *data = MNEW(u1, size);
+	FILE *classfile = os::fopen(path.c_str(), "r");
 
-				// read class data
-				size_t bytes_read = os::fread(data, 1, size, classfile);
-				os::fclose(classfile);
+	if (classfile == NULL)
+		return false;
 
-				if (bytes_read != size) {
-					free();
-					return;
-				}
+	struct stat stat_buffer;
 
-				init(c, data, size, lce->path);
-				return;
-			}
-#if defined(ENABLE_ZLIB)
+	cost->syscalls++;
+
+	if (os::stat(path.c_str(), &stat_buffer) == -1) {
+		os::fclose(classfile);
+		return false;
+	}
+
+	size_t   size = stat_buffer.st_size;
+	uint8_t *data = detached ? (uint8_t*) os::malloc(size) : MNEW(u1, size);
+
+	// read class data
+	size_t bytes_read = os::fread(data, 1, size, classfile);
+	os::fclose(classfile);
+
+	// a short read is reported like a missing class file, but
+	// does not continue the search
+	if (bytes_read != size) {
+		if (detached)
+			os::free(data);
+		else
+			MFREE(data, u1, size);
+		return true;
+	}
+
+	init(c, data, size, lce->path);
+	return true;
+}
+
+/***
+ *	Reads the first class file found for <name> on the classpath, either
+ *	through the class index or by walking all classpath entries.
+ */
+void ClassBuffer::load(classinfo *c, Utf8String name) {
+	size_t filenamelen = name.size() + strlen(".class") + strlen("0");
+
+	Buffer<> filename(filenamelen);
+
+	filename.write(name)
+	        .write(".class");
+
+	const char *file = filename.c_str();
+
+	ClassLookupCost cost = { 0, 0 };
+	bool            walk = true;
+
+	// the class index is not safe for threads not attached to the VM
+
+	if (!detached && ClassIndex::is_enabled()) {
+		list_classpath_entry *lce = ClassIndex::find(name, &cost);
+
+		// Misses are checked against the package directories by the
+		// index itself.  A hit is only wrong if the class file was
+		// removed from a directory, walk the classpath in that case.
+		walk = (lce != NULL) && !load_from(c, name, file, lce, &cost);
+	}
+
+	if (walk) {
+		// Get current list of classpath entries.
+		SuckClasspath& suckclasspath = VM::get_current()->get_suckclasspath();
+
+		// walk through all classpath entries
+
+		for (SuckClasspath::iterator it = suckclasspath.begin(); it != suckclasspath.end(); it++) {
+			if (load_from(c, name, file, *it, &cost))
+				break;
 		}
-#endif
 	}
 
-	// if we get here, we could not find the file
-	if (opt_verbose)
-		dolog("Warning: Can not open class file '%s'", filename.c_str());
+	if (detached)
+		return;
+
+	STATISTICS(count_classpath_lookups++);
+	STATISTICS(count_classpath_probes   += cost.probes);
+	STATISTICS(count_classpath_syscalls += cost.syscalls);
+	STATISTICS(count_classpath_probes_dist[cost.probes]++);
+	STATISTICS(count_classpath_syscalls_dist[cost.syscalls]++);
 }
 
 
@@ -436,9 +584,18 @@ ClassBuffer::ClassBuffer(classinfo *c) {
 *******************************************************************************/
 
 void ClassBuffer::free() {
+	// class files mapped from the shared archive or a zip/jar archive
+	// are not ours to free
+
+	if (mapped)
+		return;
+
 	// free memory
 
-	MFREE(data, u1, end - data);
+	if (detached)
+		os::free(data);
+	else
+		MFREE(data, u1, end - data);
 }
 
 
@@ -34,6 +34,7 @@
 #include "vm/loader.hpp"
 #include "vm/types.hpp"
 
+struct ClassLookupCost;
 struct classinfo;
 struct hashtable;
 class Mutex;
@@ -117,6 +118,7 @@ namespace cacao {
 		classinfo     *get_class() const { return clazz; }
 		const uint8_t *get_data()  const { return pos;   }
 		const char    *get_path()  const { return path;  }
+		bool           is_mapped() const { return mapped; }
 
 		ClassFileVersion version() const;
 	private:
@@ -124,12 +126,17 @@ namespace cacao {
 		ClassBuffer& operator=(const ClassBuffer&);
 
 		void init(classinfo*, uint8_t*, size_t, const char*);
+		void load(classinfo*, Utf8String);
+		bool load_from(classinfo*, Utf8String, const char*, list_classpath_entry*, ClassLookupCost*);
+		void loaded_from_classpath();
 
 		classinfo  *clazz;      // pointer to classinfo structure
 		uint8_t    *data;       // pointer to start of buffer
 		uint8_t    *pos;        // pointer to current position in buffer
 		uint8_t    *end;        // pointer to end of buffer
 		const char *path;       // path to file (for debugging)
+		bool        mapped;     // data is mapped from a file, not ours to free
+		bool        detached;   // read by a thread not attached to the VM
 	};
 
 	inline bool ClassBuffer::check_size(size_t sz) {
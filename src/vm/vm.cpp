@@ -64,9 +64,11 @@
 #include "vm/javaobjects.hpp"
 #include "vm/options.hpp"
 #include "vm/os.hpp"
+#include "vm/preload.hpp"
 #include "vm/primitive.hpp"
 #include "vm/properties.hpp"
 #include "vm/rt-timing.hpp"
+#include "vm/sharedarchive.hpp"
 #include "vm/signallocal.hpp"
 #include "vm/statistics.hpp"
 #include "vm/string.hpp"
@@ -79,6 +81,7 @@
 #include "vm/jit/asmpart.hpp"
 #include "vm/jit/builtin.hpp"
 #include "vm/jit/code.hpp"
+#include "vm/jit/compilelog.hpp"
 #include "vm/jit/disass.hpp"
 #include "vm/jit/jit.hpp"
 #include "vm/jit/methodtree.hpp"
@@ -87,6 +90,7 @@
 
 #include "vm/jit/optimizing/profile.hpp"
 #include "vm/jit/optimizing/recompiler.hpp"
+#include "vm/jit/optimizing/tiered.hpp"
 
 using namespace cacao;
 
@@ -1323,6 +1327,9 @@ VM::VM(JavaVMInitArgs* vm_args)
 	code_init();
 	methodtree_init();
 
+	if (!compilelog_init())
+		os::abort("vm_create: compilelog_init failed");
+
 	/* AFTER: utf8_init, classcache_init */
 
 	loader_preinit();
@@ -1414,6 +1421,14 @@ VM::VM(JavaVMInitArgs* vm_args)
 	// profiling thread).
 	// FIXME Only works for one recompiler.
 	_recompiler.start();
+
+	// Start the tiered compilation thread (must be done after the
+	// recompilation thread).
+	if (!tiered_init())
+		os::abort("vm_create: tiered_init failed");
+
+	if (!tiered_start_thread())
+		os::abort("vm_create: tiered_start_thread failed");
 #endif
 
 #if defined(ENABLE_PROFILING)
@@ -1723,6 +1738,10 @@ void vm_run(JavaVM *vm, JavaVMInitArgs *vm_args)
 	typeinfo_test();
 #endif
 
+	/* the class files preloaded for the startup are not needed any more */
+
+	ClassPreloader::finish();
+
 	/* start the main thread */
 
 	(void) vm_call_method(m, NULL, oa.get_handle());
@@ -1906,6 +1925,27 @@ void vm_exit_handler(void)
 # endif
 #endif /* !defined(NDEBUG) */
 
+	/* Write the shared class archive in dump mode. */
+
+	SharedArchive::dump(VM::get_current()->get_suckclasspath());
+
+	if (opt_PrintSharedArchiveStatistics)
+		SharedArchive::print_statistics();
+
+	if (opt_PrintPreloadStatistics)
+		ClassPreloader::print_statistics();
+
+	if (opt_PrintImplicitExceptionStatistics)
+		trap_print_statistics();
+
+#if defined(ENABLE_THREADS)
+	if (opt_PrintTieredStatistics)
+		tiered_print_statistics();
+#endif
+
+	if (opt_LogCompilation)
+		compilelog_dump();
+
 #if defined(ENABLE_CYCLES_STATS)
 	builtin_print_cycles_stats(log_get_logfile());
 	stacktrace_print_cycles_stats(log_get_logfile());
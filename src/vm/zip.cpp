@@ -29,6 +29,9 @@
 #include <cassert>
 #include <cerrno>
 #include <unistd.h>
+#if defined(ENABLE_THREADS)
+# include <pthread.h>
+#endif
 #include <zlib.h>
 
 #include "mm/memory.hpp"
@@ -237,8 +240,9 @@ ZipFile *ZipFile::open(const char *path) {
 
 		if (filename[cdsfh.filenamelength - 1] != '/') {
 			Utf8String u;
+			bool       classfile = (strncmp(classext, ".class", strlen(".class")) == 0);
 
-			if (strncmp(classext, ".class", strlen(".class")) == 0)
+			if (classfile)
 				u = Utf8String::from_utf8(filename, cdsfh.filenamelength - strlen(".class"));
 			else
 				u = Utf8String::from_utf8(filename, cdsfh.filenamelength);
@@ -252,6 +256,7 @@ ZipFile *ZipFile::open(const char *path) {
 			entry.compressedsize    = cdsfh.compressedsize;
 			entry.uncompressedsize  = cdsfh.uncompressedsize;
 			entry.data              = filep + cdsfh.relativeoffset;
+			entry.classfile         = classfile;
 
 			// insert into hashtable
 
@@ -273,23 +278,108 @@ ZipFile *ZipFile::open(const char *path) {
 }
 
 
+/* per-thread inflate streams **************************************************
+
+   Every thread keeps its z_stream and only resets it between files, so
+   inflating does not allocate and several threads can inflate from the
+   same archive at the same time.
+
+*******************************************************************************/
+
+#if defined(ENABLE_THREADS)
+static pthread_key_t  zip_stream_key;
+static pthread_once_t zip_stream_once = PTHREAD_ONCE_INIT;
+
+static void zip_stream_free(void *p)
+{
+	z_stream *zs = (z_stream *) p;
+
+	inflateEnd(zs);
+	os::free(zs);
+}
+
+static void zip_stream_key_create(void)
+{
+	int result = pthread_key_create(&zip_stream_key, &zip_stream_free);
+
+	if (result != 0)
+		os::abort_errnum(result, "zip_stream_key_create: pthread_key_create failed");
+}
+#else
+static z_stream *zip_stream_single = NULL;
+#endif
+
+static z_stream *zip_stream(void)
+{
+	z_stream *zs;
+
+#if defined(ENABLE_THREADS)
+	pthread_once(&zip_stream_once, &zip_stream_key_create);
+
+	zs = (z_stream *) pthread_getspecific(zip_stream_key);
+#else
+	zs = zip_stream_single;
+#endif
+
+	if (zs != NULL) {
+		if (inflateReset(zs) != Z_OK)
+			vm_abort("zip_get: inflateReset failed");
+
+		return zs;
+	}
+
+	// streams of threads not attached to the VM are allocated too
+
+	zs = (z_stream *) os::calloc(1, sizeof(z_stream));
+
+	zs->next_in  = Z_NULL;
+	zs->avail_in = 0;
+	zs->zalloc   = Z_NULL;
+	zs->zfree    = Z_NULL;
+	zs->opaque   = Z_NULL;
+
+	if (inflateInit2(zs, -MAX_WBITS) != Z_OK)
+		vm_abort("zip_get: inflateInit2 failed: %s", strerror(errno));
+
+#if defined(ENABLE_THREADS)
+	pthread_setspecific(zip_stream_key, zs);
+#else
+	zip_stream_single = zs;
+#endif
+
+	return zs;
+}
+
+
 /***
- * Load file from zip archive into memory
+ * Returns the start of the file data behind the local file header
  */
-void ZipFileEntry::get(uint8_t *dst) const {
-	lfh      lfh;
-	z_stream zs;
-	int      err;
+static u1 *zip_file_data(u1 *data)
+{
+	lfh lfh;
 
 	// read stuff from local file header
 
 	lfh.filenamelength   = read_u2_le(data + LFH_FILE_NAME_LENGTH);
 	lfh.extrafieldlength = read_u2_le(data + LFH_EXTRA_FIELD_LENGTH);
 
-	u1 *indata = data
-	           + LFH_HEADER_SIZE
-	           + lfh.filenamelength
-	           + lfh.extrafieldlength;
+	return data
+	     + LFH_HEADER_SIZE
+	     + lfh.filenamelength
+	     + lfh.extrafieldlength;
+}
+
+
+/***
+ * Load file from zip archive into memory
+ *
+ * This does not touch the archive's hashtable and needs no lock.
+ */
+void ZipFileEntry::get(uint8_t *dst) const {
+	z_stream *zs;
+	int       err;
+
+	u1 *indata = zip_file_data(data);
 
 	// how is the file stored?
 
@@ -297,31 +387,19 @@ void ZipFileEntry::get(uint8_t *dst) const {
 	case Z_DEFLATED:
 		// fill z_stream structure
 
-		zs.next_in   = indata;
-		zs.avail_in  = compressedsize;
-		zs.next_out  = dst;
-		zs.avail_out = uncompressedsize;
+		zs = zip_stream();
 
-		zs.zalloc = Z_NULL;
-		zs.zfree  = Z_NULL;
-		zs.opaque = Z_NULL;
-
-		// initialize this inflate run
-
-		if (inflateInit2(&zs, -MAX_WBITS) != Z_OK)
-			vm_abort("zip_get: inflateInit2 failed: %s", strerror(errno));
+		zs->next_in   = indata;
+		zs->avail_in  = compressedsize;
+		zs->next_out  = dst;
+		zs->avail_out = uncompressedsize;
 
 		// decompress the file into buffer
 
-		err = inflate(&zs, Z_SYNC_FLUSH);
+		err = inflate(zs, Z_SYNC_FLUSH);
 
 		if ((err != Z_STREAM_END) && (err != Z_OK))
 			vm_abort("zip_get: inflate failed: %s", strerror(errno));
-
-		// finish this inflate run
-
-		if (inflateEnd(&zs) != Z_OK)
-			vm_abort("zip_get: inflateEnd failed: %s", strerror(errno));
 		break;
 
 	case 0:
@@ -335,6 +413,17 @@ void ZipFileEntry::get(uint8_t *dst) const {
 	}
 }
 
+
+/***
+ * Access a stored file in place
+ */
+const uint8_t *ZipFileEntry::get_stored() const {
+	if (compressionmethod != 0)
+		return NULL;
+
+	return zip_file_data(data);
+}
+
 /*
  * These are local overrides for various environment variables in Emacs.
  * Please do not remove this and leave it at the end of the file, where
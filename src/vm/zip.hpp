@@ -80,6 +80,7 @@ struct ZipFileEntry {
 	u4         compressedsize;
 	u4         uncompressedsize;
 	u1        *data;
+	bool       classfile;   // the name had its .class suffix stripped
 
 	/***
 	 * Load data from zipped file into memory
@@ -88,6 +89,14 @@ struct ZipFileEntry {
 	 */
 	void get(uint8_t *dst) const;
 
+	/***
+	 * Returns the data of a stored (uncompressed) file in the mapped
+	 * archive, NULL if the file is compressed.
+	 *
+	 * The data stays valid as long as the VM runs.
+	 */
+	const uint8_t *get_stored() const;
+
 	/// interface to HashTable
 	size_t hash() const { return filename.hash(); }
 
@@ -0,0 +1,62 @@
+// Null checks and type checks the optimizing tier can prove to succeed:
+// calls on an object after its fields were accessed, casts repeated on
+// the same value, and casts and instanceof of freshly allocated objects.
+//
+// Usage: cacao -XX:+Inline -XX:+LogCompilation CheckElimination [iterations]
+// Compare the times with -XX:-EliminateChecks; the "nullchecks" and
+// "typechecks" columns of the compilation log show the checks removed
+// per method.
+
+public class CheckElimination {
+
+    static class Point {
+        int x, y;
+
+        final int sum() {
+            return x + y;
+        }
+    }
+
+    static class Point3 extends Point {
+        int z;
+    }
+
+    static int dereferenced(Point p) {
+        p.x++;
+        return p.sum() + p.sum();
+    }
+
+    static int repeatedCast(Object o) {
+        int r = ((Point) o).x;
+        r += ((Point) o).y;
+        return r + ((Point) o).sum();
+    }
+
+    static int allocated(int i) {
+        Object o = new Point3();
+        Point p = (Point) o;
+        p.x = i;
+        return (o instanceof Point) ? p.sum() : 0;
+    }
+
+    public static void main(String[] args) {
+        int n = args.length > 0 ? Integer.parseInt(args[0]) : 100000000;
+        Point p = new Point3();
+        int sum = 0;
+
+        long start = System.currentTimeMillis();
+        for (int i = 0; i < n; i++)
+            sum += dereferenced(p);
+        long t1 = System.currentTimeMillis();
+        for (int i = 0; i < n; i++)
+            sum += repeatedCast(p);
+        long t2 = System.currentTimeMillis();
+        for (int i = 0; i < n; i++)
+            sum += allocated(i);
+        long t3 = System.currentTimeMillis();
+
+        System.out.println("dereferenced: " + (t1 - start) + " ms");
+        System.out.println("repeatedCast: " + (t2 - t1) + " ms");
+        System.out.println("allocated:    " + (t3 - t2) + " ms (" + sum + ")");
+    }
+}
@@ -0,0 +1,174 @@
+// Instruction cache pressure from cold code: many small hot methods,
+// each with argument checks that throw and exception handlers that are
+// never executed.  With hot/cold splitting the hot paths of a method
+// are contiguous and the cold code is placed behind them.
+//
+// Usage: cacao -XX:+LogCompilation ColdCode [rounds]
+// Compare the times with -XX:-HotColdSplitting; the "cold" column of
+// the compilation log shows the blocks moved per method.
+
+public class ColdCode {
+
+    static int checked;
+
+    static void fail(String what, int value) {
+        throw new IllegalArgumentException(what + " out of range: " + value);
+    }
+
+    static int k0(int[] a, int i) {
+        if (a == null)
+            throw new NullPointerException("a is null in k0");
+        if (i < 0 || i >= a.length)
+            throw new IndexOutOfBoundsException("k0: " + i + " not in [0, " + a.length + ")");
+        return a[i] * 3 + 1;
+    }
+
+    static int k1(int[] a, int i) {
+        try {
+            return a[i] ^ (a[i] >>> 3);
+        }
+        catch (ArrayIndexOutOfBoundsException e) {
+            StringBuilder sb = new StringBuilder("k1: ");
+            sb.append(i).append(" of ").append(a.length);
+            throw new IllegalStateException(sb.toString(), e);
+        }
+    }
+
+    static int k2(int x) {
+        if (x == Integer.MIN_VALUE)
+            fail("k2", x);
+        int r = x < 0 ? -x : x;
+        if (r > 1000000)
+            throw new ArithmeticException("k2 overflow: " + x + " -> " + r);
+        return r + 7;
+    }
+
+    static int k3(String s, int i) {
+        if (s == null || s.length() == 0)
+            throw new IllegalArgumentException("k3: empty string at " + i);
+        return s.charAt(i % s.length()) + i;
+    }
+
+    static int k4(int[] a, int i, int j) {
+        int r = 0;
+        try {
+            r = a[i] + a[j];
+        }
+        catch (RuntimeException e) {
+            checked++;
+            System.err.println("k4: " + e + " at " + i + ", " + j);
+            r = -1;
+        }
+        return r;
+    }
+
+    static long k5(long x, int shift) {
+        if (shift < 0 || shift > 63)
+            throw new IllegalArgumentException("k5: shift " + shift + " for " + x);
+        return (x << shift) | (x >>> (64 - shift));
+    }
+
+    static int k6(Object o) {
+        if (!(o instanceof int[])) {
+            String name = (o == null) ? "null" : o.getClass().getName();
+            throw new ClassCastException("k6: expected int[] but got " + name);
+        }
+        int[] a = (int[]) o;
+        return a.length > 0 ? a[0] : 0;
+    }
+
+    static int k7(int[] a, int i) {
+        int v = a[i & (a.length - 1)];
+        switch (v & 3) {
+        case 0:  return v + 1;
+        case 1:  return v * 2;
+        case 2:  return v - 3;
+        case 3:  return v ^ 5;
+        default: throw new IllegalStateException("k7: impossible " + v);
+        }
+    }
+
+    static int k8(int x, int y) {
+        if (y == 0)
+            throw new ArithmeticException("k8: division of " + x + " by zero");
+        try {
+            return x / y + x % y;
+        }
+        catch (ArithmeticException e) {
+            throw new IllegalStateException("k8: " + x + " / " + y, e);
+        }
+    }
+
+    static int k9(int[] a, int i) {
+        synchronized (a) {
+            if (i < 0)
+                throw new IllegalArgumentException("k9: negative index " + i);
+            return a[i % a.length] + i;
+        }
+    }
+
+    static int k10(String s) {
+        int h = 0;
+        for (int i = 0; i < s.length(); i++) {
+            char c = s.charAt(i);
+            if (c == 0)
+                throw new IllegalArgumentException("k10: NUL at " + i + " in \"" + s + "\"");
+            h = 31 * h + c;
+        }
+        return h;
+    }
+
+    static int k11(int[] a, int i) {
+        try {
+            return k0(a, i) + k2(i);
+        }
+        catch (IndexOutOfBoundsException e) {
+            return -k10(e.getMessage());
+        }
+        catch (ArithmeticException e) {
+            return -k10(e.toString());
+        }
+    }
+
+    static long time(String name, long start) {
+        long t = System.currentTimeMillis() - start;
+        System.out.println(name + ": " + t + " ms");
+        return t;
+    }
+
+    public static void main(String[] args) {
+        int rounds = args.length > 0 ? Integer.parseInt(args[0]) : 2000000;
+
+        int[] a = new int[64];
+        for (int i = 0; i < a.length; i++)
+            a[i] = i * 17;
+
+        // the cold paths still work
+
+        boolean thrown = false;
+        try {
+            k0(a, -1);
+        }
+        catch (IndexOutOfBoundsException e) {
+            thrown = true;
+        }
+        if (!thrown || k4(a, 0, 64) != -1)
+            throw new RuntimeException("cold path failed");
+
+        long start = System.currentTimeMillis();
+        long r = 0;
+
+        for (int n = 0; n < rounds; n++) {
+            int i = n & 63;
+            r += k0(a, i) + k1(a, i) + k2(i) + k3("cold", i) + k4(a, i, 63 - i);
+            r += k5(n, i) + k6(a) + k7(a, n) + k8(n, i + 1) + k9(a, i);
+            r += k10("hot") + k11(a, i);
+        }
+
+        time("round robin", start);
+
+        // keep the results alive
+        if (r == 42)
+            System.out.println(r);
+    }
+}
@@ -0,0 +1,54 @@
+// Throws exceptions through call chains of various depths and catches
+// them at the bottom.
+//
+// Usage: cacao ExceptionDispatch [iterations]
+// Compare with -XX:-ExceptionCache.  The exception is preallocated, so
+// the times are dominated by unwinding and handler lookup.
+
+public class ExceptionDispatch {
+
+    static final RuntimeException EXCEPTION = new IllegalStateException();
+
+    static int counter;
+
+    static void thrower(int depth) {
+        if (depth == 0)
+            throw EXCEPTION;
+
+        try {
+            thrower(depth - 1);
+        } catch (IllegalArgumentException e) {
+            // never taken, makes every frame look at its handlers
+            counter--;
+        } finally {
+            counter++;
+        }
+    }
+
+    static long time(int depth, int iterations) {
+        long start = System.nanoTime();
+
+        for (int i = 0; i < iterations; i++) {
+            try {
+                thrower(depth);
+            } catch (IllegalStateException e) {
+                counter++;
+            }
+        }
+
+        return (System.nanoTime() - start) / 1000000;
+    }
+
+    public static void main(String[] args) {
+        int iterations = args.length > 0 ? Integer.parseInt(args[0]) : 100000;
+        int[] depths = { 1, 4, 16, 64 };
+
+        // warm up
+        time(8, iterations / 10);
+
+        for (int d : depths)
+            System.out.println("depth " + d + ": " + time(d, iterations) + " ms");
+
+        System.out.println("counter " + counter);
+    }
+}
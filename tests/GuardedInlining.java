@@ -0,0 +1,106 @@
+// Virtual and interface calls of small getters and comparators whose
+// receivers are of one class most of the time, and a call site whose
+// receiver class changes half way, which deoptimizes the method.
+//
+// Usage: cacao -XX:+TieredCompilation -XX:+Inline -XX:+PrintTieredStatistics
+//        -XX:TraceInlining=1 GuardedInlining [iterations]
+// Compare the times with -XX:-GuardedInlining; the statistics show the
+// receiver checks compiled and the methods deoptimized.
+
+import java.util.Comparator;
+
+public class GuardedInlining {
+
+    static class Point {
+        int x, y;
+        Point(int x, int y) { this.x = x; this.y = y; }
+        int getX() { return x; }
+        int getY() { return y; }
+    }
+
+    static class ShiftedPoint extends Point {
+        ShiftedPoint(int x, int y) { super(x, y); }
+        int getX() { return x + 1; }
+    }
+
+    static class ByX implements Comparator<Point> {
+        public int compare(Point a, Point b) { return a.getX() - b.getX(); }
+    }
+
+    static class ByY implements Comparator<Point> {
+        public int compare(Point a, Point b) { return a.getY() - b.getY(); }
+    }
+
+    // monomorphic virtual calls
+    static long sum(Point[] a) {
+        long s = 0;
+        for (int i = 0; i < a.length; i++)
+            s += a[i].getX() + a[i].getY();
+        return s;
+    }
+
+    // interface calls through one comparator class
+    static int count(Point[] a, Comparator<Point> c) {
+        int n = 0;
+        for (int i = 1; i < a.length; i++)
+            if (c.compare(a[i - 1], a[i]) < 0)
+                n++;
+        return n;
+    }
+
+    static long time(String name, long start) {
+        long t = System.currentTimeMillis() - start;
+        System.out.println(name + ": " + t + " ms");
+        return t;
+    }
+
+    public static void main(String[] args) {
+        int iterations = args.length > 0 ? Integer.parseInt(args[0]) : 20000;
+
+        Point[] points  = new Point[1000];
+        Point[] shifted = new Point[1000];
+        for (int i = 0; i < points.length; i++) {
+            points[i]  = new Point(i, 2 * i);
+            shifted[i] = new ShiftedPoint(i, 2 * i);
+        }
+
+        Comparator<Point> byX = new ByX();
+        Comparator<Point> byY = new ByY();
+
+        // check results first, the timings are useless otherwise
+
+        if (sum(points) != 3 * 999 * 1000 / 2)
+            throw new RuntimeException("sum failed");
+        if (sum(shifted) != 3 * 999 * 1000 / 2 + 1000)
+            throw new RuntimeException("sum of shifted points failed");
+        if (count(points, byX) != 999 || count(points, byY) != 999)
+            throw new RuntimeException("count failed");
+
+        long start;
+        long r = 0;
+
+        start = System.currentTimeMillis();
+        for (int n = 0; n < iterations; n++)
+            r += sum(points);
+        time("getter", start);
+
+        start = System.currentTimeMillis();
+        for (int n = 0; n < iterations; n++)
+            r += count(points, byX);
+        time("comparator", start);
+
+        // the profiled class of sum() does not match any more
+
+        start = System.currentTimeMillis();
+        for (int n = 0; n < iterations; n++)
+            r += sum(shifted);
+        time("getter (other class)", start);
+
+        if (sum(shifted) != 3 * 999 * 1000 / 2 + 1000)
+            throw new RuntimeException("sum after deoptimization failed");
+
+        // keep the results alive
+        if (r == 42)
+            System.out.println(r);
+    }
+}
@@ -0,0 +1,58 @@
+// Parses numbers the lazy way, relying on implicit exceptions for the
+// end of the input and for bad values.
+//
+// Usage: cacao -XX:ImplicitExceptionThreshold=<n> ImplicitExceptions [iterations]
+// Compare with the default threshold of 0, which creates a new
+// exception with a full stack trace every time.  Run with
+// -XX:+PrintImplicitExceptionStatistics to see the trap sites.
+
+public class ImplicitExceptions {
+
+    static final int[] DIGITS = { 1, 2, 0, 4, 5, 0, 7, 8, 9 };
+
+    static int parse(int[] digits, int[] divisors) {
+        int sum = 0;
+        int i = 0;
+
+        try {
+            for (;;) {
+                // throws ArrayIndexOutOfBoundsException at the end
+                // and ArithmeticException for every zero
+                try {
+                    sum += 100 / digits[i] / divisors[i % divisors.length];
+                } catch (ArithmeticException e) {
+                    sum--;
+                }
+                i++;
+            }
+        } catch (ArrayIndexOutOfBoundsException e) {
+            return sum;
+        }
+    }
+
+    static int length(String s) {
+        try {
+            return s.length();
+        } catch (NullPointerException e) {
+            return -1;
+        }
+    }
+
+    public static void main(String[] args) {
+        int iterations = args.length > 0 ? Integer.parseInt(args[0]) : 200000;
+        int[] divisors = { 1, 2, 3 };
+        String[] strings = { "a", null, "abc" };
+        long result = 0;
+
+        long start = System.currentTimeMillis();
+
+        for (int i = 0; i < iterations; i++) {
+            result += parse(DIGITS, divisors);
+            result += length(strings[i % strings.length]);
+        }
+
+        long t = System.currentTimeMillis() - start;
+
+        System.out.println(iterations + " iterations: result " + result + ", " + t + " ms");
+    }
+}
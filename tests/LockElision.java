@@ -0,0 +1,60 @@
+// Monitor operations on objects that never leave the method: a
+// StringBuffer built and consumed locally, a Vector used as a scratch
+// list, and nested synchronized blocks on a local lock object.
+//
+// Usage: cacao -XX:+Inline -XX:+LogCompilation LockElision [iterations]
+// Compare the times with -XX:-EliminateLocks; the "elided" column of
+// the compilation log shows the monitor operations removed per method.
+// The synchronized methods of StringBuffer and Vector are only elided
+// once they are inlined.
+
+import java.util.Vector;
+
+public class LockElision {
+
+    static int stringBuffer(int i) {
+        StringBuffer sb = new StringBuffer();
+        sb.append('x').append(i).append("y");
+        return sb.length();
+    }
+
+    static int vector(int i) {
+        Vector<Integer> v = new Vector<Integer>();
+        v.addElement(i);
+        v.addElement(i + 1);
+        return v.size();
+    }
+
+    static int nested(int i) {
+        Object lock = new Object();
+        int r;
+
+        synchronized (lock) {
+            synchronized (lock) {
+                r = i + 1;
+            }
+        }
+
+        return r;
+    }
+
+    public static void main(String[] args) {
+        int n = args.length > 0 ? Integer.parseInt(args[0]) : 10000000;
+        int sum = 0;
+
+        long start = System.currentTimeMillis();
+        for (int i = 0; i < n; i++)
+            sum += stringBuffer(i);
+        long t1 = System.currentTimeMillis();
+        for (int i = 0; i < n; i++)
+            sum += vector(i);
+        long t2 = System.currentTimeMillis();
+        for (int i = 0; i < n; i++)
+            sum += nested(i);
+        long t3 = System.currentTimeMillis();
+
+        System.out.println("StringBuffer: " + (t1 - start) + " ms");
+        System.out.println("Vector:       " + (t2 - t1) + " ms");
+        System.out.println("nested:       " + (t3 - t2) + " ms (" + sum + ")");
+    }
+}
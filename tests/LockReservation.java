@@ -0,0 +1,102 @@
+// Lock reservation: objects locked by a single thread only, and an
+// object reserved by one thread that a second thread locks later, so
+// the reservation has to be revoked while the owner keeps running.
+//
+// Usage: cacao -XX:+LockReservation LockReservation [iterations]
+// Compare the times with -XX:-LockReservation; the counter must come
+// out the same, a lost update means a broken revocation.
+
+import java.util.Vector;
+
+public class LockReservation {
+
+    static int stringBuffer(int n) {
+        StringBuffer sb = new StringBuffer();
+        int length = 0;
+
+        for (int i = 0; i < n; i++) {
+            sb.setLength(0);
+            sb.append('x').append(i).append("y");
+            length += sb.length();
+        }
+
+        return length;
+    }
+
+    static int vector(int n) {
+        Vector<Integer> v = new Vector<Integer>();
+        int sum = 0;
+
+        for (int i = 0; i < n; i++) {
+            v.addElement(i);
+
+            if (v.size() > 16)
+                v.removeAllElements();
+
+            sum += v.size();
+        }
+
+        return sum;
+    }
+
+    static class Counter {
+        int value;
+
+        synchronized void increment() {
+            value++;
+        }
+    }
+
+    static class Incrementer extends Thread {
+        private final Counter counter;
+        private final int n;
+
+        Incrementer(Counter counter, int n) {
+            this.counter = counter;
+            this.n = n;
+        }
+
+        public void run() {
+            for (int i = 0; i < n; i++)
+                counter.increment();
+        }
+    }
+
+    static int revocation(int n) throws InterruptedException {
+        Counter counter = new Counter();
+
+        // reserved by the main thread ...
+        for (int i = 0; i < n; i++)
+            counter.increment();
+
+        // ... and revoked as soon as the second thread locks it
+        Incrementer other = new Incrementer(counter, n);
+        other.start();
+
+        for (int i = 0; i < n; i++)
+            counter.increment();
+
+        other.join();
+
+        return counter.value;
+    }
+
+    public static void main(String[] args) throws Exception {
+        int n = args.length > 0 ? Integer.parseInt(args[0]) : 10000000;
+
+        long start = System.currentTimeMillis();
+        int length = stringBuffer(n);
+        long t1 = System.currentTimeMillis();
+        int sum = vector(n);
+        long t2 = System.currentTimeMillis();
+        int value = revocation(n);
+        long t3 = System.currentTimeMillis();
+
+        System.out.println("StringBuffer: " + (t1 - start) + " ms (" + length + ")");
+        System.out.println("Vector:       " + (t2 - t1) + " ms (" + sum + ")");
+        System.out.println("revocation:   " + (t3 - t2) + " ms (" + value + ")");
+
+        if (value != 3 * n)
+            System.out.println("FAILED: expected " + (3 * n) + ", got " + value);
+    }
+}
@@ -0,0 +1,169 @@
+// Loop kernels with invariant loads, type checks and arithmetic.
+//
+// Usage: cacao -oloop LoopInvariants [size] [times]
+// Compare against a run with -XX:-LoopInvariantCodeMotion.
+
+public class LoopInvariants {
+
+    static class Vector {
+        int[] data;
+        int   scale;
+        int   offset;
+
+        Vector(int n) {
+            data = new int[n];
+        }
+    }
+
+    int[] values;
+    int   bias;
+
+    LoopInvariants(int n) {
+        values = new int[n];
+    }
+
+    // this.values and this.bias are loaded in every iteration
+    int sumBiased() {
+        int s = 0;
+        for (int i = 0; i < values.length; i++)
+            s += values[i] + bias;
+        return s;
+    }
+
+    // v.data, v.scale and v.offset need a null check in the preheader
+    static void scale(Vector v) {
+        for (int i = 0; i < v.data.length; i++)
+            v.data[i] = v.data[i] * v.scale + v.offset;
+    }
+
+    // a * b + c is recomputed in every iteration
+    static int affine(int[] a, int x, int y, int z) {
+        int s = 0;
+        for (int i = 0; i < a.length; i++)
+            s += a[i] * (x * y + z);
+        return s;
+    }
+
+    // the cast and the field loads only depend on o
+    static int castSum(Object o, int n) {
+        int s = 0;
+        for (int i = 0; i < n; i++)
+            s += ((Vector) o).scale + i;
+        return s;
+    }
+
+    // the unoptimized loop is taken for null and for other classes
+    static int instanceSum(Object o, int n) {
+        int s = 0;
+        for (int i = 0; i < n; i++)
+            if (o instanceof Vector)
+                s += i;
+        return s;
+    }
+
+    static long time(String name, long start) {
+        long t = System.currentTimeMillis() - start;
+        System.out.println(name + ": " + t + " ms");
+        return t;
+    }
+
+    public static void main(String[] args) {
+        int n     = args.length > 0 ? Integer.parseInt(args[0]) : 10000;
+        int times = args.length > 1 ? Integer.parseInt(args[1]) : 10000;
+
+        LoopInvariants li = new LoopInvariants(n);
+        Vector         v  = new Vector(n);
+
+        li.bias = 3;
+        v.scale = 1;
+        v.offset = 0;
+
+        for (int i = 0; i < n; i++) {
+            li.values[i] = i;
+            v.data[i] = i;
+        }
+
+        // check results first, the timings are useless otherwise
+
+        int expected = 0;
+        for (int i = 0; i < n; i++)
+            expected += i;
+
+        if (li.sumBiased() != expected + 3 * n)
+            throw new RuntimeException("sumBiased failed");
+
+        v.scale = 2;
+        v.offset = 1;
+        scale(v);
+        for (int i = 0; i < n; i++)
+            if (v.data[i] != 2 * i + 1)
+                throw new RuntimeException("scale failed");
+
+        boolean thrown = false;
+        try {
+            scale(null);
+        }
+        catch (NullPointerException e) {
+            thrown = true;
+        }
+        if (!thrown)
+            throw new RuntimeException("scale(null) did not throw");
+
+        if (affine(li.values, 2, 3, 1) != 7 * expected)
+            throw new RuntimeException("affine failed");
+
+        if (castSum(v, n) != 2 * n + expected)
+            throw new RuntimeException("castSum failed");
+
+        if (castSum("x", 0) != 0)
+            throw new RuntimeException("castSum of an empty loop failed");
+
+        thrown = false;
+        try {
+            castSum("x", 1);
+        }
+        catch (ClassCastException e) {
+            thrown = true;
+        }
+        if (!thrown)
+            throw new RuntimeException("castSum did not throw");
+
+        if (instanceSum(v, n) != expected || instanceSum(null, n) != 0 || instanceSum("x", n) != 0)
+            throw new RuntimeException("instanceSum failed");
+
+        long start;
+        int  r = 0;
+
+        v.scale = 1;
+        v.offset = 0;
+
+        start = System.currentTimeMillis();
+        for (int t = 0; t < times; t++)
+            r += li.sumBiased();
+        time("sumBiased", start);
+
+        start = System.currentTimeMillis();
+        for (int t = 0; t < times; t++)
+            scale(v);
+        time("scale", start);
+
+        start = System.currentTimeMillis();
+        for (int t = 0; t < times; t++)
+            r += affine(li.values, t, 3, 1);
+        time("affine", start);
+
+        start = System.currentTimeMillis();
+        for (int t = 0; t < times; t++)
+            r += castSum(v, n);
+        time("castSum", start);
+
+        start = System.currentTimeMillis();
+        for (int t = 0; t < times; t++)
+            r += instanceSum(v, n);
+        time("instanceSum", start);
+
+        // keep the results alive
+        if (r == 42)
+            System.out.println(r);
+    }
+}
@@ -0,0 +1,117 @@
+// Array loop kernels for the loop optimizer.
+//
+// Usage: cacao -oloop LoopKernels [size] [times]
+// Compare against a run without -oloop or with -XX:LoopUnrollFactor=1.
+
+public class LoopKernels {
+
+    static int sum(int[] a) {
+        int s = 0;
+        for (int i = 0; i < a.length; i++)
+            s += a[i];
+        return s;
+    }
+
+    static double dsum(double[] a) {
+        double s = 0;
+        for (int i = 0; i < a.length; i++)
+            s += a[i];
+        return s;
+    }
+
+    static void saxpy(float alpha, float[] x, float[] y) {
+        for (int i = 0; i < x.length; i++)
+            y[i] = alpha * x[i] + y[i];
+    }
+
+    static void fill(int[] a, int v) {
+        for (int i = 0; i < a.length; i++)
+            a[i] = v;
+    }
+
+    static int compare(byte[] a, byte[] b) {
+        int diff = 0;
+        for (int i = 0; i < a.length; i++)
+            diff |= a[i] ^ b[i];
+        return diff;
+    }
+
+    static long time(String name, long start) {
+        long t = System.currentTimeMillis() - start;
+        System.out.println(name + ": " + t + " ms");
+        return t;
+    }
+
+    public static void main(String[] args) {
+        int n     = args.length > 0 ? Integer.parseInt(args[0]) : 10000;
+        int times = args.length > 1 ? Integer.parseInt(args[1]) : 10000;
+
+        int[]    ia = new int[n];
+        double[] da = new double[n];
+        float[]  fx = new float[n];
+        float[]  fy = new float[n];
+        byte[]   ba = new byte[n];
+        byte[]   bb = new byte[n];
+
+        for (int i = 0; i < n; i++) {
+            ia[i] = i;
+            da[i] = i;
+            fx[i] = i;
+            ba[i] = bb[i] = (byte) i;
+        }
+
+        // check results first, the timings are useless otherwise
+
+        int expected = 0;
+        for (int i = 0; i < n; i++)
+            expected += i;
+
+        if (sum(ia) != expected || dsum(da) != (double) expected)
+            throw new RuntimeException("sum failed");
+
+        saxpy(2.0f, fx, fy);
+        for (int i = 0; i < n; i++)
+            if (fy[i] != 2.0f * i)
+                throw new RuntimeException("saxpy failed");
+
+        if (compare(ba, bb) != 0)
+            throw new RuntimeException("compare failed");
+
+        fill(ia, 7);
+        for (int i = 0; i < n; i++)
+            if (ia[i] != 7)
+                throw new RuntimeException("fill failed");
+
+        long start;
+        int  r = 0;
+
+        start = System.currentTimeMillis();
+        for (int t = 0; t < times; t++)
+            r += sum(ia);
+        time("sum", start);
+
+        start = System.currentTimeMillis();
+        for (int t = 0; t < times; t++)
+            r += (int) dsum(da);
+        time("dsum", start);
+
+        start = System.currentTimeMillis();
+        for (int t = 0; t < times; t++)
+            saxpy(0.5f, fx, fy);
+        time("saxpy", start);
+
+        start = System.currentTimeMillis();
+        for (int t = 0; t < times; t++)
+            fill(ia, t);
+        time("fill", start);
+
+        start = System.currentTimeMillis();
+        for (int t = 0; t < times; t++)
+            r += compare(ba, bb);
+        time("compare", start);
+
+        // keep the results alive
+        if (r == 42)
+            System.out.println(r);
+    }
+}
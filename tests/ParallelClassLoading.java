@@ -0,0 +1,90 @@
+// Loads all classes of a jar file with the bootstrap class loader from
+// several threads at once.
+//
+// Usage: cacao -Xbootclasspath/a:<jar> ParallelClassLoading <jar> [threads]
+// Compare the times for 1 and more threads; with a single big jar the
+// threads used to serialize on inflating the class files.
+
+import java.util.ArrayList;
+import java.util.Enumeration;
+import java.util.List;
+import java.util.zip.ZipEntry;
+import java.util.zip.ZipFile;
+
+public class ParallelClassLoading {
+
+    static List<String> classNames(String jar) throws Exception {
+        List<String> names = new ArrayList<String>();
+        ZipFile zip = new ZipFile(jar);
+
+        for (Enumeration<? extends ZipEntry> e = zip.entries(); e.hasMoreElements(); ) {
+            String name = e.nextElement().getName();
+
+            if (name.endsWith(".class"))
+                names.add(name.substring(0, name.length() - 6).replace('/', '.'));
+        }
+
+        zip.close();
+        return names;
+    }
+
+    static class Loader extends Thread {
+        private final List<String> names;
+        private final int first;
+        private final int step;
+        int loaded;
+        int failed;
+
+        Loader(List<String> names, int first, int step) {
+            this.names = names;
+            this.first = first;
+            this.step  = step;
+        }
+
+        public void run() {
+            for (int i = first; i < names.size(); i += step) {
+                try {
+                    // null selects the bootstrap class loader
+                    Class.forName(names.get(i), false, null);
+                    loaded++;
+                } catch (Throwable t) {
+                    failed++;
+                }
+            }
+        }
+    }
+
+    public static void main(String[] args) throws Exception {
+        if (args.length < 1) {
+            System.out.println("Usage: ParallelClassLoading <jar> [threads]");
+            return;
+        }
+
+        int threads = args.length > 1 ? Integer.parseInt(args[1]) : 4;
+        List<String> names = classNames(args[0]);
+
+        Loader[] loaders = new Loader[threads];
+
+        for (int i = 0; i < threads; i++)
+            loaders[i] = new Loader(names, i, threads);
+
+        long start = System.currentTimeMillis();
+
+        for (int i = 0; i < threads; i++)
+            loaders[i].start();
+
+        int loaded = 0;
+        int failed = 0;
+
+        for (int i = 0; i < threads; i++) {
+            loaders[i].join();
+            loaded += loaders[i].loaded;
+            failed += loaders[i].failed;
+        }
+
+        long t = System.currentTimeMillis() - start;
+
+        System.out.println(threads + " threads: " + loaded + " classes loaded, "
+                           + failed + " failed, " + t + " ms");
+    }
+}
@@ -0,0 +1,51 @@
+// Calls methods returning small primitives through reflection and
+// checks that the boxed results are the instances valueOf returns.
+//
+// Usage: cacao ReflectionBoxing [iterations]
+// Compare with -XX:-BoxCache, which allocates a new wrapper for every
+// result.
+
+import java.lang.reflect.Method;
+
+public class ReflectionBoxing {
+
+    public static int smallInt(int i)        { return i & 127; }
+    public static boolean flag(int i)        { return (i & 1) != 0; }
+    public static char ascii(int i)          { return (char) (i & 127); }
+    public static long bigLong(int i)        { return i * 1000000007L; }
+
+    public static void main(String[] args) throws Exception {
+        int iterations = args.length > 0 ? Integer.parseInt(args[0]) : 1000000;
+
+        Method smallInt = ReflectionBoxing.class.getMethod("smallInt", int.class);
+        Method flag     = ReflectionBoxing.class.getMethod("flag", int.class);
+        Method ascii    = ReflectionBoxing.class.getMethod("ascii", int.class);
+        Method bigLong  = ReflectionBoxing.class.getMethod("bigLong", int.class);
+
+        int same = 0;
+        long sum = 0;
+
+        long start = System.currentTimeMillis();
+
+        for (int i = 0; i < iterations; i++) {
+            Object a = smallInt.invoke(null, i);
+            Object b = flag.invoke(null, i);
+            Object c = ascii.invoke(null, i);
+            Object d = bigLong.invoke(null, i);
+
+            if (a == Integer.valueOf(smallInt(i)))
+                same++;
+            if (b == Boolean.valueOf(flag(i)))
+                same++;
+            if (c == Character.valueOf(ascii(i)))
+                same++;
+
+            sum += ((Integer) a) + ((Character) c) + ((Long) d);
+        }
+
+        long t = System.currentTimeMillis() - start;
+
+        System.out.println(iterations + " iterations: " + same + " of " + (3 * iterations)
+                           + " results canonical, sum " + sum + ", " + t + " ms");
+    }
+}
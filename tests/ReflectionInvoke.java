@@ -0,0 +1,63 @@
+// Times reflective calls of small methods.
+//
+// Usage: cacao ReflectionInvoke [calls]
+// Compare with -XX:ReflectionInvokerThreshold=0, which keeps every
+// call on the generic path.
+
+import java.lang.reflect.Method;
+
+public class ReflectionInvoke {
+
+    private int sum;
+
+    public static int add(int a, int b) {
+        return a + b;
+    }
+
+    public void accumulate(long l, double d) {
+        sum += (int) l + (int) d;
+    }
+
+    public final Object identity(Object o) {
+        return o;
+    }
+
+    static long time(Method m, Object receiver, Object[] args, int calls) throws Exception {
+        long start = System.nanoTime();
+
+        for (int i = 0; i < calls; i++)
+            m.invoke(receiver, args);
+
+        return (System.nanoTime() - start) / 1000000;
+    }
+
+    public static void main(String[] args) throws Exception {
+        int calls = args.length > 0 ? Integer.parseInt(args[0]) : 1000000;
+
+        ReflectionInvoke r = new ReflectionInvoke();
+
+        Method add        = ReflectionInvoke.class.getMethod("add", int.class, int.class);
+        Method accumulate = ReflectionInvoke.class.getMethod("accumulate", long.class, double.class);
+        Method identity   = ReflectionInvoke.class.getMethod("identity", Object.class);
+
+        // widening conversions must give the same results on both paths
+
+        if (((Integer) add.invoke(null, new Object[] { (byte) 1, (short) 2 })).intValue() != 3)
+            throw new Error("add failed");
+
+        accumulate.invoke(r, new Object[] { 40, 2.5f });
+
+        if (r.sum != 42)
+            throw new Error("accumulate failed: " + r.sum);
+
+        try {
+            add.invoke(null, new Object[] { 1L, 2 });
+            throw new Error("long accepted for int");
+        } catch (IllegalArgumentException e) {
+        }
+
+        System.out.println("static add:        " + time(add, null, new Object[] { 1, 2 }, calls) + " ms");
+        System.out.println("virtual accumulate: " + time(accumulate, r, new Object[] { 1L, 1.0 }, calls) + " ms");
+        System.out.println("final identity:    " + time(identity, r, new Object[] { "x" }, calls) + " ms");
+    }
+}
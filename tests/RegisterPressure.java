@@ -0,0 +1,160 @@
+// Register pressure from local variables: float kernels which call a
+// method outside their inner loop, and methods with many short-lived
+// locals.
+//
+// Usage: cacao -XX:+LogCompilation RegisterPressure [size] [times]
+// Compare the times and the "spilled" column of the compilation log
+// with -XX:-LinearScan.
+
+public class RegisterPressure {
+
+    static int calls;
+
+    static void note(double d) {
+        calls++;
+    }
+
+    // the float locals are live across no call in the loop
+    static double dot(double[] a, double[] b) {
+        double s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+        int n = a.length & ~3;
+        for (int i = 0; i < n; i += 4) {
+            s0 += a[i] * b[i];
+            s1 += a[i + 1] * b[i + 1];
+            s2 += a[i + 2] * b[i + 2];
+            s3 += a[i + 3] * b[i + 3];
+        }
+        double s = s0 + s1 + s2 + s3;
+        note(s);
+        return s;
+    }
+
+    static float poly(float[] x, float c0, float c1, float c2, float c3) {
+        float s = 0;
+        for (int i = 0; i < x.length; i++) {
+            float v = x[i];
+            s += ((c3 * v + c2) * v + c1) * v + c0;
+        }
+        note(s);
+        return s;
+    }
+
+    // the locals of each phase are dead in the next one
+    static int phases(int[] a) {
+        int s = 0;
+        for (int i = 0; i < a.length; i++) {
+            int p = a[i], q = p * 3, r = q ^ p;
+            s += p + q + r;
+        }
+        note(s);
+        for (int i = 0; i < a.length; i++) {
+            int t = a[i], u = t >>> 2, w = u + t;
+            s ^= t + u + w;
+        }
+        note(s);
+        for (int i = 0; i < a.length; i++) {
+            int x = a[i], y = x << 1, z = y - x;
+            s += x * y + z;
+        }
+        return s;
+    }
+
+    // the locals live across the call keep callee saved registers
+    static long mixed(int[] a, int n) {
+        long s = 0;
+        int k = 7;
+        for (int i = 0; i < n; i++) {
+            s += a[i % a.length] * k;
+            note(s);
+            k = k * 31 + i;
+        }
+        return s;
+    }
+
+    static long time(String name, long start) {
+        long t = System.currentTimeMillis() - start;
+        System.out.println(name + ": " + t + " ms");
+        return t;
+    }
+
+    public static void main(String[] args) {
+        int n     = args.length > 0 ? Integer.parseInt(args[0]) : 10000;
+        int times = args.length > 1 ? Integer.parseInt(args[1]) : 10000;
+
+        double[] a = new double[n];
+        double[] b = new double[n];
+        float[]  f = new float[n];
+        int[]    v = new int[n];
+
+        for (int i = 0; i < n; i++) {
+            a[i] = i;
+            b[i] = 2;
+            f[i] = 1;
+            v[i] = i;
+        }
+
+        // check results first, the timings are useless otherwise
+
+        double expected = 0;
+        for (int i = 0; i < (n & ~3); i++)
+            expected += 2.0 * i;
+
+        if (dot(a, b) != expected)
+            throw new RuntimeException("dot failed");
+
+        if (poly(f, 1, 2, 3, 4) != 10.0f * n)
+            throw new RuntimeException("poly failed");
+
+        int s = 0;
+        for (int i = 0; i < n; i++) {
+            int p = v[i], q = p * 3, r = q ^ p;
+            s += p + q + r;
+        }
+        for (int i = 0; i < n; i++) {
+            int t = v[i], u = t >>> 2, w = u + t;
+            s ^= t + u + w;
+        }
+        for (int i = 0; i < n; i++) {
+            int x = v[i], y = x << 1, z = y - x;
+            s += x * y + z;
+        }
+        if (phases(v) != s)
+            throw new RuntimeException("phases failed");
+
+        long m = 0;
+        int  k = 7;
+        for (int i = 0; i < n; i++) {
+            m += v[i % n] * k;
+            k = k * 31 + i;
+        }
+        if (mixed(v, n) != m)
+            throw new RuntimeException("mixed failed");
+
+        long   start;
+        double r = 0;
+
+        start = System.currentTimeMillis();
+        for (int t = 0; t < times; t++)
+            r += dot(a, b);
+        time("dot", start);
+
+        start = System.currentTimeMillis();
+        for (int t = 0; t < times; t++)
+            r += poly(f, t, 2, 3, 4);
+        time("poly", start);
+
+        start = System.currentTimeMillis();
+        for (int t = 0; t < times; t++)
+            r += phases(v);
+        time("phases", start);
+
+        start = System.currentTimeMillis();
+        for (int t = 0; t < times; t++)
+            r += mixed(v, n);
+        time("mixed", start);
+
+        // keep the results alive
+        if (r == 42)
+            System.out.println(r);
+    }
+}
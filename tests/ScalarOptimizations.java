@@ -0,0 +1,60 @@
+// Computations the scalar optimizations of the optimizing tier remove:
+// a debug flag known to be false, a field and an array length loaded
+// again after a store to another field, and multiplications and
+// remainders by powers of two held in locals.
+//
+// Usage: cacao -XX:+TieredCompilation ScalarOptimizations [iterations]
+// Compare the times with -XX:-ScalarOptimizations; run with
+// -stat (statistics builds) for the counts per optimization.
+
+public class ScalarOptimizations {
+
+    int[] data = new int[64];
+    int scale = 3;
+    int other;
+
+    int constants(int i) {
+        boolean debug = false;
+        int shift = 4;
+        int r = i << shift;
+
+        if (debug)
+            r += i * 17;
+
+        return r + (shift * 2 - 8);
+    }
+
+    int redundant(int i) {
+        int a = data[i & 63] * scale;
+        other = a;
+        int b = data[i & 63] * scale;
+        return a + b + data.length;
+    }
+
+    static int reduced(int i) {
+        int eight = 8;
+        long sixteen = 16;
+        return i * eight + i % eight + (int) ((i * sixteen) / sixteen);
+    }
+
+    public static void main(String[] args) {
+        int n = args.length > 0 ? Integer.parseInt(args[0]) : 100000000;
+        ScalarOptimizations s = new ScalarOptimizations();
+        int sum = 0;
+
+        long start = System.currentTimeMillis();
+        for (int i = 0; i < n; i++)
+            sum += s.constants(i);
+        long t1 = System.currentTimeMillis();
+        for (int i = 0; i < n; i++)
+            sum += s.redundant(i);
+        long t2 = System.currentTimeMillis();
+        for (int i = 0; i < n; i++)
+            sum += reduced(i);
+        long t3 = System.currentTimeMillis();
+
+        System.out.println("constants: " + (t1 - start) + " ms");
+        System.out.println("redundant: " + (t2 - t1) + " ms");
+        System.out.println("reduced:   " + (t3 - t2) + " ms (" + sum + ")");
+    }
+}
@@ -0,0 +1,99 @@
+// Uncontended locking in tight loops: synchronized methods of
+// StringBuffer and Vector, nested synchronized blocks, and a lock
+// shared by two threads now and then so the slow path is taken too.
+//
+// Usage: cacao SynchronizedLoops [iterations]
+// Monitors held once or recursively by the current thread are entered
+// and left inline on x86_64 without calling into the VM.
+
+import java.util.Vector;
+
+public class SynchronizedLoops {
+
+    static final Object lock = new Object();
+    static int counter;
+
+    static int stringBuffer(int n) {
+        StringBuffer sb = new StringBuffer();
+        int length = 0;
+
+        for (int i = 0; i < n; i++) {
+            sb.setLength(0);
+            sb.append('x').append(i).append("y");
+            length += sb.length();
+        }
+
+        return length;
+    }
+
+    static int vector(int n) {
+        Vector<Integer> v = new Vector<Integer>();
+        int sum = 0;
+
+        for (int i = 0; i < n; i++) {
+            v.addElement(i & 0xff);
+            if (v.size() == 64) {
+                for (int j = 0; j < v.size(); j++)
+                    sum += v.elementAt(j);
+                v.removeAllElements();
+            }
+        }
+
+        return sum;
+    }
+
+    static int nested(int n) {
+        for (int i = 0; i < n; i++) {
+            synchronized (lock) {
+                synchronized (lock) {
+                    counter++;
+                }
+            }
+        }
+
+        return counter;
+    }
+
+    static int contended(final int n) throws InterruptedException {
+        Thread t = new Thread() {
+            public void run() {
+                nested(n / 4);
+            }
+        };
+
+        t.start();
+        nested(n / 4);
+        t.join();
+
+        return counter;
+    }
+
+    static void time(String name, long start, int result) {
+        long t = System.currentTimeMillis() - start;
+        System.out.println(name + ": " + t + " ms (" + result + ")");
+    }
+
+    public static void main(String[] args) throws Exception {
+        int n = args.length > 0 ? Integer.parseInt(args[0]) : 2000000;
+
+        for (int round = 0; round < 3; round++) {
+            long start = System.currentTimeMillis();
+            time("StringBuffer", start, stringBuffer(n));
+
+            start = System.currentTimeMillis();
+            time("Vector", start, vector(n));
+
+            counter = 0;
+            start = System.currentTimeMillis();
+            time("nested", start, nested(n));
+
+            counter = 0;
+            start = System.currentTimeMillis();
+            int result = contended(n);
+            time("contended", start, result);
+
+            if (result != n / 2)
+                throw new RuntimeException("lost updates: " + result);
+        }
+    }
+}
@@ -0,0 +1,122 @@
+// Casts, instanceof tests and array stores whose sites see one class
+// most of the time: a deep class hierarchy, an interface implemented by
+// one class, and stores into an Object[] and a Shape[].
+//
+// Usage: cacao -XX:+TieredCompilation -XX:+PrintTieredStatistics
+//        -XX:+LogCompilation TypeProfile [iterations]
+// Compare the times with -XX:-TypeProfiles; the "guarded" column of the
+// compilation log shows the checks testing the profiled class first.
+
+public class TypeProfile {
+
+    interface Shape {
+        int area();
+    }
+
+    static class Base { int v = 1; }
+    static class D1 extends Base { }
+    static class D2 extends D1 { }
+    static class D3 extends D2 { }
+    static class D4 extends D3 { }
+    static class D5 extends D4 { }
+    static class D6 extends D5 { }
+    static class D7 extends D6 { }
+    static class D8 extends D7 implements Shape {
+        public int area() { return v * 2; }
+    }
+    static class Other extends Base implements Shape {
+        public int area() { return 3; }
+    }
+
+    // monomorphic: the cast to an interface and a shallow class
+    static int casts(Object[] a) {
+        int r = 0;
+        for (int i = 0; i < a.length; i++) {
+            r += ((Shape) a[i]).area();
+            r += ((Base) a[i]).v;
+        }
+        return r;
+    }
+
+    // dominated by D8, with an occasional Other
+    static int tests(Object[] a) {
+        int r = 0;
+        for (int i = 0; i < a.length; i++) {
+            if (a[i] instanceof D1)
+                r++;
+            if (a[i] instanceof Shape)
+                r += 2;
+        }
+        return r;
+    }
+
+    static void stores(Object[] objects, Shape[] shapes, Object[] from) {
+        for (int i = 0; i < from.length; i++) {
+            objects[i] = from[i];
+            shapes[i] = (Shape) from[i];
+        }
+    }
+
+    static long time(String name, long start) {
+        long t = System.currentTimeMillis() - start;
+        System.out.println(name + ": " + t + " ms");
+        return t;
+    }
+
+    public static void main(String[] args) {
+        int iterations = args.length > 0 ? Integer.parseInt(args[0]) : 20000;
+
+        Object[] mono  = new Object[1000];
+        Object[] mixed = new Object[1000];
+        for (int i = 0; i < mono.length; i++) {
+            mono[i]  = new D8();
+            mixed[i] = (i % 50 == 0) ? (Object) new Other() : new D8();
+        }
+
+        Object[] objects = new Object[1000];
+        Shape[]  shapes  = new D8[1000];
+
+        // check results first, the timings are useless otherwise
+
+        if (casts(mono) != 3000)
+            throw new RuntimeException("casts failed");
+        if (tests(mixed) != 980 + 2000)
+            throw new RuntimeException("tests failed");
+
+        stores(objects, new Shape[1000], mixed);
+        if (objects[50] != mixed[50])
+            throw new RuntimeException("stores failed");
+
+        boolean thrown = false;
+        try {
+            stores(objects, shapes, mixed);
+        }
+        catch (ArrayStoreException e) {
+            thrown = true;
+        }
+        if (!thrown)
+            throw new RuntimeException("array store check failed");
+
+        long start;
+        long r = 0;
+
+        start = System.currentTimeMillis();
+        for (int n = 0; n < iterations; n++)
+            r += casts(mono);
+        time("checkcast", start);
+
+        start = System.currentTimeMillis();
+        for (int n = 0; n < iterations; n++)
+            r += tests(mixed);
+        time("instanceof", start);
+
+        start = System.currentTimeMillis();
+        for (int n = 0; n < iterations; n++)
+            stores(objects, shapes, mono);
+        time("aastore", start);
+
+        // keep the results alive
+        if (r == 42)
+            System.out.println(r);
+    }
+}
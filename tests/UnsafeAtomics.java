@@ -0,0 +1,161 @@
+// Measures java.util.concurrent operations built on the atomic and
+// volatile accessors of sun.misc.Unsafe.
+//
+// Usage: cacao UnsafeAtomics [iterations] [threads]
+// Compare the times with -XX:+UnsafeIntrinsics (the default) and
+// -XX:-UnsafeIntrinsics, which calls the native methods through JNI.
+
+import java.util.concurrent.ConcurrentHashMap;
+import java.util.concurrent.ConcurrentLinkedQueue;
+import java.util.concurrent.atomic.AtomicInteger;
+import java.util.concurrent.atomic.AtomicLong;
+import java.util.concurrent.atomic.AtomicReference;
+
+public class UnsafeAtomics {
+
+    static int iterations;
+
+    static long atomicInteger() {
+        AtomicInteger a = new AtomicInteger();
+
+        for (int i = 0; i < iterations; i++)
+            a.incrementAndGet();
+
+        return a.get();
+    }
+
+    static long atomicLong() {
+        AtomicLong a = new AtomicLong();
+
+        for (int i = 0; i < iterations; i++)
+            a.addAndGet(i);
+
+        return a.get();
+    }
+
+    static long atomicReference() {
+        AtomicReference<Object> a = new AtomicReference<Object>();
+        Object o1 = new Object();
+        Object o2 = new Object();
+        long swapped = 0;
+
+        for (int i = 0; i < iterations; i++) {
+            if (a.compareAndSet(null, o1) || a.compareAndSet(o1, o2) || a.compareAndSet(o2, null))
+                swapped++;
+        }
+
+        return swapped;
+    }
+
+    static long lazySet() {
+        AtomicInteger a = new AtomicInteger();
+
+        for (int i = 0; i < iterations; i++)
+            a.lazySet(i);
+
+        return a.get();
+    }
+
+    static long concurrentHashMap() {
+        ConcurrentHashMap<Integer, Integer> map = new ConcurrentHashMap<Integer, Integer>();
+        long sum = 0;
+
+        for (int i = 0; i < iterations; i++) {
+            Integer key = Integer.valueOf(i & 1023);
+
+            map.put(key, key);
+            sum += map.get(key);
+        }
+
+        return sum;
+    }
+
+    static long concurrentLinkedQueue() {
+        ConcurrentLinkedQueue<Integer> queue = new ConcurrentLinkedQueue<Integer>();
+        Integer value = Integer.valueOf(1);
+        long sum = 0;
+
+        for (int i = 0; i < iterations; i++) {
+            queue.offer(value);
+            sum += queue.poll();
+        }
+
+        return sum;
+    }
+
+    static void run(String name, int test) {
+        long start = System.nanoTime();
+        long result = 0;
+
+        switch (test) {
+        case 0: result = atomicInteger();         break;
+        case 1: result = atomicLong();            break;
+        case 2: result = atomicReference();       break;
+        case 3: result = lazySet();               break;
+        case 4: result = concurrentHashMap();     break;
+        case 5: result = concurrentLinkedQueue(); break;
+        }
+
+        long t = System.nanoTime() - start;
+
+        System.out.println(name + ": " + (t / iterations) + " ns/op (" + result + ")");
+    }
+
+    static final String[] names = {
+        "AtomicInteger.incrementAndGet",
+        "AtomicLong.addAndGet",
+        "AtomicReference.compareAndSet",
+        "AtomicInteger.lazySet",
+        "ConcurrentHashMap.put/get",
+        "ConcurrentLinkedQueue.offer/poll"
+    };
+
+    // A shared counter updated from all threads, checks that no
+    // increment is lost.
+    static void contended(int threads) throws Exception {
+        final AtomicInteger counter = new AtomicInteger();
+        Thread[] t = new Thread[threads];
+
+        for (int i = 0; i < threads; i++) {
+            t[i] = new Thread() {
+                public void run() {
+                    for (int j = 0; j < iterations; j++)
+                        counter.incrementAndGet();
+                }
+            };
+        }
+
+        long start = System.nanoTime();
+
+        for (int i = 0; i < threads; i++)
+            t[i].start();
+
+        for (int i = 0; i < threads; i++)
+            t[i].join();
+
+        long time = System.nanoTime() - start;
+        int expected = threads * iterations;
+
+        System.out.println(threads + " threads incrementAndGet: " + (time / expected) + " ns/op"
+                           + (counter.get() == expected ? "" : " LOST UPDATES: " + counter.get() + " != " + expected));
+    }
+
+    public static void main(String[] args) throws Exception {
+        iterations = args.length > 0 ? Integer.parseInt(args[0]) : 10000000;
+        int threads = args.length > 1 ? Integer.parseInt(args[1]) : 4;
+
+        // warm up, so the measured loops run compiled code
+        int n = iterations;
+        iterations = 10000;
+        for (int i = 0; i < names.length; i++)
+            run(names[i], i);
+        iterations = n;
+
+        System.out.println();
+
+        for (int i = 0; i < names.length; i++)
+            run(names[i], i);
+
+        contended(threads);
+    }
+}
@@ -33,7 +33,8 @@ TestAbstractMethodError.class,
 TestArrayClasses.class,
 TestCloning.class,
 TestExceptionInStaticClassInitializer.class,
-TestPatcher.class
+TestPatcher.class,
+TestReflectionWidening.class
 })
 
 public class All {
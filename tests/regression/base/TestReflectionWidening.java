@@ -0,0 +1,125 @@
+/* tests/regression/base/TestReflectionWidening.java
+
+   Copyright (C) 1996-2013
+   CACAOVM - Verein zur Foerderung der freien virtuellen Maschine CACAO
+
+   This file is part of CACAO.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation; either version 2, or (at
+   your option) any later version.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA.
+
+*/
+
+
+import org.junit.Test;
+import static org.junit.Assert.*;
+
+import java.lang.reflect.Method;
+
+/* Method.invoke widens primitive arguments to the parameter types
+   (JLS 5.1.2).  Every call is repeated more often than
+   -XX:ReflectionInvokerThreshold, so both the generic path and the
+   cached invoker are tested. */
+
+public class TestReflectionWidening {
+	static final int CALLS = 40;
+
+	public static int sum(int a, int b) { return a + b; }
+	public static short neg(short s) { return (short) -s; }
+	public static long add(long a, long b) { return a + b; }
+	public static float half(float f) { return f / 2; }
+	public static double twice(double d) { return 2 * d; }
+	public static boolean not(boolean z) { return !z; }
+
+	private static Method method(String name, Class<?>... types) throws Exception {
+		return TestReflectionWidening.class.getMethod(name, types);
+	}
+
+	private static void check(Object expected, Method m, Object[] args) throws Exception {
+		for (int i = 0; i < CALLS; i++)
+			assertEquals("call " + i, expected, m.invoke(null, args));
+	}
+
+	private static void reject(Method m, Object[] args) throws Exception {
+		for (int i = 0; i < CALLS; i++) {
+			try {
+				m.invoke(null, args);
+				fail("IllegalArgumentException expected in call " + i);
+			} catch (IllegalArgumentException e) {
+			}
+		}
+	}
+
+	@Test
+	public void testToInt() throws Exception {
+		Method m = method("sum", int.class, int.class);
+
+		check(new Integer(1), m, new Object[] { new Byte((byte) -1), new Short((short) 2) });
+		check(new Integer(98), m, new Object[] { new Character('a'), new Integer(1) });
+		reject(m, new Object[] { new Long(1), new Integer(2) });
+		reject(m, new Object[] { new Float(1), new Integer(2) });
+		reject(m, new Object[] { Boolean.TRUE, new Integer(2) });
+	}
+
+	@Test
+	public void testToShort() throws Exception {
+		Method m = method("neg", short.class);
+
+		check(new Short((short) 3), m, new Object[] { new Byte((byte) -3) });
+		reject(m, new Object[] { new Character('a') });
+		reject(m, new Object[] { new Integer(1) });
+	}
+
+	@Test
+	public void testToLong() throws Exception {
+		Method m = method("add", long.class, long.class);
+
+		check(new Long(0), m, new Object[] { new Integer(-1), new Long(1) });
+		check(new Long(-5), m, new Object[] { new Short((short) -2), new Byte((byte) -3) });
+		check(new Long(0x10000), m, new Object[] { new Character('\uffff'), new Integer(1) });
+		reject(m, new Object[] { new Float(1), new Long(1) });
+	}
+
+	@Test
+	public void testToFloat() throws Exception {
+		Method m = method("half", float.class);
+
+		check(new Float(1.5f), m, new Object[] { new Float(3.0f) });
+		check(new Float(-2.0f), m, new Object[] { new Integer(-4) });
+		check(new Float(0.5f), m, new Object[] { new Character('\u0001') });
+		check(new Float(1L << 40), m, new Object[] { new Long(1L << 41) });
+		reject(m, new Object[] { new Double(3.0) });
+	}
+
+	@Test
+	public void testToDouble() throws Exception {
+		Method m = method("twice", double.class);
+
+		check(new Double(3.0), m, new Object[] { new Float(1.5f) });
+		check(new Double(3.0), m, new Object[] { new Double(1.5) });
+		check(new Double(-6.0), m, new Object[] { new Byte((byte) -3) });
+		check(new Double(194.0), m, new Object[] { new Character('a') });
+		check(new Double(1L << 41), m, new Object[] { new Long(1L << 40) });
+		reject(m, new Object[] { Boolean.TRUE });
+	}
+
+	@Test
+	public void testBoolean() throws Exception {
+		Method m = method("not", boolean.class);
+
+		check(Boolean.FALSE, m, new Object[] { Boolean.TRUE });
+		reject(m, new Object[] { new Integer(0) });
+	}
+}
@@ -0,0 +1,117 @@
+/* tests/regression/tiered/TestGuardedReceiver.java
+
+   Copyright (C) 1996-2013
+   CACAOVM - Verein zur Foerderung der freien virtuellen Maschine CACAO
+
+   This file is part of CACAO.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation; either version 2, or (at
+   your option) any later version.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA.
+
+*/
+
+
+import org.junit.Test;
+import static org.junit.Assert.*;
+
+/* Virtual and interface calls inlined behind a check of the profiled
+   receiver class.  After the methods have been promoted, the receiver
+   class changes: the checks fail, the calls must still reach the right
+   method, and the methods are deoptimized after enough failures.
+
+   This test needs the inliner and is run on its own, see
+   Makefile.am. */
+
+public class TestGuardedReceiver {
+	static class Value {
+		int get() { return 1; }
+	}
+
+	static class DoubleValue extends Value {
+		int get() { return 2; }
+	}
+
+	interface Op {
+		int apply(int x);
+	}
+
+	static class Inc implements Op {
+		public int apply(int x) { return x + 1; }
+	}
+
+	static class Dec implements Op {
+		public int apply(int x) { return x - 1; }
+	}
+
+	static int sum(Value[] a) {
+		int s = 0;
+		for (int i = 0; i < a.length; i++)
+			s += a[i].get();
+		return s;
+	}
+
+	static int fold(Op op, int n) {
+		int x = 0;
+		for (int i = 0; i < n; i++)
+			x = op.apply(x);
+		return x;
+	}
+
+	static Value[] fill(Value[] a, boolean mixed) {
+		for (int i = 0; i < a.length; i++)
+			a[i] = (mixed && (i % 2 == 1)) ? new DoubleValue() : new Value();
+		return a;
+	}
+
+	@Test
+	public void testReceiverChange() throws Exception {
+		final Value[] values  = fill(new Value[100], false);
+		final Value[] mixed   = fill(new Value[100], true);
+		final Value[] doubles = new Value[100];
+		for (int i = 0; i < doubles.length; i++)
+			doubles[i] = new DoubleValue();
+
+		final Op inc = new Inc();
+		final Op dec = new Dec();
+
+		// promote with one receiver class at each call site
+		TieredDriver.promote(new TieredDriver.Workload() {
+				public Object run() {
+					sum(values);
+					fold(inc, 100);
+					return null;
+				}
+			}, 20, 200);
+
+		assertEquals(100, sum(values));
+		assertEquals(10, fold(inc, 10));
+
+		// the receiver class changes
+		for (int i = 0; i < 5000; i++) {
+			assertEquals("iteration " + i, 200, sum(doubles));
+			assertEquals("iteration " + i, 150, sum(mixed));
+			assertEquals("iteration " + i, -10, fold(dec, 10));
+		}
+
+		// after the methods have been deoptimized
+		Thread.sleep(TieredDriver.PAUSE);
+
+		assertEquals(200, sum(doubles));
+		assertEquals(150, sum(mixed));
+		assertEquals(100, sum(values));
+		assertEquals(-10, fold(dec, 10));
+		assertEquals(10, fold(inc, 10));
+	}
+}
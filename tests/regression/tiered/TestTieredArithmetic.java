@@ -0,0 +1,120 @@
+/* tests/regression/tiered/TestTieredArithmetic.java
+
+   Copyright (C) 1996-2013
+   CACAOVM - Verein zur Foerderung der freien virtuellen Maschine CACAO
+
+   This file is part of CACAO.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation; either version 2, or (at
+   your option) any later version.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA.
+
+*/
+
+
+import org.junit.Test;
+
+import java.util.Arrays;
+import java.util.Collections;
+
+/* Division and remainder the scalar optimizations fold or reduce: by
+   -1 must not trap on the minimum value, by 0 must still throw, and by
+   powers of two must round towards zero. */
+
+public class TestTieredArithmetic {
+	static final int ITERATIONS = 1000;
+
+	static int idiv(int a, int b) { return a / b; }
+	static int irem(int a, int b) { return a % b; }
+	static long ldiv(long a, long b) { return a / b; }
+	static long lrem(long a, long b) { return a % b; }
+
+	// the divisors are constants after propagation
+	static int idivMinusOne(int a) { int b = -1; return a / b; }
+	static int iremMinusOne(int a) { int b = -1; return a % b; }
+	static long ldivMinusOne(long a) { long b = -1; return a / b; }
+	static long lremMinusOne(long a) { long b = -1; return a % b; }
+
+	static int idivZero(int a) { int b = 0; return a / b; }
+	static int iremZero(int a) { int b = 0; return a % b; }
+	static long ldivZero(long a) { long b = 0; return a / b; }
+	static long lremZero(long a) { long b = 0; return a % b; }
+
+	static int idivFour(int a) { int b = 4; return a / b; }
+	static int iremFour(int a) { int b = 4; return a % b; }
+	static long ldivFour(long a) { long b = 4; return a / b; }
+	static long lremFour(long a) { long b = 4; return a % b; }
+
+	// all operands are constants
+	static int folded() {
+		int min = Integer.MIN_VALUE;
+		int m1 = -1;
+		return min / m1 + min % m1;
+	}
+
+	static String zero(int which) {
+		try {
+			switch (which) {
+			case 0: return "" + idivZero(7);
+			case 1: return "" + iremZero(7);
+			case 2: return "" + ldivZero(7);
+			case 3: return "" + lremZero(7);
+			case 4: return "" + idiv(7, 0);
+			case 5: return "" + irem(7, 0);
+			case 6: return "" + ldiv(7, 0);
+			default: return "" + lrem(7, 0);
+			}
+		}
+		catch (ArithmeticException e) {
+			return e.getClass().getName();
+		}
+	}
+
+	@Test
+	public void testMinusOne() throws Exception {
+		TieredDriver.check(Arrays.asList(Integer.MIN_VALUE, Integer.MIN_VALUE, 0, 0,
+										 Long.MIN_VALUE, Long.MIN_VALUE, 0L, 0L,
+										 -7, Integer.MIN_VALUE),
+						   new TieredDriver.Workload() {
+				public Object run() {
+					return Arrays.asList(idivMinusOne(Integer.MIN_VALUE), idiv(Integer.MIN_VALUE, -1),
+										 iremMinusOne(Integer.MIN_VALUE), irem(Integer.MIN_VALUE, -1),
+										 ldivMinusOne(Long.MIN_VALUE), ldiv(Long.MIN_VALUE, -1),
+										 lremMinusOne(Long.MIN_VALUE), lrem(Long.MIN_VALUE, -1),
+										 idivMinusOne(7), folded());
+				}
+			}, ITERATIONS);
+	}
+
+	@Test
+	public void testZero() throws Exception {
+		TieredDriver.check(Collections.nCopies(8, ArithmeticException.class.getName()),
+						   new TieredDriver.Workload() {
+				public Object run() {
+					return Arrays.asList(zero(0), zero(1), zero(2), zero(3),
+										 zero(4), zero(5), zero(6), zero(7));
+				}
+			}, ITERATIONS);
+	}
+
+	@Test
+	public void testPowerOfTwo() throws Exception {
+		TieredDriver.check(Arrays.asList(-1, -3, -1L, -3L),
+						   new TieredDriver.Workload() {
+				public Object run() {
+					return Arrays.asList(idivFour(-7), iremFour(-7), ldivFour(-7), lremFour(-7));
+				}
+			}, ITERATIONS);
+	}
+}
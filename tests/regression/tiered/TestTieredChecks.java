@@ -0,0 +1,151 @@
+/* tests/regression/tiered/TestTieredChecks.java
+
+   Copyright (C) 1996-2013
+   CACAOVM - Verein zur Foerderung der freien virtuellen Maschine CACAO
+
+   This file is part of CACAO.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation; either version 2, or (at
+   your option) any later version.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA.
+
+*/
+
+
+import org.junit.Test;
+
+import java.util.Arrays;
+
+/* Null, bounds and type checks that check elimination must keep.  The
+   same methods run with good and bad arguments. */
+
+public class TestTieredChecks {
+	static final int ITERATIONS = 1000;
+
+	static final String NPE   = NullPointerException.class.getName();
+	static final String AIOOB = ArrayIndexOutOfBoundsException.class.getName();
+	static final String ASE   = ArrayStoreException.class.getName();
+	static final String CCE   = ClassCastException.class.getName();
+
+	static class Point {
+		int x, y;
+		Point(int x, int y) { this.x = x; this.y = y; }
+		int sum() { return x + y; }
+	}
+
+	// the second access is known not to be null only after the first
+	static int twice(Point p) {
+		int x = p.x;
+		return x + p.y;
+	}
+
+	static int call(Point p) {
+		return p.sum();
+	}
+
+	static int length(int[] a) {
+		return a.length;
+	}
+
+	static int at(int[] a, int i) {
+		return a[i];
+	}
+
+	// the second load uses the index checked by the first
+	static int pair(int[] a, int i) {
+		return a[i] + a[i + 1];
+	}
+
+	static void store(Object[] a, Object o) {
+		a[0] = o;
+	}
+
+	static String cast(Object o) {
+		return (String) o;
+	}
+
+	// the cast is known to succeed only on one path
+	static int castAfterTest(Object o, boolean test) {
+		if (test && o instanceof String)
+			return ((String) o).length();
+		return ((String) o).length();
+	}
+
+	// the object is reloaded from a field written by the callee
+	static Point holder;
+
+	static void clear() {
+		holder = null;
+	}
+
+	static int afterCall() {
+		int x = holder.x;
+		clear();
+		return x + holder.y;
+	}
+
+	static String run(int which, boolean good) {
+		Point   p = good ? new Point(1, 2) : null;
+		int[]   a = good ? new int[] { 1, 2, 3 } : null;
+		Object  o = good ? (Object) "abc" : (Object) new Integer(1);
+
+		try {
+			switch (which) {
+			case 0: return "" + twice(p);
+			case 1: return "" + call(p);
+			case 2: return "" + length(a);
+			case 3: return "" + at(new int[3], good ? 2 : 3);
+			case 4: return "" + at(new int[3], good ? 0 : -1);
+			case 5: return "" + pair(new int[3], good ? 1 : 2);
+			case 6: store(good ? new Object[1] : new String[1], new Integer(1)); return "stored";
+			case 7: return cast(o);
+			case 8: return "" + castAfterTest(o, good);
+			default: holder = new Point(1, 2); return "" + afterCall();
+			}
+		}
+		catch (RuntimeException e) {
+			return e.getClass().getName();
+		}
+	}
+
+	private static void check(final int which, String good, String bad) throws Exception {
+		TieredDriver.check(Arrays.asList(good, bad), new TieredDriver.Workload() {
+				public Object run() {
+					return Arrays.asList(TestTieredChecks.run(which, true), TestTieredChecks.run(which, false));
+				}
+			}, ITERATIONS);
+	}
+
+	@Test
+	public void testNullChecks() throws Exception {
+		check(0, "3", NPE);
+		check(1, "3", NPE);
+		check(2, "3", NPE);
+		check(9, NPE, NPE);
+	}
+
+	@Test
+	public void testBoundsChecks() throws Exception {
+		check(3, "0", AIOOB);
+		check(4, "0", AIOOB);
+		check(5, "0", AIOOB);
+	}
+
+	@Test
+	public void testTypeChecks() throws Exception {
+		check(6, "stored", ASE);
+		check(7, "abc", CCE);
+		check(8, "3", CCE);
+	}
+}
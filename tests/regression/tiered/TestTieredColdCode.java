@@ -0,0 +1,123 @@
+/* tests/regression/tiered/TestTieredColdCode.java
+
+   Copyright (C) 1996-2013
+   CACAOVM - Verein zur Foerderung der freien virtuellen Maschine CACAO
+
+   This file is part of CACAO.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation; either version 2, or (at
+   your option) any later version.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA.
+
+*/
+
+
+import org.junit.Test;
+import static org.junit.Assert.*;
+
+/* Exception handlers, blocks leading to a throw and rarely executed
+   blocks which hot/cold splitting moves behind the hot code.  They are
+   taken after the methods have been promoted to the optimizing tier
+   with a block profile that never saw them. */
+
+public class TestTieredColdCode {
+	static int handled;
+	static int finallies;
+
+	static int parse(String s) {
+		try {
+			return Integer.parseInt(s);
+		}
+		catch (NumberFormatException e) {
+			handled++;
+			return -1;
+		}
+	}
+
+	static int twice(int x) {
+		if (x < 0)
+			throw new IllegalArgumentException("negative");
+		return 2 * x;
+	}
+
+	static int checked(int x) {
+		try {
+			return twice(x);
+		}
+		catch (IllegalArgumentException e) {
+			handled++;
+			return 0;
+		}
+		finally {
+			finallies++;
+		}
+	}
+
+	static int rare(int x) {
+		int r = x;
+
+		if (x == 12345) {
+			for (int i = 0; i < 10; i++)
+				r += i;
+		}
+
+		return r + 1;
+	}
+
+	// nested handlers, the inner one rethrows
+	static String nested(int x) {
+		try {
+			try {
+				if (x == 0)
+					throw new IllegalStateException("inner");
+				return "none";
+			}
+			catch (IllegalStateException e) {
+				throw new RuntimeException("outer", e);
+			}
+		}
+		catch (RuntimeException e) {
+			return e.getMessage() + "/" + e.getCause().getMessage();
+		}
+	}
+
+	@Test
+	public void testColdBlocks() throws Exception {
+		TieredDriver.promote(new TieredDriver.Workload() {
+				int i;
+
+				public Object run() {
+					parse("12");
+					checked(i++);
+					rare(i);
+					nested(1);
+					return null;
+				}
+			}, 10, 1000);
+
+		handled   = 0;
+		finallies = 0;
+
+		assertEquals(12, parse("12"));
+		assertEquals(-1, parse("x"));
+		assertEquals(6, checked(3));
+		assertEquals(0, checked(-3));
+		assertEquals(2, rare(1));
+		assertEquals(12391, rare(12345));
+		assertEquals("none", nested(1));
+		assertEquals("outer/inner", nested(0));
+		assertEquals(2, handled);
+		assertEquals(2, finallies);
+	}
+}
@@ -0,0 +1,125 @@
+/* tests/regression/tiered/TestTieredLocks.java
+
+   Copyright (C) 1996-2013
+   CACAOVM - Verein zur Foerderung der freien virtuellen Maschine CACAO
+
+   This file is part of CACAO.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation; either version 2, or (at
+   your option) any later version.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA.
+
+*/
+
+
+import org.junit.Test;
+
+/* Monitors that lock elision must keep: objects allocated by the
+   compiled method but reachable by other threads or passed to
+   calls. */
+
+public class TestTieredLocks {
+	static final int ITERATIONS = 300;
+
+	static int counter;
+
+	// the object is handed to another thread, which notifies us
+	static int handOff() throws InterruptedException {
+		final Object lock = new Object();
+		final int[] value = new int[1];
+
+		Thread t = new Thread() {
+				public void run() {
+					synchronized (lock) {
+						value[0] = 42;
+						lock.notify();
+					}
+				}
+			};
+
+		synchronized (lock) {
+			t.start();
+			while (value[0] == 0)
+				lock.wait();
+		}
+
+		t.join();
+		return value[0];
+	}
+
+	// the object is passed to calls which need the monitor
+	static boolean notifyLocal() {
+		Object lock = new Object();
+
+		synchronized (lock) {
+			lock.notify();
+			return Thread.holdsLock(lock);
+		}
+	}
+
+	// the object comes from the caller and is shared between threads
+	static void increment(Object lock, int n) {
+		for (int i = 0; i < n; i++) {
+			synchronized (lock) {
+				counter++;
+			}
+		}
+	}
+
+	static int contended(int n) throws InterruptedException {
+		final Object lock = new Object();
+		final int count = n;
+
+		counter = 0;
+
+		Thread t = new Thread() {
+				public void run() {
+					increment(lock, count);
+				}
+			};
+
+		t.start();
+		increment(lock, n);
+		t.join();
+
+		return counter;
+	}
+
+	@Test
+	public void testHandOff() throws Exception {
+		TieredDriver.check(new Integer(42), new TieredDriver.Workload() {
+				public Object run() throws Exception {
+					return new Integer(handOff());
+				}
+			}, ITERATIONS);
+	}
+
+	@Test
+	public void testNotifyLocal() throws Exception {
+		TieredDriver.check(Boolean.TRUE, new TieredDriver.Workload() {
+				public Object run() {
+					return Boolean.valueOf(notifyLocal());
+				}
+			}, ITERATIONS);
+	}
+
+	@Test
+	public void testContended() throws Exception {
+		TieredDriver.check(new Integer(20000), new TieredDriver.Workload() {
+				public Object run() throws Exception {
+					return new Integer(contended(10000));
+				}
+			}, ITERATIONS);
+	}
+}
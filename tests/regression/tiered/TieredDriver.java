@@ -0,0 +1,70 @@
+/* tests/regression/tiered/TieredDriver.java - drives methods through the tiers
+
+   Copyright (C) 1996-2013
+   CACAOVM - Verein zur Foerderung der freien virtuellen Maschine CACAO
+
+   This file is part of CACAO.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation; either version 2, or (at
+   your option) any later version.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+   02110-1301, USA.
+
+*/
+
+
+import static org.junit.Assert.*;
+
+/* The tests of this directory run with the low tier thresholds of
+   Makefile.am.  Their methods start in baseline code and are promoted
+   to the optimizing tier by the recompiler thread while the tests
+   keep calling them. */
+
+public class TieredDriver {
+	/* rounds of calls, the recompiler runs in the pauses */
+	static final int ROUNDS = 2;
+	static final int PAUSE  = 200;
+
+	static final int PROMOTE_PAUSE = 20;
+
+	public interface Workload {
+		Object run() throws Exception;
+	}
+
+	/* Runs the workload often enough to get its methods promoted,
+	   pausing after each round for the recompiler. */
+
+	public static void promote(Workload w, int rounds, int iterations) throws Exception {
+		for (int round = 0; round < rounds; round++) {
+			for (int i = 0; i < iterations; i++)
+				w.run();
+
+			Thread.sleep(PROMOTE_PAUSE);
+		}
+	}
+
+	/* Runs the workload before and after its methods have been
+	   promoted and checks that every result equals the expected
+	   one. */
+
+	public static void check(Object expected, Workload w, int iterations) throws Exception {
+		assertEquals("baseline", expected, w.run());
+
+		for (int round = 0; round < ROUNDS; round++) {
+			for (int i = 0; i < iterations; i++)
+				assertEquals("round " + round + ", iteration " + i, expected, w.run());
+
+			Thread.sleep(PAUSE);
+		}
+	}
+}